@@ -120,5 +120,13 @@ if "%debug%"=="1" (
   %linker% %cc_obj_debug% %bin%\*.res %l_files_debug% %l_out_debug% %l_all% || exit /b 1
 )
 
+:: -- ASSET PACK (build.bat pack) -------------------------------------------------------
+:: NOTE: Compiles the icons and fonts of %assets% into %bin%\betterdeck.pack, next to the exe
+if "%pack%"=="1" (
+  %cc% %src_dir%\asset_compiler.c %cc_flags% /Fo:%bin%\asset_compiler.obj /Fd:%bin%\asset_compiler.pdb || exit /b 1
+  %linker% %bin%\asset_compiler.obj /OUT:%bin%\asset_compiler%ext% /PDB:%bin%\asset_compiler.pdb %l_all% || exit /b 1
+  %bin%\asset_compiler%ext% %assets% %bin%\betterdeck.pack || exit /b 1
+)
+
 :: -- Misc ---------------------------------------------------------------------------
 ctags -f tags --langmap=c:.c.h --languages=c -R src
@@ -0,0 +1,457 @@
+/*
+ * NOTE:
+ *      Offline asset compiler, writes the asset pack sdk_assets.c maps:
+ *
+ *        asset_compiler <asset dir> <out.pack>
+ *
+ *        *.jpg, *.jpeg  kept as they are (IMAGE "<name>") and, for every deck
+ *        *.png          model, resized, rotated, re-encoded at the best quality
+ *                       that needs the fewest reports and cut into the model's
+ *                       output reports (KEY "<name>@<pid>"). At runtime only
+ *                       the key index is filled in.
+ *        *.fnt          BMFont text metrics (FONT "<name>") and the atlas of
+ *                       page 0 as it is (ATLAS "<name>").
+ *
+ *      SVG icons are rasterized before they get here. A PNG next to a font
+ *      of its name ("<font>.fnt" for "<font>.png" or "<font>_0.png") is that
+ *      font's atlas, not an icon.
+ */
+#include <cm_entry.h>
+#include <cm_error_handling.c>
+#include <cm_io.c>
+#include <cm_memory.c>
+#include <cm_string.c>
+
+#include "cm_arena.c"
+#include "cm_alloc.c"
+#include "cm_hid.c"
+#include "cm_image.c"
+#include "cm_jpeg.c"
+#include "cm_png.c"
+#include "sdk_input.c"
+#include "sdk_timer.c"
+#include "sdk_gesture.c"
+#include "sdk_packed.c"
+#include "sdk_assets.c"
+#include "sdk_tiles.c"
+#include "sdk_decode.c"
+#include "sdk_action.c"
+#include "sdk_deck.c"
+#include "sdk_frame.c"
+#include "sdk_profile.c"
+
+#define PACK_MAX_ASSETS   4096
+#define PACK_QUALITY_MAX  92
+#define PACK_QUALITY_MIN  72
+#define PACK_QUALITY_STEP 4
+
+#pragma warning(disable : 4820)
+typedef struct PackBlob
+{
+  u8  *data;
+  u32 size;
+  u64 offset;                                /* NOTE: Set when written */
+} PackBlob, Pack_Blob;
+
+typedef struct Pack
+{
+  Arena           arena;
+  Sdk_Asset_Entry entries[PACK_MAX_ASSETS];
+  u32             blobs_of[PACK_MAX_ASSETS];  /* NOTE: Blob of each entry */
+  u32             entry_count;
+  Pack_Blob       blobs[PACK_MAX_ASSETS];
+  u32             blob_count;
+  u64             source_bytes, key_bytes;
+} Pack;
+#pragma warning(default : 4820)
+
+/* NOTE: Copies `data` into the pack's arena, returns the blob index or -1. */
+static i32
+pack_blob(Pack *pack, u8 *data, u32 size)
+{
+  Pack_Blob *blob;
+
+  if (pack->blob_count >= PACK_MAX_ASSETS) { printf("pack: too many blobs\n"); return -1; }
+  blob       = &pack->blobs[pack->blob_count];
+  blob->data = arena_push(&pack->arena, size ? size : 1);
+  if (!blob->data) return -1;
+  memcpy(blob->data, data, size);
+  blob->size = size;
+  return (i32) pack->blob_count++;
+}
+
+static Sdk_Asset_Entry*
+pack_entry(Pack *pack, char *name, u16 kind, u16 format, i32 blob)
+{
+  u32             i;
+  Sdk_Asset_Entry *entry;
+
+  if (blob < 0) return NULL;
+  if (strlen(name) > SDK_ASSET_NAME_LEN) { printf("pack: name %s is longer than %u\n", name, SDK_ASSET_NAME_LEN); return NULL; }
+  for (i = 0; i < pack->entry_count; i++)
+  {
+    if (pack->entries[i].kind == kind && !strncmp(pack->entries[i].name, name, SDK_ASSET_NAME_LEN))
+    {
+      printf("pack: %s is there twice\n", name);
+      return NULL;
+    }
+  }
+  if (pack->entry_count >= PACK_MAX_ASSETS) { printf("pack: too many assets\n"); return NULL; }
+  entry = &pack->entries[pack->entry_count];
+  memset(entry, 0, sizeof(Sdk_Asset_Entry));
+  strncpy(entry->name, name, SDK_ASSET_NAME_LEN);
+  entry->hash   = sdk_asset_hash(name);
+  entry->kind   = kind;
+  entry->format = format;
+  entry->size   = pack->blobs[blob].size;
+  pack->blobs_of[pack->entry_count++] = (u32) blob;
+  return entry;
+}
+
+/* NOTE: `name` is the file name without its directory and extension. */
+static void
+pack_name(char *file, char *name)
+{
+  char *dot;
+
+  strncpy(name, file, MAX_PATH - 1);
+  name[MAX_PATH - 1] = 0;
+  dot = strrchr(name, '.');
+  if (dot) *dot = 0;
+}
+
+/*
+ * NOTE:
+ *      The reports `model` wants for `image`: the quality goes down from
+ *      PACK_QUALITY_MAX only as long as it saves a report, fewer reports is
+ *      fewer USB transfers for every redraw.
+ */
+static Sdk_Packed*
+pack_key_reports(Stream_Deck *sdk, Image *image, u32 *image_size)
+{
+  u8         *encoded, *best;
+  u32        quality, size, best_size, reports, best_reports;
+  Sdk_Packed *packed;
+
+  best         = NULL;
+  best_size    = 0;
+  best_reports = 0;
+  for (quality = PACK_QUALITY_MAX; quality >= PACK_QUALITY_MIN; quality -= PACK_QUALITY_STEP)
+  {
+    encoded = jpeg_encode(image, quality, &size);
+    if (!encoded) break;
+    reports = (size + sdk->img_rpt_payload_len - 1) / sdk->img_rpt_payload_len;
+    if (best && reports >= best_reports) { heap_free_dz(encoded); continue; }
+    if (best) heap_free_dz(best);
+    best         = encoded;
+    best_size    = size;
+    best_reports = reports;
+  }
+  if (!best) return NULL;
+  packed = sdk_pack_key_image(sdk, best, best_size, 0);
+  heap_free_dz(best);
+  *image_size = best_size;
+  return packed;
+}
+
+static bool
+pack_icon(Pack *pack, char *path, char *name)
+{
+  u8              done[countof(g_sdk_models)];
+  u32             i, j, image_size;
+  i32             blob;
+  bool            ok;
+  char            full[SDK_ASSET_NAME_LEN + 8];
+  u16             format;
+  File            file;
+  Image           sized, turned;
+  Stream_Deck     *sdk;
+  Sdk_Packed      *packed;
+  Sdk_Model       *model;
+  Sdk_Asset_Entry *entry;
+
+  if (file_exist_open_map_ro(path, &file) != CM_OK) { printf("pack: cannot read %s\n", path); return false; }
+  ok  = false;
+  sdk = NULL;
+  memset(&sized,  0, sizeof(Image));
+  memset(&turned, 0, sizeof(Image));
+  pack->source_bytes += file.buffer.size;
+  switch (sdk_image_kind(file.buffer.view, (u32) file.buffer.size))
+  {
+    case SDK_IMAGE_JPEG: format = SDK_ASSET_JPEG; break;
+    case SDK_IMAGE_PNG:  format = SDK_ASSET_PNG;  break;
+    default: printf("pack: %s is not a JPEG or PNG\n", path); goto _end;
+  }
+  if (!pack_entry(pack, name, SDK_ASSET_IMAGE, format, pack_blob(pack, file.buffer.view, (u32) file.buffer.size))) goto _end;
+  cm_heap_alloc(sizeof(Stream_Deck), sdk);
+  if (!sdk) goto _end;
+
+  memset(done, 0, sizeof(done));
+  for (i = 0; i < countof(g_sdk_models); i++)
+  {
+    if (done[i]) continue;
+    model = &g_sdk_models[i];
+    memset(sdk, 0, sizeof(Stream_Deck));
+    sdk_init_from_model(sdk, model);
+    /* NOTE: Decoded again per key size, a large JPEG is scaled down in the DCT */
+    if (!sdk_decode_image(file.buffer.view, (u32) file.buffer.size, model->pxl, model->pxl, &sized))
+    {
+      printf("pack: cannot decode %s\n", path);
+      goto _end;
+    }
+    if (!image_rotate(&sized, &turned, model->key_rotation)) goto _end;
+    packed = pack_key_reports(sdk, &turned, &image_size);
+    image_free(&sized);
+    image_free(&turned);
+    if (!packed) { printf("pack: cannot encode %s for %s\n", path, model->name); goto _end; }
+    blob = pack_blob(pack, packed->reports, packed->report_len * packed->report_count);
+    pack->key_bytes += (u64) packed->report_len * packed->report_count;
+    sdk_packed_release(packed);
+    /* NOTE: Every model wanting the same reports points at this blob */
+    for (j = i; j < countof(g_sdk_models); j++)
+    {
+      if (g_sdk_models[j].pxl != model->pxl || g_sdk_models[j].key_rotation != model->key_rotation) continue;
+      done[j] = 1;
+      snprintf(full, sizeof(full), "%s@%04x", name, g_sdk_models[j].pid);
+      entry = pack_entry(pack, full, SDK_ASSET_KEY, SDK_ASSET_REPORTS, blob);
+      if (!entry) goto _end;
+      entry->width  = model->pxl;
+      entry->height = model->pxl;
+      entry->param  = image_size;
+    }
+  }
+  ok = true;
+
+_end:
+  if (sdk) heap_free_dz(sdk);
+  image_free(&sized);
+  image_free(&turned);
+  file_close(&file);
+  return ok;
+}
+
+/* NOTE: The PNG `name` in `dir` is the page of a font, see the header. */
+static bool
+pack_is_atlas(char *dir, char *name)
+{
+  u32  len;
+  char fnt[MAX_PATH], *under;
+
+  snprintf(fnt, MAX_PATH, "%s\\%s.fnt", dir, name);
+  if (GetFileAttributesA(fnt) != INVALID_FILE_ATTRIBUTES) return true;
+  under = strrchr(name, '_');
+  if (!under || !under[1] || strspn(under + 1, "0123456789") != strlen(under + 1)) return false;
+  len = (u32)(under - name);
+  snprintf(fnt, MAX_PATH, "%s\\%.*s.fnt", dir, (i32) len, name);
+  return GetFileAttributesA(fnt) != INVALID_FILE_ATTRIBUTES;
+}
+
+/* NOTE: Value of ` key=` in a BMFont line, 0 when missing. Quoted values are copied to `text`. */
+static i32
+pack_fnt_value(char *line, char *key, char *text, u32 text_len)
+{
+  u32  len;
+  char *at, *end;
+
+  len = (u32) strlen(key);
+  for (at = strstr(line, key); at; at = strstr(at + 1, key))
+  {
+    if (at != line && at[-1] != ' ') continue;
+    if (at[len] != '=') continue;
+    at += len + 1;
+    if (*at == '"' && text)
+    {
+      end = strchr(at + 1, '"');
+      len = end ? (u32)(end - at - 1) : 0;
+      if (len >= text_len) len = text_len - 1;
+      memcpy(text, at + 1, len);
+      text[len] = 0;
+      return 1;
+    }
+    return atoi(at);
+  }
+  return 0;
+}
+
+static bool
+pack_font(Pack *pack, char *dir, char *path, char *name)
+{
+  u32             count, len;
+  i32             blob;
+  bool            ok;
+  char            *line, *next, page[MAX_PATH], atlas_path[MAX_PATH];
+  File            file, atlas;
+  Sdk_Asset_Font  *font;
+  Sdk_Asset_Glyph *glyphs, glyph;
+  Sdk_Asset_Entry *entry;
+
+  if (file_exist_open_map_ro(path, &file) != CM_OK) { printf("pack: cannot read %s\n", path); return false; }
+  ok      = false;
+  page[0] = 0;
+  /* NOTE: Room for one glyph per line at most */
+  font    = arena_push(&pack->arena, sizeof(Sdk_Asset_Font) + file.buffer.size / 8 * sizeof(Sdk_Asset_Glyph));
+  line    = arena_push(&pack->arena, file.buffer.size + 1);
+  if (!font || !line) goto _end;
+  memset(font, 0, sizeof(Sdk_Asset_Font));
+  memcpy(line, file.buffer.view, file.buffer.size);
+  line[file.buffer.size] = 0;
+  glyphs = (Sdk_Asset_Glyph*)(font + 1);
+  count  = 0;
+  for (; *line; line = next)
+  {
+    next = strchr(line, '\n');
+    if (next) *next++ = 0;
+    else      next = line + strlen(line);
+    if (!strncmp(line, "common ", 7))
+    {
+      font->line_height = (u16) pack_fnt_value(line, "lineHeight", NULL, 0);
+      font->base        = (u16) pack_fnt_value(line, "base", NULL, 0);
+      font->scale_w     = (u16) pack_fnt_value(line, "scaleW", NULL, 0);
+      font->scale_h     = (u16) pack_fnt_value(line, "scaleH", NULL, 0);
+    }
+    else if (!strncmp(line, "page ", 5) && !pack_fnt_value(line, "id", NULL, 0))
+    {
+      pack_fnt_value(line, "file", page, MAX_PATH);
+    }
+    else if (!strncmp(line, "char ", 5))
+    {
+      glyph.id       = (u32) pack_fnt_value(line, "id", NULL, 0);
+      glyph.x        = (u16) pack_fnt_value(line, "x", NULL, 0);
+      glyph.y        = (u16) pack_fnt_value(line, "y", NULL, 0);
+      glyph.w        = (u16) pack_fnt_value(line, "width", NULL, 0);
+      glyph.h        = (u16) pack_fnt_value(line, "height", NULL, 0);
+      glyph.xoffset  = (i16) pack_fnt_value(line, "xoffset", NULL, 0);
+      glyph.yoffset  = (i16) pack_fnt_value(line, "yoffset", NULL, 0);
+      glyph.xadvance = (i16) pack_fnt_value(line, "xadvance", NULL, 0);
+      glyph.page     = (u16) pack_fnt_value(line, "page", NULL, 0);
+      /* NOTE: Insertion keeps them sorted for sdk_font_glyph */
+      for (len = count; len && glyphs[len - 1].id > glyph.id; len--) glyphs[len] = glyphs[len - 1];
+      glyphs[len] = glyph;
+      count++;
+    }
+  }
+  font->glyph_count = count;
+  strncpy(font->atlas, name, SDK_ASSET_NAME_LEN);
+  if (!page[0]) { printf("pack: %s has no page 0\n", path); goto _end; }
+  snprintf(atlas_path, MAX_PATH, "%s\\%s", dir, page);
+  if (file_exist_open_map_ro(atlas_path, &atlas) != CM_OK) { printf("pack: cannot read %s\n", atlas_path); goto _end; }
+  blob = pack_blob(pack, atlas.buffer.view, (u32) atlas.buffer.size);
+  file_close(&atlas);
+  entry = pack_entry(pack, name, SDK_ASSET_ATLAS, SDK_ASSET_PNG, blob);
+  if (!entry) goto _end;
+  entry->width  = font->scale_w;
+  entry->height = font->scale_h;
+  /* NOTE: The glyphs were pushed with the font, the blob copy is exact */
+  ok = pack_entry(pack, name, SDK_ASSET_FONT, SDK_ASSET_RAW,
+                  pack_blob(pack, (u8*) font, (u32)(sizeof(Sdk_Asset_Font) + count * sizeof(Sdk_Asset_Glyph)))) != NULL;
+  printf("pack: %s, %u glyphs\n", name, count);
+
+_end:
+  file_close(&file);
+  return ok;
+}
+
+static bool
+pack_write(Pack *pack, char *path)
+{
+  u32              i, slot, slot_count, mask;
+  u64              offset;
+  bool             ok;
+  DWORD            written;
+  HANDLE           out;
+  Sdk_Asset_Header header;
+  Sdk_Asset_Entry  *slots;
+  static u8        zeros[SDK_ASSET_ALIGN];
+
+  /* NOTE: At most half full, probes stay short */
+  for (slot_count = 16; slot_count < pack->entry_count * 2; slot_count *= 2) {}
+  mask  = slot_count - 1;
+  slots = arena_push(&pack->arena, (u64) slot_count * sizeof(Sdk_Asset_Entry));
+  if (!slots) return false;
+  memset(slots, 0, (u64) slot_count * sizeof(Sdk_Asset_Entry));
+
+  offset = sizeof(Sdk_Asset_Header) + (u64) slot_count * sizeof(Sdk_Asset_Entry);
+  for (i = 0; i < pack->blob_count; i++)
+  {
+    offset = (offset + SDK_ASSET_ALIGN - 1) & ~(u64)(SDK_ASSET_ALIGN - 1);
+    pack->blobs[i].offset = offset;
+    offset += pack->blobs[i].size;
+  }
+  for (i = 0; i < pack->entry_count; i++)
+  {
+    pack->entries[i].offset = pack->blobs[pack->blobs_of[i]].offset;
+    for (slot = (u32) pack->entries[i].hash & mask; slots[slot].hash; slot = (slot + 1) & mask) {}
+    slots[slot] = pack->entries[i];
+  }
+  memset(&header, 0, sizeof(Sdk_Asset_Header));
+  header.magic       = SDK_ASSET_MAGIC;
+  header.version     = SDK_ASSET_VERSION;
+  header.file_size   = offset;
+  header.slot_count  = slot_count;
+  header.asset_count = pack->entry_count;
+  header.directory   = sizeof(Sdk_Asset_Header);
+
+  out = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (out == INVALID_HANDLE_VALUE) { report_error("CreateFileA"); return false; }
+  ok     = WriteFile(out, &header, sizeof(header), &written, NULL)
+        && WriteFile(out, slots, slot_count * (u32) sizeof(Sdk_Asset_Entry), &written, NULL);
+  offset = sizeof(Sdk_Asset_Header) + (u64) slot_count * sizeof(Sdk_Asset_Entry);
+  for (i = 0; i < pack->blob_count && ok; i++)
+  {
+    ok = WriteFile(out, zeros, (DWORD)(pack->blobs[i].offset - offset), &written, NULL)
+      && WriteFile(out, pack->blobs[i].data, pack->blobs[i].size, &written, NULL);
+    offset = pack->blobs[i].offset + pack->blobs[i].size;
+  }
+  if (!ok) report_error("WriteFile");
+  handle_close(out);
+  if (ok) printf("pack: %s, %u assets in %llu bytes\n", path, pack->entry_count, header.file_size);
+  return ok;
+}
+
+ENTRY
+{
+  u32              failures;
+  char             *args, *out, *ext, dir[MAX_PATH], pattern[MAX_PATH], path[MAX_PATH], name[MAX_PATH];
+  Pack             *pack;
+  HANDLE           find;
+  WIN32_FIND_DATAA data;
+
+  /* NOTE: Skips the program name, then "<asset dir> <out.pack>", no spaces in either */
+  args = GetCommandLineA();
+  if (*args == '"') args = strchr(args + 1, '"');
+  args = args ? strchr(args, ' ') : NULL;
+  while (args && *args == ' ') args++;
+  out  = args ? strchr(args, ' ') : NULL;
+  if (!out) { printf("usage: asset_compiler <asset dir> <out.pack>\n"); RETURN_FROM_MAIN(EXIT_FAILURE); }
+  snprintf(dir, MAX_PATH, "%.*s", (i32)(out - args), args);
+  while (*out == ' ') out++;
+
+  pack = NULL;
+  cm_heap_alloc(sizeof(Pack), pack);
+  if (!pack || !arena_open(&pack->arena, 1ull << 30)) RETURN_FROM_MAIN(EXIT_FAILURE);
+  failures = 0;
+  snprintf(pattern, MAX_PATH, "%s\\*", dir);
+  find = FindFirstFileA(pattern, &data);
+  if (find == INVALID_HANDLE_VALUE) { report_error("FindFirstFileA"); RETURN_FROM_MAIN(EXIT_FAILURE); }
+  do
+  {
+    ext = strrchr(data.cFileName, '.');
+    if (!ext || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) continue;
+    snprintf(path, MAX_PATH, "%s\\%s", dir, data.cFileName);
+    pack_name(data.cFileName, name);
+    if (!_stricmp(ext, ".jpg") || !_stricmp(ext, ".jpeg")) failures += !pack_icon(pack, path, name);
+    else if (!_stricmp(ext, ".fnt"))                      failures += !pack_font(pack, dir, path, name);
+    else if (!_stricmp(ext, ".png") && !pack_is_atlas(dir, name)) failures += !pack_icon(pack, path, name);
+  } while (FindNextFileA(find, &data));
+  FindClose(find);
+
+  printf("pack: %llu bytes of icons, %llu bytes of compiled reports\n", pack->source_bytes, pack->key_bytes);
+  if (failures || !pack_write(pack, out))
+  {
+    printf("pack: %u failures, %s not written\n", failures, out);
+    RETURN_FROM_MAIN(EXIT_FAILURE);
+  }
+  arena_close(&pack->arena);
+  heap_free_dz(pack);
+  RETURN_FROM_MAIN(EXIT_SUCCESS);
+}
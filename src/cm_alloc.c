@@ -0,0 +1,70 @@
+#ifndef CM_ALLOC_C
+#define CM_ALLOC_C
+
+#pragma warning(push, 0)
+#include <stdatomic.h>
+#pragma warning(pop)
+
+/*
+ * NOTE:
+ *      Counting hook for the heap and a stack high-water mark, DEBUG only.
+ *      Everything allocates through cm_heap_alloc, never heap_alloc_dz
+ *      directly, so the I/O threads can check they stay allocation free once
+ *      warmed up (see sdk_service_audit): an allocation that skips the hook
+ *      is one the audit cannot see. In release builds both compile down to
+ *      heap_alloc_dz / nothing.
+ */
+#if defined(DEBUG)
+
+global atomic_ullong g_heap_alloc_count;
+global __declspec(thread) u64 t_heap_alloc_count;
+global __declspec(thread) u8  *t_stack_base;
+global __declspec(thread) u8  *t_stack_low;
+
+static inline void
+cm_alloc_count(u64 size)
+{
+  (void) size;
+  atomic_fetch_add(&g_heap_alloc_count, 1);
+  t_heap_alloc_count++;
+}
+
+static inline u64
+cm_alloc_thread_count(void)
+{
+  return t_heap_alloc_count;
+}
+
+/* NOTE: Call once at the top of a thread procedure, then cm_stack_mark in the leaves */
+static inline void
+cm_stack_base(void *base)
+{
+  t_stack_base = base;
+  t_stack_low  = base;
+}
+
+static inline void
+cm_stack_mark(void *here)
+{
+  if ((u8*) here < t_stack_low) t_stack_low = here;
+}
+
+static inline u64
+cm_stack_used(void)
+{
+  return t_stack_base ? (u64)(t_stack_base - t_stack_low) : 0;
+}
+
+#define cm_heap_alloc(size, ptr) DO cm_alloc_count(size); heap_alloc_dz((size), ptr); WHILE
+
+#else
+
+#define cm_alloc_thread_count() 0
+#define cm_stack_base(base)
+#define cm_stack_mark(here)
+#define cm_stack_used()         0
+#define cm_heap_alloc(size, ptr) heap_alloc_dz((size), ptr)
+
+#endif // DEBUG
+
+#endif // CM_ALLOC_C
@@ -0,0 +1,114 @@
+#ifndef CM_ARENA_C
+#define CM_ARENA_C
+
+/*
+ * NOTE:
+ *      Linear allocator over a reserved range of address space. Pages are
+ *      committed on demand and kept on clear, so a cleared arena serves the
+ *      next round of allocations without touching the OS or the heap.
+ *      Everything pushed is released at once with arena_clear/arena_close.
+ */
+#define ARENA_RESERVE_DEFAULT  (64ull << 20)
+#define ARENA_COMMIT_CHUNK     (64ull << 10)
+#define ARENA_ALIGN            16ull
+
+#pragma warning(disable : 4820)
+typedef struct Arena
+{
+  u8  *base;
+  u64 reserved;
+  u64 committed;
+  u64 used;
+} Arena;
+
+typedef struct ArenaTemp
+{
+  Arena *arena;
+  u64   used;
+} ArenaTemp, Arena_Temp;
+#pragma warning(default : 4820)
+
+static bool
+arena_open(Arena *arena, u64 reserve)
+{
+  memset(arena, 0, sizeof(Arena));
+  if (!reserve) reserve = ARENA_RESERVE_DEFAULT;
+  arena->base = VirtualAlloc(NULL, reserve, MEM_RESERVE, PAGE_READWRITE);
+  if (!arena->base) { report_error("VirtualAlloc"); return false; }
+  arena->reserved = reserve;
+  return true;
+}
+
+static void
+arena_close(Arena *arena)
+{
+  if (arena->base && !VirtualFree(arena->base, 0, MEM_RELEASE)) report_error("VirtualFree");
+  memset(arena, 0, sizeof(Arena));
+}
+
+static inline void
+arena_clear(Arena *arena)
+{
+  arena->used = 0;
+}
+
+/* NOTE: Returns zeroed memory, NULL when the reservation is exhausted. */
+static void*
+arena_push(Arena *arena, u64 size)
+{
+  u8  *ptr;
+  u64 start, end, commit;
+
+  start = (arena->used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  end   = start + size;
+  if (end > arena->reserved) { console_debug("arena_push: out of reserved memory"); return NULL; }
+  if (end > arena->committed)
+  {
+    commit = (end + ARENA_COMMIT_CHUNK - 1) & ~(ARENA_COMMIT_CHUNK - 1);
+    if (commit > arena->reserved) commit = arena->reserved;
+    if (!VirtualAlloc(arena->base + arena->committed, commit - arena->committed, MEM_COMMIT, PAGE_READWRITE))
+    {
+      report_error("VirtualAlloc");
+      return NULL;
+    }
+    arena->committed = commit;
+  }
+  ptr         = arena->base + start;
+  arena->used = end;
+  memset(ptr, 0, size);
+  return ptr;
+}
+
+#define arena_push_struct(arena, type)       ((type*) arena_push((arena), sizeof(type)))
+#define arena_push_array(arena, type, count) ((type*) arena_push((arena), sizeof(type) * (count)))
+
+static char*
+arena_strdup(Arena *arena, char *string)
+{
+  u64  len;
+  char *copy;
+
+  len  = strlen(string);
+  copy = arena_push(arena, len + 1);
+  if (copy) memcpy(copy, string, len);
+  return copy;
+}
+
+/* NOTE: Scratch scopes, everything pushed after begin is dropped by end. */
+static inline Arena_Temp
+arena_temp_begin(Arena *arena)
+{
+  Arena_Temp temp;
+
+  temp.arena = arena;
+  temp.used  = arena->used;
+  return temp;
+}
+
+static inline void
+arena_temp_end(Arena_Temp temp)
+{
+  temp.arena->used = temp.used;
+}
+
+#endif // CM_ARENA_C
@@ -76,6 +76,13 @@ typedef struct Hid_Device {
   HANDLE        h_dev;
   bool          blocking;
 
+  /*
+   * NOTE:
+   *      Every report buffer below is carved out of `pool`, one allocation
+   *      sized from the HID caps at open time. Nothing on the I/O paths
+   *      allocates after that.
+   */
+  u8            *pool;
   HidReport     output;
   HidReport     input;
   HidReport     feature;
@@ -83,7 +90,8 @@ typedef struct Hid_Device {
   bool          read_pending;
   OVERLAPPED    read_ol;
   u32           read_timeout_ms;
-  OVERLAPPED    ol;
+  bool          feature_pending;
+  OVERLAPPED    feature_ol;
   OVERLAPPED    write_ol;
   u32           write_timeout_ms;
   Hid_Device_Info *device_info;
@@ -140,70 +148,102 @@ hid_open_rw(char *path)
   return h_dev;
 }
 
-static void*
-hid_interface_get_property(char *path, DEVPROPKEY *key, DEVPROPTYPE expected_type)
+/*
+ * NOTE:
+ *      Configuration manager properties come back as UTF-16. They are fetched
+ *      into `scratch` and handed back as UTF-8 pushed on `arena` (string lists
+ *      keep their embedded terminators).
+ */
+static char*
+hid_property_to_chars(Arena *arena, wchar_t *value, u32 len)
 {
-	u8          *value;
-	u32         len ;
-  wchar_t     *wpath;
-	CONFIGRET   cr;
-	DEVPROPTYPE property_type;
+  i32  chars, size;
+  char *string;
+
+  chars = (i32)(len / sizeof(wchar_t));
+  size  = WideCharToMultiByte(CP_UTF8, 0, value, chars, NULL, 0, NULL, NULL);
+  if (size <= 0) { report_error("WideCharToMultiByte"); return NULL; }
+  string = arena_push(arena, (u64) size + 2);
+  if (!string) return NULL;
+  WideCharToMultiByte(CP_UTF8, 0, value, chars, string, size, NULL, NULL);
+  return string;
+}
 
-  value = NULL;
-  wpath = chars_to_wchars(path);
-	cr    = CM_Get_Device_Interface_PropertyW(wpath, key, &property_type, NULL, &len, 0);
-	if (cr != CR_BUFFER_SMALL || property_type != expected_type)
+static char*
+hid_interface_get_property(Arena *arena, Arena *scratch, char *path, DEVPROPKEY *key, DEVPROPTYPE expected_type)
+{
+  i32         wlen;
+  u32         len;
+  u8          *value;
+  char        *string;
+  wchar_t     *wpath;
+  CONFIGRET   cr;
+  Arena_Temp  temp;
+  DEVPROPTYPE property_type;
+
+  string = NULL;
+  temp   = arena_temp_begin(scratch);
+  wlen   = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+  wpath  = arena_push_array(scratch, wchar_t, (u64) wlen);
+  if (!wpath || !MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, wlen)) goto _cleanup;
+
+  len = 0;
+  cr  = CM_Get_Device_Interface_PropertyW(wpath, key, &property_type, NULL, &len, 0);
+  if (cr != CR_BUFFER_SMALL || property_type != expected_type)
   { report_error_go("CM_Get_Device_Interface_PropertyW", _cleanup); }
 
-	heap_alloc_dz(len * sizeof(BYTE), value);
-	cr = CM_Get_Device_Interface_PropertyW(wpath, key, &property_type, value, &len, 0);
-	if (cr != CR_SUCCESS) { report_error_go("CM_Get_Device_Interface_PropertyW", _failure); }
+  value = arena_push(scratch, len);
+  if (!value) goto _cleanup;
+  cr = CM_Get_Device_Interface_PropertyW(wpath, key, &property_type, value, &len, 0);
+  if (cr != CR_SUCCESS) { report_error_go("CM_Get_Device_Interface_PropertyW", _cleanup); }
+  string = hid_property_to_chars(arena, (wchar_t*) value, len);
 
 _cleanup:
-  heap_free_dz(wpath);
-	return value;
-
-_failure:
-  heap_free_dz(value);
-  value = NULL;
-  goto _cleanup;
+  /* NOTE: `arena` may be `scratch`, only drop the scope if the result is not in it */
+  if (arena != scratch || !string) arena_temp_end(temp);
+  return string;
 }
 
-static void*
-hid_node_get_property(DEVINST dev_node, DEVPROPKEY* key, DEVPROPTYPE expected_type)
+static char*
+hid_node_get_property(Arena *arena, Arena *scratch, DEVINST dev_node, DEVPROPKEY* key, DEVPROPTYPE expected_type)
 {
-	u32         len;
-	u8          *value;
-	CONFIGRET   cr;
-	DEVPROPTYPE property_type;
-
-  value = NULL;
-	cr    = CM_Get_DevNode_PropertyW(dev_node, key, &property_type, NULL, &len, 0);
-	if (cr != CR_BUFFER_SMALL || property_type != expected_type)
+  u32         len;
+  u8          *value;
+  char        *string;
+  CONFIGRET   cr;
+  Arena_Temp  temp;
+  DEVPROPTYPE property_type;
+
+  string = NULL;
+  temp   = arena_temp_begin(scratch);
+  len    = 0;
+  cr     = CM_Get_DevNode_PropertyW(dev_node, key, &property_type, NULL, &len, 0);
+  if (cr != CR_BUFFER_SMALL || property_type != expected_type)
   { report_error_go("CM_Get_DevNode_PropertyW", _finish); }
 
-	heap_alloc_dz(len * sizeof(BYTE), value);
-	cr = CM_Get_DevNode_PropertyW(dev_node, key, &property_type, value, &len, 0);
-	if (cr != CR_SUCCESS) { report_error_go("CM_Get_DevNode_PropertyW", _failure); }
+  value = arena_push(scratch, len);
+  if (!value) goto _finish;
+  cr = CM_Get_DevNode_PropertyW(dev_node, key, &property_type, value, &len, 0);
+  if (cr != CR_SUCCESS) { report_error_go("CM_Get_DevNode_PropertyW", _finish); }
+  string = hid_property_to_chars(arena, (wchar_t*) value, len);
 
 _finish:
-	return value;
-_failure:
-  heap_free_dz(value);
-  value = NULL;
-  goto _finish;
+  if (arena != scratch || !string) arena_temp_end(temp);
+  return string;
 }
 
 static Hid_Detect_Bus_Type
-hid_get_bus_type(char *path)
+hid_get_bus_type(Arena *scratch, char *path)
 {
   char                 *device_id, *ids;
 	DEVINST              dev_node;
 	CONFIGRET            cr;
+	Arena_Temp           temp;
 	Hid_Detect_Bus_Type  bus;
 
   memset(&bus, 0, sizeof(Hid_Detect_Bus_Type));
-	device_id = hid_interface_get_property( path, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
+  temp      = arena_temp_begin(scratch);
+	device_id = hid_interface_get_property(scratch, scratch, path, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
 	if (!device_id) goto _end;
 
 	cr = CM_Locate_DevNode(&dev_node, (DEVINSTID)device_id, CM_LOCATE_DEVNODE_NORMAL);
@@ -213,7 +253,7 @@ hid_get_bus_type(char *path)
 	if (cr != CR_SUCCESS) goto _end;
 
 	/* NOTE: Get the compatible ids from parent devnode */
-  ids = hid_node_get_property(dev_node, &DEVPKEY_Device_CompatibleIds, DEVPROP_TYPE_STRING_LIST);
+  ids = hid_node_get_property(scratch, scratch, dev_node, &DEVPKEY_Device_CompatibleIds, DEVPROP_TYPE_STRING_LIST);
 	if (!ids) goto _end;
 
 	/* NOTE: Now we can parse parent's compatible IDs to find out the device bus type */
@@ -235,9 +275,8 @@ hid_get_bus_type(char *path)
 		if (strstr(id, "PNP0C51")) { bus.type = HID_BUS_SPI; break; }
 	}
 	bus.dev_node = dev_node;
-	heap_free_dz(ids);
 _end:
-	heap_free_dz(device_id);
+	arena_temp_end(temp);
 	return bus;
 }
 
@@ -258,11 +297,13 @@ hid_token_value_get(char *string, char *token)
 }
 
 static void
-hid_usb_get_info(Hid_Device_Info *dev, DEVINST dev_node)
+hid_usb_get_info(Arena *arena, Arena *scratch, Hid_Device_Info *dev, DEVINST dev_node)
 {
-  char *dev_id, *hw_ids;
+  char       *dev_id, *hw_ids;
+  Arena_Temp temp;
 
-	dev_id = hid_node_get_property(dev_node, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
+  temp   = arena_temp_begin(scratch);
+	dev_id = hid_node_get_property(scratch, scratch, dev_node, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
 	if (!dev_id) goto _end;
   for (char* i = dev_id; *i; ++i) *i= (char) toupper(*i);
   /*
@@ -276,7 +317,7 @@ hid_usb_get_info(Hid_Device_Info *dev, DEVINST dev_node)
 		/* NOTE: Get devnode parent to reach out USB device. */
 		if (CM_Get_Parent(&dev_node, dev_node, 0) != CR_SUCCESS) goto _end;
 	}
-	hw_ids = hid_node_get_property(dev_node, &DEVPKEY_Device_HardwareIds, DEVPROP_TYPE_STRING_LIST);
+	hw_ids = hid_node_get_property(scratch, scratch, dev_node, &DEVPKEY_Device_HardwareIds, DEVPROP_TYPE_STRING_LIST);
 	if (!hw_ids) goto _end;
   /*
    * NOTE:
@@ -303,12 +344,8 @@ hid_usb_get_info(Hid_Device_Info *dev, DEVINST dev_node)
   /* NOTE: Try to get USB device manufacturer string if not provided by HidD_GetManufacturerString. */
   if (!strlen(dev->manufacturer_string))
   {
-    char *m_str = hid_node_get_property(dev_node, &DEVPKEY_Device_Manufacturer, DEVPROP_TYPE_STRING);
-    if (m_str)
-    {
-      heap_free_dz(dev->manufacturer_string);
-      dev->manufacturer_string = m_str;
-    }
+    char *m_str = hid_node_get_property(arena, scratch, dev_node, &DEVPKEY_Device_Manufacturer, DEVPROP_TYPE_STRING);
+    if (m_str) dev->manufacturer_string = m_str;
   }
   /* NOTE: Try to get USB device serial number if not provided by HidD_GetSerialNumberString. */
   if (!strlen(dev->serial_number))
@@ -321,12 +358,11 @@ hid_usb_get_info(Hid_Device_Info *dev, DEVINST dev_node)
        *       Get devnode parent to reach out composite parent USB device.
        *       https://docs.microsoft.com/windows-hardware/drivers/usbcon/enumeration-of-the-composite-parent-device
        */
-      if (CM_Get_Parent(&usb_dev_node, dev_node, 0) != CR_SUCCESS) goto _cleanup;
+      if (CM_Get_Parent(&usb_dev_node, dev_node, 0) != CR_SUCCESS) goto _end;
     }
     /* NOTE: Get the device id of the USB device. */
-    heap_free_dz(dev_id);
-    dev_id = hid_node_get_property(usb_dev_node, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
-    if (!dev_id) goto _cleanup;
+    dev_id = hid_node_get_property(scratch, scratch, usb_dev_node, &DEVPKEY_Device_InstanceId, DEVPROP_TYPE_STRING);
+    if (!dev_id) goto _end;
     /*
      * NOTE:
      *       Extract substring after last '\\' of Instance ID.
@@ -343,49 +379,38 @@ hid_usb_get_info(Hid_Device_Info *dev, DEVINST dev_node)
       if (*ptr == '&') break;
       if (*ptr == '\\')
       {
-        heap_free_dz(dev->serial_number);
-        dev->serial_number = _strdup(ptr + 1);
+        dev->serial_number = arena_strdup(arena, ptr + 1);
         break;
       }
     }
   }
   /* NOTE: If we can't get the interface number, it means that there is only one interface. */
   if (dev->interface_number == -1) dev->interface_number = 0;
-_cleanup:
-  heap_free_dz(hw_ids);
 _end:
-  heap_free_dz(dev_id);
+  arena_temp_end(temp);
 }
 
 static void
-hid_ble_get_info(Hid_Device_Info *dev, DEVINST dev_node)
+hid_ble_get_info(Arena *arena, Arena *scratch, Hid_Device_Info *dev, DEVINST dev_node)
 {
   char    *m_string, *serial_number, *product_string;
   DEVINST parent_dev_node;
 	if (strlen(dev->manufacturer_string) == 0)
   {
 		/* NOTE: Manufacturer Name String (UUID: 0x2A29) */
-		m_string = hid_node_get_property(dev_node, &PKEY_DeviceInterface_Bluetooth_Manufacturer, DEVPROP_TYPE_STRING);
-		if (m_string)
-    {
-			heap_free_dz(dev->manufacturer_string);
-			dev->manufacturer_string = m_string;
-		}
+		m_string = hid_node_get_property(arena, scratch, dev_node, &PKEY_DeviceInterface_Bluetooth_Manufacturer, DEVPROP_TYPE_STRING);
+		if (m_string) dev->manufacturer_string = m_string;
 	}
 	if (strlen(dev->serial_number) == 0)
   {
 		/* NOTE: Serial Number String (UUID: 0x2A25) */
-		serial_number = hid_node_get_property(dev_node, &PKEY_DeviceInterface_Bluetooth_DeviceAddress, DEVPROP_TYPE_STRING);
-		if (serial_number)
-    {
-			heap_free_dz(dev->serial_number);
-			dev->serial_number = serial_number;
-		}
+		serial_number = hid_node_get_property(arena, scratch, dev_node, &PKEY_DeviceInterface_Bluetooth_DeviceAddress, DEVPROP_TYPE_STRING);
+		if (serial_number) dev->serial_number = serial_number;
 	}
 	if (strlen(dev->product_string) == 0)
   {
 		/* NOTE: Model Number String (UUID: 0x2A24) */
-		product_string = hid_node_get_property(dev_node, &PKEY_DeviceInterface_Bluetooth_ModelNumber, DEVPROP_TYPE_STRING);
+		product_string = hid_node_get_property(arena, scratch, dev_node, &PKEY_DeviceInterface_Bluetooth_ModelNumber, DEVPROP_TYPE_STRING);
 		if (!product_string)
     {
 			parent_dev_node = 0;
@@ -393,32 +418,40 @@ hid_ble_get_info(Hid_Device_Info *dev, DEVINST dev_node)
 			if (CM_Get_Parent(&parent_dev_node, dev_node, 0) == CR_SUCCESS)
       {
 				/* NOTE: Device Name (UUID: 0x2A00) */
-				product_string = hid_node_get_property(parent_dev_node, &DEVPKEY_NAME, DEVPROP_TYPE_STRING);
+				product_string = hid_node_get_property(arena, scratch, parent_dev_node, &DEVPKEY_NAME, DEVPROP_TYPE_STRING);
 			}
 		}
-		if (product_string)
-    {
-			heap_free_dz(dev->product_string);
-			dev->product_string = product_string;
-		}
+		if (product_string) dev->product_string = product_string;
 	}
 }
 
-static inline void
-hid_close_info(Hid_Device_Info* info)
+/*
+ * NOTE:
+ *      Enumeration results live in the scan arena and die with it, an opened
+ *      device keeps its own copy of its node (strings packed behind it) so the
+ *      arena can be cleared right after the devices are opened.
+ */
+static Hid_Device_Info*
+hid_info_clone(Hid_Device_Info *info)
 {
-  Hid_Device_Info *d;
-
-  d = info;
-  while (d)
-  {
-    Hid_Device_Info *next = d->next;
-    heap_free_dz(d->serial_number);
-    heap_free_dz(d->product_string);
-    heap_free_dz(d->manufacturer_string);
-    heap_free_dz(d);
-    d = next;
-  }
+  u64             path_len, serial_len, m_len, p_len;
+  char            *strings;
+  Hid_Device_Info *copy;
+
+  path_len   = strlen(info->path) + 1;
+  serial_len = strlen(info->serial_number) + 1;
+  m_len      = strlen(info->manufacturer_string) + 1;
+  p_len      = strlen(info->product_string) + 1;
+  cm_heap_alloc(sizeof(Hid_Device_Info) + path_len + serial_len + m_len + p_len, copy);
+  if (!copy) return NULL;
+  *copy                     = *info;
+  copy->next                = NULL;
+  strings                   = (char*)(copy + 1);
+  copy->path                = memcpy(strings, info->path, path_len);                strings += path_len;
+  copy->serial_number       = memcpy(strings, info->serial_number, serial_len);     strings += serial_len;
+  copy->manufacturer_string = memcpy(strings, info->manufacturer_string, m_len);    strings += m_len;
+  copy->product_string      = memcpy(strings, info->product_string, p_len);
+  return copy;
 }
 
 static inline void
@@ -429,28 +462,31 @@ hid_close_device(Hid_Device* dev)
 	if (!CancelIo(dev->h_dev)) report_error("CancelIo");
 
 	handle_close(dev->h_dev);
-	handle_close(dev->ol.hEvent);
+	handle_close(dev->feature_ol.hEvent);
 	handle_close(dev->read_ol.hEvent);
 	handle_close(dev->write_ol.hEvent);
 
-	heap_free_dz(dev->input.buf);
-	heap_free_dz(dev->output.buf);
-	heap_free_dz(dev->feature.buf);
+	heap_free_dz(dev->pool);
 
-	hid_close_info(dev->device_info);
+	heap_free_dz(dev->device_info);
 	heap_free_dz(dev);
 }
 
+#define HID_POOL_ALIGN(size) (((size) + 63u) & ~63u)
+
 #pragma warning(disable : 4701)
 #pragma warning(disable : 4703)
 static Hid_Device*
 hid_get_device(Hid_Device_Info *hid_info, u32 r_timeout, u32 w_timeout)
 {
+	u32                   input_size, output_size, feature_size;
 	HANDLE                h_dev;
 	HIDP_CAPS             caps;
 	Hid_Device            *dev;
 	PHIDP_PREPARSED_DATA  pp_data;
 
+  dev     = NULL;
+  pp_data = NULL;
   /* NOTE: System devices, keyboards, mice, cannot be opened in rw */
 	h_dev = hid_open_rw(hid_info->path);
 	if (h_dev == INVALID_HANDLE_VALUE) { report_error("hid_open_ro", hid_info->path); goto _end; }
@@ -461,31 +497,44 @@ hid_get_device(Hid_Device_Info *hid_info, u32 r_timeout, u32 w_timeout)
 	if ( !HidD_GetPreparsedData(h_dev, &pp_data) ) { console_debug("HidD_GetPreparsedData"); goto _end; }
 	if ( HidP_GetCaps(pp_data, &caps) != HIDP_STATUS_SUCCESS ) { console_debug("HidP_GetCaps"); goto _cleanup; }
 
-  heap_alloc_dz(sizeof(Hid_Device), dev);
+  cm_heap_alloc(sizeof(Hid_Device), dev);
+  if (!dev) { console_debug("hid_get_device: out of memory"); goto _cleanup; }
 	dev->h_dev = h_dev;
 	h_dev      = NULL;
 
-  memset(&dev->ol,       0, sizeof(dev->ol));
-  memset(&dev->read_ol,  0, sizeof(dev->read_ol));
-  memset(&dev->write_ol, 0, sizeof(dev->write_ol));
+  memset(&dev->feature_ol, 0, sizeof(dev->feature_ol));
+  memset(&dev->read_ol,    0, sizeof(dev->read_ol));
+  memset(&dev->write_ol,   0, sizeof(dev->write_ol));
 
   dev->blocking         = true;
   dev->read_pending     = false;
   /* FIXME: Handle errors for CreateEvent! */
-  dev->ol.hEvent        = CreateEvent(NULL, FALSE, FALSE, NULL);
+  dev->feature_ol.hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
   dev->read_ol.hEvent   = CreateEvent(NULL, FALSE, FALSE, NULL);
   dev->write_ol.hEvent  = CreateEvent(NULL, FALSE, FALSE, NULL);
   dev->read_timeout_ms  = r_timeout;
   dev->write_timeout_ms = w_timeout;
 
   dev->input.size   = caps.InputReportByteLength;
-  dev->device_info  = hid_info;
+  dev->device_info  = hid_info_clone(hid_info);
   dev->output.size  = caps.OutputReportByteLength;
   dev->feature.size = caps.FeatureReportByteLength;
 
-	heap_alloc_dz(dev->input.size, dev->input.buf);
-	heap_alloc_dz(dev->output.size, dev->output.buf);
-	heap_alloc_dz(dev->feature.size, dev->feature.buf);
+  input_size   = HID_POOL_ALIGN(dev->input.size);
+  output_size  = HID_POOL_ALIGN(dev->output.size);
+  feature_size = HID_POOL_ALIGN(dev->feature.size);
+	cm_heap_alloc(input_size + output_size + feature_size, dev->pool);
+  if (!dev->pool || !dev->device_info)
+  {
+    console_debug("hid_get_device: out of memory");
+    /* NOTE: Closes the handle it took over too */
+    hid_close_device(dev);
+    dev = NULL;
+    goto _cleanup;
+  }
+  dev->input.buf   = dev->pool;
+  dev->output.buf  = dev->input.buf  + input_size;
+  dev->feature.buf = dev->output.buf + output_size;
 _cleanup:
 	if (pp_data) { HidD_FreePreparsedData(pp_data); }
 _end:
@@ -496,10 +545,10 @@ _end:
 #pragma warning(default : 4703)
 
 static Hid_Device_Info*
-hid_get_info(char *path, HANDLE h)
+hid_get_info(Arena *arena, Arena *scratch, char *path, HANDLE h)
 {
 	u32                   len, size;
-	char                  string[MAX_STRING_CHARS + 1];
+	wchar_t               string[MAX_STRING_CHARS + 1];
 	HIDP_CAPS             caps;
 	Hid_Device_Info       *dev;
 	HIDD_ATTRIBUTES       attrib;
@@ -507,9 +556,10 @@ hid_get_info(char *path, HANDLE h)
 	PHIDP_PREPARSED_DATA  pp_data = NULL;
 
   attrib.Size = sizeof(HIDD_ATTRIBUTES);
-  heap_alloc_dz(sizeof(Hid_Device_Info), dev);
+  dev = arena_push_struct(arena, Hid_Device_Info);
+  if (!dev) return NULL;
 	dev->next             = NULL;
-	dev->path             = path;
+	dev->path             = arena_strdup(arena, path);
 	dev->interface_number = -1;
 	if (HidD_GetAttributes(h, &attrib))
   {
@@ -532,36 +582,39 @@ hid_get_info(char *path, HANDLE h)
   else console_debug("HidD_GetPreparsedData");
 
 	/* NOTE: detect bus type before reading string descriptors */
-	dbtype      = hid_get_bus_type(path);
+	dbtype      = hid_get_bus_type(scratch, path);
 	dev->type   = dbtype.type;
 
+  /* NOTE: HidD_Get*String fill UTF-16, `size` is in bytes */
 	len         = (dev->type == HID_BUS_USB) ? MAX_STRING_CHARS_USB : MAX_STRING_CHARS;
-	size        = len * sizeof(char);
-	string[len] = '\0';
+	size        = len * sizeof(wchar_t);
+	string[len] = L'\0';
 
-	string[0] = '\0';
+	string[0] = L'\0';
 	if (!HidD_GetSerialNumberString(h, string, size)) console_debug("HidD_GetSerialNumberString");
-	dev->serial_number = _strdup(string);
+	dev->serial_number = hid_property_to_chars(arena, string, (u32)((wcslen(string) + 1) * sizeof(wchar_t)));
 
-	string[0] = '\0';
+	string[0] = L'\0';
 	if (!HidD_GetManufacturerString(h, string, size)) console_debug("HidD_GetManufacturerString");
-	dev->manufacturer_string = _strdup(string);
+	dev->manufacturer_string = hid_property_to_chars(arena, string, (u32)((wcslen(string) + 1) * sizeof(wchar_t)));
 
-	string[0] = '\0';
+	string[0] = L'\0';
 	if (!HidD_GetProductString(h, string, size)) console_debug("HidD_GetProductString");
-	dev->product_string = _strdup(string);
+	dev->product_string = hid_property_to_chars(arena, string, (u32)((wcslen(string) + 1) * sizeof(wchar_t)));
+
+  if (!dev->path || !dev->serial_number || !dev->manufacturer_string || !dev->product_string) return NULL;
 
   /* NOTE: String descriptors */
   switch (dev->type)
   {
     case HID_BUS_USB: 
     {
-      hid_usb_get_info(dev, dbtype.dev_node);
+      hid_usb_get_info(arena, scratch, dev, dbtype.dev_node);
       break;
     }
     case HID_BUS_BL:
     {
-      if (dbtype.flags & HID_BUS_FLAG_BLE) hid_ble_get_info(dev, dbtype.dev_node);
+      if (dbtype.flags & HID_BUS_FLAG_BLE) hid_ble_get_info(arena, scratch, dev, dbtype.dev_node);
       break;
     }
     case HID_BUS_SPI:
@@ -573,14 +626,21 @@ hid_get_info(char *path, HANDLE h)
 	return dev;
 }
 
+/*
+ * NOTE:
+ *      The returned list and all of its strings are pushed on `arena`, the
+ *      interface list and property lookups only live in `scratch`. Release
+ *      everything with arena_clear: a rescan then reuses the same pages.
+ */
 static Hid_Device_Info*
-hid_enumerate(u16 v_id, u16 p_id)
+hid_enumerate(Arena *arena, Arena *scratch, u16 v_id, u16 p_id)
 {
   char            *idev_list;
   GUID            iguid;
   u32             len;
   HANDLE          h_dev;
   CONFIGRET       cr;
+  Arena_Temp      temp;
   Hid_Device_Info *root, *current, *tmp;
   HIDD_ATTRIBUTES attrib;
 
@@ -588,17 +648,19 @@ hid_enumerate(u16 v_id, u16 p_id)
   root      = NULL;
   current   = NULL;
   idev_list = NULL;
+  temp      = arena_temp_begin(scratch);
   HidD_GetHidGuid(&iguid);
   do {
     cr = hid_interface_list_get_size(&len, &iguid);
     if ( cr != CR_SUCCESS) break;
 
-    if (idev_list) heap_free_dz(idev_list);
-    heap_alloc_dz(len * sizeof(char) + 1, idev_list);
+    arena_temp_end(temp);
+    idev_list = arena_push(scratch, len * sizeof(char) + 1);
+    if (!idev_list) { cr = CR_BUFFER_SMALL; break; }
     cr = idev_get_list(&iguid, idev_list, len);
   } while(cr == CR_BUFFER_SMALL);
 
-  if (cr != CR_SUCCESS) goto cleanup;
+  if (cr != CR_SUCCESS || !idev_list) goto cleanup;
 
   for (char *idev = idev_list; *idev; idev += strlen(idev) + 1)
   {
@@ -609,7 +671,7 @@ hid_enumerate(u16 v_id, u16 p_id)
     {
       if ( (v_id == 0x0 || attrib.VendorID == v_id) && (p_id == 0x0 || attrib.ProductID == p_id) )
       {
-        tmp = hid_get_info(idev, h_dev);
+        tmp = hid_get_info(arena, scratch, idev, h_dev);
         if (tmp)
         {
           if (current) current->next = tmp;
@@ -623,7 +685,7 @@ hid_enumerate(u16 v_id, u16 p_id)
     handle_close(h_dev);
   }
 cleanup:
-  heap_free_dz(idev_list);
+  arena_temp_end(temp);
   return root;
 }
 
@@ -653,7 +715,8 @@ hid_send_report(Hid_Device* hid_dev, HidReport data, i32 type)
 	if (data.size <= dev_payload.size)
   {
     payload = dev_payload;
-		memcpy(payload.buf, data.buf, data.size);
+    /* NOTE: Reports built in place in the device's own buffer skip the copy */
+		if (data.buf != payload.buf) memcpy(payload.buf, data.buf, data.size);
 		memset(payload.buf + data.size, 0, payload.size - data.size);
 	}
 	if (!HidD_SetFeature(hid_dev->h_dev, payload.buf, payload.size))
@@ -664,60 +727,175 @@ hid_send_report(Hid_Device* hid_dev, HidReport data, i32 type)
 	return payload.size;
 }
 
+/*
+ * NOTE:
+ *      Non-blocking halves of hid_read/hid_write. `_start` issues the overlapped
+ *      request and returns HID_IO_DONE when it completed synchronously,
+ *      HID_IO_PENDING when the caller has to wait on the matching OVERLAPPED
+ *      event and then call `_finish`.
+ */
+#define HID_IO_ERROR   -1
+#define HID_IO_PENDING  0
+#define HID_IO_DONE     1
+#define HID_IO_GONE     2
+
+static inline i32
+hid_io_error(char *what)
+{
+  u32 error;
+
+  error = GetLastError();
+  if (error == ERROR_DEVICE_NOT_CONNECTED || error == ERROR_OPERATION_ABORTED) return HID_IO_GONE;
+  report_error(what);
+  return HID_IO_ERROR;
+}
+
+static i32
+hid_read_start(Hid_Device* hid_dev, Hid_Report data, u32 *read)
+{
+  *read = 0;
+  if (hid_dev->read_pending) return HID_IO_PENDING;
+  if (!ReadFile(hid_dev->h_dev, data.buf, data.size, read, &hid_dev->read_ol))
+  {
+    if (GetLastError() != ERROR_IO_PENDING) return hid_io_error("ReadFile");
+    hid_dev->read_pending = true;
+    return HID_IO_PENDING;
+  }
+  return HID_IO_DONE;
+}
+
+static i32
+hid_read_finish(Hid_Device* hid_dev, u32 *read)
+{
+  *read = 0;
+  if (!hid_dev->read_pending) return HID_IO_PENDING;
+  if (!GetOverlappedResult(hid_dev->h_dev, &hid_dev->read_ol, read, FALSE))
+  {
+    if (GetLastError() == ERROR_IO_INCOMPLETE) return HID_IO_PENDING;
+    hid_dev->read_pending = false;
+    return hid_io_error("GetOverlappedResult");
+  }
+  hid_dev->read_pending = false;
+  return HID_IO_DONE;
+}
+
+static i32
+hid_write_start(Hid_Device* hid_dev, Hid_Report data, u32 *written)
+{
+  cm_stack_mark(&data);
+  *written = 0;
+  if (!WriteFile(hid_dev->h_dev, data.buf, data.size, written, &hid_dev->write_ol))
+  {
+    if (GetLastError() != ERROR_IO_PENDING) return hid_io_error("WriteFile");
+    return HID_IO_PENDING;
+  }
+  return HID_IO_DONE;
+}
+
+static i32
+hid_write_finish(Hid_Device* hid_dev, u32 *written)
+{
+  *written = 0;
+  if (!GetOverlappedResult(hid_dev->h_dev, &hid_dev->write_ol, written, FALSE))
+  {
+    if (GetLastError() == ERROR_IO_INCOMPLETE) return HID_IO_PENDING;
+    return hid_io_error("GetOverlappedResult");
+  }
+  return HID_IO_DONE;
+}
+
+/*
+ * NOTE:
+ *      Feature reports through IOCTL_HID_GET_FEATURE / IOCTL_HID_SET_FEATURE
+ *      on `feature_ol`, so they complete like reads and writes instead of
+ *      blocking in HidD_SetFeature. For a get, `data.buf[0]` holds the report id.
+ *      One feature request in flight per device.
+ */
+static i32
+hid_feature_start(Hid_Device* hid_dev, Hid_Report data, u32 ioctl, u32 *total)
+{
+  bool ok;
+
+  cm_stack_mark(&ok);
+  *total = 0;
+  if (hid_dev->feature_pending) return HID_IO_PENDING;
+  if (ioctl == IOCTL_HID_SET_FEATURE)
+    ok = DeviceIoControl(hid_dev->h_dev, ioctl, data.buf, data.size, NULL, 0, total, &hid_dev->feature_ol);
+  else
+    ok = DeviceIoControl(hid_dev->h_dev, ioctl, data.buf, data.size, data.buf, data.size, total, &hid_dev->feature_ol);
+  if (!ok)
+  {
+    if (GetLastError() != ERROR_IO_PENDING) return hid_io_error("DeviceIoControl");
+    hid_dev->feature_pending = true;
+    return HID_IO_PENDING;
+  }
+  return HID_IO_DONE;
+}
+
+static i32
+hid_feature_finish(Hid_Device* hid_dev, u32 *total)
+{
+  *total = 0;
+  if (!hid_dev->feature_pending) return HID_IO_PENDING;
+  if (!GetOverlappedResult(hid_dev->h_dev, &hid_dev->feature_ol, total, FALSE))
+  {
+    if (GetLastError() == ERROR_IO_INCOMPLETE) return HID_IO_PENDING;
+    hid_dev->feature_pending = false;
+    return hid_io_error("GetOverlappedResult");
+  }
+  hid_dev->feature_pending = false;
+  return HID_IO_DONE;
+}
+
+/* NOTE: Blocking variant, waits on the device's own OVERLAPPED event. */
 static i64
-hid_get_report(HANDLE h, Hid_Report d, i32 type)
+hid_get_report(Hid_Device* hid_dev, Hid_Report d, i32 type)
 {
-	u32         total;
-	OVERLAPPED  ol;
+	u32 total;
+	i32 status;
 
 	if (!d.buf || !d.size) return -1;
-  total = 0;
-	memset(&ol, 0, sizeof(ol));
-  d.buf[0] = 0x06;
-  if (!DeviceIoControl(h, type, d.buf, d.size, d.buf, d.size, &total, &ol))
+  status = hid_feature_start(hid_dev, d, (u32) type, &total);
+  if (status == HID_IO_PENDING)
   {
-		if (GetLastError() != ERROR_IO_PENDING)
+    if (WaitForSingleObject(hid_dev->feature_ol.hEvent, INFINITE) != WAIT_OBJECT_0)
     {
-      report_error("DeviceIoControl");
+      report_error("WaitForSingleObject");
       return -1;
     }
+    status = hid_feature_finish(hid_dev, &total);
   }
-	if (!GetOverlappedResult(h, &ol, &total, TRUE))
-  {
-    report_error("GetOverLappedResult");
-		return -1;
-	}
+  if (status != HID_IO_DONE) return -1;
   /* NOTE: If no numbered reports, `total` does not seem to include the first byte with 0 */
 	if (d.buf[0] == 0x0) total++;
 	return total;
 }
 
-#define hid_get_feature_report(h, d) hid_get_report((h), (d), IOCTL_HID_GET_FEATURE)
-#define hid_get_input_report(h, d) hid_get_report((h), (d), IOCTL_HID_GET_INPUT_REPORT)
+#define hid_get_feature_report(dev, d) hid_get_report((dev), (d), IOCTL_HID_GET_FEATURE)
+#define hid_get_input_report(dev, d) hid_get_report((dev), (d), IOCTL_HID_GET_INPUT_REPORT)
 
+/*
+ * NOTE:
+ *      A read that timed out stays queued in the driver, `read_pending` makes
+ *      sure we wait on it again instead of issuing a second ReadFile with the
+ *      same OVERLAPPED.
+ */
 static i64
 hid_read(Hid_Device* hid_dev, Hid_Report data)
 {
   u32 read;
-  if (!ReadFile(hid_dev->h_dev, data.buf, data.size, &read, &hid_dev->read_ol))
+  i32 status;
+
+  status = hid_read_start(hid_dev, data, &read);
+  if (status == HID_IO_DONE)    return read;
+  if (status != HID_IO_PENDING) return -1;
+  switch (WaitForSingleObject(hid_dev->read_ol.hEvent, hid_dev->read_timeout_ms))
   {
-    if (GetLastError() != ERROR_IO_PENDING)
-    {
-      report_error("ReadFile");
-      return -1;
-    }
-    switch (WaitForSingleObject(hid_dev->read_ol.hEvent, hid_dev->read_timeout_ms))
-    {
-      case WAIT_TIMEOUT:  return -2;
-      case WAIT_OBJECT_0: break;
-      default: report_error("WaitForSingleObject"); return -1;
-    }
-    if (!GetOverlappedResult(hid_dev->h_dev, &hid_dev->read_ol, &read, FALSE))
-    {
-      report_error("GetOverlappedResult");
-      return -1;
-    }
+    case WAIT_TIMEOUT:  return -2;
+    case WAIT_OBJECT_0: break;
+    default: report_error("WaitForSingleObject"); return -1;
   }
+  if (hid_read_finish(hid_dev, &read) != HID_IO_DONE) return -1;
   return read;
 }
 
@@ -738,7 +916,7 @@ hid_write(Hid_Device* hid_dev, Hid_Report data)
   if (payload.size <= hid_dev->output.size)
   {
     payload = hid_dev->output;
-    memcpy(payload.buf, data.buf, data.size);
+    if (data.buf != payload.buf) memcpy(payload.buf, data.buf, data.size);
     memset(payload.buf + data.size, 0, payload.size - data.size);
   }
 	if (!WriteFile(hid_dev->h_dev, payload.buf, payload.size, &written, &hid_dev->write_ol))
@@ -0,0 +1,133 @@
+#ifndef CM_IMAGE_C
+#define CM_IMAGE_C
+
+/*
+ * NOTE:
+ *      8-bit RGB pixels, tightly packed rows. Small helpers to turn one key
+ *      image into another (scaled, darkened) before it is encoded again.
+ */
+#pragma warning(disable : 4820)
+typedef struct Image
+{
+  u32 w, h;
+  u8  *pixels;                               /* NOTE: w * h * 3 */
+} Image;
+#pragma warning(default : 4820)
+
+static bool
+image_alloc(Image *image, u32 w, u32 h)
+{
+  image->w      = w;
+  image->h      = h;
+  image->pixels = NULL;
+  cm_heap_alloc((u64) w * h * 3, image->pixels);
+  if (!image->pixels) { report_error("image_alloc"); return false; }
+  return true;
+}
+
+static void
+image_free(Image *image)
+{
+  if (image->pixels) heap_free_dz(image->pixels);
+  memset(image, 0, sizeof(Image));
+}
+
+/* NOTE: Bilinear, good enough for the few percent a key image is shrunk by. */
+static void
+image_scale_into(Image *src, u8 *dst, u32 dst_stride, u32 w, u32 h)
+{
+  u32 x, y, c, x0, y0, x1, y1, fx, fy;
+  u8  *p00, *p01, *p10, *p11, *out;
+  u64 sx, sy;
+
+  for (y = 0; y < h; y++)
+  {
+    sy = h > 1 ? ((u64) y * (src->h - 1) << 8) / (h - 1) : 0;
+    y0 = (u32)(sy >> 8);
+    fy = (u32)(sy & 0xFF);
+    y1 = y0 + 1 < src->h ? y0 + 1 : y0;
+    out = dst + (u64) y * dst_stride;
+    for (x = 0; x < w; x++)
+    {
+      sx = w > 1 ? ((u64) x * (src->w - 1) << 8) / (w - 1) : 0;
+      x0 = (u32)(sx >> 8);
+      fx = (u32)(sx & 0xFF);
+      x1 = x0 + 1 < src->w ? x0 + 1 : x0;
+      p00 = src->pixels + ((u64) y0 * src->w + x0) * 3;
+      p01 = src->pixels + ((u64) y0 * src->w + x1) * 3;
+      p10 = src->pixels + ((u64) y1 * src->w + x0) * 3;
+      p11 = src->pixels + ((u64) y1 * src->w + x1) * 3;
+      for (c = 0; c < 3; c++)
+      {
+        *out++ = (u8)(((p00[c] * (256 - fx) + p01[c] * fx) * (256 - fy)
+                     + (p10[c] * (256 - fx) + p11[c] * fx) * fy + (1 << 15)) >> 16);
+      }
+    }
+  }
+}
+
+static bool
+image_resize(Image *src, Image *dst, u32 w, u32 h)
+{
+  if (!image_alloc(dst, w, h)) return false;
+  image_scale_into(src, dst->pixels, w * 3, w, h);
+  return true;
+}
+
+/* NOTE: `dst` is `src` shrunk to `percent` of its size, centered on black. */
+static bool
+image_inset(Image *src, Image *dst, u32 percent)
+{
+  u32 w, h, x, y;
+
+  if (!image_alloc(dst, src->w, src->h)) return false;
+  memset(dst->pixels, 0, (u64) dst->w * dst->h * 3);
+  if (percent > 100) percent = 100;
+  w = src->w * percent / 100;
+  h = src->h * percent / 100;
+  if (!w || !h) return true;
+  x = (src->w - w) / 2;
+  y = (src->h - h) / 2;
+  image_scale_into(src, dst->pixels + ((u64) y * dst->w + x) * 3, dst->w * 3, w, h);
+  return true;
+}
+
+/* NOTE: Scales every channel to `percent`, in place. */
+static void
+image_darken(Image *image, u32 percent)
+{
+  u64 i, n;
+
+  if (percent > 100) percent = 100;
+  n = (u64) image->w * image->h * 3;
+  for (i = 0; i < n; i++) image->pixels[i] = (u8)((image->pixels[i] * percent + 50) / 100);
+}
+
+/* NOTE: `dst` is `src` turned clockwise `quarters` times. */
+static bool
+image_rotate(Image *src, Image *dst, u32 quarters)
+{
+  u32 x, y, dx, dy, w, h;
+
+  quarters &= 3;
+  w = (quarters & 1) ? src->h : src->w;
+  h = (quarters & 1) ? src->w : src->h;
+  if (!image_alloc(dst, w, h)) return false;
+  for (y = 0; y < src->h; y++)
+  {
+    for (x = 0; x < src->w; x++)
+    {
+      switch (quarters)
+      {
+        case 1:  dx = src->h - 1 - y; dy = x;              break;
+        case 2:  dx = src->w - 1 - x; dy = src->h - 1 - y; break;
+        case 3:  dx = y;              dy = src->w - 1 - x; break;
+        default: dx = x;              dy = y;              break;
+      }
+      memcpy(dst->pixels + ((u64) dy * w + dx) * 3, src->pixels + ((u64) y * src->w + x) * 3, 3);
+    }
+  }
+  return true;
+}
+
+#endif // CM_IMAGE_C
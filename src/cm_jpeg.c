@@ -0,0 +1,1078 @@
+#ifndef CM_JPEG_C
+#define CM_JPEG_C
+
+/*
+ * NOTE:
+ *      Small baseline JPEG codec, enough for key images:
+ *        - decode: baseline / extended / progressive huffman, 8-bit, 1 or 3
+ *          components, any sampling factors, restart intervals. Optionally
+ *          scaled by 1/2, 1/4 or 1/8 right in the inverse DCT (only the low
+ *          frequencies are transformed), so a photo bound for a key is never
+ *          decoded at full size.
+ *        - encode: baseline 4:4:4 with the standard tables, libjpeg quality.
+ *      Floating point separable DCT, key images are a few dozen blocks.
+ *      Progressive scans are gathered as coefficients and transformed once
+ *      the last one is in.
+ */
+#pragma warning(push, 0)
+#include <math.h>
+#pragma warning(pop)
+
+#define JPEG_MAX_COMPONENTS 3
+
+global u8 g_jpeg_zigzag[64] =
+{
+   0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/* NOTE: cos((2x + 1) u pi / 2n) * C(u) / 2 for n = 8 >> shift, indexed [shift][x][u] */
+global f32  g_jpeg_dct[4][8][8];
+global bool g_jpeg_dct_ready;
+
+#pragma warning(disable : 4820)
+typedef struct JpegHuffman
+{
+  u8  lookup_len[512];                       /* NOTE: 9-bit fast path, 0 = slow path */
+  u8  lookup_val[512];
+  i32 maxcode[18];
+  i32 valptr[17];
+  u16 mincode[17];
+  u8  vals[256];
+  bool present;
+} JpegHuffman, Jpeg_Huffman;
+
+typedef struct JpegComponent
+{
+  u8  id, h, v, tq, td, ta;
+  i32 dc_pred;
+  u32 stride;                                /* NOTE: plane width, in pixels */
+  u8  *plane;
+  u32 blocks_w, blocks_h;                    /* NOTE: Whole MCUs */
+  i16 *coefs;                                /* NOTE: Progressive: 64 per block, zigzag order, quantized */
+} JpegComponent, Jpeg_Component;
+
+typedef struct JpegDecoder
+{
+  u8             *at, *end;
+  u32            bits;
+  u32            bit_count;
+  bool           marker_hit;
+  u16            qt[4][64];
+  Jpeg_Huffman   dc[4], ac[4];
+  Jpeg_Component comps[JPEG_MAX_COMPONENTS];
+  u32            comp_count;
+  u32            w, h, hmax, vmax, mcux, mcuy;
+  u32            restart_interval;
+  u32            shift;                      /* NOTE: Blocks come out 8 >> shift pixels wide */
+  u32            out_w, out_h;
+  bool           progressive;
+  u32            ss, se, ah, al;             /* NOTE: Spectral selection and successive approximation of the scan */
+  u32            eobrun;
+} JpegDecoder, Jpeg_Decoder;
+#pragma warning(default : 4820)
+
+static void
+jpeg_dct_init(void)
+{
+  u32 shift, n, x, u;
+  f64 cu;
+
+  if (g_jpeg_dct_ready) return;
+  for (shift = 0; shift < 4; shift++)
+  {
+    n = 8 >> shift;
+    for (x = 0; x < n; x++)
+    {
+      for (u = 0; u < n; u++)
+      {
+        cu = u ? 1.0 : 0.70710678118654752;
+        g_jpeg_dct[shift][x][u] = (f32)(cu / 2.0 * cos((2.0 * x + 1.0) * u * 3.14159265358979323846 / (2.0 * n)));
+      }
+    }
+  }
+  g_jpeg_dct_ready = true;
+}
+
+/* -- Decoder ------------------------------------------------------------------------ */
+
+/* NOTE: False when `counts` hold more codes than `len` bits can tell apart (corrupt DHT), nothing is usable then. */
+static bool
+jpeg_huffman_build(Jpeg_Huffman *huff, u8 *counts)
+{
+  u32 len, i, k, code, shift, fill;
+
+  memset(huff->lookup_len, 0, sizeof(huff->lookup_len));
+  huff->present = false;
+  code = 0;
+  k    = 0;
+  for (len = 1; len <= 16; len++)
+  {
+    /* NOTE: Checked before the fast tables are filled, an oversubscribed length would write past them */
+    if (code + counts[len - 1] > (1u << len)) return false;
+    huff->valptr[len]  = (i32) k;
+    huff->mincode[len] = (u16) code;
+    for (i = 0; i < counts[len - 1]; i++, k++, code++)
+    {
+      if (len <= 9)
+      {
+        shift = 9 - len;
+        for (fill = 0; fill < (1u << shift); fill++)
+        {
+          huff->lookup_len[(code << shift) | fill] = (u8) len;
+          huff->lookup_val[(code << shift) | fill] = huff->vals[k];
+        }
+      }
+    }
+    huff->maxcode[len] = counts[len - 1] ? (i32)(code - 1) : -1;
+    code <<= 1;
+  }
+  huff->maxcode[17] = 0x7FFFFFFF;
+  huff->present     = true;
+  return true;
+}
+
+static inline void
+jpeg_fill(Jpeg_Decoder *dec)
+{
+  u32 byte;
+
+  while (dec->bit_count <= 24)
+  {
+    byte = 0;
+    if (!dec->marker_hit && dec->at < dec->end)
+    {
+      byte = *dec->at;
+      if (byte == 0xFF)
+      {
+        if (dec->at + 1 < dec->end && dec->at[1] == 0x00) dec->at += 2;
+        else { dec->marker_hit = true; byte = 0; }
+      }
+      else dec->at++;
+    }
+    dec->bits      |= byte << (24 - dec->bit_count);
+    dec->bit_count += 8;
+  }
+}
+
+static inline u32
+jpeg_bits(Jpeg_Decoder *dec, u32 n)
+{
+  u32 value;
+
+  if (!n) return 0;
+  jpeg_fill(dec);
+  value            = dec->bits >> (32 - n);
+  dec->bits      <<= n;
+  dec->bit_count  -= n;
+  return value;
+}
+
+static inline i32
+jpeg_extend(u32 value, u32 n)
+{
+  return (n && value < (1u << (n - 1))) ? (i32) value - (i32)((1u << n) - 1) : (i32) value;
+}
+
+/* NOTE: Returns the decoded symbol, -1 on a corrupt code. */
+static i32
+jpeg_decode_symbol(Jpeg_Decoder *dec, Jpeg_Huffman *huff)
+{
+  u32 len, code, peek;
+
+  jpeg_fill(dec);
+  peek = dec->bits >> 23;
+  len  = huff->lookup_len[peek];
+  if (len)
+  {
+    dec->bits      <<= len;
+    dec->bit_count  -= len;
+    return huff->lookup_val[peek];
+  }
+  code = 0;
+  for (len = 1; len <= 16; len++)
+  {
+    code = (code << 1) | (dec->bits >> 31);
+    dec->bits <<= 1;
+    dec->bit_count--;
+    if (huff->maxcode[len] >= 0 && (i32) code <= huff->maxcode[len])
+    {
+      return huff->vals[huff->valptr[len] + (i32)(code - huff->mincode[len])];
+    }
+  }
+  return -1;
+}
+
+/*
+ * NOTE:
+ *      Dequantized coefficients in natural order -> (8 >> shift)^2 pixels at
+ *      `out`. Scaled down, only the frequencies that still fit are used.
+ */
+static void
+jpeg_idct_block(f32 *coefs, u8 *out, u32 stride, u32 shift)
+{
+  u32 x, y, u, n;
+  f32 tmp[64], sum, (*dct)[8];
+  i32 value;
+
+  n   = 8 >> shift;
+  dct = g_jpeg_dct[shift];
+  for (y = 0; y < n; y++)
+  {
+    for (x = 0; x < n; x++)
+    {
+      sum = 0.0f;
+      for (u = 0; u < n; u++) sum += dct[x][u] * coefs[y * 8 + u];
+      tmp[y * 8 + x] = sum;
+    }
+  }
+  for (x = 0; x < n; x++)
+  {
+    for (y = 0; y < n; y++)
+    {
+      sum = 0.0f;
+      for (u = 0; u < n; u++) sum += dct[y][u] * tmp[u * 8 + x];
+      value = (i32)(sum + 128.5f);
+      out[y * stride + x] = (u8)(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+  }
+}
+
+/* NOTE: Baseline: block (`bx`, `by`) of `comp` straight to its plane. */
+static bool
+jpeg_decode_block(Jpeg_Decoder *dec, Jpeg_Component *comp, u32 bx, u32 by)
+{
+  i32 symbol, run, size, k;
+  u32 n;
+  f32 coefs[64];
+  u16 *qt;
+
+  cm_stack_mark(coefs);
+  memset(coefs, 0, sizeof(coefs));
+  qt     = dec->qt[comp->tq];
+  symbol = jpeg_decode_symbol(dec, &dec->dc[comp->td]);
+  if (symbol < 0 || symbol > 11) return false;
+  comp->dc_pred += jpeg_extend(jpeg_bits(dec, (u32) symbol), (u32) symbol);
+  coefs[0] = (f32)(comp->dc_pred * qt[0]);
+  for (k = 1; k < 64;)
+  {
+    symbol = jpeg_decode_symbol(dec, &dec->ac[comp->ta]);
+    if (symbol < 0) return false;
+    run  = symbol >> 4;
+    size = symbol & 0x0F;
+    if (!size)
+    {
+      if (run != 15) break;
+      k += 16;
+      continue;
+    }
+    k += run;
+    if (k > 63) return false;
+    coefs[g_jpeg_zigzag[k]] = (f32)(jpeg_extend(jpeg_bits(dec, (u32) size), (u32) size) * qt[k]);
+    k++;
+  }
+  n = 8 >> dec->shift;
+  jpeg_idct_block(coefs, comp->plane + (u64) by * n * comp->stride + bx * n, comp->stride, dec->shift);
+  return true;
+}
+
+/* NOTE: Progressive DC scan, first pass or one more bit. */
+static bool
+jpeg_decode_dc_prog(Jpeg_Decoder *dec, Jpeg_Component *comp, i16 *blk)
+{
+  i32 symbol;
+
+  if (dec->ah)
+  {
+    if (jpeg_bits(dec, 1)) blk[0] |= (i16)(1 << dec->al);
+    return true;
+  }
+  symbol = jpeg_decode_symbol(dec, &dec->dc[comp->td]);
+  if (symbol < 0 || symbol > 11) return false;
+  comp->dc_pred += jpeg_extend(jpeg_bits(dec, (u32) symbol), (u32) symbol);
+  blk[0] = (i16)(comp->dc_pred * (1 << dec->al));
+  return true;
+}
+
+/* NOTE: Progressive AC scan, first pass over [ss, se]. A run of empty blocks is counted in `eobrun`. */
+static bool
+jpeg_decode_ac_first(Jpeg_Decoder *dec, Jpeg_Component *comp, i16 *blk)
+{
+  i32 symbol, run, size;
+  u32 k;
+
+  if (dec->eobrun) { dec->eobrun--; return true; }
+  for (k = dec->ss; k <= dec->se;)
+  {
+    symbol = jpeg_decode_symbol(dec, &dec->ac[comp->ta]);
+    if (symbol < 0) return false;
+    run  = symbol >> 4;
+    size = symbol & 0x0F;
+    if (!size)
+    {
+      if (run < 15)
+      {
+        dec->eobrun = (1u << run) - 1;
+        if (run) dec->eobrun += jpeg_bits(dec, (u32) run);
+        break;
+      }
+      k += 16;
+      continue;
+    }
+    k += (u32) run;
+    if (k > 63) return false;
+    blk[k++] = (i16)(jpeg_extend(jpeg_bits(dec, (u32) size), (u32) size) * (1 << dec->al));
+  }
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Progressive AC scan, one more bit: coefficients already non zero get
+ *      a correction bit each, new ones (always +-1 << al) land after `run`
+ *      zero ones.
+ */
+static bool
+jpeg_decode_ac_refine(Jpeg_Decoder *dec, Jpeg_Component *comp, i16 *blk)
+{
+  i32 symbol, run, value, bit;
+  u32 k;
+  i16 *p;
+
+  bit = 1 << dec->al;
+  k   = dec->ss;
+  while (!dec->eobrun && k <= dec->se)
+  {
+    symbol = jpeg_decode_symbol(dec, &dec->ac[comp->ta]);
+    if (symbol < 0) return false;
+    run   = symbol >> 4;
+    value = 0;
+    if (!(symbol & 0x0F))
+    {
+      if (run < 15)
+      {
+        /* NOTE: This block included, the rest of it is refined below */
+        dec->eobrun = 1u << run;
+        if (run) dec->eobrun += jpeg_bits(dec, (u32) run);
+        break;
+      }
+    }
+    else
+    {
+      if ((symbol & 0x0F) != 1) return false;
+      value = jpeg_bits(dec, 1) ? bit : -bit;
+    }
+    while (k <= dec->se)
+    {
+      p = &blk[k++];
+      if (*p)
+      {
+        if (jpeg_bits(dec, 1) && !(*p & bit)) *p += (i16)(*p > 0 ? bit : -bit);
+      }
+      else
+      {
+        if (!run) { *p = (i16) value; break; }
+        run--;
+      }
+    }
+  }
+  if (dec->eobrun)
+  {
+    for (; k <= dec->se; k++)
+    {
+      p = &blk[k];
+      if (*p && jpeg_bits(dec, 1) && !(*p & bit)) *p += (i16)(*p > 0 ? bit : -bit);
+    }
+    dec->eobrun--;
+  }
+  return true;
+}
+
+static inline bool
+jpeg_scan_block(Jpeg_Decoder *dec, Jpeg_Component *comp, u32 bx, u32 by)
+{
+  i16 *blk;
+
+  if (!dec->progressive) return jpeg_decode_block(dec, comp, bx, by);
+  blk = comp->coefs + ((u64) by * comp->blocks_w + bx) * 64;
+  if (!dec->ss)  return jpeg_decode_dc_prog(dec, comp, blk);
+  if (!dec->ah)  return jpeg_decode_ac_first(dec, comp, blk);
+  return jpeg_decode_ac_refine(dec, comp, blk);
+}
+
+/* NOTE: Progressive: every scan is in, dequantize and transform all the blocks. */
+static void
+jpeg_progressive_output(Jpeg_Decoder *dec)
+{
+  u32            i, k, n, bx, by;
+  f32            coefs[64];
+  u16            *qt;
+  i16            *blk;
+  Jpeg_Component *comp;
+
+  n = 8 >> dec->shift;
+  for (i = 0; i < dec->comp_count; i++)
+  {
+    comp = &dec->comps[i];
+    qt   = dec->qt[comp->tq];
+    for (by = 0; by < comp->blocks_h; by++)
+    {
+      for (bx = 0; bx < comp->blocks_w; bx++)
+      {
+        blk = comp->coefs + ((u64) by * comp->blocks_w + bx) * 64;
+        for (k = 0; k < 64; k++) coefs[g_jpeg_zigzag[k]] = (f32)(blk[k] * qt[k]);
+        jpeg_idct_block(coefs, comp->plane + (u64) by * n * comp->stride + bx * n, comp->stride, dec->shift);
+      }
+    }
+  }
+}
+
+static inline u32
+jpeg_u16(u8 *p)
+{
+  return ((u32) p[0] << 8) | p[1];
+}
+
+/* NOTE: Skips to the byte after the next RSTn marker and resets the predictors. */
+static bool
+jpeg_restart(Jpeg_Decoder *dec)
+{
+  u32 i;
+
+  while (dec->at + 1 < dec->end && !(dec->at[0] == 0xFF && dec->at[1] >= 0xD0 && dec->at[1] <= 0xD7)) dec->at++;
+  if (dec->at + 1 >= dec->end) return false;
+  dec->at        += 2;
+  dec->bits       = 0;
+  dec->bit_count  = 0;
+  dec->marker_hit = false;
+  dec->eobrun     = 0;
+  for (i = 0; i < dec->comp_count; i++) dec->comps[i].dc_pred = 0;
+  return true;
+}
+
+static bool
+jpeg_decode_scan(Jpeg_Decoder *dec, Jpeg_Component **scan, u32 scan_count)
+{
+  u32            mx, my, i, bx, by, mcus;
+  Jpeg_Component *comp;
+
+  mcus = 0;
+  if (scan_count == 1)
+  {
+    /* NOTE: Non interleaved, one block per MCU over the component's own grid */
+    comp = scan[0];
+    for (my = 0; my < (dec->h * comp->v + dec->vmax * 8 - 1) / (dec->vmax * 8); my++)
+    {
+      for (mx = 0; mx < (dec->w * comp->h + dec->hmax * 8 - 1) / (dec->hmax * 8); mx++)
+      {
+        if (dec->restart_interval && mcus && !(mcus % dec->restart_interval) && !jpeg_restart(dec)) return false;
+        if (!jpeg_scan_block(dec, comp, mx, my)) return false;
+        mcus++;
+      }
+    }
+    return true;
+  }
+  for (my = 0; my < dec->mcuy; my++)
+  {
+    for (mx = 0; mx < dec->mcux; mx++)
+    {
+      if (dec->restart_interval && mcus && !(mcus % dec->restart_interval) && !jpeg_restart(dec)) return false;
+      for (i = 0; i < scan_count; i++)
+      {
+        comp = scan[i];
+        for (by = 0; by < comp->v; by++)
+        {
+          for (bx = 0; bx < comp->h; bx++)
+          {
+            if (!jpeg_scan_block(dec, comp, mx * comp->h + bx, my * comp->v + by)) return false;
+          }
+        }
+      }
+      mcus++;
+    }
+  }
+  return true;
+}
+
+static void
+jpeg_output(Jpeg_Decoder *dec, Image *image)
+{
+  u32            x, y, i;
+  i32            yy, cb, cr, r, g, b;
+  u8             *out, *p[JPEG_MAX_COMPONENTS];
+  Jpeg_Component *comp;
+
+  out = image->pixels;
+  for (y = 0; y < dec->out_h; y++)
+  {
+    for (i = 0; i < dec->comp_count; i++)
+    {
+      comp = &dec->comps[i];
+      p[i] = comp->plane + (y * comp->v / dec->vmax) * comp->stride;
+    }
+    for (x = 0; x < dec->out_w; x++, out += 3)
+    {
+      yy = p[0][x * dec->comps[0].h / dec->hmax];
+      if (dec->comp_count == 1) { out[0] = out[1] = out[2] = (u8) yy; continue; }
+      cb = p[1][x * dec->comps[1].h / dec->hmax] - 128;
+      cr = p[2][x * dec->comps[2].h / dec->hmax] - 128;
+      r  = yy + ((91881 * cr + (1 << 15)) >> 16);
+      g  = yy - ((22554 * cb + 46802 * cr - (1 << 15)) >> 16);
+      b  = yy + ((116130 * cb + (1 << 15)) >> 16);
+      out[0] = (u8)(r < 0 ? 0 : r > 255 ? 255 : r);
+      out[1] = (u8)(g < 0 ? 0 : g > 255 ? 255 : g);
+      out[2] = (u8)(b < 0 ? 0 : b > 255 ? 255 : b);
+    }
+  }
+}
+
+/* NOTE: Size from the frame header, nothing decoded. False when there is none before the scan. */
+static bool
+jpeg_dimensions(u8 *data, u32 size, u32 *w, u32 *h)
+{
+  u8  *at, *end, marker;
+  u32 len;
+
+  at  = data;
+  end = data + size;
+  if (size < 4 || at[0] != 0xFF || at[1] != 0xD8) return false;
+  at += 2;
+  while (at + 4 <= end)
+  {
+    if (at[0] != 0xFF) { at++; continue; }
+    marker = at[1];
+    if (marker == 0xFF) { at++; continue; }
+    if (marker == 0xD9 || marker == 0xDA) return false;
+    len = jpeg_u16(at + 2);
+    if (len < 2 || at + 2 + len > end) return false;
+    /* NOTE: Any SOFn, C4 / C8 / CC are DHT, JPG and DAC */
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+    {
+      if (len < 7) return false;
+      *h = jpeg_u16(at + 5);
+      *w = jpeg_u16(at + 7);
+      return *w && *h;
+    }
+    at += 2 + len;
+  }
+  return false;
+}
+
+/*
+ * NOTE:
+ *      `image` is allocated on success, release it with image_free. Decoded
+ *      at the smallest 1/1, 1/2, 1/4 or 1/8 scale still at least `min_w` x
+ *      `min_h`, both 0 is full size.
+ */
+static bool
+jpeg_decode_scaled(u8 *data, u32 size, u32 min_w, u32 min_h, Image *image)
+{
+  u8             *at, *end, *seg, marker;
+  u32            len, i, j, n, total, id, bs;
+  u8             counts[16];
+  bool           ok, frame;
+  Jpeg_Huffman   *huff;
+  Jpeg_Component *comp, *scan[JPEG_MAX_COMPONENTS];
+  Jpeg_Decoder   *dec;
+
+  memset(image, 0, sizeof(Image));
+  jpeg_dct_init();
+  dec = NULL;
+  ok  = false;
+  frame = false;
+  cm_heap_alloc(sizeof(Jpeg_Decoder), dec);
+  if (!dec) return false;
+  at  = data;
+  end = data + size;
+  if (size < 4 || at[0] != 0xFF || at[1] != 0xD8) goto _end;
+  at += 2;
+  while (at + 4 <= end)
+  {
+    if (at[0] != 0xFF) { at++; continue; }
+    marker = at[1];
+    if (marker == 0xFF) { at++; continue; }
+    if (marker == 0xD9) break;
+    len = jpeg_u16(at + 2);
+    seg = at + 4;
+    if (len < 2 || seg + len - 2 > end) goto _end;
+    switch (marker)
+    {
+      case 0xDB: /* NOTE: DQT */
+        for (i = 0; i + 65 <= len - 2;)
+        {
+          id = seg[i] & 3;
+          if (seg[i] >> 4)
+          {
+            if (i + 129 > len - 2) goto _end;
+            for (j = 0; j < 64; j++) dec->qt[id][j] = (u16) jpeg_u16(seg + i + 1 + j * 2);
+            i += 129;
+          }
+          else
+          {
+            for (j = 0; j < 64; j++) dec->qt[id][j] = seg[i + 1 + j];
+            i += 65;
+          }
+        }
+        break;
+      case 0xC4: /* NOTE: DHT */
+        for (i = 0; i + 17 <= len - 2;)
+        {
+          id   = seg[i] & 3;
+          huff = (seg[i] >> 4) ? &dec->ac[id] : &dec->dc[id];
+          memcpy(counts, seg + i + 1, 16);
+          for (j = 0, total = 0; j < 16; j++) total += counts[j];
+          if (total > 256 || i + 17 + total > len - 2) goto _end;
+          memcpy(huff->vals, seg + i + 17, total);
+          if (!jpeg_huffman_build(huff, counts)) { console_debug("jpeg_decode: bad Huffman table"); goto _end; }
+          i += 17 + total;
+        }
+        break;
+      case 0xDD: /* NOTE: DRI */
+        dec->restart_interval = jpeg_u16(seg);
+        break;
+      case 0xC0: case 0xC1: case 0xC2: /* NOTE: SOF0 / SOF1 / SOF2 */
+        if (frame || len < 8) goto _end;
+        if (seg[0] != 8) { console_debug("jpeg_decode: only 8-bit samples"); goto _end; }
+        dec->progressive = marker == 0xC2;
+        dec->h          = jpeg_u16(seg + 1);
+        dec->w          = jpeg_u16(seg + 3);
+        dec->comp_count = seg[5];
+        if (!dec->w || !dec->h || (dec->comp_count != 1 && dec->comp_count != 3) || len < 8 + dec->comp_count * 3) goto _end;
+        dec->hmax = dec->vmax = 1;
+        for (i = 0; i < dec->comp_count; i++)
+        {
+          comp     = &dec->comps[i];
+          comp->id = seg[6 + i * 3];
+          comp->h  = seg[7 + i * 3] >> 4;
+          comp->v  = seg[7 + i * 3] & 15;
+          comp->tq = seg[8 + i * 3] & 3;
+          if (!comp->h || !comp->v || comp->h > 4 || comp->v > 4) goto _end;
+          if (comp->h > dec->hmax) dec->hmax = comp->h;
+          if (comp->v > dec->vmax) dec->vmax = comp->v;
+        }
+        dec->mcux = (dec->w + dec->hmax * 8 - 1) / (dec->hmax * 8);
+        dec->mcuy = (dec->h + dec->vmax * 8 - 1) / (dec->vmax * 8);
+        if (min_w || min_h)
+        {
+          for (dec->shift = 3; dec->shift; dec->shift--)
+          {
+            if (((dec->w + (1u << dec->shift) - 1) >> dec->shift) >= min_w
+                && ((dec->h + (1u << dec->shift) - 1) >> dec->shift) >= min_h) break;
+          }
+        }
+        bs          = 8 >> dec->shift;
+        dec->out_w  = (dec->w + (1u << dec->shift) - 1) >> dec->shift;
+        dec->out_h  = (dec->h + (1u << dec->shift) - 1) >> dec->shift;
+        for (i = 0; i < dec->comp_count; i++)
+        {
+          comp           = &dec->comps[i];
+          comp->blocks_w = dec->mcux * comp->h;
+          comp->blocks_h = dec->mcuy * comp->v;
+          comp->stride   = comp->blocks_w * bs;
+          cm_heap_alloc((u64) comp->stride * comp->blocks_h * bs, comp->plane);
+          if (!comp->plane) goto _end;
+          if (!dec->progressive) continue;
+          cm_heap_alloc((u64) comp->blocks_w * comp->blocks_h * 64 * sizeof(i16), comp->coefs);
+          if (!comp->coefs) goto _end;
+          memset(comp->coefs, 0, (u64) comp->blocks_w * comp->blocks_h * 64 * sizeof(i16));
+        }
+        frame = true;
+        break;
+      case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+      case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+        console_debug("jpeg_decode: unsupported frame type");
+        goto _end;
+      case 0xDA: /* NOTE: SOS */
+        if (!frame) goto _end;
+        n = seg[0];
+        if (!n || n > dec->comp_count || len < 6 + n * 2) goto _end;
+        dec->ss = seg[1 + n * 2];
+        dec->se = seg[2 + n * 2];
+        dec->ah = seg[3 + n * 2] >> 4;
+        dec->al = seg[3 + n * 2] & 15;
+        if (dec->progressive)
+        {
+          /* NOTE: DC scans may interleave, AC scans carry one component over one band */
+          if (dec->se > 63 || dec->ss > dec->se || dec->al > 13 || (dec->ss && n != 1) || (!dec->ss && dec->se)) goto _end;
+        }
+        else
+        {
+          dec->ss = 0;
+          dec->se = 63;
+          dec->ah = dec->al = 0;
+        }
+        for (i = 0; i < n; i++)
+        {
+          scan[i] = NULL;
+          for (j = 0; j < dec->comp_count; j++)
+          {
+            if (dec->comps[j].id == seg[1 + i * 2]) scan[i] = &dec->comps[j];
+          }
+          if (!scan[i]) goto _end;
+          /* NOTE: Four tables of each kind, a selector past them is a broken file */
+          if ((seg[2 + i * 2] >> 4) > 3 || (seg[2 + i * 2] & 15) > 3) goto _end;
+          scan[i]->td      = seg[2 + i * 2] >> 4;
+          scan[i]->ta      = seg[2 + i * 2] & 15;
+          scan[i]->dc_pred = 0;
+          /* NOTE: Progressive, DC refinement needs no table and AC scans no DC one */
+          if (!dec->ss && !dec->ah && !dec->dc[scan[i]->td].present) goto _end;
+          if (dec->se && !dec->ac[scan[i]->ta].present) goto _end;
+        }
+        dec->eobrun     = 0;
+        dec->at         = seg + len - 2;
+        dec->end        = end;
+        dec->bits       = 0;
+        dec->bit_count  = 0;
+        dec->marker_hit = false;
+        if (!jpeg_decode_scan(dec, scan, n)) { console_debug("jpeg_decode: corrupt scan"); goto _end; }
+        /* NOTE: Resume marker parsing after the entropy coded data */
+        at = dec->at;
+        while (at + 1 < end && !(at[0] == 0xFF && at[1] != 0x00 && !(at[1] >= 0xD0 && at[1] <= 0xD7))) at++;
+        continue;
+      default: break;
+    }
+    at = seg + len - 2;
+  }
+  if (!frame || !image_alloc(image, dec->out_w, dec->out_h)) goto _end;
+  if (dec->progressive) jpeg_progressive_output(dec);
+  jpeg_output(dec, image);
+  ok = true;
+
+_end:
+  for (i = 0; i < JPEG_MAX_COMPONENTS; i++)
+  {
+    if (dec->comps[i].plane) heap_free_dz(dec->comps[i].plane);
+    if (dec->comps[i].coefs) heap_free_dz(dec->comps[i].coefs);
+  }
+  heap_free_dz(dec);
+  return ok;
+}
+
+/* NOTE: Full size. */
+static inline bool
+jpeg_decode(u8 *data, u32 size, Image *image)
+{
+  return jpeg_decode_scaled(data, size, 0, 0, image);
+}
+
+/* -- Encoder ------------------------------------------------------------------------ */
+
+global u8 g_jpeg_std_qt_luma[64] =
+{
+  16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+  14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+  18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+  49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+global u8 g_jpeg_std_qt_chroma[64] =
+{
+  17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+  24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+global u8 g_jpeg_dc_luma_counts[16]   = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+global u8 g_jpeg_dc_chroma_counts[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+global u8 g_jpeg_dc_vals[12]          = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+global u8 g_jpeg_ac_luma_counts[16]   = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+global u8 g_jpeg_ac_chroma_counts[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+
+global u8 g_jpeg_ac_luma_vals[162] =
+{
+  0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+  0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+  0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+  0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+  0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+  0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+  0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+  0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+  0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+  0xf9, 0xfa,
+};
+
+global u8 g_jpeg_ac_chroma_vals[162] =
+{
+  0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+  0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+  0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+  0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+  0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+  0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+  0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+  0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+  0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+  0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+  0xf9, 0xfa,
+};
+
+#pragma warning(disable : 4820)
+typedef struct JpegCodes
+{
+  u16 code[256];
+  u8  size[256];
+} JpegCodes, Jpeg_Codes;
+
+typedef struct JpegEncoder
+{
+  u8         *out, *end;
+  u32        bits;
+  u32        bit_count;
+  bool       overflow;
+  u8         qt[2][64];                      /* NOTE: zigzag order, as written */
+  Jpeg_Codes dc[2], ac[2];
+} JpegEncoder, Jpeg_Encoder;
+#pragma warning(default : 4820)
+
+static void
+jpeg_codes_build(Jpeg_Codes *codes, u8 *counts, u8 *vals)
+{
+  u32 len, i, k, code;
+
+  memset(codes, 0, sizeof(Jpeg_Codes));
+  code = 0;
+  k    = 0;
+  for (len = 1; len <= 16; len++)
+  {
+    for (i = 0; i < counts[len - 1]; i++, k++, code++)
+    {
+      codes->code[vals[k]] = (u16) code;
+      codes->size[vals[k]] = (u8) len;
+    }
+    code <<= 1;
+  }
+}
+
+static inline void
+jpeg_put_byte(Jpeg_Encoder *enc, u8 byte)
+{
+  if (enc->out >= enc->end) { enc->overflow = true; return; }
+  *enc->out++ = byte;
+}
+
+static inline void
+jpeg_put_u16(Jpeg_Encoder *enc, u32 value)
+{
+  jpeg_put_byte(enc, (u8)(value >> 8));
+  jpeg_put_byte(enc, (u8)(value & 0xFF));
+}
+
+static inline void
+jpeg_put_bits(Jpeg_Encoder *enc, u32 value, u32 n)
+{
+  u8 byte;
+
+  enc->bits      |= (value & ((1u << n) - 1)) << (24 - enc->bit_count - n);
+  enc->bit_count += n;
+  while (enc->bit_count >= 8)
+  {
+    byte = (u8)(enc->bits >> 16);
+    jpeg_put_byte(enc, byte);
+    if (byte == 0xFF) jpeg_put_byte(enc, 0x00);
+    enc->bits      <<= 8;
+    enc->bits       &= 0xFFFFFF;
+    enc->bit_count  -= 8;
+  }
+}
+
+static void
+jpeg_put_table(Jpeg_Encoder *enc, u8 class_id, u8 *counts, u8 *vals)
+{
+  u32 i, total;
+
+  for (i = 0, total = 0; i < 16; i++) total += counts[i];
+  jpeg_put_u16(enc, 0xFFC4);
+  jpeg_put_u16(enc, 2 + 1 + 16 + total);
+  jpeg_put_byte(enc, class_id);
+  for (i = 0; i < 16; i++)    jpeg_put_byte(enc, counts[i]);
+  for (i = 0; i < total; i++) jpeg_put_byte(enc, vals[i]);
+}
+
+static void
+jpeg_encode_block(Jpeg_Encoder *enc, f32 *samples, u32 table, i32 *dc_pred)
+{
+  u32 x, y, u, k, run, size, value;
+  i32 q[64], coef, diff;
+  f32 tmp[64], sum;
+
+  cm_stack_mark(tmp);
+  for (y = 0; y < 8; y++)
+  {
+    for (u = 0; u < 8; u++)
+    {
+      sum = 0.0f;
+      for (x = 0; x < 8; x++) sum += g_jpeg_dct[0][x][u] * samples[y * 8 + x];
+      tmp[y * 8 + u] = sum;
+    }
+  }
+  for (u = 0; u < 8; u++)
+  {
+    for (k = 0; k < 8; k++)
+    {
+      sum = 0.0f;
+      for (y = 0; y < 8; y++) sum += g_jpeg_dct[0][y][k] * tmp[y * 8 + u];
+      samples[k * 8 + u] = sum;
+    }
+  }
+  for (k = 0; k < 64; k++)
+  {
+    sum  = samples[g_jpeg_zigzag[k]] / (f32) enc->qt[table][k];
+    q[k] = (i32)(sum < 0.0f ? sum - 0.5f : sum + 0.5f);
+  }
+
+  diff     = q[0] - *dc_pred;
+  *dc_pred = q[0];
+  value    = (u32)(diff < 0 ? -diff : diff);
+  for (size = 0; value; size++) value >>= 1;
+  jpeg_put_bits(enc, enc->dc[table].code[size], enc->dc[table].size[size]);
+  if (size) jpeg_put_bits(enc, (u32)(diff < 0 ? diff - 1 : diff), size);
+
+  run = 0;
+  for (k = 1; k < 64; k++)
+  {
+    coef = q[k];
+    if (!coef) { run++; continue; }
+    while (run > 15)
+    {
+      jpeg_put_bits(enc, enc->ac[table].code[0xF0], enc->ac[table].size[0xF0]);
+      run -= 16;
+    }
+    value = (u32)(coef < 0 ? -coef : coef);
+    for (size = 0; value; size++) value >>= 1;
+    jpeg_put_bits(enc, enc->ac[table].code[(run << 4) | size], enc->ac[table].size[(run << 4) | size]);
+    jpeg_put_bits(enc, (u32)(coef < 0 ? coef - 1 : coef), size);
+    run = 0;
+  }
+  if (run) jpeg_put_bits(enc, enc->ac[table].code[0x00], enc->ac[table].size[0x00]);
+}
+
+/*
+ * NOTE:
+ *      Encodes `image` into a cm_heap_alloc'd buffer (release with
+ *      heap_free_dz), NULL on failure. `quality` is 1..100, libjpeg scale.
+ */
+static u8*
+jpeg_encode(Image *image, u32 quality, u32 *out_size)
+{
+  u8           *buffer, *p;
+  u32          i, x, y, bx, by, sx, sy, scale, value;
+  u64          capacity;
+  i32          r, g, b, dc[3];
+  f32          blocks[3][64];
+  Jpeg_Encoder enc;
+
+  *out_size = 0;
+  buffer    = NULL;
+  jpeg_dct_init();
+  if (!image->w || !image->h || image->w > 0xFFFF || image->h > 0xFFFF) return NULL;
+  /* NOTE: Worst case is well under 20 bytes per pixel with the standard tables */
+  capacity = (u64) image->w * image->h * 20 + 1024;
+  cm_heap_alloc(capacity, buffer);
+  if (!buffer) return NULL;
+
+  memset(&enc, 0, sizeof(Jpeg_Encoder));
+  enc.out = buffer;
+  enc.end = buffer + capacity;
+  if (quality < 1)   quality = 1;
+  if (quality > 100) quality = 100;
+  scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  for (i = 0; i < 64; i++)
+  {
+    value = (g_jpeg_std_qt_luma[g_jpeg_zigzag[i]] * scale + 50) / 100;
+    enc.qt[0][i] = (u8)(value < 1 ? 1 : value > 255 ? 255 : value);
+    value = (g_jpeg_std_qt_chroma[g_jpeg_zigzag[i]] * scale + 50) / 100;
+    enc.qt[1][i] = (u8)(value < 1 ? 1 : value > 255 ? 255 : value);
+  }
+  jpeg_codes_build(&enc.dc[0], g_jpeg_dc_luma_counts,   g_jpeg_dc_vals);
+  jpeg_codes_build(&enc.dc[1], g_jpeg_dc_chroma_counts, g_jpeg_dc_vals);
+  jpeg_codes_build(&enc.ac[0], g_jpeg_ac_luma_counts,   g_jpeg_ac_luma_vals);
+  jpeg_codes_build(&enc.ac[1], g_jpeg_ac_chroma_counts, g_jpeg_ac_chroma_vals);
+
+  jpeg_put_u16(&enc, 0xFFD8);
+  /* NOTE: JFIF APP0 */
+  jpeg_put_u16(&enc, 0xFFE0);
+  jpeg_put_u16(&enc, 16);
+  jpeg_put_byte(&enc, 'J'); jpeg_put_byte(&enc, 'F'); jpeg_put_byte(&enc, 'I'); jpeg_put_byte(&enc, 'F');
+  jpeg_put_byte(&enc, 0);
+  jpeg_put_u16(&enc, 0x0101);
+  jpeg_put_byte(&enc, 0);
+  jpeg_put_u16(&enc, 1);
+  jpeg_put_u16(&enc, 1);
+  jpeg_put_u16(&enc, 0);
+  for (i = 0; i < 2; i++)
+  {
+    jpeg_put_u16(&enc, 0xFFDB);
+    jpeg_put_u16(&enc, 67);
+    jpeg_put_byte(&enc, (u8) i);
+    for (x = 0; x < 64; x++) jpeg_put_byte(&enc, enc.qt[i][x]);
+  }
+  jpeg_put_u16(&enc, 0xFFC0);
+  jpeg_put_u16(&enc, 17);
+  jpeg_put_byte(&enc, 8);
+  jpeg_put_u16(&enc, image->h);
+  jpeg_put_u16(&enc, image->w);
+  jpeg_put_byte(&enc, 3);
+  for (i = 0; i < 3; i++)
+  {
+    jpeg_put_byte(&enc, (u8)(i + 1));
+    jpeg_put_byte(&enc, 0x11);
+    jpeg_put_byte(&enc, i ? 1 : 0);
+  }
+  jpeg_put_table(&enc, 0x00, g_jpeg_dc_luma_counts,   g_jpeg_dc_vals);
+  jpeg_put_table(&enc, 0x10, g_jpeg_ac_luma_counts,   g_jpeg_ac_luma_vals);
+  jpeg_put_table(&enc, 0x01, g_jpeg_dc_chroma_counts, g_jpeg_dc_vals);
+  jpeg_put_table(&enc, 0x11, g_jpeg_ac_chroma_counts, g_jpeg_ac_chroma_vals);
+  jpeg_put_u16(&enc, 0xFFDA);
+  jpeg_put_u16(&enc, 12);
+  jpeg_put_byte(&enc, 3);
+  for (i = 0; i < 3; i++)
+  {
+    jpeg_put_byte(&enc, (u8)(i + 1));
+    jpeg_put_byte(&enc, i ? 0x11 : 0x00);
+  }
+  jpeg_put_byte(&enc, 0);
+  jpeg_put_byte(&enc, 63);
+  jpeg_put_byte(&enc, 0);
+
+  dc[0] = dc[1] = dc[2] = 0;
+  for (by = 0; by < image->h; by += 8)
+  {
+    for (bx = 0; bx < image->w; bx += 8)
+    {
+      for (y = 0; y < 8; y++)
+      {
+        sy = by + y < image->h ? by + y : image->h - 1;
+        for (x = 0; x < 8; x++)
+        {
+          sx = bx + x < image->w ? bx + x : image->w - 1;
+          p  = image->pixels + ((u64) sy * image->w + sx) * 3;
+          r  = p[0]; g = p[1]; b = p[2];
+          blocks[0][y * 8 + x] =  0.299f    * r + 0.587f    * g + 0.114f    * b - 128.0f;
+          blocks[1][y * 8 + x] = -0.168736f * r - 0.331264f * g + 0.5f      * b;
+          blocks[2][y * 8 + x] =  0.5f      * r - 0.418688f * g - 0.081312f * b;
+        }
+      }
+      jpeg_encode_block(&enc, blocks[0], 0, &dc[0]);
+      jpeg_encode_block(&enc, blocks[1], 1, &dc[1]);
+      jpeg_encode_block(&enc, blocks[2], 1, &dc[2]);
+    }
+  }
+  /* NOTE: Pad the last byte with ones */
+  jpeg_put_bits(&enc, 0x7F, 7);
+  jpeg_put_u16(&enc, 0xFFD9);
+  if (enc.overflow)
+  {
+    console_debug("jpeg_encode: output buffer too small");
+    heap_free_dz(buffer);
+    return NULL;
+  }
+  *out_size = (u32)(enc.out - buffer);
+  return buffer;
+}
+
+#endif // CM_JPEG_C
@@ -0,0 +1,591 @@
+#ifndef CM_PNG_C
+#define CM_PNG_C
+
+/*
+ * NOTE:
+ *      Small PNG decoder, enough for key images: every color type and bit
+ *      depth, palettes and tRNS, Adam7 interlacing. Comes out as the same
+ *      8-bit RGB as jpeg_decode, 16-bit samples keep their high byte and
+ *      transparency is blended over black (what an unlit key shows), the
+ *      alpha coming out on the side for the compositor. CRCs are not
+ *      checked, a corrupt stream fails in inflate or the filters. The
+ *      inflater writes into a buffer of the exact size the header promises,
+ *      anything longer is an error.
+ */
+#define PNG_FAST_BITS 9
+
+#pragma warning(disable : 4820)
+typedef struct PngHuffman
+{
+  u16 fast[1 << PNG_FAST_BITS];              /* NOTE: (length << 9) | symbol, 0 = slow path */
+  u16 first_code[17];
+  u16 first_symbol[17];
+  i32 max_code[18];                          /* NOTE: Exclusive, left aligned on 16 bits */
+  u8  sizes[288];
+  u16 symbols[288];
+} PngHuffman, Png_Huffman;
+
+typedef struct PngInflate
+{
+  u8          *at, *end;
+  u32         bits;
+  u32         bit_count;
+  u8          *out, *out_end, *out_at;
+  Png_Huffman length, distance;
+} PngInflate, Png_Inflate;
+#pragma warning(default : 4820)
+
+global u16 g_png_length_base[31] =
+{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0,
+};
+global u8  g_png_length_extra[31] =
+{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0,
+};
+global u16 g_png_distance_base[32] =
+{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 0, 0,
+};
+global u8  g_png_distance_extra[32] =
+{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0,
+};
+global u8  g_png_code_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/* NOTE: Adam7 passes: x0, y0, dx, dy */
+global u8  g_png_adam7[7][4] =
+{
+  {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2},
+};
+
+/* -- Inflate ------------------------------------------------------------------------ */
+
+static inline u32
+png_bit_reverse(u32 code, u32 len)
+{
+  u32 result;
+
+  for (result = 0; len; len--, code >>= 1) result = (result << 1) | (code & 1);
+  return result;
+}
+
+/* NOTE: Canonical code from `count` lengths, false when it is oversubscribed. */
+static bool
+png_huffman_build(Png_Huffman *huff, u8 *sizes, u32 count)
+{
+  u32 i, len, code, k, fill, next_code[16], length_count[17];
+
+  memset(length_count, 0, sizeof(length_count));
+  memset(huff->fast, 0, sizeof(huff->fast));
+  for (i = 0; i < count; i++) length_count[sizes[i]]++;
+  length_count[0] = 0;
+  code = 0;
+  k    = 0;
+  for (len = 1; len < 16; len++)
+  {
+    next_code[len]          = code;
+    huff->first_code[len]   = (u16) code;
+    huff->first_symbol[len] = (u16) k;
+    code += length_count[len];
+    if (code > (1u << len)) return false;
+    huff->max_code[len] = (i32)(code << (16 - len));
+    code <<= 1;
+    k    += length_count[len];
+  }
+  huff->max_code[16] = 0x10000;
+  huff->max_code[17] = 0x7FFFFFFF;
+  for (i = 0; i < count; i++)
+  {
+    len = sizes[i];
+    if (!len) continue;
+    k = huff->first_symbol[len] + (next_code[len] - huff->first_code[len]);
+    huff->sizes[k]   = (u8) len;
+    huff->symbols[k] = (u16) i;
+    if (len <= PNG_FAST_BITS)
+    {
+      /* NOTE: Deflate codes go LSB first, index the fast table with the reversed code */
+      for (fill = png_bit_reverse(next_code[len], len); fill < (1u << PNG_FAST_BITS); fill += 1u << len)
+      {
+        huff->fast[fill] = (u16)((len << 9) | i);
+      }
+    }
+    next_code[len]++;
+  }
+  return true;
+}
+
+static inline void
+png_fill(Png_Inflate *inf)
+{
+  while (inf->bit_count <= 24)
+  {
+    if (inf->at < inf->end) inf->bits |= (u32) *inf->at++ << inf->bit_count;
+    inf->bit_count += 8;
+  }
+}
+
+static inline u32
+png_bits(Png_Inflate *inf, u32 n)
+{
+  u32 value;
+
+  if (!n) return 0;
+  png_fill(inf);
+  value            = inf->bits & ((1u << n) - 1);
+  inf->bits      >>= n;
+  inf->bit_count  -= n;
+  return value;
+}
+
+/* NOTE: Returns the decoded symbol, -1 on a bad code. */
+static i32
+png_decode_symbol(Png_Inflate *inf, Png_Huffman *huff)
+{
+  u32 fast, code, len, k;
+
+  png_fill(inf);
+  fast = huff->fast[inf->bits & ((1 << PNG_FAST_BITS) - 1)];
+  if (fast)
+  {
+    len             = fast >> 9;
+    inf->bits     >>= len;
+    inf->bit_count -= len;
+    return (i32)(fast & 511);
+  }
+  code = png_bit_reverse(inf->bits & 0xFFFF, 16);
+  for (len = PNG_FAST_BITS + 1; (i32) code >= huff->max_code[len]; len++) {}
+  if (len >= 16) return -1;
+  k = (code >> (16 - len)) - huff->first_code[len] + huff->first_symbol[len];
+  if (k >= 288 || huff->sizes[k] != len) return -1;
+  inf->bits     >>= len;
+  inf->bit_count -= len;
+  return huff->symbols[k];
+}
+
+static bool
+png_inflate_codes(Png_Inflate *inf)
+{
+  i32 symbol;
+  u32 len, dist;
+  u8  *from;
+
+  for (;;)
+  {
+    symbol = png_decode_symbol(inf, &inf->length);
+    if (symbol < 0) return false;
+    if (symbol < 256)
+    {
+      if (inf->out_at >= inf->out_end) return false;
+      *inf->out_at++ = (u8) symbol;
+      continue;
+    }
+    if (symbol == 256) return true;
+    symbol -= 257;
+    if (symbol >= 29) return false;
+    len    = g_png_length_base[symbol] + png_bits(inf, g_png_length_extra[symbol]);
+    symbol = png_decode_symbol(inf, &inf->distance);
+    if (symbol < 0 || symbol >= 30) return false;
+    dist   = g_png_distance_base[symbol] + png_bits(inf, g_png_distance_extra[symbol]);
+    if (dist > (u64)(inf->out_at - inf->out) || len > (u64)(inf->out_end - inf->out_at)) return false;
+    from = inf->out_at - dist;
+    /* NOTE: Overlapping copies repeat the pattern, byte by byte on purpose */
+    while (len--) *inf->out_at++ = *from++;
+  }
+}
+
+static bool
+png_inflate_dynamic(Png_Inflate *inf)
+{
+  u32         hlit, hdist, hclen, i, n, repeat;
+  i32         symbol;
+  u8          sizes[286 + 32], code_sizes[19];
+  Png_Huffman *codes;
+
+  cm_stack_mark(sizes);
+  hlit  = png_bits(inf, 5) + 257;
+  hdist = png_bits(inf, 5) + 1;
+  hclen = png_bits(inf, 4) + 4;
+  if (hlit > 286 || hdist > 30) return false;
+  memset(code_sizes, 0, sizeof(code_sizes));
+  for (i = 0; i < hclen; i++) code_sizes[g_png_code_order[i]] = (u8) png_bits(inf, 3);
+  /* NOTE: The distance table is free until the end of the lengths */
+  codes = &inf->distance;
+  if (!png_huffman_build(codes, code_sizes, 19)) return false;
+  for (n = 0; n < hlit + hdist;)
+  {
+    symbol = png_decode_symbol(inf, codes);
+    if (symbol < 0) return false;
+    if (symbol < 16) { sizes[n++] = (u8) symbol; continue; }
+    if      (symbol == 16) { if (!n) return false; repeat = 3 + png_bits(inf, 2); symbol = sizes[n - 1]; }
+    else if (symbol == 17) { repeat = 3  + png_bits(inf, 3); symbol = 0; }
+    else                   { repeat = 11 + png_bits(inf, 7); symbol = 0; }
+    if (n + repeat > hlit + hdist) return false;
+    memset(sizes + n, symbol, repeat);
+    n += repeat;
+  }
+  if (!sizes[256]) return false;
+  return png_huffman_build(&inf->length, sizes, hlit) && png_huffman_build(&inf->distance, sizes + hlit, hdist);
+}
+
+static bool
+png_inflate_fixed(Png_Inflate *inf)
+{
+  u32 i;
+  u8  sizes[288];
+
+  for (i = 0;   i < 144; i++) sizes[i] = 8;
+  for (;        i < 256; i++) sizes[i] = 9;
+  for (;        i < 280; i++) sizes[i] = 7;
+  for (;        i < 288; i++) sizes[i] = 8;
+  if (!png_huffman_build(&inf->length, sizes, 288)) return false;
+  memset(sizes, 5, 32);
+  return png_huffman_build(&inf->distance, sizes, 32);
+}
+
+/* NOTE: zlib stream at `data` into exactly `out_size` bytes at `out`. */
+static bool
+png_inflate(u8 *data, u32 size, u8 *out, u64 out_size)
+{
+  u32         final, type, len;
+  bool        ok;
+  Png_Inflate *inf;
+
+  inf = NULL;
+  ok  = false;
+  if (size < 2 || (data[0] & 15) != 8 || ((data[0] << 8) | data[1]) % 31 || (data[1] & 32)) return false;
+  cm_heap_alloc(sizeof(Png_Inflate), inf);
+  if (!inf) return false;
+  inf->at      = data + 2;
+  inf->end     = data + size;
+  inf->out     = inf->out_at = out;
+  inf->out_end = out + out_size;
+  do
+  {
+    final = png_bits(inf, 1);
+    type  = png_bits(inf, 2);
+    if (type == 0)
+    {
+      /* NOTE: Stored, drop to the byte boundary then read straight from the stream */
+      png_bits(inf, inf->bit_count & 7);
+      len = png_bits(inf, 16);
+      if ((len ^ 0xFFFF) != png_bits(inf, 16)) goto _end;
+      for (; len && inf->bit_count >= 8; len--)
+      {
+        if (inf->out_at >= inf->out_end) goto _end;
+        *inf->out_at++   = (u8) inf->bits;
+        inf->bits      >>= 8;
+        inf->bit_count  -= 8;
+      }
+      if (len > (u64)(inf->end - inf->at) || len > (u64)(inf->out_end - inf->out_at)) goto _end;
+      memcpy(inf->out_at, inf->at, len);
+      inf->out_at += len;
+      inf->at     += len;
+      continue;
+    }
+    if      (type == 1) { if (!png_inflate_fixed(inf))   goto _end; }
+    else if (type == 2) { if (!png_inflate_dynamic(inf)) goto _end; }
+    else goto _end;
+    if (!png_inflate_codes(inf)) goto _end;
+  } while (!final);
+  ok = inf->out_at == inf->out_end;
+
+_end:
+  heap_free_dz(inf);
+  return ok;
+}
+
+/* -- Decoder ------------------------------------------------------------------------ */
+
+static inline u32
+png_u32(u8 *p)
+{
+  return ((u32) p[0] << 24) | ((u32) p[1] << 16) | ((u32) p[2] << 8) | p[3];
+}
+
+static inline u8
+png_paeth(u8 a, u8 b, u8 c)
+{
+  i32 p, pa, pb, pc;
+
+  p  = (i32) a + b - c;
+  pa = abs(p - a);
+  pb = abs(p - b);
+  pc = abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  return pb <= pc ? b : c;
+}
+
+/* NOTE: In place, `rows` filtered rows of `row_bytes` each preceded by their filter byte. */
+static bool
+png_unfilter(u8 *data, u32 rows, u32 row_bytes, u32 bpp)
+{
+  u32 y, x;
+  u8  *row, *prior, filter, a, b, c;
+
+  prior = NULL;
+  for (y = 0; y < rows; y++)
+  {
+    filter = data[(u64) y * (row_bytes + 1)];
+    row    = data + (u64) y * (row_bytes + 1) + 1;
+    if (filter > 4) return false;
+    for (x = 0; x < row_bytes; x++)
+    {
+      a = x >= bpp ? row[x - bpp] : 0;
+      b = prior ? prior[x] : 0;
+      c = (prior && x >= bpp) ? prior[x - bpp] : 0;
+      switch (filter)
+      {
+        case 1: row[x] = (u8)(row[x] + a);                    break;
+        case 2: row[x] = (u8)(row[x] + b);                    break;
+        case 3: row[x] = (u8)(row[x] + ((a + b) >> 1));       break;
+        case 4: row[x] = (u8)(row[x] + png_paeth(a, b, c));   break;
+        default: break;
+      }
+    }
+    prior = row;
+  }
+  return true;
+}
+
+#pragma warning(disable : 4820)
+typedef struct PngInfo
+{
+  u32 w, h;
+  u8  depth, color, interlace;
+  u32 channels;
+  u8  palette[256 * 4];                      /* NOTE: RGBA */
+  u32 palette_count;
+  u16 key[3];                                /* NOTE: tRNS of gray / truecolor, at the image depth */
+  bool has_key;
+} PngInfo, Png_Info;
+#pragma warning(default : 4820)
+
+/* NOTE: Sample `i` of an unfiltered row, at the image depth. */
+static inline u32
+png_sample(Png_Info *info, u8 *row, u32 i)
+{
+  u32 bit;
+
+  switch (info->depth)
+  {
+    case 16: return ((u32) row[i * 2] << 8) | row[i * 2 + 1];
+    case 8:  return row[i];
+    default:
+      bit = i * info->depth;
+      return (row[bit >> 3] >> (8 - info->depth - (bit & 7))) & ((1u << info->depth) - 1);
+  }
+}
+
+/*
+ * NOTE:
+ *      One unfiltered row of `w` pixels to RGB, every `dx` pixel of `out`,
+ *      and their alpha to the same pixels of `mask` when it is not NULL.
+ *      True when one of them is not opaque.
+ */
+static bool
+png_row_rgb(Png_Info *info, u8 *row, u32 w, u8 *out, u8 *mask, u32 dx)
+{
+  u32  x, c, alpha, max, v[4], shift;
+  u8   *entry;
+  bool translucent;
+
+  max         = (1u << info->depth) - 1;
+  shift       = info->depth == 16 ? 8 : 0;
+  translucent = false;
+  for (x = 0; x < w; x++, out += dx * 3)
+  {
+    alpha = 255;
+    for (c = 0; c < info->channels; c++) v[c] = png_sample(info, row, x * info->channels + c);
+    switch (info->color)
+    {
+      case 3:
+        entry  = info->palette + (v[0] < info->palette_count ? v[0] : 0) * 4;
+        out[0] = entry[0];
+        out[1] = entry[1];
+        out[2] = entry[2];
+        alpha  = entry[3];
+        break;
+      case 0: case 4:
+        if (info->has_key && v[0] == info->key[0]) alpha = 0;
+        if (info->color == 4) alpha = (v[1] * 255 + max / 2) / max;
+        out[0] = out[1] = out[2] = (u8)((v[0] * 255 + max / 2) / max);
+        break;
+      default:
+        if (info->has_key && v[0] == info->key[0] && v[1] == info->key[1] && v[2] == info->key[2]) alpha = 0;
+        if (info->color == 6) alpha = v[3] >> shift;
+        out[0] = (u8)(v[0] >> shift);
+        out[1] = (u8)(v[1] >> shift);
+        out[2] = (u8)(v[2] >> shift);
+        break;
+    }
+    if (alpha != 255)
+    {
+      out[0] = (u8)((out[0] * alpha + 127) / 255);
+      out[1] = (u8)((out[1] * alpha + 127) / 255);
+      out[2] = (u8)((out[2] * alpha + 127) / 255);
+      translucent = true;
+    }
+    if (mask) { mask[0] = mask[1] = mask[2] = (u8) alpha; mask += dx * 3; }
+  }
+  return translucent;
+}
+
+/*
+ * NOTE:
+ *      `image` is allocated on success, release it with image_free. With a
+ *      `mask`, the alpha of every pixel comes out in it too (the same value
+ *      in the three channels, so it scales like any image), the pixels being
+ *      premultiplied by it. An opaque image leaves `mask` zeroed.
+ */
+static bool
+png_decode_alpha(u8 *data, u32 size, Image *image, Image *mask)
+{
+  u8       *at, *end, *idat, *raw, *row, *out;
+  u32      len, pass, pw, ph, y, i, dx, bpp, row_bytes, idat_size;
+  u64      raw_size;
+  bool     ok, header, translucent;
+  Png_Info *info;
+
+  memset(image, 0, sizeof(Image));
+  if (mask) memset(mask, 0, sizeof(Image));
+  info = NULL;
+  idat = raw = NULL;
+  ok   = false;
+  if (size < 8 || memcmp(data, "\x89PNG\r\n\x1a\n", 8)) return false;
+  cm_heap_alloc(sizeof(Png_Info), info);
+  if (!info) return false;
+  cm_heap_alloc(size, idat);
+  if (!idat) goto _end;
+  idat_size = 0;
+  header    = false;
+  at  = data + 8;
+  end = data + size;
+  while (at + 12 <= end)
+  {
+    len = png_u32(at);
+    if (len > (u64)(end - at) - 12) goto _end;
+    if (!memcmp(at + 4, "IHDR", 4))
+    {
+      if (header || len < 13) goto _end;
+      info->w         = png_u32(at + 8);
+      info->h         = png_u32(at + 12);
+      info->depth     = at[16];
+      info->color     = at[17];
+      info->interlace = at[20];
+      switch (info->color)
+      {
+        case 0: info->channels = 1; break;
+        case 2: info->channels = 3; break;
+        case 3: info->channels = 1; break;
+        case 4: info->channels = 2; break;
+        case 6: info->channels = 4; break;
+        default: goto _end;
+      }
+      if (!info->w || !info->h || info->w > 0x4000 || info->h > 0x4000 || info->interlace > 1) goto _end;
+      if (info->depth != 1 && info->depth != 2 && info->depth != 4 && info->depth != 8 && info->depth != 16) goto _end;
+      if ((info->color == 3 && info->depth > 8) || (info->color != 0 && info->color != 3 && info->depth < 8)) goto _end;
+      header = true;
+    }
+    else if (!memcmp(at + 4, "PLTE", 4))
+    {
+      if (len % 3 || len > 256 * 3) goto _end;
+      info->palette_count = len / 3;
+      for (i = 0; i < info->palette_count; i++)
+      {
+        info->palette[i * 4 + 0] = at[8 + i * 3 + 0];
+        info->palette[i * 4 + 1] = at[8 + i * 3 + 1];
+        info->palette[i * 4 + 2] = at[8 + i * 3 + 2];
+        info->palette[i * 4 + 3] = 255;
+      }
+    }
+    else if (!memcmp(at + 4, "tRNS", 4) && header)
+    {
+      if (info->color == 3)
+      {
+        for (i = 0; i < len && i < 256; i++) info->palette[i * 4 + 3] = at[8 + i];
+      }
+      else if (len >= info->channels * 2 && info->channels <= 3)
+      {
+        for (i = 0; i < info->channels; i++) info->key[i] = (u16)((at[8 + i * 2] << 8) | at[9 + i * 2]);
+        info->has_key = true;
+      }
+    }
+    else if (!memcmp(at + 4, "IDAT", 4))
+    {
+      memcpy(idat + idat_size, at + 8, len);
+      idat_size += len;
+    }
+    else if (!memcmp(at + 4, "IEND", 4)) break;
+    at += 12 + len;
+  }
+  if (!header || !idat_size || (info->color == 3 && !info->palette_count)) goto _end;
+
+  /* NOTE: Filtered size of every pass, the inflated stream must be exactly that */
+  bpp      = (info->channels * info->depth + 7) / 8;
+  raw_size = 0;
+  for (pass = 0; pass < (info->interlace ? 7u : 1u); pass++)
+  {
+    pw = info->interlace ? (info->w - g_png_adam7[pass][0] + g_png_adam7[pass][2] - 1) / g_png_adam7[pass][2] : info->w;
+    ph = info->interlace ? (info->h - g_png_adam7[pass][1] + g_png_adam7[pass][3] - 1) / g_png_adam7[pass][3] : info->h;
+    if (info->w <= g_png_adam7[pass][0] || info->h <= g_png_adam7[pass][1]) pw = ph = 0;
+    if (pw && ph) raw_size += (u64) ph * (((u64) pw * info->channels * info->depth + 7) / 8 + 1);
+  }
+  cm_heap_alloc(raw_size, raw);
+  if (!raw || !png_inflate(idat, idat_size, raw, raw_size)) { console_debug("png_decode: corrupt data"); goto _end; }
+  if (!image_alloc(image, info->w, info->h)) goto _end;
+  if (mask && !image_alloc(mask, info->w, info->h)) { image_free(image); goto _end; }
+
+  row         = raw;
+  translucent = false;
+  for (pass = 0; pass < (info->interlace ? 7u : 1u); pass++)
+  {
+    if (info->interlace)
+    {
+      if (info->w <= g_png_adam7[pass][0] || info->h <= g_png_adam7[pass][1]) continue;
+      pw = (info->w - g_png_adam7[pass][0] + g_png_adam7[pass][2] - 1) / g_png_adam7[pass][2];
+      ph = (info->h - g_png_adam7[pass][1] + g_png_adam7[pass][3] - 1) / g_png_adam7[pass][3];
+    }
+    else
+    {
+      pw = info->w;
+      ph = info->h;
+    }
+    row_bytes = (u32)(((u64) pw * info->channels * info->depth + 7) / 8);
+    if (!png_unfilter(row, ph, row_bytes, bpp))
+    {
+      console_debug("png_decode: bad filter");
+      image_free(image);
+      if (mask) image_free(mask);
+      goto _end;
+    }
+    for (y = 0; y < ph; y++)
+    {
+      dx  = info->interlace ? g_png_adam7[pass][2] : 1;
+      out = info->interlace ? image->pixels + ((u64)(g_png_adam7[pass][1] + y * g_png_adam7[pass][3]) * info->w + g_png_adam7[pass][0]) * 3
+                            : image->pixels + (u64) y * info->w * 3;
+      translucent |= png_row_rgb(info, row + (u64) y * (row_bytes + 1) + 1, pw, out,
+                                 mask ? mask->pixels + (out - image->pixels) : NULL, dx);
+    }
+    row += (u64) ph * (row_bytes + 1);
+  }
+  if (mask && !translucent) image_free(mask);
+  ok = true;
+
+_end:
+  if (raw)  heap_free_dz(raw);
+  if (idat) heap_free_dz(idat);
+  heap_free_dz(info);
+  return ok;
+}
+
+/* NOTE: `image` is allocated on success, release it with image_free. */
+static bool
+png_decode(u8 *data, u32 size, Image *image)
+{
+  return png_decode_alpha(data, size, image, NULL);
+}
+
+#endif // CM_PNG_C
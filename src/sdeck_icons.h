@@ -1,379 +0,0 @@
-#ifndef SDECK_ICONS_H
-#define SDECK_ICONS_H
-
-global unsigned char grenade_jpg[] = {
-  0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
-  0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
-  0x00, 0x03, 0x02, 0x02, 0x02, 0x02, 0x02, 0x03, 0x02, 0x02, 0x02, 0x03,
-  0x03, 0x03, 0x03, 0x04, 0x06, 0x04, 0x04, 0x04, 0x04, 0x04, 0x08, 0x06,
-  0x06, 0x05, 0x06, 0x09, 0x08, 0x0a, 0x0a, 0x09, 0x08, 0x09, 0x09, 0x0a,
-  0x0c, 0x0f, 0x0c, 0x0a, 0x0b, 0x0e, 0x0b, 0x09, 0x09, 0x0d, 0x11, 0x0d,
-  0x0e, 0x0f, 0x10, 0x10, 0x11, 0x10, 0x0a, 0x0c, 0x12, 0x13, 0x12, 0x10,
-  0x13, 0x0f, 0x10, 0x10, 0x10, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x03, 0x03,
-  0x03, 0x04, 0x03, 0x04, 0x08, 0x04, 0x04, 0x08, 0x10, 0x0b, 0x09, 0x0b,
-  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
-  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
-  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
-  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
-  0x10, 0x10, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x60, 0x00, 0x60, 0x03,
-  0x01, 0x11, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00,
-  0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
-  0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00,
-  0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00,
-  0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
-  0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81,
-  0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24,
-  0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25,
-  0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
-  0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56,
-  0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
-  0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86,
-  0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
-  0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3,
-  0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6,
-  0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
-  0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1,
-  0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xc4, 0x00,
-  0x1f, 0x01, 0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
-  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
-  0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x11, 0x00,
-  0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00,
-  0x01, 0x02, 0x77, 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31,
-  0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08,
-  0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15,
-  0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18,
-  0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39,
-  0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55,
-  0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
-  0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84,
-  0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
-  0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
-  0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4,
-  0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7,
-  0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
-  0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xda, 0x00,
-  0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xfd,
-  0x53, 0xa0, 0x02, 0x80, 0x0a, 0x00, 0x28, 0x00, 0xa0, 0x02, 0x80, 0x0a,
-  0x00, 0x28, 0x00, 0xa0, 0x02, 0x80, 0x0a, 0x00, 0x28, 0x00, 0xa0, 0x02,
-  0x80, 0x3e, 0x5b, 0xfd, 0xaa, 0x3e, 0x23, 0xfc, 0x58, 0xf1, 0x4f, 0xc4,
-  0x4f, 0x0c, 0xfe, 0xc8, 0x9f, 0xb3, 0xd6, 0xbd, 0x07, 0x87, 0x7c, 0x59,
-  0xe3, 0x2d, 0x2e, 0x7d, 0x77, 0xc4, 0xde, 0x2a, 0x91, 0x24, 0x69, 0x7c,
-  0x31, 0xe1, 0xd8, 0xe5, 0x10, 0x9b, 0x8b, 0x74, 0x00, 0x2b, 0xcf, 0x3c,
-  0x9e, 0x64, 0x51, 0x95, 0x70, 0xc8, 0xca, 0x3f, 0xd5, 0x99, 0x12, 0x78,
-  0x80, 0x28, 0xda, 0xff, 0x00, 0xc1, 0x30, 0x3f, 0x63, 0xfb, 0x98, 0xda,
-  0xeb, 0xc6, 0xde, 0x0d, 0xf1, 0x0f, 0x8d, 0xf5, 0xeb, 0x89, 0x24, 0x9f,
-  0x50, 0xf1, 0x0f, 0x88, 0x3c, 0x55, 0xa8, 0xbe, 0xa3, 0xa8, 0x4c, 0xee,
-  0x58, 0xcb, 0x3b, 0x41, 0x34, 0x51, 0xb3, 0xf3, 0x8c, 0x88, 0xd7, 0x20,
-  0x02, 0x72, 0x72, 0x48, 0x07, 0xc8, 0xff, 0x00, 0xb6, 0x1f, 0xc4, 0x5f,
-  0xda, 0x83, 0xfe, 0x09, 0xdd, 0x79, 0xa2, 0x7c, 0x34, 0xf8, 0x43, 0xfb,
-  0x40, 0xeb, 0x1a, 0xbf, 0x82, 0xfc, 0x4f, 0x0a, 0xdf, 0xe8, 0x92, 0xf8,
-  0x96, 0xda, 0xdb, 0x54, 0xd5, 0xf4, 0x7f, 0xb2, 0xa7, 0x93, 0x3d, 0x90,
-  0x9a, 0x78, 0x9a, 0x36, 0xb6, 0x7f, 0x32, 0x07, 0x40, 0x10, 0x14, 0xf2,
-  0xd5, 0x14, 0x20, 0x59, 0x1a, 0x70, 0x0f, 0x9a, 0xff, 0x00, 0xe1, 0xe8,
-  0xdf, 0xb7, 0x5f, 0xfd, 0x17, 0x3f, 0xfc, 0xb6, 0x74, 0x7f, 0xfe, 0x44,
-  0xa0, 0x03, 0xfe, 0x1e, 0x8d, 0xfb, 0x75, 0xff, 0x00, 0xd1, 0x73, 0xff,
-  0x00, 0xcb, 0x67, 0x47, 0xff, 0x00, 0xe4, 0x4a, 0x00, 0xfb, 0x43, 0xfe,
-  0x09, 0x77, 0xfb, 0x6d, 0x7c, 0x7e, 0xfd, 0xa1, 0x7e, 0x2c, 0xf8, 0xaf,
-  0xe1, 0xaf, 0xc6, 0x7f, 0x14, 0x43, 0xe2, 0x4b, 0x78, 0x7c, 0x3a, 0xda,
-  0xed, 0x8d, 0xd9, 0xd3, 0xed, 0x2c, 0xe4, 0xb4, 0x78, 0x6e, 0x61, 0x85,
-  0xe3, 0x0b, 0x6d, 0x14, 0x61, 0xd6, 0x41, 0x74, 0x09, 0x2d, 0x92, 0xa6,
-  0x21, 0x8f, 0xbc, 0x68, 0x03, 0xf4, 0xba, 0x80, 0x0a, 0x00, 0x28, 0x00,
-  0xa0, 0x02, 0x80, 0x0a, 0x00, 0xf9, 0x1e, 0x29, 0x7f, 0xe1, 0x0a, 0xff,
-  0x00, 0x82, 0x9c, 0xce, 0xfe, 0x24, 0x9a, 0xe1, 0xe0, 0xf8, 0x89, 0xf0,
-  0xb5, 0x60, 0xf0, 0xdd, 0xdd, 0xdc, 0x4e, 0xb1, 0xa5, 0xcd, 0x95, 0xe6,
-  0xfb, 0x9d, 0x32, 0xd5, 0xfe, 0xe3, 0x1f, 0x29, 0x4d, 0xdc, 0x8b, 0x90,
-  0x57, 0x72, 0x92, 0x3e, 0x60, 0x58, 0x03, 0xeb, 0x8a, 0x00, 0xfc, 0x95,
-  0xff, 0x00, 0x82, 0xe1, 0x82, 0x7c, 0x57, 0xf0, 0x97, 0x1c, 0xe3, 0x4e,
-  0xd5, 0xf3, 0xff, 0x00, 0x7f, 0x6d, 0xa8, 0x03, 0xf3, 0x06, 0x80, 0x0a,
-  0x00, 0xfb, 0xff, 0x00, 0xfe, 0x08, 0xa9, 0xff, 0x00, 0x27, 0x4f, 0xe2,
-  0x9f, 0xfb, 0x27, 0xf7, 0xdf, 0xfa, 0x71, 0xd3, 0xa8, 0x03, 0xf6, 0xa6,
-  0x80, 0x0a, 0x00, 0x28, 0x00, 0xa0, 0x02, 0x80, 0x0a, 0x00, 0xf2, 0x4f,
-  0xda, 0x27, 0xf6, 0x6b, 0xf0, 0x1f, 0xed, 0x23, 0xe1, 0x9d, 0x3f, 0x49,
-  0xf1, 0x44, 0xfa, 0x8e, 0x8f, 0xae, 0x78, 0x7e, 0xf5, 0x35, 0x4f, 0x0e,
-  0x78, 0x9b, 0x47, 0x9b, 0xec, 0xfa, 0xa6, 0x89, 0x7a, 0x8c, 0xac, 0x25,
-  0xb7, 0x98, 0x0c, 0x80, 0x4a, 0x26, 0xe4, 0x3c, 0x1d, 0xaa, 0xc3, 0x6b,
-  0xa4, 0x6e, 0x80, 0x1e, 0x4d, 0x2e, 0x81, 0xff, 0x00, 0x05, 0x39, 0xf0,
-  0x85, 0xac, 0xfa, 0x26, 0x87, 0xf1, 0x0b, 0xe0, 0x2f, 0x8e, 0xac, 0xec,
-  0xd5, 0xcd, 0xbe, 0xbd, 0xe2, 0x2d, 0x27, 0x53, 0xd3, 0xf5, 0x5b, 0xc0,
-  0x72, 0xdf, 0xbc, 0xb6, 0xb2, 0xcd, 0xb2, 0x32, 0x92, 0x51, 0x42, 0x12,
-  0x0a, 0xaa, 0x96, 0x25, 0x89, 0xa0, 0x0f, 0xc7, 0x3b, 0xaf, 0xdb, 0x0f,
-  0xf6, 0x8c, 0xbe, 0xf8, 0xab, 0x75, 0xf1, 0xb3, 0x51, 0xf8, 0x90, 0xf7,
-  0xde, 0x34, 0xbb, 0xd2, 0x9f, 0x44, 0xfe, 0xd2, 0xbc, 0xd2, 0xac, 0x6e,
-  0x3e, 0xcd, 0x62, 0xcb, 0xb5, 0xa1, 0xb6, 0x86, 0x48, 0x4c, 0x36, 0xc0,
-  0x82, 0xf9, 0x30, 0xa2, 0x13, 0xe6, 0xca, 0x73, 0x99, 0x64, 0xdc, 0x01,
-  0xe2, 0xf4, 0x00, 0x50, 0x07, 0xd3, 0xbe, 0x04, 0xff, 0x00, 0x82, 0x91,
-  0xfe, 0xd8, 0xdf, 0x0e, 0xf4, 0x4f, 0x0f, 0x78, 0x53, 0xc3, 0xff, 0x00,
-  0x15, 0x60, 0xfe, 0xc0, 0xf0, 0xcd, 0xa5, 0xa6, 0x9f, 0x63, 0xa6, 0x4f,
-  0xe1, 0xfd, 0x35, 0xe2, 0xfb, 0x25, 0xba, 0x2a, 0x47, 0x03, 0xc9, 0xe4,
-  0x09, 0x99, 0x76, 0x20, 0x52, 0xde, 0x60, 0x72, 0x39, 0xdd, 0x9e, 0x68,
-  0x03, 0xf7, 0x87, 0xe1, 0x7f, 0x8b, 0xaf, 0x7e, 0x20, 0xfc, 0x35, 0xf0,
-  0x97, 0x8f, 0x75, 0x0d, 0x12, 0x4d, 0x1a, 0xef, 0xc4, 0x9a, 0x1d, 0x86,
-  0xaf, 0x3e, 0x9b, 0x23, 0x97, 0x7b, 0x29, 0x2e, 0x2d, 0xd2, 0x56, 0x81,
-  0x98, 0xaa, 0x92, 0x50, 0xb9, 0x52, 0x4a, 0xa9, 0x38, 0xe8, 0x3a, 0x50,
-  0x07, 0x55, 0x40, 0x05, 0x00, 0x14, 0x00, 0x50, 0x01, 0x40, 0x05, 0x00,
-  0x7c, 0x37, 0xff, 0x00, 0x05, 0x09, 0xff, 0x00, 0x82, 0x86, 0xd8, 0x7e,
-  0xcd, 0x76, 0x17, 0x3f, 0x09, 0xfe, 0x16, 0x49, 0x05, 0xff, 0x00, 0xc5,
-  0x0d, 0x42, 0xd5, 0x64, 0x7b, 0x87, 0x0b, 0x2d, 0xbf, 0x87, 0xa1, 0x90,
-  0x65, 0x66, 0x95, 0x0e, 0x44, 0x97, 0x05, 0x70, 0xd1, 0xc2, 0xc3, 0x68,
-  0x0c, 0xb2, 0x48, 0x0a, 0x6d, 0x8e, 0x50, 0x0f, 0xcb, 0x1f, 0xd9, 0xb7,
-  0xe0, 0xff, 0x00, 0x8a, 0xff, 0x00, 0x6c, 0x9f, 0xda, 0x6b, 0x4f, 0xf0,
-  0xb6, 0xb1, 0x75, 0x75, 0x33, 0x78, 0x8f, 0x53, 0x9f, 0x5d, 0xf1, 0x66,
-  0xa7, 0x6f, 0x10, 0x88, 0xc1, 0x67, 0xe6, 0x19, 0x6f, 0x27, 0x06, 0x38,
-  0x9a, 0x38, 0x5d, 0xcb, 0x79, 0x71, 0x92, 0x9e, 0x5f, 0x9b, 0x34, 0x4a,
-  0x40, 0x06, 0x80, 0x3d, 0x03, 0xc4, 0xde, 0x37, 0xf8, 0x3f, 0xf1, 0xc7,
-  0xfe, 0x0a, 0x03, 0xe0, 0x1b, 0x7f, 0x86, 0xff, 0x00, 0x0b, 0xfc, 0x23,
-  0xa2, 0xfc, 0x37, 0x8f, 0xc6, 0xda, 0x17, 0x87, 0x6c, 0x74, 0xed, 0x37,
-  0x46, 0x8e, 0xda, 0xdb, 0x58, 0xb0, 0x5d, 0x49, 0x15, 0xee, 0x6e, 0xa0,
-  0x28, 0xa1, 0xda, 0xe3, 0xcc, 0x7c, 0x87, 0x40, 0x44, 0x46, 0x38, 0xd8,
-  0x12, 0x84, 0x90, 0x09, 0x3c, 0x53, 0xe3, 0x0f, 0x85, 0xff, 0x00, 0xb3,
-  0xf7, 0xfc, 0x14, 0x2b, 0xc5, 0xf3, 0x78, 0x8f, 0xe1, 0x6f, 0x86, 0x35,
-  0x8f, 0x87, 0x56, 0x3e, 0x29, 0xbc, 0xd2, 0xf5, 0x3f, 0x0e, 0xcd, 0xa1,
-  0x5a, 0x5c, 0x5a, 0xc5, 0xa7, 0x3b, 0x85, 0x2d, 0x6f, 0x04, 0x91, 0xb2,
-  0x47, 0x24, 0x27, 0x6c, 0x89, 0xe5, 0x84, 0x27, 0x61, 0x8f, 0x70, 0x59,
-  0x1f, 0x20, 0x1c, 0x07, 0xed, 0xad, 0xf0, 0x16, 0xcb, 0xf6, 0x78, 0xf8,
-  0xff, 0x00, 0xab, 0xf8, 0x63, 0xc3, 0x12, 0xdb, 0xdc, 0x78, 0x3f, 0x5c,
-  0x8a, 0x2f, 0x12, 0xf8, 0x42, 0xe6, 0xde, 0x75, 0x9a, 0x29, 0x74, 0x7b,
-  0xa2, 0xcd, 0x0a, 0xa3, 0x79, 0xb2, 0xb3, 0xac, 0x4e, 0xb2, 0xc0, 0x1d,
-  0xdb, 0x74, 0x82, 0x11, 0x26, 0x00, 0x91, 0x68, 0x03, 0xf4, 0x97, 0xfe,
-  0x09, 0xf3, 0xff, 0x00, 0x05, 0x29, 0xbc, 0xfd, 0xa0, 0x3c, 0x41, 0x63,
-  0xf0, 0x3b, 0xe3, 0x45, 0x84, 0x36, 0xfe, 0x3a, 0x9e, 0xd9, 0x8e, 0x91,
-  0xac, 0x58, 0xdb, 0x95, 0xb7, 0xd6, 0x8c, 0x10, 0xb4, 0x93, 0x2c, 0xd1,
-  0xa8, 0xdb, 0x6f, 0x3f, 0x97, 0x1b, 0xcb, 0xb9, 0x71, 0x13, 0xe1, 0xc0,
-  0x11, 0x10, 0x89, 0x20, 0x07, 0xe8, 0x45, 0x00, 0x14, 0x00, 0x50, 0x01,
-  0x40, 0x05, 0x00, 0x78, 0x57, 0xed, 0x9f, 0xfb, 0x47, 0x5b, 0xfe, 0xcb,
-  0x9f, 0x00, 0xb5, 0xdf, 0x89, 0xb0, 0xc5, 0x6d, 0x71, 0xae, 0x48, 0xd1,
-  0xe9, 0x5e, 0x1e, 0xb4, 0xb9, 0xdd, 0xe5, 0xdc, 0x6a, 0x53, 0xe7, 0x66,
-  0xed, 0xa3, 0x95, 0x8d, 0x16, 0x59, 0x99, 0x49, 0x5d, 0xcb, 0x0b, 0x28,
-  0x65, 0x2c, 0x0d, 0x00, 0x7e, 0x4a, 0xf8, 0x3b, 0xfe, 0x0a, 0x07, 0x69,
-  0xe3, 0x7f, 0x0c, 0xe9, 0x9f, 0x0c, 0xbf, 0x6d, 0x3f, 0x84, 0x5a, 0x4f,
-  0xc6, 0x6f, 0x0c, 0xd8, 0x79, 0x76, 0xf6, 0xba, 0xd4, 0x8d, 0xf6, 0x4f,
-  0x11, 0xe9, 0x90, 0x17, 0x87, 0xcc, 0x68, 0xae, 0xd3, 0x6b, 0x4a, 0xc5,
-  0x60, 0x42, 0xc0, 0x3c, 0x32, 0x4c, 0x46, 0x25, 0x99, 0x81, 0x34, 0x01,
-  0xf5, 0x87, 0xc1, 0x3f, 0x83, 0xdf, 0xb2, 0x5e, 0x8d, 0xfb, 0x32, 0x7c,
-  0x4b, 0xf8, 0xa5, 0xf0, 0x1b, 0xe2, 0xcf, 0xfc, 0x20, 0x76, 0x9f, 0x18,
-  0xb4, 0xc9, 0x7c, 0x19, 0x63, 0xab, 0x7c, 0x53, 0x8e, 0x0b, 0x71, 0xa4,
-  0x4c, 0x44, 0xed, 0x73, 0x63, 0x6f, 0x70, 0x4c, 0x3b, 0x92, 0x58, 0xdb,
-  0x69, 0x68, 0xe5, 0x98, 0x07, 0xb6, 0x57, 0x26, 0x66, 0x85, 0xa3, 0xa0,
-  0x0f, 0x20, 0xfd, 0x9a, 0xbf, 0xe0, 0x98, 0x5f, 0x18, 0xb4, 0xff, 0x00,
-  0x89, 0xbf, 0x0f, 0x3e, 0x34, 0xe8, 0x1f, 0x16, 0xbe, 0x10, 0x78, 0xb7,
-  0xc2, 0xfe, 0x1b, 0xf1, 0x66, 0x97, 0xab, 0x5c, 0x5c, 0xf8, 0x77, 0xc4,
-  0x17, 0x37, 0xa2, 0x68, 0x6d, 0x6f, 0x22, 0x96, 0x65, 0x89, 0xc5, 0xa8,
-  0x89, 0x9c, 0x2a, 0x1f, 0x94, 0xb8, 0xe7, 0x8c, 0x8a, 0x00, 0xd5, 0xfd,
-  0xab, 0xff, 0x00, 0xe0, 0x99, 0x9f, 0x19, 0xbc, 0x5d, 0xf1, 0x77, 0xe2,
-  0x17, 0xc7, 0x1b, 0xef, 0x8a, 0x1f, 0x0a, 0x3c, 0x2d, 0xe1, 0x5d, 0x6f,
-  0x5c, 0xb8, 0xd4, 0x22, 0xb9, 0xf1, 0x16, 0xbb, 0x73, 0x67, 0xe4, 0x43,
-  0x23, 0xfc, 0x9e, 0x73, 0xfd, 0x95, 0xa3, 0x42, 0x72, 0x06, 0x37, 0x9e,
-  0x68, 0x03, 0xd4, 0xbe, 0x21, 0x7c, 0x0f, 0xfd, 0x98, 0x7c, 0x53, 0xfb,
-  0x10, 0xf8, 0x3b, 0x54, 0xf8, 0xfd, 0xf1, 0xfe, 0x4f, 0x1e, 0x5b, 0xfc,
-  0x03, 0xd3, 0xe5, 0xb1, 0xb9, 0xd6, 0xfe, 0x1a, 0x6a, 0xb6, 0x77, 0x44,
-  0xfd, 0xaa, 0x58, 0xa3, 0xb7, 0xd3, 0xc0, 0x29, 0x2a, 0x36, 0xd5, 0x16,
-  0x70, 0x23, 0x38, 0x8c, 0xe2, 0x30, 0xec, 0x51, 0x4b, 0xe0, 0x03, 0xe5,
-  0xaf, 0x13, 0x7f, 0xc1, 0x42, 0x7c, 0x25, 0xf0, 0xb3, 0x42, 0xbf, 0xf0,
-  0x17, 0xec, 0x2f, 0xf0, 0x3b, 0x49, 0xf8, 0x55, 0xa5, 0xde, 0x86, 0x8e,
-  0xe3, 0xc4, 0xda, 0x82, 0x2d, 0xff, 0x00, 0x88, 0x2f, 0x23, 0xde, 0xb2,
-  0x26, 0x5e, 0x43, 0x20, 0x8f, 0x04, 0xce, 0x9b, 0x65, 0x92, 0xe4, 0x05,
-  0x90, 0x18, 0xcc, 0x45, 0x45, 0x00, 0x7e, 0x9e, 0xfe, 0xc1, 0x3f, 0xb4,
-  0xb5, 0xc7, 0xed, 0x41, 0xfb, 0x3d, 0x69, 0x5e, 0x30, 0xd7, 0xe4, 0x0f,
-  0xe2, 0xad, 0x1a, 0x66, 0xd0, 0xfc, 0x46, 0xc1, 0x12, 0x31, 0x35, 0xec,
-  0x28, 0x8d, 0xf6, 0x85, 0x54, 0x0a, 0xa0, 0x4b, 0x1c, 0x91, 0xc8, 0x42,
-  0xaa, 0xaa, 0xbb, 0x48, 0x8a, 0x30, 0x94, 0x01, 0xf4, 0x7d, 0x00, 0x14,
-  0x00, 0x50, 0x01, 0x40, 0x1f, 0x91, 0xdf, 0xf0, 0x5b, 0x7f, 0x89, 0x37,
-  0x17, 0x5e, 0x38, 0xf8, 0x73, 0xf0, 0x7e, 0x16, 0xbe, 0x8a, 0x0d, 0x33,
-  0x49, 0xb9, 0xf1, 0x2d, 0xd0, 0xf3, 0xc8, 0xb6, 0xb9, 0x7b, 0xa9, 0x8d,
-  0xbc, 0x19, 0x8c, 0x70, 0x64, 0x88, 0x5a, 0x5c, 0x61, 0x8f, 0x41, 0x70,
-  0x40, 0xc6, 0x5b, 0x20, 0x1f, 0x99, 0x14, 0x01, 0xf6, 0xf7, 0xed, 0x7b,
-  0xa4, 0x78, 0x8b, 0xe1, 0xc7, 0xec, 0x29, 0xfb, 0x26, 0xfc, 0x39, 0x9b,
-  0x5d, 0x13, 0xe9, 0xfa, 0xce, 0x9f, 0xad, 0xf8, 0xb2, 0xe6, 0xde, 0x21,
-  0x88, 0xde, 0x4b, 0x99, 0x20, 0xba, 0xb5, 0x2c, 0x0f, 0x3b, 0xa2, 0x8b,
-  0x53, 0x9a, 0x3c, 0xf4, 0xcb, 0x3e, 0x3a, 0x8a, 0x00, 0xf9, 0xdb, 0xf6,
-  0x4e, 0xff, 0x00, 0x93, 0xa6, 0xf8, 0x37, 0xff, 0x00, 0x65, 0x03, 0xc3,
-  0xdf, 0xfa, 0x71, 0x82, 0x80, 0x37, 0x7f, 0x6e, 0x5f, 0xf9, 0x3b, 0xef,
-  0x8b, 0x9f, 0xf6, 0x35, 0x5e, 0xff, 0x00, 0xe8, 0x74, 0x01, 0xeb, 0x5f,
-  0xb0, 0xad, 0xef, 0x85, 0x3c, 0x41, 0xf0, 0x1b, 0xf6, 0xaf, 0xf8, 0x53,
-  0xe2, 0x5d, 0x35, 0xef, 0x1f, 0x52, 0xf8, 0x6e, 0xde, 0x2d, 0xb5, 0x5f,
-  0x31, 0xd1, 0x12, 0x4d, 0x18, 0x4f, 0x2c, 0x6e, 0x4a, 0x90, 0x72, 0xb7,
-  0x17, 0x16, 0xae, 0x06, 0x70, 0x7c, 0xb2, 0x08, 0x20, 0x91, 0x40, 0x1f,
-  0x19, 0xd0, 0x07, 0xe8, 0xe7, 0xfc, 0x11, 0x3b, 0xc6, 0x9a, 0xad, 0x87,
-  0xc6, 0xcf, 0x1f, 0xfc, 0x3b, 0x89, 0x6d, 0xbf, 0xb3, 0x35, 0xcf, 0x0b,
-  0xc7, 0xac, 0x4e, 0xcc, 0x87, 0xce, 0xfb, 0x45, 0x95, 0xdc, 0x71, 0x42,
-  0x11, 0xb3, 0x80, 0xbb, 0x2f, 0xe7, 0x2c, 0x30, 0x49, 0x21, 0x08, 0x23,
-  0x07, 0x20, 0x1f, 0xb1, 0x94, 0x00, 0x50, 0x01, 0x40, 0x05, 0x00, 0x7e,
-  0x60, 0x7f, 0xc1, 0x4f, 0xbf, 0x69, 0xaf, 0xf8, 0x52, 0xff, 0x00, 0x1f,
-  0x34, 0x0f, 0x0b, 0xff, 0x00, 0xc3, 0x3e, 0x7c, 0x16, 0xf1, 0xd7, 0xda,
-  0xbc, 0x21, 0x6b, 0xa8, 0x7f, 0x68, 0xf8, 0xd7, 0xc2, 0x7f, 0xda, 0x97,
-  0xd1, 0x6e, 0xbd, 0xbd, 0x4f, 0x21, 0x25, 0xf3, 0x53, 0x6c, 0x23, 0xca,
-  0xdc, 0x13, 0x1c, 0x34, 0x8e, 0x73, 0xf3, 0x50, 0x07, 0xc8, 0x1f, 0xf0,
-  0xdf, 0x43, 0xfe, 0x8c, 0xaf, 0xf6, 0x55, 0xff, 0x00, 0xc3, 0x71, 0xff,
-  0x00, 0xdd, 0x14, 0x01, 0xf5, 0xb7, 0xed, 0x9f, 0xfb, 0x4c, 0xcb, 0xf0,
-  0xeb, 0xe0, 0x87, 0xec, 0xd5, 0xe2, 0xd3, 0xfb, 0x3b, 0xfc, 0x10, 0xf1,
-  0x3c, 0x3e, 0x34, 0xf0, 0x52, 0xde, 0xad, 0x8f, 0x88, 0xbc, 0x25, 0xf6,
-  0xdb, 0x5d, 0x1d, 0x96, 0xd3, 0x4f, 0x76, 0xb7, 0xd3, 0xe3, 0xf3, 0x97,
-  0xec, 0xf0, 0x0f, 0xb4, 0x2a, 0x84, 0xcb, 0x7c, 0xb1, 0xa0, 0xcf, 0xcb,
-  0x40, 0x1e, 0x13, 0xfb, 0x3d, 0xfe, 0xdb, 0x3f, 0xf0, 0x96, 0x7c, 0x7b,
-  0xf8, 0x6b, 0xe1, 0x7f, 0xf8, 0x64, 0x8f, 0xd9, 0xaf, 0x46, 0xfe, 0xd8,
-  0xf1, 0x86, 0x8d, 0xa7, 0xff, 0x00, 0x68, 0xe9, 0x3e, 0x01, 0xfb, 0x3d,
-  0xf5, 0x97, 0x9b, 0x7b, 0x12, 0x79, 0xf6, 0xf2, 0xf9, 0xe7, 0xcb, 0x99,
-  0x37, 0x6e, 0x47, 0xc1, 0xda, 0xc0, 0x1c, 0x1c, 0x50, 0x06, 0xb7, 0xed,
-  0x53, 0xfb, 0x67, 0xff, 0x00, 0xc2, 0x0f, 0xfb, 0x46, 0xfc, 0x44, 0xf0,
-  0x8f, 0xfc, 0x32, 0x87, 0xec, 0xe7, 0xe2, 0x0f, 0xec, 0x8d, 0x7e, 0xea,
-  0xd7, 0xfb, 0x53, 0x5d, 0xf0, 0x27, 0xda, 0xf5, 0x0b, 0xbd, 0xad, 0x8f,
-  0x32, 0xe2, 0x6f, 0x3c, 0x79, 0x92, 0x1e, 0xed, 0x81, 0x9a, 0x00, 0xeb,
-  0x3f, 0x64, 0x4f, 0xda, 0xce, 0x4f, 0x1f, 0x45, 0xf1, 0xae, 0xe0, 0x7e,
-  0xcb, 0x9f, 0x01, 0x3c, 0x3d, 0x17, 0x86, 0x7e, 0x11, 0xf8, 0x87, 0x5c,
-  0x77, 0xf0, 0xff, 0x00, 0x82, 0x7e, 0xc8, 0xba, 0x83, 0x42, 0x21, 0x22,
-  0xc2, 0xf0, 0xf9, 0xcc, 0x25, 0xb4, 0x94, 0x16, 0xf3, 0x21, 0xe3, 0x7e,
-  0xc1, 0xc8, 0xdb, 0x40, 0x1f, 0x3e, 0x7f, 0xc3, 0x7d, 0x7f, 0xd5, 0x96,
-  0x7e, 0xca, 0xbf, 0xf8, 0x6e, 0x3f, 0xfb, 0xa2, 0x80, 0x3e, 0xab, 0xff,
-  0x00, 0x82, 0x6d, 0xfe, 0xd2, 0x3a, 0x97, 0xc6, 0xff, 0x00, 0xda, 0x30,
-  0xf8, 0x72, 0xc3, 0xf6, 0x72, 0xf8, 0x09, 0xe0, 0xa8, 0x74, 0xdf, 0x0f,
-  0xde, 0xea, 0xb7, 0xba, 0xa7, 0x85, 0x3c, 0x1c, 0x74, 0xed, 0x4f, 0xc9,
-  0x57, 0x8a, 0x11, 0x1c, 0x53, 0x09, 0x9b, 0x01, 0xa4, 0x9e, 0x2d, 0xc0,
-  0xa9, 0xca, 0x86, 0xf6, 0x34, 0x01, 0xfa, 0xa9, 0x40, 0x05, 0x00, 0x14,
-  0x00, 0x50, 0x07, 0xe6, 0xaf, 0xfc, 0x16, 0xa7, 0xe0, 0xf5, 0xd6, 0xbb,
-  0xf0, 0xef, 0xc1, 0x5f, 0x1b, 0x34, 0x9d, 0x3c, 0x48, 0xde, 0x15, 0xbe,
-  0x9b, 0x46, 0xd5, 0xde, 0x0b, 0x22, 0xf2, 0x0b, 0x4b, 0xb0, 0x8d, 0x04,
-  0xb3, 0x4c, 0x3e, 0xe4, 0x51, 0xcd, 0x09, 0x8c, 0x06, 0xe3, 0x7d, 0xe8,
-  0xc1, 0x05, 0xb0, 0xc0, 0x1f, 0x97, 0x3f, 0x0a, 0xbe, 0x0a, 0xfc, 0x57,
-  0xf8, 0xdf, 0xae, 0x8f, 0x0d, 0xfc, 0x27, 0xf0, 0x06, 0xb3, 0xe2, 0x6b,
-  0xe5, 0x78, 0x92, 0x6f, 0xb0, 0xdb, 0x16, 0x86, 0xd7, 0xcc, 0x24, 0x23,
-  0x5c, 0x4c, 0x71, 0x14, 0x08, 0x48, 0x3f, 0x3c, 0xac, 0xab, 0xc1, 0xe7,
-  0x8a, 0x00, 0xfd, 0x2e, 0xf8, 0x9b, 0xfb, 0x0f, 0x43, 0xa8, 0x7e, 0xc5,
-  0x5f, 0x06, 0x74, 0xaf, 0xda, 0x83, 0xe3, 0xad, 0x87, 0xc2, 0x7d, 0x47,
-  0xe1, 0x6c, 0x3a, 0xcc, 0x77, 0x97, 0x17, 0xb1, 0x26, 0xad, 0x1b, 0x8b,
-  0xfb, 0xaf, 0x3a, 0x2b, 0x45, 0x2b, 0x3c, 0x7e, 0x64, 0xb1, 0xc3, 0x04,
-  0x4a, 0xa9, 0x13, 0x49, 0xf7, 0x59, 0x50, 0x30, 0x00, 0xd0, 0x07, 0x9a,
-  0xfe, 0xcf, 0x3f, 0x0a, 0x3f, 0xe0, 0x99, 0x5e, 0x1e, 0xf8, 0x99, 0xf0,
-  0xca, 0xe7, 0x42, 0xfd, 0xa8, 0x7c, 0x7d, 0xe2, 0xdf, 0x88, 0x56, 0xde,
-  0x2a, 0xd2, 0x5b, 0x4d, 0x8e, 0xd3, 0x42, 0x9f, 0x4f, 0xd3, 0xee, 0xf5,
-  0x11, 0x7b, 0x19, 0xb6, 0x56, 0x8a, 0x7b, 0x12, 0xd1, 0xc4, 0x5f, 0xcb,
-  0x56, 0xcd, 0xc1, 0x38, 0xdc, 0x43, 0x0e, 0xc0, 0x1a, 0xbf, 0xb5, 0x17,
-  0xc3, 0x0f, 0xf8, 0x26, 0xa7, 0x89, 0x7e, 0x30, 0xfc, 0x49, 0xba, 0xf1,
-  0xcf, 0xed, 0x29, 0xe3, 0xff, 0x00, 0x07, 0xfc, 0x44, 0xb8, 0xd6, 0x6e,
-  0xbe, 0xdd, 0x0c, 0x9a, 0x34, 0xb7, 0xda, 0x7d, 0xad, 0xf1, 0x6f, 0x9b,
-  0x6c, 0x50, 0xd8, 0x96, 0x92, 0x20, 0x7f, 0x87, 0xed, 0x0a, 0x4f, 0xf7,
-  0xa8, 0x03, 0xd0, 0xbf, 0x66, 0x8f, 0xd9, 0x1e, 0xcb, 0xc3, 0x3f, 0xb2,
-  0xdf, 0xc7, 0x2b, 0xcf, 0xd9, 0x7f, 0xe3, 0x4f, 0x85, 0x3e, 0x30, 0xde,
-  0xfc, 0x51, 0xf0, 0xf4, 0x7e, 0x1e, 0xd3, 0x67, 0x9f, 0x4f, 0x7d, 0x27,
-  0xec, 0xae, 0xa9, 0x70, 0xb7, 0x96, 0xb2, 0x2b, 0x4b, 0x23, 0xc5, 0x3b,
-  0xdb, 0xdd, 0xa3, 0xc6, 0xb2, 0xf9, 0x63, 0x78, 0x84, 0xc8, 0x04, 0x67,
-  0x75, 0x00, 0x7e, 0x65, 0xfc, 0x5d, 0xf8, 0x0f, 0xf1, 0x87, 0xe0, 0x2e,
-  0xb8, 0x9e, 0x1e, 0xf8, 0xbf, 0xf0, 0xf7, 0x56, 0xf0, 0xcd, 0xdc, 0xc5,
-  0x85, 0xb3, 0xdd, 0x44, 0x1a, 0xda, 0xef, 0x62, 0xa3, 0x3f, 0xd9, 0xee,
-  0x10, 0xb4, 0x33, 0x85, 0x12, 0xc7, 0xb8, 0xc6, 0xec, 0x14, 0xb0, 0x07,
-  0x07, 0x8a, 0x00, 0xfd, 0x17, 0xff, 0x00, 0x82, 0x26, 0x7c, 0x1e, 0x75,
-  0x8f, 0xc7, 0xff, 0x00, 0x1e, 0xf5, 0x1b, 0x32, 0x04, 0x82, 0x2f, 0x09,
-  0xe9, 0x33, 0x09, 0x88, 0xc8, 0x05, 0x2e, 0x6f, 0x43, 0x47, 0xd0, 0x8c,
-  0x8b, 0x1d, 0xaf, 0xea, 0x24, 0x1e, 0xb4, 0x01, 0xfa, 0xa5, 0x40, 0x05,
-  0x00, 0x14, 0x00, 0x50, 0x07, 0x39, 0xe3, 0xef, 0x00, 0xf8, 0x3b, 0xe2,
-  0x97, 0x83, 0xb5, 0x6f, 0x87, 0xfe, 0x3f, 0xf0, 0xfd, 0xae, 0xb7, 0xe1,
-  0xed, 0x72, 0xdc, 0xdb, 0x5f, 0x58, 0xdc, 0x83, 0xb2, 0x54, 0xc8, 0x20,
-  0x82, 0x08, 0x64, 0x75, 0x60, 0xac, 0xae, 0xa4, 0x32, 0x32, 0xab, 0x29,
-  0x0c, 0xa0, 0x80, 0x0f, 0xc8, 0x9f, 0xdb, 0xb7, 0xf6, 0x82, 0xfd, 0xa1,
-  0xff, 0x00, 0x66, 0xff, 0x00, 0x16, 0xdc, 0x7e, 0xcc, 0x7f, 0x0a, 0xfc,
-  0x3f, 0x61, 0xf0, 0x67, 0xe1, 0xc6, 0x9c, 0x8b, 0x36, 0x84, 0xde, 0x11,
-  0x0f, 0x05, 0xce, 0xb3, 0x66, 0x7c, 0xa2, 0x97, 0x52, 0x5f, 0xe1, 0x65,
-  0x12, 0xf9, 0x91, 0x37, 0x99, 0xe5, 0x6c, 0x6d, 0xcf, 0x2c, 0x72, 0xbd,
-  0xc0, 0xc4, 0x8c, 0x01, 0xc6, 0xfe, 0xc0, 0x3a, 0xb2, 0xfc, 0x6a, 0xf0,
-  0x4f, 0xc6, 0x3f, 0xd8, 0xab, 0xc4, 0x7a, 0xc9, 0x49, 0x7e, 0x28, 0xe8,
-  0xad, 0xad, 0xf8, 0x5e, 0x4b, 0xdd, 0x45, 0xe2, 0x81, 0x3c, 0x41, 0x62,
-  0x44, 0xca, 0x18, 0x2c, 0x6e, 0xcd, 0xe6, 0xf9, 0x70, 0x4b, 0x2b, 0x0c,
-  0x9f, 0x2e, 0xc5, 0x86, 0xd6, 0x2c, 0x30, 0x01, 0xe0, 0x9f, 0xb3, 0x2e,
-  0x93, 0xaa, 0x68, 0x1f, 0xb5, 0xcf, 0xc2, 0x8d, 0x0f, 0x5c, 0xd3, 0x6e,
-  0xb4, 0xed, 0x4b, 0x4f, 0xf8, 0x8f, 0xa1, 0x5a, 0x5e, 0x59, 0xdd, 0xc2,
-  0xd0, 0xcf, 0x6d, 0x3c, 0x7a, 0x9c, 0x2b, 0x24, 0x52, 0x46, 0xc0, 0x32,
-  0x3a, 0xb0, 0x2a, 0x54, 0x80, 0x41, 0x04, 0x1a, 0x00, 0xd2, 0xfd, 0xb8,
-  0x55, 0xa4, 0xfd, 0xb0, 0x3e, 0x2d, 0xa2, 0x29, 0x66, 0x6f, 0x15, 0xde,
-  0x80, 0x00, 0xc9, 0x27, 0x7f, 0x4a, 0x00, 0xf6, 0x5f, 0xdb, 0x58, 0xdb,
-  0x7c, 0x05, 0xfd, 0x9e, 0x3e, 0x0d, 0xfe, 0xc5, 0x90, 0xc5, 0x66, 0x9e,
-  0x21, 0xd2, 0xa0, 0x3e, 0x3b, 0xf1, 0xdf, 0x95, 0x0d, 0xb9, 0x92, 0x2d,
-  0x62, 0xed, 0x64, 0x10, 0x5b, 0xc9, 0x34, 0x32, 0x36, 0xf9, 0x61, 0x8e,
-  0x5b, 0x88, 0xd8, 0xb6, 0x77, 0x44, 0xb6, 0x8c, 0xac, 0x54, 0x80, 0x00,
-  0x37, 0x7f, 0x62, 0x6f, 0xda, 0xa7, 0xf6, 0xa6, 0xf8, 0xb3, 0xe3, 0x8b,
-  0x1f, 0xd9, 0xd3, 0xc4, 0x9e, 0x1b, 0xb4, 0xf8, 0xf3, 0xe1, 0x1d, 0x75,
-  0xbc, 0xdd, 0x5b, 0x48, 0xf1, 0xae, 0x2e, 0x96, 0xca, 0xd5, 0x24, 0x0e,
-  0xd7, 0x93, 0x5f, 0x4a, 0x92, 0xb2, 0xc7, 0x14, 0x9e, 0x53, 0x7e, 0xf9,
-  0x66, 0x19, 0x54, 0x8e, 0x24, 0x12, 0x3c, 0x74, 0x01, 0xfb, 0x11, 0xf0,
-  0xcf, 0xe1, 0xa7, 0x81, 0xfe, 0x0f, 0x78, 0x23, 0x4c, 0xf8, 0x71, 0xf0,
-  0xdf, 0x41, 0x4d, 0x1b, 0xc3, 0x9a, 0x32, 0xc8, 0x96, 0x56, 0x49, 0x34,
-  0x93, 0x08, 0x84, 0x92, 0x34, 0xaf, 0xf3, 0xca, 0xcc, 0xec, 0x4b, 0xc8,
-  0xec, 0x4b, 0x31, 0x39, 0x63, 0x40, 0x1d, 0x55, 0x00, 0x14, 0x00, 0x50,
-  0x01, 0x40, 0x05, 0x00, 0x79, 0xa7, 0xc7, 0x7f, 0xd9, 0xf3, 0xe1, 0x67,
-  0xed, 0x23, 0xe0, 0x6b, 0xaf, 0x01, 0x7c, 0x53, 0xf0, 0xe4, 0x7a, 0x85,
-  0xa4, 0xa8, 0xff, 0x00, 0x63, 0xbd, 0x88, 0x2a, 0x5e, 0xe9, 0xb3, 0x30,
-  0xe2, 0x7b, 0x59, 0x88, 0x26, 0x39, 0x01, 0x0a, 0x7a, 0x14, 0x60, 0x36,
-  0xba, 0xba, 0x12, 0xa4, 0x03, 0xf2, 0x67, 0xe2, 0x97, 0xfc, 0x13, 0x57,
-  0xf6, 0xb0, 0xfd, 0x96, 0x7c, 0x71, 0x61, 0xf1, 0x53, 0xe0, 0x2d, 0xc3,
-  0x78, 0xf2, 0xcf, 0xc3, 0x97, 0x91, 0xea, 0x7a, 0x6e, 0xa1, 0xa2, 0xc0,
-  0x06, 0xab, 0x69, 0x24, 0x46, 0x22, 0xa2, 0x6d, 0x3d, 0xcb, 0x19, 0xb2,
-  0xee, 0xea, 0x12, 0x13, 0x38, 0x74, 0x8d, 0x8c, 0x8a, 0x81, 0xb6, 0x50,
-  0x07, 0xa8, 0x7c, 0x4e, 0xf8, 0x19, 0x1f, 0x8e, 0xfe, 0x3e, 0x7c, 0x10,
-  0xfd, 0xb7, 0x3c, 0x0b, 0xe0, 0xbb, 0xcf, 0x0a, 0xa6, 0xbd, 0xf1, 0x17,
-  0xc3, 0x36, 0x1f, 0x11, 0xbc, 0x1f, 0x75, 0x64, 0xf0, 0xde, 0xf8, 0x6b,
-  0x5e, 0x3a, 0x85, 0xb8, 0x69, 0xa7, 0x5d, 0xaa, 0x55, 0x66, 0x2d, 0x1e,
-  0x5a, 0x48, 0xe2, 0x67, 0x69, 0x60, 0x9b, 0x0d, 0xf6, 0xac, 0x20, 0x04,
-  0xfa, 0x17, 0xc0, 0x7b, 0x2d, 0x0f, 0xf6, 0xbf, 0xf8, 0xb9, 0xfb, 0x62,
-  0x7c, 0x5e, 0xf0, 0xc6, 0xaf, 0x75, 0xe1, 0x4f, 0x09, 0xf8, 0xca, 0xed,
-  0x7c, 0x0f, 0xa5, 0x5a, 0x42, 0xef, 0x7b, 0xe2, 0xcf, 0x13, 0xac, 0xc4,
-  0x5b, 0x41, 0x67, 0x6e, 0x88, 0xd2, 0xdc, 0x08, 0xe4, 0x46, 0xe5, 0x42,
-  0xaf, 0x9a, 0xa0, 0x96, 0x29, 0x05, 0xc0, 0x50, 0x0f, 0x2a, 0xf0, 0x8f,
-  0xfc, 0x13, 0xe7, 0xf6, 0xbf, 0xfd, 0xb2, 0xbe, 0x26, 0xeb, 0x1f, 0x19,
-  0xbe, 0x35, 0xd9, 0xff, 0x00, 0xc2, 0xba, 0xb5, 0xf1, 0x5d, 0xfc, 0xda,
-  0x85, 0xe5, 0xde, 0xbb, 0x14, 0xa6, 0xf2, 0x35, 0x2e, 0xe8, 0xb0, 0x5b,
-  0x69, 0xf2, 0x48, 0x6e, 0x11, 0x22, 0x11, 0xa4, 0x71, 0xa5, 0xc3, 0xc4,
-  0x04, 0x22, 0x32, 0x8c, 0xe0, 0x0c, 0x80, 0x7e, 0xa8, 0xfe, 0xce, 0x1f,
-  0xb2, 0xe7, 0xc2, 0x0f, 0xd9, 0x63, 0xc2, 0x57, 0x1e, 0x14, 0xf8, 0x55,
-  0xa2, 0x4d, 0x13, 0x6a, 0x12, 0xa4, 0xda, 0xa6, 0xa9, 0x7d, 0x20, 0x9a,
-  0xff, 0x00, 0x51, 0x91, 0x01, 0x54, 0x33, 0x4a, 0x15, 0x46, 0xd5, 0x05,
-  0xb6, 0xc6, 0x8a, 0xb1, 0xa9, 0x67, 0x2a, 0xa1, 0x9d, 0xcb, 0x00, 0x7a,
-  0xf5, 0x00, 0x14, 0x00, 0x50, 0x01, 0x40, 0x05, 0x00, 0x14, 0x00, 0x50,
-  0x01, 0x40, 0x09, 0x81, 0x40, 0x06, 0x07, 0xa0, 0xa0, 0x05, 0xa0, 0x02,
-  0x80, 0x0a, 0x00, 0x28, 0x00, 0xa0, 0x0f, 0xff, 0xd9
-};
-global unsigned int grenade_jpg_len = 3921;
-
-global u8 blank_key_img[] = {
-  0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00,
-  0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08, 0x07, 0x07, 0x07, 0x09, 0x09, 0x08,
-  0x0a, 0x0c, 0x14, 0x0d, 0x0c, 0x0b, 0x0b, 0x0c, 0x19, 0x12, 0x13, 0x0f, 0x14, 0x1d, 0x1a, 0x1f, 0x1e, 0x1d, 0x1a,
-  0x1c, 0x1c, 0x20, 0x24, 0x2e, 0x27, 0x20, 0x22, 0x2c, 0x23, 0x1c, 0x1c, 0x28, 0x37, 0x29, 0x2c, 0x30, 0x31, 0x34,
-  0x34, 0x34, 0x1f, 0x27, 0x39, 0x3d, 0x38, 0x32, 0x3c, 0x2e, 0x33, 0x34, 0x32, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x09,
-  0x09, 0x09, 0x0c, 0x0b, 0x0c, 0x18, 0x0d, 0x0d, 0x18, 0x32, 0x21, 0x1c, 0x21, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
-  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
-  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
-  0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x60, 0x00, 0x60, 0x03, 0x01, 0x22, 0x00,
-  0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01,
-  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
-  0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00,
-  0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
-  0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62,
-  0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37,
-  0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
-  0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85,
-  0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
-  0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
-  0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7,
-  0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xc4, 0x00, 0x1f, 0x01, 0x00,
-  0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03,
-  0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x11, 0x00, 0x02, 0x01, 0x02, 0x04, 0x04,
-  0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31,
-  0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09,
-  0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a,
-  0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a,
-  0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
-  0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96,
-  0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
-  0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
-  0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9,
-  0xfa, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xf9, 0xfe, 0x8a, 0x28,
-  0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a,
-  0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02,
-  0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0,
-  0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28,
-  0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a,
-  0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02,
-  0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0,
-  0x02, 0x8a, 0x28, 0xa0, 0x02, 0x8a, 0x28, 0xa0, 0x0f, 0xff, 0xd9
-};
-
-#endif // SDECK_ICONS_H
@@ -0,0 +1,415 @@
+#ifndef SDK_ACTION_C
+#define SDK_ACTION_C
+
+/*
+ * NOTE:
+ *      Key presses and gestures trigger actions run on a small worker pool.
+ *      The thread servicing the deck only pushes a job in a ring (no heap, no
+ *      blocking, dropped and counted when full), so a slow action can never
+ *      delay the next input read. Each action has a timeout bounding how long
+ *      it keeps a worker:
+ *        - SPAWN: start a command line and forget about it
+ *        - RUN:   start a command line, killed once `timeout_ms` expires
+ *        - PIPE:  write `data` to a named pipe, cancelled on timeout
+ *        - KEYS:  press then release `keys` (virtual key codes) with SendInput
+ *      Latency is measured from the key-down timestamp (sdk_now() of the
+ *      report) to the moment a worker starts the action.
+ *
+ *      Actions and bindings can be added while running, they are never
+ *      removed: slots are fixed and published with release stores.
+ */
+#define SDK_ACTION_MAX          256
+#define SDK_ACTION_WORKERS      4
+#define SDK_ACTION_QUEUE_LEN    256
+#define SDK_ACTION_ARG_LEN      512
+#define SDK_ACTION_DATA_LEN     256
+#define SDK_ACTION_KEYS_LEN     8
+#define SDK_ACTION_GESTURES     256
+#define SDK_ACTION_TIMEOUT      5'000
+#define SDK_ACTION_UNBOUND      0xFFFF
+
+enum
+{
+  SDK_ACTION_SPAWN = 1,
+  SDK_ACTION_RUN,
+  SDK_ACTION_PIPE,
+  SDK_ACTION_KEYS,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkAction
+{
+  u8            kind;
+  u32           timeout_ms;
+  char          arg[SDK_ACTION_ARG_LEN];     /* NOTE: command line / pipe name */
+  u8            data[SDK_ACTION_DATA_LEN];
+  u32           data_len;
+  u16           keys[SDK_ACTION_KEYS_LEN];
+  u32           key_count;
+  /* NOTE: Metrics, updated by the workers */
+  atomic_ullong runs;
+  atomic_ullong failures;
+  atomic_ullong timeouts;
+  atomic_ullong dropped;                     /* NOTE: Job queue was full */
+  atomic_ullong latency_total_us;
+  atomic_ullong latency_max_us;
+} SdkAction, Sdk_Action;
+
+typedef struct SdkActionJob
+{
+  u64 time;                                  /* NOTE: sdk_now() of the key down */
+  u16 action;
+  u8  key;
+} SdkActionJob, Sdk_Action_Job;
+
+typedef struct SdkActions
+{
+  SRWLOCK         lock;
+  u32             head, count;
+  Sdk_Action_Job  jobs[SDK_ACTION_QUEUE_LEN];
+  HANDLE          job_semaphore;
+  HANDLE          stop_event;
+  HANDLE          workers[SDK_ACTION_WORKERS];
+  u32             worker_count;
+  atomic_uint     action_count;
+  atomic_ushort   on_key[SDK_KEYS_MAX];
+  atomic_ushort   on_gesture[SDK_ACTION_GESTURES];
+  Sdk_Action      actions[SDK_ACTION_MAX];
+} SdkActions, Sdk_Actions;
+#pragma warning(default : 4820)
+
+static inline void
+sdk_action_max(atomic_ullong *max, u64 value)
+{
+  u64 seen;
+
+  seen = atomic_load_explicit(max, memory_order_relaxed);
+  while (value > seen && !atomic_compare_exchange_weak(max, &seen, value));
+}
+
+static bool
+sdk_action_process(Sdk_Action *action, bool wait)
+{
+  bool                ok;
+  char                cmdline[SDK_ACTION_ARG_LEN];
+  STARTUPINFOA        si;
+  PROCESS_INFORMATION pi;
+
+  memset(&si, 0, sizeof(si));
+  memset(&pi, 0, sizeof(pi));
+  si.cb = sizeof(si);
+  /* NOTE: CreateProcessA may write into the command line */
+  memcpy(cmdline, action->arg, sizeof(cmdline));
+  if (!CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi))
+  {
+    report_error("CreateProcessA");
+    return false;
+  }
+  ok = true;
+  if (wait)
+  {
+    switch (WaitForSingleObject(pi.hProcess, action->timeout_ms))
+    {
+      case WAIT_OBJECT_0: break;
+      case WAIT_TIMEOUT:
+        atomic_fetch_add(&action->timeouts, 1);
+        if (!TerminateProcess(pi.hProcess, 1)) report_error("TerminateProcess");
+        ok = false;
+        break;
+      default: report_error("WaitForSingleObject"); ok = false; break;
+    }
+  }
+  handle_close(pi.hThread);
+  handle_close(pi.hProcess);
+  return ok;
+}
+
+static bool
+sdk_action_pipe(Sdk_Action *action)
+{
+  bool       ok;
+  DWORD      written;
+  HANDLE     pipe;
+  OVERLAPPED ol;
+
+  if (!WaitNamedPipeA(action->arg, action->timeout_ms))
+  {
+    if (GetLastError() == ERROR_SEM_TIMEOUT) atomic_fetch_add(&action->timeouts, 1);
+    else report_error("WaitNamedPipeA");
+    return false;
+  }
+  pipe = CreateFileA(action->arg, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+  if (pipe == INVALID_HANDLE_VALUE) { report_error("CreateFileA"); return false; }
+  memset(&ol, 0, sizeof(ol));
+  ol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (!ol.hEvent) { report_error("CreateEvent"); handle_close(pipe); return false; }
+  ok = true;
+  if (!WriteFile(pipe, action->data, action->data_len, &written, &ol))
+  {
+    if (GetLastError() != ERROR_IO_PENDING) { report_error("WriteFile"); ok = false; }
+    else if (WaitForSingleObject(ol.hEvent, action->timeout_ms) != WAIT_OBJECT_0)
+    {
+      atomic_fetch_add(&action->timeouts, 1);
+      CancelIoEx(pipe, &ol);
+      GetOverlappedResult(pipe, &ol, &written, TRUE);
+      ok = false;
+    }
+    else ok = GetOverlappedResult(pipe, &ol, &written, FALSE) && written == action->data_len;
+  }
+  handle_close(ol.hEvent);
+  handle_close(pipe);
+  return ok;
+}
+
+/* NOTE: Presses the keys in order and releases them in reverse, a chord like ctrl+shift+x. */
+static bool
+sdk_action_keys(Sdk_Action *action)
+{
+  u32   i, n;
+  INPUT inputs[SDK_ACTION_KEYS_LEN * 2];
+
+  memset(inputs, 0, sizeof(inputs));
+  n = action->key_count;
+  for (i = 0; i < n; i++)
+  {
+    inputs[i].type               = INPUT_KEYBOARD;
+    inputs[i].ki.wVk             = action->keys[i];
+    inputs[n * 2 - 1 - i].type       = INPUT_KEYBOARD;
+    inputs[n * 2 - 1 - i].ki.wVk     = action->keys[i];
+    inputs[n * 2 - 1 - i].ki.dwFlags = KEYEVENTF_KEYUP;
+  }
+  if (SendInput(n * 2, inputs, sizeof(INPUT)) != n * 2) { report_error("SendInput"); return false; }
+  return true;
+}
+
+static void
+sdk_action_run(Sdk_Action *action)
+{
+  bool ok;
+
+  switch (action->kind)
+  {
+    case SDK_ACTION_SPAWN: ok = sdk_action_process(action, false); break;
+    case SDK_ACTION_RUN:   ok = sdk_action_process(action, true);  break;
+    case SDK_ACTION_PIPE:  ok = sdk_action_pipe(action);           break;
+    case SDK_ACTION_KEYS:  ok = sdk_action_keys(action);           break;
+    default:               ok = false;                             break;
+  }
+  if (!ok) atomic_fetch_add(&action->failures, 1);
+}
+
+static DWORD WINAPI
+sdk_action_worker(void *args)
+{
+  u64            latency;
+  bool           popped;
+  HANDLE         handles[2];
+  Sdk_Actions    *actions;
+  Sdk_Action     *action;
+  Sdk_Action_Job job;
+
+  actions    = args;
+  handles[0] = actions->stop_event;
+  handles[1] = actions->job_semaphore;
+  for (;;)
+  {
+    if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) break;
+    AcquireSRWLockExclusive(&actions->lock);
+    popped = actions->count != 0;
+    if (popped)
+    {
+      job           = actions->jobs[actions->head];
+      actions->head = (actions->head + 1) % SDK_ACTION_QUEUE_LEN;
+      actions->count--;
+    }
+    ReleaseSRWLockExclusive(&actions->lock);
+    if (!popped) continue;
+
+    action  = &actions->actions[job.action];
+    latency = sdk_ticks_to_us(sdk_now() - job.time);
+    atomic_fetch_add(&action->runs, 1);
+    atomic_fetch_add(&action->latency_total_us, latency);
+    sdk_action_max(&action->latency_max_us, latency);
+    sdk_action_run(action);
+  }
+  return EXIT_SUCCESS;
+}
+
+/* NOTE: Waits for the actions in flight, their timeouts bound how long. */
+static void
+sdk_actions_close(Sdk_Actions *actions)
+{
+  u32 i;
+
+  if (actions->stop_event) SetEvent(actions->stop_event);
+  for (i = 0; i < actions->worker_count; i++)
+  {
+    if (WaitForSingleObject(actions->workers[i], INFINITE) != WAIT_OBJECT_0) report_error("WaitForSingleObject");
+    handle_close(actions->workers[i]);
+  }
+  if (actions->job_semaphore) handle_close(actions->job_semaphore);
+  if (actions->stop_event)    handle_close(actions->stop_event);
+  actions->worker_count  = 0;
+  actions->job_semaphore = NULL;
+  actions->stop_event    = NULL;
+}
+
+static bool
+sdk_actions_open(Sdk_Actions *actions, u32 workers)
+{
+  u32 i;
+
+  memset(actions, 0, sizeof(Sdk_Actions));
+  InitializeSRWLock(&actions->lock);
+  for (i = 0; i < SDK_KEYS_MAX; i++)        atomic_init(&actions->on_key[i], SDK_ACTION_UNBOUND);
+  for (i = 0; i < SDK_ACTION_GESTURES; i++) atomic_init(&actions->on_gesture[i], SDK_ACTION_UNBOUND);
+  actions->stop_event    = CreateEvent(NULL, TRUE, FALSE, NULL);
+  actions->job_semaphore = CreateSemaphoreA(NULL, 0, SDK_ACTION_QUEUE_LEN, NULL);
+  if (!actions->stop_event || !actions->job_semaphore) { report_error("sdk_actions_open"); goto _failure; }
+  if (!workers || workers > SDK_ACTION_WORKERS) workers = SDK_ACTION_WORKERS;
+  for (i = 0; i < workers; i++)
+  {
+    actions->workers[i] = CreateThread(NULL, 0, sdk_action_worker, actions, 0, NULL);
+    if (!actions->workers[i]) { report_error("CreateThread"); goto _failure; }
+    actions->worker_count++;
+  }
+  return true;
+
+_failure:
+  sdk_actions_close(actions);
+  return false;
+}
+
+/* NOTE: Lock held. Same definition as the one sdk_action_add would store. */
+static bool
+sdk_action_same(Sdk_Action *action, u8 kind, char *arg, void *data, u32 data_len, u32 timeout_ms)
+{
+  u32 key_count;
+
+  if (action->kind != kind) return false;
+  if (action->timeout_ms != (timeout_ms ? timeout_ms : SDK_ACTION_TIMEOUT)) return false;
+  if (strncmp(action->arg, arg ? arg : "", SDK_ACTION_ARG_LEN - 1)) return false;
+  if (kind == SDK_ACTION_KEYS)
+  {
+    key_count = data_len / sizeof(u16);
+    if (key_count > SDK_ACTION_KEYS_LEN) key_count = SDK_ACTION_KEYS_LEN;
+    return action->key_count == key_count && (!key_count || !memcmp(action->keys, data, key_count * sizeof(u16)));
+  }
+  if (data_len > SDK_ACTION_DATA_LEN) data_len = SDK_ACTION_DATA_LEN;
+  if (!data) data_len = 0;
+  return action->data_len == data_len && (!data_len || !memcmp(action->data, data, data_len));
+}
+
+/*
+ * NOTE:
+ *      Returns the action id, SDK_ACTION_UNBOUND on failure. `arg` is the
+ *      command line (SPAWN, RUN) or the pipe name (PIPE), `data` the bytes
+ *      to write (PIPE) or the virtual key codes as u16 (KEYS).
+ *      Ids are never reused, so adding an action identical to an existing
+ *      one returns that one: a reloaded configuration does not use them up.
+ */
+static u16
+sdk_action_add(Sdk_Actions *actions, u8 kind, char *arg, void *data, u32 data_len, u32 timeout_ms)
+{
+  u32        id;
+  Sdk_Action *action;
+
+  AcquireSRWLockExclusive(&actions->lock);
+  id = atomic_load(&actions->action_count);
+  for (u32 i = 0; i < id; i++)
+  {
+    if (sdk_action_same(&actions->actions[i], kind, arg, data, data_len, timeout_ms))
+    {
+      ReleaseSRWLockExclusive(&actions->lock);
+      return (u16) i;
+    }
+  }
+  if (id >= SDK_ACTION_MAX) { ReleaseSRWLockExclusive(&actions->lock); printf("sdk_action_add: too many actions\n"); return SDK_ACTION_UNBOUND; }
+  action = &actions->actions[id];
+  memset(action, 0, sizeof(Sdk_Action));
+  action->kind       = kind;
+  action->timeout_ms = timeout_ms ? timeout_ms : SDK_ACTION_TIMEOUT;
+  if (arg) strncpy(action->arg, arg, SDK_ACTION_ARG_LEN - 1);
+  if (kind == SDK_ACTION_KEYS)
+  {
+    action->key_count = data_len / sizeof(u16);
+    if (action->key_count > SDK_ACTION_KEYS_LEN) action->key_count = SDK_ACTION_KEYS_LEN;
+    if (data) memcpy(action->keys, data, action->key_count * sizeof(u16));
+  }
+  else if (data)
+  {
+    action->data_len = data_len < SDK_ACTION_DATA_LEN ? data_len : SDK_ACTION_DATA_LEN;
+    memcpy(action->data, data, action->data_len);
+  }
+  atomic_store_explicit(&actions->action_count, id + 1, memory_order_release);
+  ReleaseSRWLockExclusive(&actions->lock);
+  return (u16) id;
+}
+
+/*
+ * NOTE:
+ *      Drops the actions added since the count was `count`, what a failed
+ *      configuration registered. Nothing may be bound to them.
+ */
+static void
+sdk_actions_truncate(Sdk_Actions *actions, u32 count)
+{
+  AcquireSRWLockExclusive(&actions->lock);
+  if (count < atomic_load(&actions->action_count)) atomic_store_explicit(&actions->action_count, count, memory_order_release);
+  ReleaseSRWLockExclusive(&actions->lock);
+}
+
+static inline void
+sdk_action_bind_key(Sdk_Actions *actions, u8 key, u16 action)
+{
+  atomic_store_explicit(&actions->on_key[key], action, memory_order_release);
+}
+
+static inline void
+sdk_action_bind_gesture(Sdk_Actions *actions, u16 gesture_id, u16 action)
+{
+  if (gesture_id < SDK_ACTION_GESTURES) atomic_store_explicit(&actions->on_gesture[gesture_id], action, memory_order_release);
+}
+
+/* NOTE: Service thread, never blocks. */
+static void
+sdk_action_trigger(Sdk_Actions *actions, u16 action, u8 key, u64 time)
+{
+  bool           pushed;
+  Sdk_Action_Job *job;
+
+  if (action == SDK_ACTION_UNBOUND || action >= atomic_load_explicit(&actions->action_count, memory_order_acquire)) return;
+  AcquireSRWLockExclusive(&actions->lock);
+  pushed = actions->count < SDK_ACTION_QUEUE_LEN;
+  if (pushed)
+  {
+    job         = &actions->jobs[(actions->head + actions->count) % SDK_ACTION_QUEUE_LEN];
+    job->time   = time;
+    job->action = action;
+    job->key    = key;
+    actions->count++;
+  }
+  ReleaseSRWLockExclusive(&actions->lock);
+  if (!pushed) { atomic_fetch_add(&actions->actions[action].dropped, 1); return; }
+  ReleaseSemaphore(actions->job_semaphore, 1, NULL);
+}
+
+static void
+sdk_actions_report(Sdk_Actions *actions)
+{
+  u32        i, count;
+  u64        runs;
+  Sdk_Action *action;
+
+  count = atomic_load(&actions->action_count);
+  for (i = 0; i < count; i++)
+  {
+    action = &actions->actions[i];
+    runs   = atomic_load(&action->runs);
+    printf("action %u: %llu runs, %llu failed, %llu timed out, %llu dropped, latency avg %llu us max %llu us\n",
+           i, runs, atomic_load(&action->failures), atomic_load(&action->timeouts), atomic_load(&action->dropped),
+           runs ? atomic_load(&action->latency_total_us) / runs : 0, atomic_load(&action->latency_max_us));
+  }
+}
+
+#endif // SDK_ACTION_C
@@ -0,0 +1,298 @@
+#ifndef SDK_ASSETS_C
+#define SDK_ASSETS_C
+
+/*
+ * NOTE:
+ *      Asset pack: one file mapped read-only at startup, every asset used
+ *      straight out of the view, nothing parsed or copied. Opening only
+ *      checks the header, whatever the number of assets, and the pages are
+ *      the file's own so every process mapping the pack shares them.
+ *
+ *        Sdk_Asset_Header
+ *        Sdk_Asset_Entry[slot_count]   open addressing on sdk_asset_hash(name),
+ *                                      linear probing, hash 0 = empty slot
+ *        blobs                         SDK_ASSET_ALIGN aligned
+ *
+ *      Blobs are encoded key images (JPEG), key images compiled for one
+ *      deck model (KEY "<name>@<pid>": resized, rotated, encoded and cut
+ *      into that model's output reports, the key index left to fill in),
+ *      glyph atlases and font metrics (Sdk_Asset_Font followed by its
+ *      glyphs, sorted by id). Models that want the same reports share one
+ *      blob. The pack is written by asset_compiler.c, offsets and sizes are
+ *      checked against the file on every lookup so a bad pack only loses
+ *      its assets.
+ */
+#define SDK_ASSET_MAGIC     0x4B504442       /* NOTE: "BDPK" */
+#define SDK_ASSET_VERSION   1
+#define SDK_ASSET_ALIGN     64
+#define SDK_ASSET_NAME_LEN  32
+#define SDK_ASSET_FILE      "betterdeck.pack"
+#define SDK_ASSET_ENV       "BETTERDECK_ASSETS"
+#define SDK_BLANK_SIZES     8
+
+enum
+{
+  SDK_ASSET_IMAGE = 1,                       /* NOTE: Encoded key image */
+  SDK_ASSET_ATLAS,                           /* NOTE: Glyph atlas of a font */
+  SDK_ASSET_FONT,                            /* NOTE: Sdk_Asset_Font */
+  SDK_ASSET_KEY,                             /* NOTE: Output reports of one model */
+};
+
+enum
+{
+  SDK_ASSET_RAW = 0,
+  SDK_ASSET_JPEG,
+  SDK_ASSET_PNG,
+  SDK_ASSET_A8,                              /* NOTE: 8-bit coverage, width * height */
+  SDK_ASSET_REPORTS,                         /* NOTE: KEY: report_len byte reports */
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkAssetHeader
+{
+  u32 magic;
+  u32 version;
+  u64 file_size;
+  u32 slot_count;                            /* NOTE: Power of two */
+  u32 asset_count;
+  u64 directory;                             /* NOTE: Offset of the slots */
+} SdkAssetHeader, Sdk_Asset_Header;
+
+typedef struct SdkAssetEntry
+{
+  u64  hash;
+  u64  offset;
+  u32  size;
+  u16  kind;
+  u16  format;
+  u16  width, height;
+  u32  param;                                /* NOTE: KEY: bytes of the encoded image */
+  char name[SDK_ASSET_NAME_LEN];             /* NOTE: Zero padded, not terminated at full length */
+} SdkAssetEntry, Sdk_Asset_Entry;
+
+typedef struct SdkAssetGlyph
+{
+  u32 id;                                    /* NOTE: Code point */
+  u16 x, y, w, h;                            /* NOTE: In the atlas */
+  i16 xoffset, yoffset, xadvance;
+  u16 page;
+} SdkAssetGlyph, Sdk_Asset_Glyph;
+
+typedef struct SdkAssetFont
+{
+  u16  line_height, base;
+  u16  scale_w, scale_h;                     /* NOTE: Atlas size */
+  u32  glyph_count;
+  u32  reserved;
+  char atlas[SDK_ASSET_NAME_LEN];            /* NOTE: SDK_ASSET_ATLAS entry of page 0 */
+} SdkAssetFont, Sdk_Asset_Font;
+
+typedef struct SdkAssets
+{
+  File             file;
+  Sdk_Asset_Header *header;                  /* NOTE: NULL without a pack */
+  Sdk_Asset_Entry  *slots;
+} SdkAssets, Sdk_Assets;
+
+/* NOTE: Encoded once per key size, see sdk_blank_key */
+typedef struct SdkBlankKey
+{
+  u32 pxl;
+  u32 size;
+  u8  *data;
+} SdkBlankKey, Sdk_Blank_Key;
+#pragma warning(default : 4820)
+
+global Sdk_Assets    g_assets;
+global Sdk_Blank_Key g_blank_keys[SDK_BLANK_SIZES];
+
+/* NOTE: The compiler hashes names the same way. */
+static inline u64
+sdk_asset_hash(char *name)
+{
+  u32 len;
+
+  for (len = 0; len < SDK_ASSET_NAME_LEN && name[len]; len++) {}
+  return sdk_image_hash((u8*) name, len);
+}
+
+/* NOTE: %`env`% when it is set, else `name` next to the executable. False when the path does not fit. */
+static bool
+sdk_app_file(char *buffer, char *env, char *name)
+{
+  u32  len;
+  char *slash;
+
+  if (GetEnvironmentVariableA(env, buffer, MAX_PATH)) return true;
+  len = (u32) GetModuleFileNameA(NULL, buffer, MAX_PATH);
+  if (!len || len >= MAX_PATH) { report_error("GetModuleFileNameA"); return false; }
+  slash = strrchr(buffer, '\\');
+  if (slash) slash[1] = 0;
+  else       buffer[0] = 0;
+  if (strlen(buffer) + strlen(name) >= MAX_PATH) { printf("%s: path too long\n", name); return false; }
+  strcat(buffer, name);
+  return true;
+}
+
+/*
+ * NOTE:
+ *      `path` NULL uses %BETTERDECK_ASSETS% or betterdeck.pack next to the
+ *      executable. A missing pack is not an error, there are just no assets.
+ */
+static bool
+sdk_assets_open(Sdk_Assets *assets, char *path)
+{
+  char             buffer[MAX_PATH];
+  Sdk_Asset_Header *header;
+
+  memset(assets, 0, sizeof(Sdk_Assets));
+  if (!path)
+  {
+    path = buffer;
+    if (!sdk_app_file(buffer, SDK_ASSET_ENV, SDK_ASSET_FILE)) return false;
+  }
+  if (file_exist_open_map_ro(path, &assets->file) != CM_OK) { printf("assets: no pack at %s\n", path); return false; }
+
+  header = (Sdk_Asset_Header*) assets->file.buffer.view;
+  if (assets->file.buffer.size < sizeof(Sdk_Asset_Header)
+      || header->magic != SDK_ASSET_MAGIC || header->version != SDK_ASSET_VERSION
+      || header->file_size != assets->file.buffer.size
+      || !header->slot_count || (header->slot_count & (header->slot_count - 1))
+      || header->directory % sizeof(u64)
+      || header->directory > header->file_size
+      || (u64) header->slot_count * sizeof(Sdk_Asset_Entry) > header->file_size - header->directory)
+  {
+    printf("assets: %s is not a version %u pack\n", path, SDK_ASSET_VERSION);
+    file_close(&assets->file);
+    memset(assets, 0, sizeof(Sdk_Assets));
+    return false;
+  }
+  assets->header = header;
+  assets->slots  = (Sdk_Asset_Entry*)(assets->file.buffer.view + header->directory);
+  printf("assets: %s, %u assets\n", path, header->asset_count);
+  return true;
+}
+
+static void
+sdk_assets_close(Sdk_Assets *assets)
+{
+  u32 i;
+
+  if (assets->header) file_close(&assets->file);
+  memset(assets, 0, sizeof(Sdk_Assets));
+  for (i = 0; i < SDK_BLANK_SIZES; i++)
+  {
+    if (g_blank_keys[i].data) heap_free_dz(g_blank_keys[i].data);
+  }
+  memset(g_blank_keys, 0, sizeof(g_blank_keys));
+}
+
+/* NOTE: Any thread. NULL when there is no such asset of that kind. */
+static Sdk_Asset_Entry*
+sdk_asset_find(Sdk_Assets *assets, char *name, u16 kind)
+{
+  u32             i, slot, mask;
+  u64             hash;
+  Sdk_Asset_Entry *entry;
+
+  if (!assets->header || !name) return NULL;
+  hash = sdk_asset_hash(name);
+  mask = assets->header->slot_count - 1;
+  for (i = 0, slot = (u32) hash & mask; i <= mask; i++, slot = (slot + 1) & mask)
+  {
+    entry = &assets->slots[slot];
+    if (!entry->hash) return NULL;
+    if (entry->hash != hash || entry->kind != kind || strncmp(entry->name, name, SDK_ASSET_NAME_LEN)) continue;
+    if (entry->offset > assets->header->file_size || entry->size > assets->header->file_size - entry->offset) return NULL;
+    return entry;
+  }
+  return NULL;
+}
+
+static inline u8*
+sdk_asset_data(Sdk_Assets *assets, Sdk_Asset_Entry *entry)
+{
+  return assets->file.buffer.view + entry->offset;
+}
+
+/* NOTE: The compiled reports of `name` for model `pid`, NULL when the pack has none. */
+static Sdk_Asset_Entry*
+sdk_asset_key(Sdk_Assets *assets, char *name, u16 pid)
+{
+  char full[SDK_ASSET_NAME_LEN + 8];
+
+  if (snprintf(full, sizeof(full), "%s@%04x", name, pid) > SDK_ASSET_NAME_LEN) return NULL;
+  return sdk_asset_find(assets, full, SDK_ASSET_KEY);
+}
+
+/* NOTE: Encoded image bytes inside the mapping, valid until sdk_assets_close. */
+static u8*
+sdk_asset_image(Sdk_Assets *assets, char *name, u32 *size)
+{
+  Sdk_Asset_Entry *entry;
+
+  entry = sdk_asset_find(assets, name, SDK_ASSET_IMAGE);
+  *size = entry ? entry->size : 0;
+  return entry ? sdk_asset_data(assets, entry) : NULL;
+}
+
+static Sdk_Asset_Font*
+sdk_asset_font(Sdk_Assets *assets, char *name)
+{
+  Sdk_Asset_Font  *font;
+  Sdk_Asset_Entry *entry;
+
+  entry = sdk_asset_find(assets, name, SDK_ASSET_FONT);
+  if (!entry || entry->size < sizeof(Sdk_Asset_Font)) return NULL;
+  font = (Sdk_Asset_Font*) sdk_asset_data(assets, entry);
+  if (font->glyph_count > (entry->size - sizeof(Sdk_Asset_Font)) / sizeof(Sdk_Asset_Glyph)) return NULL;
+  return font;
+}
+
+/* NOTE: Binary search, NULL when the font has no glyph for `id`. */
+static Sdk_Asset_Glyph*
+sdk_font_glyph(Sdk_Asset_Font *font, u32 id)
+{
+  u32             lo, hi, mid;
+  Sdk_Asset_Glyph *glyphs;
+
+  glyphs = (Sdk_Asset_Glyph*)(font + 1);
+  lo     = 0;
+  hi     = font->glyph_count;
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    if (glyphs[mid].id == id) return &glyphs[mid];
+    if (glyphs[mid].id < id) lo = mid + 1;
+    else                     hi = mid;
+  }
+  return NULL;
+}
+
+/*
+ * NOTE:
+ *      Black `pxl` x `pxl` JPEG, encoded the first time a deck of that key
+ *      size shows up, shared by every deck of that size. Main thread.
+ */
+static u8*
+sdk_blank_key(u32 pxl, u32 *size)
+{
+  u32   i;
+  Image black;
+
+  for (i = 0; i < SDK_BLANK_SIZES && g_blank_keys[i].data; i++)
+  {
+    if (g_blank_keys[i].pxl == pxl) { *size = g_blank_keys[i].size; return g_blank_keys[i].data; }
+  }
+  *size = 0;
+  if (i == SDK_BLANK_SIZES || !image_alloc(&black, pxl, pxl)) return NULL;
+  memset(black.pixels, 0, (u64) pxl * pxl * 3);
+  g_blank_keys[i].data = jpeg_encode(&black, 90, &g_blank_keys[i].size);
+  image_free(&black);
+  if (!g_blank_keys[i].data) return NULL;
+  g_blank_keys[i].pxl = pxl;
+  *size = g_blank_keys[i].size;
+  return g_blank_keys[i].data;
+}
+
+#endif // SDK_ASSETS_C
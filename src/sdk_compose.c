@@ -0,0 +1,832 @@
+#ifndef SDK_COMPOSE_C
+#define SDK_COMPOSE_C
+
+#pragma warning(push, 0)
+#include <emmintrin.h>
+#pragma warning(pop)
+
+/*
+ * NOTE:
+ *      Key compositor: a key image built from layers, bottom first:
+ *
+ *        FILL, GRADIENT   background, solid or top to bottom
+ *        ICON             encoded image (JPEG, PNG), centered, `percent` of the key
+ *        TEXT             label in an asset pack font (BMFont), with a shadow
+ *        BADGE            disc in the top right corner with a short text
+ *        BAR              progress bar along the bottom, `percent` filled
+ *        DIGITS           seven segment digits (0-9, ':', '-', '.'), no font needed
+ *
+ *      Every layer is rasterized on its own at the key size into
+ *      premultiplied RGBA and kept in g_compose, keyed by everything that
+ *      changes its pixels: a dashboard key whose badge moves re-rasterizes
+ *      the badge and blends, the icon under it is not decoded again.
+ *      Blending is `dst = src + dst * (255 - src.a) / 255`, four pixels at a
+ *      time with SSE2, only over the rows a layer covers, starting from the
+ *      topmost opaque layer. The result is encoded, packed and goes through
+ *      the tile cache like any fitted image, so a composition seen before
+ *      (a clock's minute, a meter's level) costs a lookup.
+ *
+ *      Fonts are decoded once, their atlas turned into 8-bit coverage; text
+ *      larger than its box is scaled down by area averaging.
+ */
+#define SDK_COMPOSE_LAYERS   8
+#define SDK_COMPOSE_ENTRIES  128
+#define SDK_COMPOSE_BUDGET   (8u << 20)      /* NOTE: Bytes of rasters kept */
+#define SDK_COMPOSE_FONTS    8
+#define SDK_COMPOSE_FONT     "default"       /* NOTE: Asset pack font of a layer without one */
+
+enum
+{
+  SDK_LAYER_FILL = 1,
+  SDK_LAYER_GRADIENT,
+  SDK_LAYER_ICON,
+  SDK_LAYER_TEXT,
+  SDK_LAYER_BADGE,
+  SDK_LAYER_BAR,
+  SDK_LAYER_DIGITS,
+};
+
+enum
+{
+  SDK_ALIGN_BOTTOM = 0,
+  SDK_ALIGN_CENTER,
+  SDK_ALIGN_TOP,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkLayer
+{
+  u8   kind;
+  u8   align;                                /* NOTE: TEXT, DIGITS */
+  u8   percent;                              /* NOTE: ICON: size, 0 = whole key. BAR: filled. DIGITS: height, 0 = 40 */
+  u32  color, color2;                        /* NOTE: 0xRRGGBB. GRADIENT: top, bottom. BAR: fill, track */
+  u8   *data;                                /* NOTE: ICON: encoded image */
+  u32  size;
+  u64  hash;                                 /* NOTE: ICON: sdk_image_hash of `data`, 0 computes it */
+  char *text;                                /* NOTE: TEXT, BADGE, DIGITS */
+  char *font;                                /* NOTE: TEXT, BADGE: NULL = SDK_COMPOSE_FONT */
+} SdkLayer, Sdk_Layer;
+
+/* NOTE: Hashed whole into the layer key, zero what is unused */
+typedef struct SdkLayerKey
+{
+  u64 data;
+  u64 text;
+  u64 font;                                  /* NOTE: TEXT, BADGE: Sdk_Compose_Font hash */
+  u32 color, color2;
+  u16 pxl;
+  u8  kind, align, percent;
+  u8  pad[3];
+} SdkLayerKey, Sdk_Layer_Key;
+
+/* NOTE: Premultiplied RGBA, w * h * 4 */
+typedef struct SdkRaster
+{
+  u32  w, h;
+  u32  y0, y1;                               /* NOTE: Rows with any coverage, [y0, y1) */
+  bool opaque;
+  u8   *pixels;
+} SdkRaster, Sdk_Raster;
+
+typedef struct SdkLayerEntry
+{
+  u64        key;                            /* NOTE: 0 = free */
+  u64        used;
+  u32        refs;                           /* NOTE: Being blended, not evicted */
+  bool       owned;                          /* NOTE: False: did not fit, freed on release */
+  Sdk_Raster raster;
+} SdkLayerEntry, Sdk_Layer_Entry;
+
+typedef struct SdkComposeFont
+{
+  char           name[SDK_ASSET_NAME_LEN + 1];
+  Sdk_Asset_Font *font;                      /* NOTE: In the asset pack mapping */
+  u8             *coverage;                  /* NOTE: w * h */
+  u32            w, h;
+  u64            hash;                       /* NOTE: Of the metrics and atlas bytes, part of the layer key */
+} SdkComposeFont, Sdk_Compose_Font;
+
+typedef struct SdkCompose
+{
+  SRWLOCK          lock;
+  Sdk_Layer_Entry  entries[SDK_COMPOSE_ENTRIES];
+  Sdk_Compose_Font fonts[SDK_COMPOSE_FONTS];
+  u32              font_count;
+  u64              clock;
+  u64              bytes;
+  /* NOTE: Stats */
+  u64              hits, misses, evicted;
+  atomic_ullong    composed, reused;
+} SdkCompose, Sdk_Compose;
+#pragma warning(default : 4820)
+
+global Sdk_Compose g_compose;                /* NOTE: Ready zeroed, SRWLOCK_INIT is 0 */
+
+/* -- Fonts -------------------------------------------------------------------------- */
+
+/* NOTE: Lock held. The font `name` of the asset pack, decoded the first time. NULL without one. */
+static Sdk_Compose_Font*
+sdk_compose_font(char *name)
+{
+  u32              i, x;
+  u8               *pixel;
+  Image            atlas;
+  Sdk_Asset_Font   *font;
+  Sdk_Asset_Entry  *entry;
+  Sdk_Compose_Font *slot;
+
+  if (!name) name = SDK_COMPOSE_FONT;
+  for (i = 0; i < g_compose.font_count; i++)
+  {
+    if (!strncmp(g_compose.fonts[i].name, name, SDK_ASSET_NAME_LEN)) return g_compose.fonts[i].coverage ? &g_compose.fonts[i] : NULL;
+  }
+  if (g_compose.font_count == SDK_COMPOSE_FONTS) return NULL;
+  /* NOTE: A missing font is remembered too, asked for again it is not looked up */
+  slot = &g_compose.fonts[g_compose.font_count++];
+  strncpy(slot->name, name, SDK_ASSET_NAME_LEN);
+  font  = sdk_asset_font(&g_assets, name);
+  entry = font ? sdk_asset_find(&g_assets, font->atlas, SDK_ASSET_ATLAS) : NULL;
+  if (!entry) { printf("compose: no font %s in the asset pack\n", name); return NULL; }
+  if (entry->format == SDK_ASSET_A8)
+  {
+    if ((u64) entry->width * entry->height > entry->size) return NULL;
+    cm_heap_alloc((u64) entry->width * entry->height, slot->coverage);
+    if (!slot->coverage) return NULL;
+    memcpy(slot->coverage, sdk_asset_data(&g_assets, entry), (u64) entry->width * entry->height);
+    slot->w = entry->width;
+    slot->h = entry->height;
+  }
+  else
+  {
+    /* NOTE: White glyphs on transparent came out over black, any channel is the coverage */
+    if (!png_decode(sdk_asset_data(&g_assets, entry), entry->size, &atlas)) { printf("compose: cannot decode the atlas of %s\n", name); return NULL; }
+    cm_heap_alloc((u64) atlas.w * atlas.h, slot->coverage);
+    if (slot->coverage)
+    {
+      for (x = 0, pixel = atlas.pixels; x < atlas.w * atlas.h; x++, pixel += 3)
+      {
+        slot->coverage[x] = pixel[0] > pixel[1] ? (pixel[0] > pixel[2] ? pixel[0] : pixel[2]) : (pixel[1] > pixel[2] ? pixel[1] : pixel[2]);
+      }
+      slot->w = atlas.w;
+      slot->h = atlas.h;
+    }
+    image_free(&atlas);
+    if (!slot->coverage) return NULL;
+  }
+  /* NOTE: The tile cache outlives the pack, a font rebuilt under the same name must not hit its old tiles */
+  slot->hash = sdk_image_hash((u8*) font, (u32)(sizeof(Sdk_Asset_Font) + font->glyph_count * sizeof(Sdk_Asset_Glyph)))
+             ^ sdk_image_hash(sdk_asset_data(&g_assets, entry), entry->size) * 0x9E3779B97F4A7C15ull;
+  slot->font = font;
+  return slot;
+}
+
+/* NOTE: Any thread. Identity of the font `name` for the layer key, 0 without one. */
+static u64
+sdk_compose_font_hash(char *name)
+{
+  u64              hash;
+  Sdk_Compose_Font *font;
+
+  AcquireSRWLockExclusive(&g_compose.lock);
+  font = sdk_compose_font(name);
+  hash = font ? font->hash : 0;
+  ReleaseSRWLockExclusive(&g_compose.lock);
+  return hash;
+}
+
+/* NOTE: Width of `text` in font units, missing glyphs take no room. */
+static u32
+sdk_compose_text_width(Sdk_Compose_Font *font, char *text)
+{
+  i32             width;
+  Sdk_Asset_Glyph *glyph;
+
+  for (width = 0; *text; text++)
+  {
+    glyph = sdk_font_glyph(font->font, (u8) *text);
+    if (glyph) width += glyph->xadvance;
+  }
+  return width > 0 ? (u32) width : 0;
+}
+
+/*
+ * NOTE:
+ *      `text` into the `box_w` x `box_h` box at (`box_x`, `box_y`) of the
+ *      `stride` wide coverage `out`, centered, scaled down to fit. Coverage
+ *      is the max of what is already there.
+ */
+static void
+sdk_compose_text(Sdk_Compose_Font *font, char *text, u8 *out, u32 stride, u32 rows,
+                 i32 box_x, i32 box_y, u32 box_w, u32 box_h, u8 align)
+{
+  i32             pen, x, y, gx, gy, sx, sy, sx0, sx1, sy0, sy1;
+  u32             width, scale, gw, gh, sum, n;
+  u8              *dst;
+  Sdk_Asset_Glyph *glyph;
+
+  cm_stack_mark(&pen);
+  width = sdk_compose_text_width(font, text);
+  if (!width || !font->font->line_height) return;
+  /* NOTE: 16.16, never scaled up */
+  scale = 1u << 16;
+  if (width > box_w)                                     scale = (box_w << 16) / width;
+  if ((font->font->line_height * scale >> 16) > box_h)  scale = (box_h << 16) / font->font->line_height;
+  pen = box_x + (i32)((box_w - ((width * scale) >> 16)) / 2);
+  switch (align)
+  {
+    case SDK_ALIGN_TOP:    break;
+    case SDK_ALIGN_CENTER: box_y += (i32)(box_h - ((font->font->line_height * scale) >> 16)) / 2; break;
+    default:               box_y += (i32)(box_h - ((font->font->line_height * scale) >> 16));     break;
+  }
+  for (; *text; text++)
+  {
+    glyph = sdk_font_glyph(font->font, (u8) *text);
+    if (!glyph) continue;
+    gx = pen   + ((glyph->xoffset * (i32) scale) >> 16);
+    gy = box_y + ((glyph->yoffset * (i32) scale) >> 16);
+    gw = (glyph->w * scale + 0xFFFF) >> 16;
+    gh = (glyph->h * scale + 0xFFFF) >> 16;
+    pen += (glyph->xadvance * (i32) scale) >> 16;
+    if ((u32) glyph->x + glyph->w > font->w || (u32) glyph->y + glyph->h > font->h || !gw || !gh) continue;
+    for (y = 0; y < (i32) gh; y++)
+    {
+      if (gy + y < 0 || gy + y >= (i32) rows) continue;
+      sy0 = glyph->y + (y * glyph->h) / (i32) gh;
+      sy1 = glyph->y + ((y + 1) * glyph->h) / (i32) gh;
+      if (sy1 <= sy0) sy1 = sy0 + 1;
+      for (x = 0; x < (i32) gw; x++)
+      {
+        if (gx + x < 0 || gx + x >= (i32) stride) continue;
+        sx0 = glyph->x + (x * glyph->w) / (i32) gw;
+        sx1 = glyph->x + ((x + 1) * glyph->w) / (i32) gw;
+        if (sx1 <= sx0) sx1 = sx0 + 1;
+        /* NOTE: Area average of the source texels under this pixel */
+        for (sum = n = 0, sy = sy0; sy < sy1; sy++)
+        {
+          for (sx = sx0; sx < sx1; sx++, n++) sum += font->coverage[(u64) sy * font->w + sx];
+        }
+        dst  = out + (u64)(gy + y) * stride + gx + x;
+        if (sum / n > *dst) *dst = (u8)(sum / n);
+      }
+    }
+  }
+}
+
+/* -- Rasters ------------------------------------------------------------------------ */
+
+static inline void
+sdk_raster_put(u8 *p, u32 color, u32 alpha)
+{
+  p[0] = (u8)((((color >> 16) & 0xFF) * alpha + 127) / 255);
+  p[1] = (u8)((((color >>  8) & 0xFF) * alpha + 127) / 255);
+  p[2] = (u8)((( color        & 0xFF) * alpha + 127) / 255);
+  p[3] = (u8) alpha;
+}
+
+/* NOTE: Covered rows from the alpha channel. */
+static void
+sdk_raster_bounds(Sdk_Raster *raster)
+{
+  u32 x, y;
+  u8  *row;
+
+  raster->y0 = raster->h;
+  raster->y1 = 0;
+  for (y = 0; y < raster->h; y++)
+  {
+    row = raster->pixels + (u64) y * raster->w * 4;
+    for (x = 0; x < raster->w && !row[x * 4 + 3]; x++) {}
+    if (x == raster->w) continue;
+    if (raster->y0 == raster->h) raster->y0 = y;
+    raster->y1 = y + 1;
+  }
+  if (raster->y0 == raster->h) raster->y0 = 0;
+}
+
+/* NOTE: Label coverage plus a one pixel shadow down right, in `color`. */
+static bool
+sdk_raster_text(Sdk_Raster *raster, Sdk_Layer *layer)
+{
+  u32              i, pxl, margin, t, s;
+  u8               *coverage;
+  Sdk_Compose_Font *font;
+
+  pxl    = raster->w;
+  margin = pxl / 16;
+  AcquireSRWLockExclusive(&g_compose.lock);
+  font = sdk_compose_font(layer->font);
+  ReleaseSRWLockExclusive(&g_compose.lock);
+  if (!font || !layer->text) return true;
+  coverage = NULL;
+  cm_heap_alloc((u64) pxl * pxl, coverage);
+  if (!coverage) return false;
+  sdk_compose_text(font, layer->text, coverage, pxl, pxl, (i32) margin, (i32) margin, pxl - margin * 2, pxl - margin * 2, layer->align);
+  for (i = 0; i < pxl * pxl; i++)
+  {
+    t = coverage[i];
+    s = (i % pxl && i >= pxl) ? coverage[i - pxl - 1] : 0;
+    if (!t && !s) continue;
+    /* NOTE: Text over a black shadow, the shadow only adds alpha */
+    sdk_raster_put(raster->pixels + (u64) i * 4, layer->color, t);
+    raster->pixels[i * 4 + 3] = (u8)(t + (s * (255 - t) + 127) / 255);
+  }
+  heap_free_dz(coverage);
+  return true;
+}
+
+/* NOTE: Anti-aliased disc in the top right corner, `text` in white on it. */
+static bool
+sdk_raster_badge(Sdk_Raster *raster, Sdk_Layer *layer)
+{
+  i32              x, y, cx, cy, r, d2;
+  u32              pxl, text_cov, disc, color;
+  f32              dist;
+  u8               *coverage, *p;
+  Sdk_Compose_Font *font;
+
+  pxl = raster->w;
+  r   = (i32) pxl / 5;
+  cx  = (i32) pxl - r - (i32) pxl / 24 - 1;
+  cy  = r + (i32) pxl / 24;
+  coverage = NULL;
+  AcquireSRWLockExclusive(&g_compose.lock);
+  font = sdk_compose_font(layer->font);
+  ReleaseSRWLockExclusive(&g_compose.lock);
+  if (font && layer->text)
+  {
+    cm_heap_alloc((u64) pxl * pxl, coverage);
+    if (!coverage) return false;
+    /* NOTE: Inside the square the disc holds */
+    sdk_compose_text(font, layer->text, coverage, pxl, pxl, cx - r * 7 / 10, cy - r * 7 / 10, (u32)(r * 14 / 10), (u32)(r * 14 / 10), SDK_ALIGN_CENTER);
+  }
+  for (y = cy - r - 1; y <= cy + r + 1; y++)
+  {
+    for (x = cx - r - 1; x <= cx + r + 1; x++)
+    {
+      if (x < 0 || y < 0 || x >= (i32) pxl || y >= (i32) pxl) continue;
+      d2   = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+      dist = sqrtf((f32) d2);
+      if (dist >= (f32) r + 0.5f) continue;
+      disc     = dist <= (f32) r - 0.5f ? 255 : (u32)(((f32) r + 0.5f - dist) * 255.0f);
+      text_cov = coverage ? coverage[(u64) y * pxl + x] : 0;
+      color    = ((((layer->color >> 16) & 0xFF) * (255 - text_cov) + 255 * text_cov) / 255) << 16
+               | ((((layer->color >>  8) & 0xFF) * (255 - text_cov) + 255 * text_cov) / 255) << 8
+               |  (((layer->color        & 0xFF) * (255 - text_cov) + 255 * text_cov) / 255);
+      p = raster->pixels + ((u64) y * pxl + x) * 4;
+      sdk_raster_put(p, color, disc);
+    }
+  }
+  if (coverage) heap_free_dz(coverage);
+  return true;
+}
+
+/* NOTE: Segments a to g of 0-9, bit 0 is a (top), clockwise, g (middle) last */
+global u8 g_compose_segments[10] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+
+static inline void
+sdk_raster_rect(Sdk_Raster *raster, i32 x0, i32 y0, i32 x1, i32 y1, u32 color)
+{
+  i32 x, y;
+
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > (i32) raster->w) x1 = (i32) raster->w;
+  if (y1 > (i32) raster->h) y1 = (i32) raster->h;
+  for (y = y0; y < y1; y++)
+  {
+    for (x = x0; x < x1; x++) sdk_raster_put(raster->pixels + ((u64) y * raster->w + x) * 4, color, 255);
+  }
+}
+
+/* NOTE: Width of one character of the DIGITS layer, `h` high with strokes `t` thick. */
+static inline u32
+sdk_digit_width(char c, u32 h, u32 t)
+{
+  if (c == ':' || c == '.') return t;
+  return h / 2;
+}
+
+/*
+ * NOTE:
+ *      Seven segment digits, centered: clocks and counters drawn without
+ *      any font in the asset pack. Characters other than 0-9, ':', '-' and
+ *      '.' take the room of a digit and stay blank.
+ */
+static void
+sdk_raster_digits(Sdk_Raster *raster, Sdk_Layer *layer)
+{
+  u32  pxl, h, t, w, gap, margin, segments;
+  i32  x, y, mid;
+  char *c;
+
+  pxl    = raster->w;
+  margin = pxl / 16;
+  h      = pxl * (layer->percent && layer->percent <= 100 ? layer->percent : 40) / 100;
+  for (;;)
+  {
+    t   = h >= 16 ? h / 8 : 2;
+    gap = t;
+    for (w = 0, c = layer->text; *c; c++) w += sdk_digit_width(*c, h, t) + gap;
+    if (w) w -= gap;
+    if (w <= pxl - margin * 2 || h <= 8) break;
+    h = h * (pxl - margin * 2) / w;
+  }
+  x = (i32)(pxl - w) / 2;
+  switch (layer->align)
+  {
+    case SDK_ALIGN_TOP:    y = (i32) margin;            break;
+    case SDK_ALIGN_CENTER: y = (i32)(pxl - h) / 2;      break;
+    default:               y = (i32)(pxl - margin - h); break;
+  }
+  mid = y + (i32)(h - t) / 2;
+  for (c = layer->text; *c; x += (i32)(sdk_digit_width(*c, h, t) + gap), c++)
+  {
+    w = sdk_digit_width(*c, h, t);
+    if (*c == ':')
+    {
+      sdk_raster_rect(raster, x, y + (i32) h / 4,               x + (i32) t, y + (i32) h / 4 + (i32) t, layer->color);
+      sdk_raster_rect(raster, x, y + (i32) h * 3 / 4 - (i32) t, x + (i32) t, y + (i32) h * 3 / 4,       layer->color);
+      continue;
+    }
+    if (*c == '.') { sdk_raster_rect(raster, x, y + (i32)(h - t), x + (i32) t, y + (i32) h, layer->color); continue; }
+    if      (*c >= '0' && *c <= '9') segments = g_compose_segments[*c - '0'];
+    else if (*c == '-')              segments = 0x40;
+    else continue;
+    /* NOTE: Corners left out, the usual segment look */
+    if (segments & 0x01) sdk_raster_rect(raster, x + (i32) t, y,                  x + (i32)(w - t), y + (i32) t,       layer->color);
+    if (segments & 0x02) sdk_raster_rect(raster, x + (i32)(w - t), y + (i32) t,   x + (i32) w,      mid,               layer->color);
+    if (segments & 0x04) sdk_raster_rect(raster, x + (i32)(w - t), mid + (i32) t, x + (i32) w,      y + (i32)(h - t),  layer->color);
+    if (segments & 0x08) sdk_raster_rect(raster, x + (i32) t, y + (i32)(h - t),   x + (i32)(w - t), y + (i32) h,       layer->color);
+    if (segments & 0x10) sdk_raster_rect(raster, x, mid + (i32) t,                x + (i32) t,      y + (i32)(h - t),  layer->color);
+    if (segments & 0x20) sdk_raster_rect(raster, x, y + (i32) t,                  x + (i32) t,      mid,               layer->color);
+    if (segments & 0x40) sdk_raster_rect(raster, x + (i32) t, mid,                x + (i32)(w - t), mid + (i32) t,     layer->color);
+  }
+}
+
+/* NOTE: Lock not held. `raster` allocated zeroed at the key size, filled for `layer`. */
+static bool
+sdk_raster_layer(Sdk_Raster *raster, Sdk_Layer *layer, u32 pxl)
+{
+  u32   x, y, t, color, side, offset, left, top, bottom, filled;
+  u8    *p;
+  bool  translucent;
+  Image icon, mask;
+
+  memset(raster, 0, sizeof(Sdk_Raster));
+  translucent = false;
+  cm_heap_alloc((u64) pxl * pxl * 4, raster->pixels);
+  if (!raster->pixels) return false;
+  raster->w = raster->h = pxl;
+  switch (layer->kind)
+  {
+    case SDK_LAYER_FILL:
+    case SDK_LAYER_GRADIENT:
+      for (y = 0; y < pxl; y++)
+      {
+        /* NOTE: Per channel lerp, top to bottom */
+        t = pxl > 1 ? y * 255 / (pxl - 1) : 0;
+        color = layer->kind == SDK_LAYER_FILL ? layer->color
+          : ((((layer->color >> 16) & 0xFF) * (255 - t) + ((layer->color2 >> 16) & 0xFF) * t) / 255) << 16
+          | ((((layer->color >>  8) & 0xFF) * (255 - t) + ((layer->color2 >>  8) & 0xFF) * t) / 255) << 8
+          |  (((layer->color        & 0xFF) * (255 - t) + ( layer->color2        & 0xFF) * t) / 255);
+        p = raster->pixels + (u64) y * pxl * 4;
+        sdk_raster_put(p, color, 255);
+        for (t = 1; t < pxl; t++) memcpy(p + t * 4, p, 4);
+      }
+      break;
+    case SDK_LAYER_ICON:
+      side = (layer->percent && layer->percent < 100) ? pxl * layer->percent / 100 : pxl;
+      if (!side) side = 1;
+      if (!layer->data || !sdk_decode_image_alpha(layer->data, layer->size, side, side, &icon, &mask))
+      {
+        printf("compose: cannot decode an icon layer\n");
+        break;
+      }
+      /* NOTE: The icon comes premultiplied, scaling may round a channel just above its alpha */
+      offset = (pxl - side) / 2;
+      for (y = 0; y < side; y++)
+      {
+        p = raster->pixels + ((u64)(offset + y) * pxl + offset) * 4;
+        for (x = 0; x < side; x++, p += 4)
+        {
+          memcpy(p, icon.pixels + ((u64) y * side + x) * 3, 3);
+          p[3] = mask.pixels ? mask.pixels[((u64) y * side + x) * 3] : 255;
+          if (p[0] > p[3]) p[0] = p[3];
+          if (p[1] > p[3]) p[1] = p[3];
+          if (p[2] > p[3]) p[2] = p[3];
+        }
+      }
+      translucent = mask.pixels != NULL;
+      image_free(&icon);
+      image_free(&mask);
+      break;
+    case SDK_LAYER_TEXT:
+      if (!sdk_raster_text(raster, layer)) goto _failure;
+      break;
+    case SDK_LAYER_BADGE:
+      if (!sdk_raster_badge(raster, layer)) goto _failure;
+      break;
+    case SDK_LAYER_BAR:
+      left   = pxl / 12;
+      bottom = pxl - pxl / 12;
+      top    = bottom - (pxl >= 20 ? pxl / 10 : 2);
+      filled = left + (pxl - left * 2) * (layer->percent < 100 ? layer->percent : 100) / 100;
+      for (y = top; y < bottom; y++)
+      {
+        p = raster->pixels + ((u64) y * pxl + left) * 4;
+        for (x = left; x < pxl - left; x++, p += 4) sdk_raster_put(p, x < filled ? layer->color : layer->color2, 255);
+      }
+      break;
+    case SDK_LAYER_DIGITS:
+      if (layer->text) sdk_raster_digits(raster, layer);
+      break;
+    default:
+      break;
+  }
+  sdk_raster_bounds(raster);
+  raster->opaque = raster->y0 == 0 && raster->y1 == pxl && (layer->kind == SDK_LAYER_FILL || layer->kind == SDK_LAYER_GRADIENT
+                                                           || (layer->kind == SDK_LAYER_ICON && !translucent && (!layer->percent || layer->percent >= 100)));
+  return true;
+
+_failure:
+  heap_free_dz(raster->pixels);
+  memset(raster, 0, sizeof(Sdk_Raster));
+  return false;
+}
+
+/* -- Layer cache -------------------------------------------------------------------- */
+
+static u64
+sdk_layer_key(Sdk_Layer *layer, u32 pxl)
+{
+  u64           text;
+  Sdk_Layer_Key key;
+
+  memset(&key, 0, sizeof(Sdk_Layer_Key));
+  key.kind    = layer->kind;
+  key.align   = layer->align;
+  key.percent = layer->percent;
+  key.color   = layer->color;
+  key.color2  = layer->color2;
+  key.pxl     = (u16) pxl;
+  if (layer->kind == SDK_LAYER_ICON && layer->data)
+  {
+    key.data = layer->hash ? layer->hash : sdk_image_hash(layer->data, layer->size);
+  }
+  if (layer->text)
+  {
+    text     = sdk_image_hash((u8*) layer->text, (u32) strlen(layer->text));
+    key.text = text ^ (sdk_asset_hash(layer->font ? layer->font : SDK_COMPOSE_FONT) * 0x9E3779B97F4A7C15ull);
+    if (layer->kind == SDK_LAYER_TEXT || layer->kind == SDK_LAYER_BADGE) key.font = sdk_compose_font_hash(layer->font);
+  }
+  return sdk_image_hash((u8*) &key, sizeof(Sdk_Layer_Key));
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_layer_evict(Sdk_Layer_Entry *entry)
+{
+  g_compose.bytes -= (u64) entry->raster.w * entry->raster.h * 4;
+  g_compose.evicted++;
+  heap_free_dz(entry->raster.pixels);
+  memset(entry, 0, sizeof(Sdk_Layer_Entry));
+}
+
+/* NOTE: Lock held. A free entry with room for `bytes`, evicting the least recently used ones. NULL when all are in use. */
+static Sdk_Layer_Entry*
+sdk_layer_slot(u64 bytes)
+{
+  u32             i;
+  Sdk_Layer_Entry *entry, *oldest;
+
+  for (;;)
+  {
+    entry = oldest = NULL;
+    for (i = 0; i < SDK_COMPOSE_ENTRIES; i++)
+    {
+      if (!g_compose.entries[i].key) { if (!entry) entry = &g_compose.entries[i]; continue; }
+      if (g_compose.entries[i].refs) continue;
+      if (!oldest || g_compose.entries[i].used < oldest->used) oldest = &g_compose.entries[i];
+    }
+    if (entry && g_compose.bytes + bytes <= SDK_COMPOSE_BUDGET) return entry;
+    if (!oldest) return NULL;
+    sdk_layer_evict(oldest);
+  }
+}
+
+/* NOTE: Any thread. The raster of `layer`, held until sdk_layer_release. */
+static Sdk_Layer_Entry*
+sdk_layer_get(Sdk_Layer *layer, u64 key, u32 pxl)
+{
+  u32             i;
+  Sdk_Raster      raster;
+  Sdk_Layer_Entry *entry;
+
+  AcquireSRWLockExclusive(&g_compose.lock);
+  for (i = 0; i < SDK_COMPOSE_ENTRIES; i++)
+  {
+    entry = &g_compose.entries[i];
+    if (entry->key != key) continue;
+    entry->refs++;
+    entry->used = ++g_compose.clock;
+    g_compose.hits++;
+    ReleaseSRWLockExclusive(&g_compose.lock);
+    return entry;
+  }
+  g_compose.misses++;
+  ReleaseSRWLockExclusive(&g_compose.lock);
+
+  if (!sdk_raster_layer(&raster, layer, pxl)) return NULL;
+  AcquireSRWLockExclusive(&g_compose.lock);
+  entry = sdk_layer_slot((u64) pxl * pxl * 4);
+  if (entry)
+  {
+    entry->key       = key;
+    entry->used      = ++g_compose.clock;
+    entry->refs      = 1;
+    entry->owned     = true;
+    entry->raster    = raster;
+    g_compose.bytes += (u64) pxl * pxl * 4;
+  }
+  ReleaseSRWLockExclusive(&g_compose.lock);
+  if (entry) return entry;
+  /* NOTE: Every entry being blended, this one lives for one composition */
+  cm_heap_alloc(sizeof(Sdk_Layer_Entry), entry);
+  if (!entry) { heap_free_dz(raster.pixels); return NULL; }
+  entry->raster = raster;
+  return entry;
+}
+
+static void
+sdk_layer_release(Sdk_Layer_Entry *entry)
+{
+  if (!entry) return;
+  if (!entry->owned)
+  {
+    heap_free_dz(entry->raster.pixels);
+    heap_free_dz(entry);
+    return;
+  }
+  AcquireSRWLockExclusive(&g_compose.lock);
+  entry->refs--;
+  ReleaseSRWLockExclusive(&g_compose.lock);
+}
+
+/* -- Compositing -------------------------------------------------------------------- */
+
+/* NOTE: `count` premultiplied RGBA pixels of `src` over `dst`. */
+static void
+sdk_blend_row(u8 *dst, u8 *src, u32 count)
+{
+  u32     i, inv, c, t;
+  __m128i zero, full, round, s, d, dl, dh, al, ah;
+
+  zero  = _mm_setzero_si128();
+  full  = _mm_set1_epi16(255);
+  round = _mm_set1_epi16(128);
+  for (i = 0; i + 4 <= count; i += 4)
+  {
+    s = _mm_loadu_si128((__m128i*)(src + i * 4));
+    d = _mm_loadu_si128((__m128i*)(dst + i * 4));
+    /* NOTE: 255 - alpha of each pixel in its four lanes */
+    al = _mm_unpacklo_epi8(s, zero);
+    ah = _mm_unpackhi_epi8(s, zero);
+    al = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(al, 0xFF), 0xFF));
+    ah = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(ah, 0xFF), 0xFF));
+    dl = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), al), round);
+    dh = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ah), round);
+    /* NOTE: x / 255 as (x + 128 + ((x + 128) >> 8)) >> 8 */
+    dl = _mm_srli_epi16(_mm_add_epi16(dl, _mm_srli_epi16(dl, 8)), 8);
+    dh = _mm_srli_epi16(_mm_add_epi16(dh, _mm_srli_epi16(dh, 8)), 8);
+    d  = _mm_adds_epu8(_mm_packus_epi16(dl, dh), s);
+    _mm_storeu_si128((__m128i*)(dst + i * 4), d);
+  }
+  for (; i < count; i++)
+  {
+    inv = 255 - src[i * 4 + 3];
+    for (c = 0; c < 4; c++)
+    {
+      t = src[i * 4 + c] + (dst[i * 4 + c] * inv + 127) / 255;
+      dst[i * 4 + c] = (u8)(t > 255 ? 255 : t);
+    }
+  }
+}
+
+/*
+ * NOTE:
+ *      Any thread. `layers` (bottom first, at most SDK_COMPOSE_LAYERS)
+ *      composed at this deck's key size, rotated, encoded at link `level`
+ *      (0 = full quality, see Sdk_Link) and packed for key 0. Black where no
+ *      layer covers.
+ */
+static Sdk_Packed*
+sdk_compose_key(Stream_Deck *sdk, Sdk_Layer *layers, u32 count, u32 level)
+{
+  u8              *canvas, *encoded;
+  u32             i, y, base, pxl, encoded_size;
+  u64             keys[SDK_COMPOSE_LAYERS], tile;
+  Image           flat;
+  Sdk_Packed      *packed;
+  Sdk_Layer_Entry *entries[SDK_COMPOSE_LAYERS];
+  Sdk_Tile_Params params;
+
+  if (!count || count > SDK_COMPOSE_LAYERS) return NULL;
+  pxl = sdk->pxl_w;
+  for (i = 0; i < count; i++) keys[i] = sdk_layer_key(&layers[i], pxl);
+  memset(&params, 0, sizeof(Sdk_Tile_Params));
+  params.source   = sdk_image_hash((u8*) keys, count * sizeof(u64));
+  params.pid      = sdk->product_id;
+  params.pxl      = (u16) pxl;
+  params.op       = SDK_TILE_COMPOSE;
+  params.rotation = sdk->key_rotation;
+  params.quality  = g_sdk_link_levels[level].quality;
+  params.scale    = g_sdk_link_levels[level].scale < 100 ? g_sdk_link_levels[level].scale : 0;
+  tile   = sdk_tile_key(&params);
+  packed = sdk_tiles_find(&g_tiles, tile, sdk->img_rpt_len);
+  if (packed) { atomic_fetch_add(&g_compose.reused, 1); return packed; }
+
+  canvas = NULL;
+  memset(entries, 0, sizeof(entries));
+  memset(&flat, 0, sizeof(Image));
+  for (i = 0; i < count; i++)
+  {
+    entries[i] = sdk_layer_get(&layers[i], keys[i], pxl);
+    if (!entries[i]) goto _end;
+  }
+  cm_heap_alloc((u64) pxl * pxl * 4, canvas);
+  if (!canvas || !image_alloc(&flat, pxl, pxl)) goto _end;
+  /* NOTE: Nothing under the topmost opaque layer shows */
+  for (base = count; base > 0 && !entries[base - 1]->raster.opaque; base--) {}
+  if (base) memcpy(canvas, entries[base - 1]->raster.pixels, (u64) pxl * pxl * 4);
+  for (i = base; i < count; i++)
+  {
+    for (y = entries[i]->raster.y0; y < entries[i]->raster.y1; y++)
+    {
+      sdk_blend_row(canvas + (u64) y * pxl * 4, entries[i]->raster.pixels + (u64) y * pxl * 4, pxl);
+    }
+  }
+  for (i = 0; i < pxl * pxl; i++) memcpy(flat.pixels + (u64) i * 3, canvas + (u64) i * 4, 3);
+  encoded = sdk_encode_key_pixels(sdk, &flat, &encoded_size, level);
+  if (!encoded) goto _end;
+  packed = sdk_pack_key_image(sdk, encoded, encoded_size, 0);
+  heap_free_dz(encoded);
+  sdk_tiles_store(&g_tiles, tile, packed);
+  atomic_fetch_add(&g_compose.composed, 1);
+
+_end:
+  for (i = 0; i < count; i++) sdk_layer_release(entries[i]);
+  if (canvas) heap_free_dz(canvas);
+  image_free(&flat);
+  return packed;
+}
+
+/*
+ * NOTE:
+ *      Thread-safe, sdk_compose_key then the write queue. `animated` content
+ *      (redrawn on its own, widgets) is encoded at the deck's link level.
+ */
+static bool
+sdk_queue_layers(Stream_Deck *sdk, u8 key, Sdk_Layer *layers, u32 count, bool animated)
+{
+  u32        level;
+  bool       queued;
+  Sdk_Packed *packed;
+
+  if (key >= sdk->total) { printf("Invalid key\n"); return false; }
+  level  = animated ? sdk_link_level(sdk) : 0;
+  packed = sdk_compose_key(sdk, layers, count, level);
+  if (!packed) return false;
+  queued = animated ? sdk_queue_animated(sdk, key, packed, level) : sdk_queue_packed(sdk, key, packed);
+  sdk_packed_release(packed);
+  return queued;
+}
+
+static void
+sdk_compose_close(void)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&g_compose.lock);
+  for (i = 0; i < SDK_COMPOSE_ENTRIES; i++)
+  {
+    if (g_compose.entries[i].key) heap_free_dz(g_compose.entries[i].raster.pixels);
+  }
+  for (i = 0; i < g_compose.font_count; i++)
+  {
+    if (g_compose.fonts[i].coverage) heap_free_dz(g_compose.fonts[i].coverage);
+  }
+  memset(g_compose.entries, 0, sizeof(g_compose.entries));
+  memset(g_compose.fonts, 0, sizeof(g_compose.fonts));
+  g_compose.font_count = 0;
+  g_compose.bytes      = 0;
+  ReleaseSRWLockExclusive(&g_compose.lock);
+}
+
+static void
+sdk_compose_report(void)
+{
+  printf("compose: %llu composed, %llu from tiles, layers %llu hits / %llu misses, %llu evicted, %llu KB held\n",
+         atomic_load(&g_compose.composed), atomic_load(&g_compose.reused), g_compose.hits, g_compose.misses, g_compose.evicted, g_compose.bytes >> 10);
+}
+
+#endif // SDK_COMPOSE_C
@@ -0,0 +1,1222 @@
+#ifndef SDK_CONFIG_C
+#define SDK_CONFIG_C
+
+/*
+ * NOTE:
+ *      Text configuration, one statement per line, `#` starts a comment and
+ *      arguments holding spaces go between double quotes (no escapes, so
+ *      Windows paths are written as they are):
+ *
+ *        brightness 60
+ *        debounce   10                      key debounce, ms
+ *        double_tap 300                     ms
+ *        hold       500                     ms, long press
+ *        transition slide                   page switches (none, blank, dim, fade)
+ *        input_depth 128                    driver input ring, reports (2..512)
+ *        model 0x006c brightness 40         per model overrides
+ *        page main
+ *        page media parent main
+ *        key 0 image "icons\play.jpg" label "Play" keys "0xB3"
+ *        key 1 folder media
+ *        key 2 next                         (prev, back)
+ *        key 3 spawn "notepad.exe"          (run, timeout <ms>)
+ *        key 4 pipe "\\.\pipe\obs" "scene 2" pipe name, message
+ *        key 5 model 0x0080 image "mk2.jpg" only on that model
+ *        key 6 icon grenade                 image from the asset pack
+ *        key 7 background 0x203040 label "Mute"  drawn (sdk_compose.c)
+ *        key 0 image "play.jpg" pressed "play_down.jpg"  shown while down
+ *        key 1 image "stop.jpg" pressed auto  darkened and shrunk
+ *        font    condensed                  asset pack font of the labels
+ *        gesture combo 5 0 spawn "calc.exe" hold 0, press 5
+ *        gesture chord 0 1 2 run "..."      exactly 0, 1 and 2 down
+ *        gesture double 0 keys "0xB3"
+ *        gesture hold 3 spawn "taskmgr.exe" 3 kept down for `hold` ms
+ *        live 6 "cpu.jpg" interval 500      file regenerated by another tool
+ *        widget 8 clock seconds             (counter, cpu, memory), see sdk_widget.c
+ *        widget 9 cpu levels 10 interval 500 color 0x40C040 label "CPU"
+ *
+ *      `key` lines belong to the last `page`, a later line for the same key
+ *      wins. Relative paths start at the configuration's directory. Images
+ *      of another size than the deck's keys are resized (and rotated) the
+ *      first time they are seen, the tile cache keeps the result across
+ *      restarts (sdk_tiles.c). A key with a label or a background is
+ *      composed instead: background, image, then the label along the
+ *      bottom in `font` (SDK_COMPOSE_FONT when not set).
+ *
+ *      Parsing is one pass over the file into an arena. Applying builds one
+ *      profile per deck model and swaps it in (sdk_swap_profile): keys whose
+ *      image did not change are neither re-packed nor re-sent, image files
+ *      that did not change are not read again, and the brightness only goes
+ *      out when it changed. A configuration that fails to parse or build
+ *      leaves the active one in place. At startup the file and its images
+ *      are read on a thread of their own while the decks are being opened.
+ *
+ *      Sdk_Config_Watch watches the configuration's directory tree with
+ *      ReadDirectoryChangesW, waits for the writes to settle and wakes the
+ *      main thread, which reloads between device scans (sdk_config_poll).
+ *      `live` keys are handed to Sdk_Live (sdk_live.c), which watches their
+ *      files on its own and keeps them out of the profile, `widget` keys to
+ *      Sdk_Widgets (sdk_widget.c) the same way.
+ */
+#define SDK_CONFIG_TOKENS     32
+#define SDK_CONFIG_MODELS     16
+#define SDK_CONFIG_PATH_LEN   260
+#define SDK_CONFIG_SETTLE_MS  150
+#define SDK_CONFIG_NO_VALUE   0xFF
+#define SDK_CONFIG_FILE       "betterdeck.cfg"
+#define SDK_CONFIG_ENV        "BETTERDECK_CONFIG"
+
+#pragma warning(disable : 4820)
+typedef struct SdkConfigAction
+{
+  u8   kind;                                 /* NOTE: 0 = none */
+  u32  timeout_ms;
+  char *arg;
+  u8   *data;
+  u32  data_len;
+  u16  id;                                   /* NOTE: Set on apply */
+} SdkConfigAction, Sdk_Config_Action;
+
+typedef struct SdkConfigImage
+{
+  struct SdkConfigImage *next;
+  char                  *path;
+  u64                   write_time;
+  u8                    *data;               /* NOTE: NULL when it could not be read */
+  u32                   size;
+} SdkConfigImage, Sdk_Config_Image;
+
+typedef struct SdkConfigKey
+{
+  struct SdkConfigKey *next;
+  u8                  key;
+  u8                  nav;
+  u16                 pid;                   /* NOTE: 0 = every model */
+  char                *target;               /* NOTE: FOLDER: page name */
+  char                *image;                /* NOTE: Resolved path, NULL = blank */
+  char                *icon;                 /* NOTE: Asset pack image, when there is no `image` */
+  char                *label;
+  u32                 background;            /* NOTE: 0xRRGGBB */
+  bool                has_background;
+  bool                pressed_auto;          /* NOTE: Pressed variant made from the key's own image */
+  char                *pressed;              /* NOTE: Resolved path of the pressed variant */
+  Sdk_Config_Action   action;
+} SdkConfigKey, Sdk_Config_Key;
+
+typedef struct SdkConfigPage
+{
+  struct SdkConfigPage *next;
+  char                 *name;
+  u16                  parent;               /* NOTE: SDK_PAGE_NONE for top level pages */
+  Sdk_Config_Key       *keys, *last;
+} SdkConfigPage, Sdk_Config_Page;
+
+typedef struct SdkConfigGesture
+{
+  struct SdkConfigGesture *next;
+  Sdk_Gesture_Def         def;
+  Sdk_Config_Action       action;
+} SdkConfigGesture, Sdk_Config_Gesture;
+
+typedef struct SdkConfigLive
+{
+  struct SdkConfigLive *next;
+  u8                   key;
+  u16                  pid;                  /* NOTE: 0 = every model */
+  char                 *path;
+  u32                  debounce_ms, interval_ms;
+} SdkConfigLive, Sdk_Config_Live;
+
+typedef struct SdkConfigWidget
+{
+  struct SdkConfigWidget *next;
+  u8                     key;
+  u16                    pid;                /* NOTE: 0 = every model */
+  Sdk_Widget_Def         def;
+} SdkConfigWidget, Sdk_Config_Widget;
+
+typedef struct SdkConfigModel
+{
+  u16 pid;
+  u8  brightness;
+} SdkConfigModel, Sdk_Config_Model;
+
+typedef struct SdkConfig
+{
+  Arena              arena;
+  char               dir[SDK_CONFIG_PATH_LEN];
+  u8                 brightness;             /* NOTE: SDK_CONFIG_NO_VALUE leaves it alone */
+  u32                debounce_ms, double_tap_ms, hold_ms;
+  u8                 transition;             /* NOTE: SDK_TRANSITION_*, see sdk_frame.c */
+  u32                input_depth;            /* NOTE: 0 leaves it alone, see sdk_set_input_depth */
+  char               *font;                  /* NOTE: Of the labels, NULL = SDK_COMPOSE_FONT */
+  Sdk_Config_Page    *pages, *last_page;
+  u32                page_count;
+  Sdk_Config_Gesture *gestures, *last_gesture;
+  u32                gesture_count;
+  Sdk_Config_Model   models[SDK_CONFIG_MODELS];
+  u32                model_count;
+  Sdk_Config_Image   *images;
+  Sdk_Config_Live    *lives;
+  Sdk_Config_Widget  *widgets;
+  /* NOTE: Built on demand, one per deck model */
+  Sdk_Profile        *profiles[SDK_MAX_DECKS];
+  u16                profile_pids[SDK_MAX_DECKS];
+  u32                profile_count;
+} SdkConfig, Sdk_Config;
+
+typedef struct SdkConfigWatch
+{
+  char          path[SDK_CONFIG_PATH_LEN];
+  Sdk_Manager   *mgr;
+  Sdk_Live      *live;                       /* NOTE: May be NULL */
+  Sdk_Widgets   *widgets;                    /* NOTE: May be NULL */
+  u32           generation;                  /* NOTE: Of the live keys and widgets bound from `active` */
+  Sdk_Config    *active;                     /* NOTE: Main thread only */
+  DWORD         main_thread;
+  HANDLE        dir;
+  HANDLE        thread;
+  HANDLE        stop_event;
+  OVERLAPPED    ol;
+  atomic_bool   changed;
+  DWORD         buffer[1024];                /* NOTE: FILE_NOTIFY_INFORMATION, DWORD aligned */
+  HANDLE        loader;                      /* NOTE: See sdk_config_watch_prefetch */
+  Sdk_Config    *loaded;                     /* NOTE: Written by `loader` */
+  /* NOTE: Stats */
+  u64           reloads, failures, last_us, load_us;
+} SdkConfigWatch, Sdk_Config_Watch;
+#pragma warning(default : 4820)
+
+/* -- Parsing ------------------------------------------------------------------------ */
+
+static bool
+sdk_config_number(char *token, u32 *value)
+{
+  u32 base, digit;
+  u64 result;
+
+  if (!token || !*token) return false;
+  base = 10;
+  if (token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) { base = 16; token += 2; }
+  if (!*token) return false;
+  for (result = 0; *token; token++)
+  {
+    if      (*token >= '0' && *token <= '9')               digit = (u32)(*token - '0');
+    else if (base == 16 && *token >= 'a' && *token <= 'f') digit = (u32)(*token - 'a' + 10);
+    else if (base == 16 && *token >= 'A' && *token <= 'F') digit = (u32)(*token - 'A' + 10);
+    else return false;
+    if (digit >= base) return false;
+    result = result * base + digit;
+    if (result > 0xFFFFFFFFull) return false;
+  }
+  *value = (u32) result;
+  return true;
+}
+
+/* NOTE: Splits `line` in place. Returns the token count, -1 on an unterminated quote. */
+static i32
+sdk_config_tokenize(char *line, char **tokens)
+{
+  i32 count;
+
+  count = 0;
+  for (;;)
+  {
+    while (*line == ' ' || *line == '\t') line++;
+    if (!*line || *line == '#') break;
+    if (count >= SDK_CONFIG_TOKENS) break;
+    if (*line == '"')
+    {
+      tokens[count++] = ++line;
+      while (*line && *line != '"') line++;
+      if (!*line) return -1;
+      *line++ = 0;
+      continue;
+    }
+    tokens[count++] = line;
+    while (*line && *line != ' ' && *line != '\t') line++;
+    if (*line) *line++ = 0;
+  }
+  return count;
+}
+
+static char*
+sdk_config_path(Sdk_Config *config, char *path)
+{
+  char *full;
+  u64  dir_len, len;
+
+  if (path[0] == '\\' || path[0] == '/' || (path[0] && path[1] == ':')) return arena_strdup(&config->arena, path);
+  dir_len = strlen(config->dir);
+  len     = strlen(path);
+  full    = arena_push(&config->arena, dir_len + len + 2);
+  if (!full) return NULL;
+  memcpy(full, config->dir, dir_len);
+  full[dir_len] = '\\';
+  memcpy(full + dir_len + 1, path, len);
+  return full;
+}
+
+static Sdk_Config_Page*
+sdk_config_page(Sdk_Config *config, char *name, u16 *index)
+{
+  u16             i;
+  Sdk_Config_Page *page;
+
+  for (page = config->pages, i = 0; page; page = page->next, i++)
+  {
+    if (!strcmp(page->name, name)) { if (index) *index = i; return page; }
+  }
+  return NULL;
+}
+
+/*
+ * NOTE:
+ *      Parses an action starting at tokens[*at] (kind and its arguments,
+ *      then an optional `timeout <ms>`). Returns false when tokens[*at] is
+ *      not an action, `*error` is set when it is one but malformed.
+ */
+static bool
+sdk_config_action(Sdk_Config *config, char **tokens, i32 count, i32 *at, Sdk_Config_Action *action, char **error)
+{
+  u32  value, n;
+  u16  keys[SDK_ACTION_KEYS_LEN];
+  char *name, *cursor, *token;
+
+  name = tokens[*at];
+  if      (!strcmp(name, "spawn")) action->kind = SDK_ACTION_SPAWN;
+  else if (!strcmp(name, "run"))   action->kind = SDK_ACTION_RUN;
+  else if (!strcmp(name, "pipe"))  action->kind = SDK_ACTION_PIPE;
+  else if (!strcmp(name, "keys"))  action->kind = SDK_ACTION_KEYS;
+  else return false;
+  if (*at + 1 >= count) { *error = "action needs an argument"; return true; }
+  (*at)++;
+  switch (action->kind)
+  {
+    case SDK_ACTION_KEYS:
+      /* NOTE: Virtual key codes, pressed in order and released in reverse */
+      cursor = tokens[*at];
+      for (n = 0; *cursor && n < SDK_ACTION_KEYS_LEN;)
+      {
+        while (*cursor == ' ') cursor++;
+        token = cursor;
+        while (*cursor && *cursor != ' ') cursor++;
+        if (*cursor) *cursor++ = 0;
+        if (!*token) break;
+        if (!sdk_config_number(token, &value) || value > 0xFFFF) { *error = "bad virtual key code"; return true; }
+        keys[n++] = (u16) value;
+      }
+      action->data = arena_push(&config->arena, n * sizeof(u16));
+      if (n && !action->data) { *error = "out of memory"; return true; }
+      memcpy(action->data, keys, n * sizeof(u16));
+      action->data_len = n * sizeof(u16);
+      break;
+    case SDK_ACTION_PIPE:
+      /* NOTE: Pipe name, then the message */
+      if (*at + 1 >= count) { *error = "pipe needs a name and a message"; return true; }
+      action->arg = arena_strdup(&config->arena, tokens[(*at)++]);
+      action->data     = (u8*) arena_strdup(&config->arena, tokens[*at]);
+      action->data_len = action->data ? (u32) strlen(tokens[*at]) : 0;
+      break;
+    default:
+      action->arg = arena_strdup(&config->arena, tokens[*at]);
+      break;
+  }
+  (*at)++;
+  if (*at + 1 < count && !strcmp(tokens[*at], "timeout"))
+  {
+    if (!sdk_config_number(tokens[*at + 1], &action->timeout_ms)) { *error = "bad timeout"; return true; }
+    *at += 2;
+  }
+  (*at)--;
+  return true;
+}
+
+static char*
+sdk_config_line_key(Sdk_Config *config, char **tokens, i32 count)
+{
+  i32            at;
+  u32            value;
+  char           *error;
+  Sdk_Config_Key *key;
+
+  if (!config->last_page) return "key before any page";
+  if (count < 2 || !sdk_config_number(tokens[1], &value) || value >= SDK_KEYS_MAX) return "bad key index";
+  key = arena_push_struct(&config->arena, Sdk_Config_Key);
+  if (!key) return "out of memory";
+  key->key = (u8) value;
+  error    = NULL;
+  for (at = 2; at < count && !error; at++)
+  {
+    if (!strcmp(tokens[at], "image") && at + 1 < count)
+    {
+      key->image = sdk_config_path(config, tokens[++at]);
+    }
+    else if (!strcmp(tokens[at], "icon") && at + 1 < count)
+    {
+      key->icon = arena_strdup(&config->arena, tokens[++at]);
+    }
+    else if (!strcmp(tokens[at], "label") && at + 1 < count)
+    {
+      key->label = arena_strdup(&config->arena, tokens[++at]);
+    }
+    else if (!strcmp(tokens[at], "background") && at + 1 < count)
+    {
+      if (!sdk_config_number(tokens[++at], &value) || value > 0xFFFFFF) error = "bad background";
+      key->background     = value;
+      key->has_background = true;
+    }
+    else if (!strcmp(tokens[at], "pressed") && at + 1 < count)
+    {
+      at++;
+      if (!strcmp(tokens[at], "auto")) key->pressed_auto = true;
+      else                             key->pressed      = sdk_config_path(config, tokens[at]);
+    }
+    else if (!strcmp(tokens[at], "model") && at + 1 < count)
+    {
+      if (!sdk_config_number(tokens[++at], &value) || value > 0xFFFF) error = "bad model";
+      key->pid = (u16) value;
+    }
+    else if (!strcmp(tokens[at], "folder") && at + 1 < count)
+    {
+      key->nav    = SDK_NAV_FOLDER;
+      key->target = arena_strdup(&config->arena, tokens[++at]);
+    }
+    else if (!strcmp(tokens[at], "next")) key->nav = SDK_NAV_NEXT;
+    else if (!strcmp(tokens[at], "prev")) key->nav = SDK_NAV_PREV;
+    else if (!strcmp(tokens[at], "back")) key->nav = SDK_NAV_BACK;
+    else if (!sdk_config_action(config, tokens, count, &at, &key->action, &error)) error = "unknown key attribute";
+  }
+  if (error) return error;
+  if (config->last_page->last) config->last_page->last->next = key;
+  else                         config->last_page->keys       = key;
+  config->last_page->last = key;
+  return NULL;
+}
+
+static char*
+sdk_config_line_gesture(Sdk_Config *config, char **tokens, i32 count)
+{
+  i32                at;
+  u32                value;
+  char               *error;
+  Sdk_Config_Gesture *gesture;
+
+  if (count < 4) return "gesture needs a kind, keys and an action";
+  gesture = arena_push_struct(&config->arena, Sdk_Config_Gesture);
+  if (!gesture) return "out of memory";
+  if      (!strcmp(tokens[1], "chord"))  gesture->def.kind = SDK_GESTURE_CHORD;
+  else if (!strcmp(tokens[1], "combo"))  gesture->def.kind = SDK_GESTURE_COMBO;
+  else if (!strcmp(tokens[1], "double")) gesture->def.kind = SDK_GESTURE_DOUBLE;
+  else if (!strcmp(tokens[1], "hold"))   gesture->def.kind = SDK_GESTURE_HOLD;
+  else return "unknown gesture kind";
+  /* NOTE: First key triggers (COMBO, DOUBLE, HOLD), the others have to be held */
+  for (at = 2; at < count && sdk_config_number(tokens[at], &value); at++)
+  {
+    if (value >= SDK_KEYS_MAX) return "bad key index";
+    if (at == 2) { gesture->def.key = (u8) value; continue; }
+    if (gesture->def.count >= countof(gesture->def.keys)) return "too many keys";
+    gesture->def.keys[gesture->def.count++] = (u8) value;
+  }
+  if (gesture->def.kind == SDK_GESTURE_CHORD && gesture->def.count < countof(gesture->def.keys))
+  {
+    gesture->def.keys[gesture->def.count++] = gesture->def.key;
+  }
+  if (at >= count) return "gesture without action";
+  error = NULL;
+  if (!sdk_config_action(config, tokens, count, &at, &gesture->action, &error)) return "unknown action";
+  if (error) return error;
+  if (at + 1 < count) return "trailing tokens";
+  gesture->def.id = (u16)(config->gesture_count + 1);
+  if (gesture->def.id >= SDK_ACTION_GESTURES) return "too many gestures";
+  config->gesture_count++;
+  if (config->last_gesture) config->last_gesture->next = gesture;
+  else                      config->gestures           = gesture;
+  config->last_gesture = gesture;
+  return NULL;
+}
+
+static char*
+sdk_config_line_live(Sdk_Config *config, char **tokens, i32 count)
+{
+  i32             at;
+  u32             value;
+  Sdk_Config_Live *live;
+
+  if (count < 3 || !sdk_config_number(tokens[1], &value) || value >= SDK_KEYS_MAX) return "live <key> <path>";
+  live = arena_push_struct(&config->arena, Sdk_Config_Live);
+  if (!live) return "out of memory";
+  live->key  = (u8) value;
+  live->path = sdk_config_path(config, tokens[2]);
+  if (!live->path) return "out of memory";
+  for (at = 3; at + 1 < count; at += 2)
+  {
+    if (!sdk_config_number(tokens[at + 1], &value)) return "bad number";
+    if      (!strcmp(tokens[at], "debounce")) live->debounce_ms = value;
+    else if (!strcmp(tokens[at], "interval")) live->interval_ms = value;
+    else if (!strcmp(tokens[at], "model") && value <= 0xFFFF) live->pid = (u16) value;
+    else return "unknown live attribute";
+  }
+  if (at != count) return "trailing tokens";
+  live->next    = config->lives;
+  config->lives = live;
+  return NULL;
+}
+
+static char*
+sdk_config_line_widget(Sdk_Config *config, char **tokens, i32 count)
+{
+  i32               at;
+  u32               value;
+  char              *label;
+  Sdk_Config_Widget *widget;
+
+  if (count < 3 || !sdk_config_number(tokens[1], &value) || value >= SDK_KEYS_MAX) return "widget <key> <kind>";
+  widget = arena_push_struct(&config->arena, Sdk_Config_Widget);
+  if (!widget) return "out of memory";
+  widget->key       = (u8) value;
+  widget->def.color = 0xFFFFFF;
+  label = NULL;
+  if      (!strcmp(tokens[2], "clock"))   widget->def.kind = SDK_WIDGET_CLOCK;
+  else if (!strcmp(tokens[2], "counter")) widget->def.kind = SDK_WIDGET_COUNTER;
+  else if (!strcmp(tokens[2], "cpu"))     { widget->def.kind = SDK_WIDGET_CPU;    label = "CPU"; }
+  else if (!strcmp(tokens[2], "memory"))  { widget->def.kind = SDK_WIDGET_MEMORY; label = "MEM"; }
+  else return "unknown widget kind";
+  for (at = 3; at < count; at++)
+  {
+    if (!strcmp(tokens[at], "seconds")) { widget->def.seconds = true; continue; }
+    if (at + 1 >= count) return "widget attribute without a value";
+    if (!strcmp(tokens[at], "label"))
+    {
+      label = tokens[++at];
+      if (strlen(label) >= SDK_WIDGET_LABEL_LEN) return "label too long";
+      continue;
+    }
+    if (!sdk_config_number(tokens[++at], &value)) return "bad number";
+    if      (!strcmp(tokens[at - 1], "levels") && value && value <= 100) widget->def.levels = (u8) value;
+    else if (!strcmp(tokens[at - 1], "interval"))                        widget->def.interval_ms = value;
+    else if (!strcmp(tokens[at - 1], "color") && value <= 0xFFFFFF)      widget->def.color = value;
+    else if (!strcmp(tokens[at - 1], "background") && value <= 0xFFFFFF) widget->def.background = value;
+    else if (!strcmp(tokens[at - 1], "model") && value <= 0xFFFF)        widget->pid = (u16) value;
+    else return "unknown widget attribute";
+  }
+  /* NOTE: The meters name themselves, `label ""` leaves it out */
+  if (label) strcpy(widget->def.label, label);
+  widget->next    = config->widgets;
+  config->widgets = widget;
+  return NULL;
+}
+
+static char*
+sdk_config_line(Sdk_Config *config, char **tokens, i32 count)
+{
+  u16              parent;
+  u32              value, pid;
+  Sdk_Config_Page  *page;
+  Sdk_Config_Model *model;
+
+  if (!strcmp(tokens[0], "key"))     return sdk_config_line_key(config, tokens, count);
+  if (!strcmp(tokens[0], "gesture")) return sdk_config_line_gesture(config, tokens, count);
+  if (!strcmp(tokens[0], "live"))    return sdk_config_line_live(config, tokens, count);
+  if (!strcmp(tokens[0], "widget"))  return sdk_config_line_widget(config, tokens, count);
+  if (!strcmp(tokens[0], "page"))
+  {
+    if (count != 2 && !(count == 4 && !strcmp(tokens[2], "parent"))) return "page <name> [parent <name>]";
+    if (sdk_config_page(config, tokens[1], NULL)) return "page defined twice";
+    parent = SDK_PAGE_NONE;
+    if (count == 4 && !sdk_config_page(config, tokens[3], &parent)) return "parent page has to come first";
+    if (config->page_count >= SDK_PROFILE_PAGES) return "too many pages";
+    page = arena_push_struct(&config->arena, Sdk_Config_Page);
+    if (!page) return "out of memory";
+    page->name   = arena_strdup(&config->arena, tokens[1]);
+    page->parent = parent;
+    if (config->last_page) config->last_page->next = page;
+    else                   config->pages           = page;
+    config->last_page = page;
+    config->page_count++;
+    return NULL;
+  }
+  if (!strcmp(tokens[0], "font"))
+  {
+    if (count != 2 || strlen(tokens[1]) > SDK_ASSET_NAME_LEN) return "font <asset pack font>";
+    config->font = arena_strdup(&config->arena, tokens[1]);
+    return config->font ? NULL : "out of memory";
+  }
+  if (!strcmp(tokens[0], "transition"))
+  {
+    for (value = 0; count == 2 && value < countof(g_sdk_transition_names); value++)
+    {
+      if (!strcmp(tokens[1], g_sdk_transition_names[value])) { config->transition = (u8) value; return NULL; }
+    }
+    return "transition none|blank|dim|slide|fade";
+  }
+  if (!strcmp(tokens[0], "model"))
+  {
+    if (count != 4 || strcmp(tokens[2], "brightness")) return "model <pid> brightness <percent>";
+    if (!sdk_config_number(tokens[1], &pid) || !sdk_config_number(tokens[3], &value) || value > 100) return "bad model override";
+    if (config->model_count >= SDK_CONFIG_MODELS) return "too many model overrides";
+    model = &config->models[config->model_count++];
+    model->pid        = (u16) pid;
+    model->brightness = (u8) value;
+    return NULL;
+  }
+  if (count != 2 || !sdk_config_number(tokens[1], &value)) return "unknown statement";
+  if      (!strcmp(tokens[0], "brightness") && value <= 100) config->brightness    = (u8) value;
+  else if (!strcmp(tokens[0], "debounce"))                   config->debounce_ms   = value;
+  else if (!strcmp(tokens[0], "double_tap"))                 config->double_tap_ms = value;
+  else if (!strcmp(tokens[0], "hold") && value)              config->hold_ms       = value;
+  else if (!strcmp(tokens[0], "input_depth") && value)       config->input_depth   = value;
+  else return "unknown statement";
+  return NULL;
+}
+
+static void
+sdk_config_close(Sdk_Config *config)
+{
+  u32 i;
+
+  if (!config) return;
+  for (i = 0; i < config->profile_count; i++) sdk_profile_close(config->profiles[i]);
+  arena_close(&config->arena);
+  heap_free_dz(config);
+}
+
+/* NOTE: NULL when the file is missing or has an error, reported with its line. */
+static Sdk_Config*
+sdk_config_load(char *path)
+{
+  i32        count;
+  u32        line_number;
+  char       *text, *line, *end, *error, *slash;
+  char       *tokens[SDK_CONFIG_TOKENS];
+  File       file;
+  Sdk_Config *config;
+
+  config = NULL;
+  if (file_exist_open_map_ro(path, &file) != CM_OK) { printf("config: cannot open %s\n", path); return NULL; }
+  cm_heap_alloc(sizeof(Sdk_Config), config);
+  if (!config) goto _failure;
+  if (!arena_open(&config->arena, 0)) { heap_free_dz(config); config = NULL; goto _failure; }
+  config->brightness    = SDK_CONFIG_NO_VALUE;
+  config->debounce_ms   = 10;
+  config->double_tap_ms = 300;
+  config->hold_ms       = 500;
+  strncpy(config->dir, path, SDK_CONFIG_PATH_LEN - 1);
+  slash = strrchr(config->dir, '\\');
+  if (!slash) slash = strrchr(config->dir, '/');
+  if (slash) *slash = 0;
+  else       strcpy(config->dir, ".");
+
+  text = arena_push(&config->arena, file.buffer.size + 1);
+  if (!text) goto _error;
+  memcpy(text, file.buffer.view, file.buffer.size);
+  file_close(&file);
+
+  error = NULL;
+  for (line = text, line_number = 1; *line && !error; line = end, line_number++)
+  {
+    end = line;
+    while (*end && *end != '\n') end++;
+    if (end > line && end[-1] == '\r') end[-1] = 0;
+    if (*end) *end++ = 0;
+    count = sdk_config_tokenize(line, tokens);
+    if (count < 0) error = "unterminated quote";
+    else if (count > 0) error = sdk_config_line(config, tokens, count);
+  }
+  if (error)
+  {
+    printf("config: %s:%u: %s\n", path, line_number - 1, error);
+    sdk_config_close(config);
+    return NULL;
+  }
+  return config;
+
+_error:
+  sdk_config_close(config);
+  config = NULL;
+_failure:
+  file_close(&file);
+  return config;
+}
+
+/* -- Building ----------------------------------------------------------------------- */
+
+/*
+ * NOTE:
+ *      Image bytes for `path`, read once per configuration. Files unchanged
+ *      since `prev` read them (same write time and size) are copied from it.
+ */
+static Sdk_Config_Image*
+sdk_config_image(Sdk_Config *config, Sdk_Config *prev, char *path)
+{
+  u32              size, cached_size;
+  u64              write_time;
+  File             file;
+  Sdk_Config_Image *image, *old;
+
+  for (image = config->images; image; image = image->next)
+  {
+    if (!strcmp(image->path, path)) return image;
+  }
+  image = arena_push_struct(&config->arena, Sdk_Config_Image);
+  if (!image) return NULL;
+  image->path       = path;
+  image->next       = config->images;
+  config->images    = image;
+  cached_size       = 0;
+  write_time        = sdk_file_write_time(path, &cached_size);
+  image->write_time = write_time;
+  for (old = prev ? prev->images : NULL; old && write_time; old = old->next)
+  {
+    if (strcmp(old->path, path) || old->write_time != write_time || old->size != cached_size || !old->data) continue;
+    image->data = arena_push(&config->arena, old->size);
+    if (image->data) { memcpy(image->data, old->data, old->size); image->size = old->size; }
+    return image;
+  }
+  if (file_exist_open_map_ro(path, &file) != CM_OK) { printf("config: cannot read image %s\n", path); return image; }
+  size        = (u32) file.buffer.size;
+  image->data = arena_push(&config->arena, size);
+  if (image->data) { memcpy(image->data, file.buffer.view, size); image->size = size; }
+  file_close(&file);
+  return image;
+}
+
+/* NOTE: Reads every image up front, the profiles then find them in `config->images`. */
+static void
+sdk_config_read_images(Sdk_Config *config)
+{
+  Sdk_Config_Page *page;
+  Sdk_Config_Key  *key;
+
+  for (page = config->pages; page; page = page->next)
+  {
+    for (key = page->keys; key; key = key->next)
+    {
+      if (key->image)   sdk_config_image(config, NULL, key->image);
+      if (key->pressed) sdk_config_image(config, NULL, key->pressed);
+    }
+  }
+}
+
+/*
+ * NOTE:
+ *      Pressed variant of `key` for the model of `sdk`: its own file, or made
+ *      from the key's image `data` with `pressed auto`. A variant that cannot
+ *      be made leaves the key without one, false only when out of memory.
+ */
+static bool
+sdk_config_pressed(Sdk_Config *config, Sdk_Config *prev, Stream_Deck *sdk, Sdk_Profile *profile, u16 index,
+                   Sdk_Config_Key *key, u8 *data, u32 size)
+{
+  u8               *reports;
+  bool             ok;
+  Sdk_Packed       *packed;
+  Sdk_Config_Image *image;
+
+  packed = NULL;
+  if (key->pressed)
+  {
+    image = sdk_config_image(config, prev, key->pressed);
+    if (image && image->data)
+    {
+      packed = sdk_fit_key_image(sdk, image->data, image->size);
+      if (!packed && sdk_key_image_ready(sdk, image->data, image->size))
+      {
+        packed = sdk_pack_key_image(sdk, image->data, image->size, 0);
+      }
+    }
+  }
+  else if (key->label || key->has_background)
+  {
+    printf("config: key %u: pressed auto does not work on drawn keys\n", key->key);
+    return true;
+  }
+  else if (data) packed = sdk_pressed_key_image(sdk, data, size, true);
+  if (!packed)
+  {
+    printf("config: key %u: no pressed image\n", key->key);
+    return true;
+  }
+  reports = arena_push(&config->arena, (u64) packed->report_len * packed->report_count);
+  if (reports) memcpy(reports, packed->reports, (u64) packed->report_len * packed->report_count);
+  ok = reports && sdk_profile_set_key_pressed(profile, index, key->key, reports, packed->report_len * packed->report_count,
+                                              packed->image_size, packed->hash);
+  sdk_packed_release(packed);
+  return ok;
+}
+
+/* NOTE: Main thread. Profile for the model of `sdk`, built the first time it is asked for. */
+static Sdk_Profile*
+sdk_config_profile(Sdk_Config *config, Sdk_Config *prev, Stream_Deck *sdk)
+{
+  u8               *data, *reports;
+  u16              index, target, action;
+  u32              i, size, layer_count;
+  bool             ok;
+  Sdk_Layer        layers[3];
+  Sdk_Packed       *packed;
+  Sdk_Profile      *profile;
+  Sdk_Asset_Entry  *asset;
+  Sdk_Config_Page  *page;
+  Sdk_Config_Key   *key;
+  Sdk_Config_Image *image;
+
+  for (i = 0; i < config->profile_count; i++)
+  {
+    if (config->profile_pids[i] == sdk->product_id) return config->profiles[i];
+  }
+  if (config->profile_count >= SDK_MAX_DECKS) return NULL;
+  profile = arena_push_struct(&config->arena, Sdk_Profile);
+  if (!profile || !sdk_profile_open(profile, sdk->total)) return NULL;
+  for (page = config->pages; page; page = page->next)
+  {
+    if (sdk_profile_add_page(profile, page->parent) == SDK_PAGE_NONE) goto _failure;
+  }
+  /* NOTE: No page at all still gives the deck a blank one */
+  if (!config->pages && sdk_profile_add_page(profile, SDK_PAGE_NONE) == SDK_PAGE_NONE) goto _failure;
+  for (page = config->pages, index = 0; page; page = page->next, index++)
+  {
+    for (key = page->keys; key; key = key->next)
+    {
+      if (key->key >= sdk->total || (key->pid && key->pid != sdk->product_id)) continue;
+      action = key->action.kind ? key->action.id : SDK_ACTION_UNBOUND;
+      /* NOTE: Compiled for this model, nothing left to do to the image. `pressed auto` needs the source image. */
+      asset  = (!key->image && key->icon && !key->label && !key->has_background && !key->pressed_auto)
+             ? sdk_asset_key(&g_assets, key->icon, sdk->product_id) : NULL;
+      data   = NULL;
+      size   = 0;
+      if (asset)
+      {
+        if (!sdk_profile_set_key_reports(profile, index, key->key, sdk_asset_data(&g_assets, asset),
+                                         asset->size, asset->param, 0, action)) goto _failure;
+      }
+      else
+      {
+        image = key->image ? sdk_config_image(config, prev, key->image) : NULL;
+        data  = image ? image->data : NULL;
+        size  = image ? image->size : 0;
+        if (!key->image && key->icon)
+        {
+          data = sdk_asset_image(&g_assets, key->icon, &size);
+          if (!data) printf("config: no icon %s in the asset pack\n", key->icon);
+        }
+        if (key->label || key->has_background)
+        {
+          memset(layers, 0, sizeof(layers));
+          layer_count = 0;
+          layers[layer_count].kind  = SDK_LAYER_FILL;
+          layers[layer_count].color = key->background;
+          layer_count++;
+          if (data)
+          {
+            layers[layer_count].kind = SDK_LAYER_ICON;
+            layers[layer_count].data = data;
+            layers[layer_count].size = size;
+            layer_count++;
+          }
+          if (key->label)
+          {
+            layers[layer_count].kind  = SDK_LAYER_TEXT;
+            layers[layer_count].align = SDK_ALIGN_BOTTOM;
+            layers[layer_count].color = 0xFFFFFF;
+            layers[layer_count].text  = key->label;
+            layers[layer_count].font  = config->font;
+            layer_count++;
+          }
+          packed = sdk_compose_key(sdk, layers, layer_count, 0);
+        }
+        /* NOTE: Not made for this model, resized and rotated once and kept in the tile cache */
+        else packed = data ? sdk_fit_key_image(sdk, data, size) : NULL;
+        if (packed)
+        {
+          reports = arena_push(&config->arena, (u64) packed->report_len * packed->report_count);
+          if (reports) memcpy(reports, packed->reports, (u64) packed->report_len * packed->report_count);
+          ok = reports && sdk_profile_set_key_reports(profile, index, key->key, reports, packed->report_len * packed->report_count,
+                                                      packed->image_size, packed->hash, action);
+          sdk_packed_release(packed);
+          if (!ok) goto _failure;
+        }
+        else if (!sdk_profile_set_key(profile, index, key->key, data, size, action)) goto _failure;
+      }
+      if ((key->pressed || key->pressed_auto) && !sdk_config_pressed(config, prev, sdk, profile, index, key, data, size)) goto _failure;
+      target = 0;
+      if (key->nav == SDK_NAV_FOLDER && !sdk_config_page(config, key->target, &target))
+      {
+        printf("config: page %s has a folder to unknown page %s\n", page->name, key->target);
+        continue;
+      }
+      sdk_profile_set_nav(profile, index, key->key, key->nav, target);
+    }
+  }
+  config->profiles[config->profile_count]       = profile;
+  config->profile_pids[config->profile_count++] = sdk->product_id;
+  return profile;
+
+_failure:
+  sdk_profile_close(profile);
+  return NULL;
+}
+
+static u8
+sdk_config_brightness(Sdk_Config *config, u16 pid)
+{
+  u32 i;
+
+  if (!config) return SDK_CONFIG_NO_VALUE;
+  for (i = config->model_count; i--;)
+  {
+    if (config->models[i].pid == pid) return config->models[i].brightness;
+  }
+  return config->brightness;
+}
+
+static void
+sdk_config_register(Sdk_Actions *actions, Sdk_Config_Action *action)
+{
+  action->id = SDK_ACTION_UNBOUND;
+  if (!actions || !action->kind) return;
+  action->id = sdk_action_add(actions, action->kind, action->arg, action->data, action->data_len, action->timeout_ms);
+}
+
+/*
+ * NOTE:
+ *      Main thread. Makes `config` the active one, `prev` (may be NULL) is
+ *      what the decks show now. Every profile is built before any deck is
+ *      touched, so on failure nothing changed and `prev` stays active.
+ *      On success `prev` can be closed right away.
+ */
+static bool
+sdk_config_apply(Sdk_Config *config, Sdk_Config *prev, Sdk_Manager *mgr)
+{
+  u8                 brightness;
+  u32                i, count, gestures, actions;
+  Sdk_Gesture_Def    defs[SDK_ACTION_GESTURES];
+  Sdk_Config_Page    *page;
+  Sdk_Config_Key     *key;
+  Sdk_Config_Gesture *gesture;
+  Stream_Deck        *sdk;
+
+  /* NOTE: What is added past this is only kept when the configuration applies */
+  actions = mgr->actions ? atomic_load(&mgr->actions->action_count) : 0;
+  for (page = config->pages; page; page = page->next)
+  {
+    for (key = page->keys; key; key = key->next) sdk_config_register(mgr->actions, &key->action);
+  }
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++)
+  {
+    if (!sdk_config_profile(config, prev, &mgr->decks[i]))
+    {
+      printf("config: cannot build the profile of [%s]\n", mgr->decks[i].serial);
+      if (mgr->actions) sdk_actions_truncate(mgr->actions, actions);
+      return false;
+    }
+  }
+
+  gestures = 0;
+  for (gesture = config->gestures; gesture; gesture = gesture->next)
+  {
+    sdk_config_register(mgr->actions, &gesture->action);
+    defs[gestures++] = gesture->def;
+  }
+  if (mgr->actions)
+  {
+    for (i = 0; i < SDK_ACTION_GESTURES; i++) sdk_action_bind_gesture(mgr->actions, (u16) i, SDK_ACTION_UNBOUND);
+    for (gesture = config->gestures; gesture; gesture = gesture->next)
+    {
+      sdk_action_bind_gesture(mgr->actions, gesture->def.id, gesture->action.id);
+    }
+  }
+  /* NOTE: Even without gestures, the table carries the debounce */
+  sdk_manager_set_gestures(mgr, sdk_gestures_compile(defs, gestures, config->debounce_ms, config->double_tap_ms,
+                                                     config->hold_ms));
+
+  for (i = 0; i < count; i++)
+  {
+    sdk = &mgr->decks[i];
+    sdk_swap_profile(sdk, sdk_config_profile(config, prev, sdk));
+    sdk_set_transition(sdk, config->transition);
+    if (config->input_depth) sdk_set_input_depth(sdk, config->input_depth);
+    brightness = sdk_config_brightness(config, sdk->product_id);
+    if (brightness != SDK_CONFIG_NO_VALUE && (!prev || brightness != sdk_config_brightness(prev, sdk->product_id)))
+    {
+      sdk_queue_brightness(sdk, brightness, NULL, NULL);
+    }
+  }
+  /* NOTE: The services may still be packing from the profiles of `prev` */
+  sdk_manager_synchronize(mgr);
+  return true;
+}
+
+/* NOTE: Binds the live keys and widgets of `config` meant for `sdk`, an unchanged binding stays as it is. */
+static void
+sdk_config_bind_live(Sdk_Config_Watch *watch, Sdk_Config *config, Stream_Deck *sdk)
+{
+  Sdk_Config_Live   *live;
+  Sdk_Config_Widget *widget;
+
+  for (live = config->lives; live && watch->live; live = live->next)
+  {
+    if (live->key >= sdk->total || (live->pid && live->pid != sdk->product_id)) continue;
+    sdk_live_bind(watch->live, sdk, live->key, live->path, live->debounce_ms, live->interval_ms, watch->generation);
+  }
+  for (widget = config->widgets; widget && watch->widgets; widget = widget->next)
+  {
+    if (widget->key >= sdk->total || (widget->pid && widget->pid != sdk->product_id)) continue;
+    sdk_widget_bind(watch->widgets, sdk, widget->key, &widget->def, watch->generation);
+  }
+}
+
+/* NOTE: Main thread, after `config` was applied. Live keys and widgets it dropped go back to the profile. */
+static void
+sdk_config_apply_live(Sdk_Config_Watch *watch, Sdk_Config *config)
+{
+  u32 i, count;
+
+  if (!watch->live && !watch->widgets) return;
+  watch->generation++;
+  count = atomic_load(&watch->mgr->count);
+  for (i = 0; i < count; i++) sdk_config_bind_live(watch, config, &watch->mgr->decks[i]);
+  if (watch->live)    sdk_live_prune(watch->live, watch->generation);
+  if (watch->widgets) sdk_widget_prune(watch->widgets, watch->generation);
+}
+
+/* NOTE: Sdk_Attach_Hook, a deck showed up (or came back) while `watch->active` is in place. */
+static void
+sdk_config_on_attach(Sdk_Manager *mgr, Stream_Deck *sdk, void *user)
+{
+  u8               brightness;
+  Sdk_Profile      *profile;
+  Sdk_Config_Watch *watch;
+
+  (void) mgr;
+  watch = user;
+  if (!watch->active) return;
+  if (!sdk->pages)
+  {
+    profile = sdk_config_profile(watch->active, NULL, sdk);
+    if (profile) sdk_set_profile(sdk, profile);
+  }
+  sdk_set_transition(sdk, watch->active->transition);
+  if (watch->active->input_depth) sdk_set_input_depth(sdk, watch->active->input_depth);
+  brightness = sdk_config_brightness(watch->active, sdk->product_id);
+  if (brightness != SDK_CONFIG_NO_VALUE) sdk_queue_brightness(sdk, brightness, NULL, NULL);
+  if (watch->live || watch->widgets) sdk_config_bind_live(watch, watch->active, sdk);
+}
+
+/* -- Watching ----------------------------------------------------------------------- */
+
+static bool
+sdk_config_watch_arm(Sdk_Config_Watch *watch)
+{
+  DWORD filter;
+
+  filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+  if (!ReadDirectoryChangesW(watch->dir, watch->buffer, sizeof(watch->buffer), TRUE, filter, NULL, &watch->ol, NULL))
+  {
+    report_error("ReadDirectoryChangesW");
+    return false;
+  }
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Editors write a file in several steps (truncate, write, rename...),
+ *      so the reload waits until the directory stayed quiet for
+ *      SDK_CONFIG_SETTLE_MS. Image changes under the directory count too.
+ */
+static DWORD WINAPI
+sdk_config_watch_proc(void *args)
+{
+  u32              ret, timeout;
+  DWORD            bytes;
+  HANDLE           handles[2];
+  Sdk_Config_Watch *watch;
+
+  watch      = args;
+  handles[0] = watch->stop_event;
+  handles[1] = watch->ol.hEvent;
+  timeout    = INFINITE;
+  if (!sdk_config_watch_arm(watch)) return EXIT_FAILURE;
+  for (;;)
+  {
+    ret = WaitForMultipleObjects(2, handles, FALSE, timeout);
+    if (ret == WAIT_OBJECT_0) break;
+    if (ret == WAIT_TIMEOUT)
+    {
+      timeout = INFINITE;
+      atomic_store(&watch->changed, true);
+      if (!PostThreadMessageA(watch->main_thread, WM_NULL, 0, 0)) report_error("PostThreadMessageA");
+      continue;
+    }
+    if (ret != WAIT_OBJECT_0 + 1) { report_error("WaitForMultipleObjects"); break; }
+    /* NOTE: 0 bytes is an overflowed buffer, still a change */
+    if (!GetOverlappedResult(watch->dir, &watch->ol, &bytes, FALSE)) { report_error("GetOverlappedResult"); break; }
+    timeout = SDK_CONFIG_SETTLE_MS;
+    if (!sdk_config_watch_arm(watch)) break;
+  }
+  CancelIoEx(watch->dir, &watch->ol);
+  return EXIT_SUCCESS;
+}
+
+/* NOTE: Main thread. Loads `watch->path` again and applies it over the active one. */
+static bool
+sdk_config_reload(Sdk_Config_Watch *watch)
+{
+  u64        start;
+  Sdk_Config *config;
+
+  start  = sdk_now();
+  config = sdk_config_load(watch->path);
+  if (!config || !sdk_config_apply(config, watch->active, watch->mgr))
+  {
+    sdk_config_close(config);
+    watch->failures++;
+    printf("config: keeping the previous configuration\n");
+    return false;
+  }
+  sdk_config_apply_live(watch, config);
+  sdk_config_close(watch->active);
+  watch->active  = config;
+  watch->last_us = sdk_ticks_to_us(sdk_now() - start);
+  watch->reloads++;
+  printf("config: %s applied in %llu us\n", watch->path, watch->last_us);
+  return true;
+}
+
+/* NOTE: Main thread, between device scans. */
+static void
+sdk_config_poll(Sdk_Config_Watch *watch)
+{
+  if (atomic_exchange(&watch->changed, false)) sdk_config_reload(watch);
+}
+
+/* NOTE: Parses the file and reads its images while the main thread opens the decks. */
+static DWORD WINAPI
+sdk_config_loader_proc(void *args)
+{
+  u64              start;
+  Sdk_Config_Watch *watch;
+
+  watch  = args;
+  start  = sdk_now();
+  watch->loaded = sdk_config_load(watch->path);
+  if (watch->loaded) sdk_config_read_images(watch->loaded);
+  watch->load_us = sdk_ticks_to_us(sdk_now() - start);
+  return EXIT_SUCCESS;
+}
+
+/*
+ * NOTE:
+ *      First half of the startup: `path` NULL uses %BETTERDECK_CONFIG% or
+ *      betterdeck.cfg next to the executable, and it starts loading on a
+ *      thread of its own, so the file and its images are read while
+ *      sdk_manager_open enumerates and opens the decks. Then
+ *      sdk_config_watch_open. Main thread.
+ */
+static bool
+sdk_config_watch_prefetch(Sdk_Config_Watch *watch, char *path)
+{
+  char *slash;
+  u32  len;
+
+  memset(watch, 0, sizeof(Sdk_Config_Watch));
+  watch->main_thread = GetCurrentThreadId();
+  watch->dir         = INVALID_HANDLE_VALUE;
+  if (path) strncpy(watch->path, path, SDK_CONFIG_PATH_LEN - 1);
+  else if (!GetEnvironmentVariableA(SDK_CONFIG_ENV, watch->path, SDK_CONFIG_PATH_LEN))
+  {
+    len = (u32) GetModuleFileNameA(NULL, watch->path, SDK_CONFIG_PATH_LEN);
+    if (!len || len >= SDK_CONFIG_PATH_LEN) { report_error("GetModuleFileNameA"); return false; }
+    slash = strrchr(watch->path, '\\');
+    if (slash) slash[1] = 0;
+    else       watch->path[0] = 0;
+    if (strlen(watch->path) + sizeof(SDK_CONFIG_FILE) > SDK_CONFIG_PATH_LEN) { printf("config: path too long\n"); return false; }
+    strcat(watch->path, SDK_CONFIG_FILE);
+  }
+  /* NOTE: Without the thread, sdk_config_watch_open loads it itself */
+  watch->loader = CreateThread(NULL, 0, sdk_config_loader_proc, watch, 0, NULL);
+  if (!watch->loader) report_error("CreateThread");
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Applies the configuration sdk_config_watch_prefetch loaded (a missing
+ *      file is not an error, the decks stay blank until it shows up) and
+ *      starts watching. The services may already run, the first page of
+ *      every deck goes out right away. `live` and `widgets` (may be NULL)
+ *      get the live keys and the widgets. The decks use the active
+ *      configuration's profiles: close the manager first.
+ */
+static bool
+sdk_config_watch_open(Sdk_Config_Watch *watch, Sdk_Manager *mgr, Sdk_Live *live, Sdk_Widgets *widgets)
+{
+  char *slash, dir[SDK_CONFIG_PATH_LEN];
+  u64  start;
+
+  watch->mgr     = mgr;
+  watch->live    = live;
+  watch->widgets = widgets;
+  if (watch->loader)
+  {
+    WaitForSingleObject(watch->loader, INFINITE);
+    handle_close(watch->loader);
+    watch->loader = NULL;
+  }
+  else sdk_config_loader_proc(watch);
+  watch->active = watch->loaded;
+  watch->loaded = NULL;
+  start = sdk_now();
+  if (watch->active && !sdk_config_apply(watch->active, NULL, mgr))
+  {
+    sdk_config_close(watch->active);
+    watch->active = NULL;
+  }
+  if (watch->active)
+  {
+    sdk_config_apply_live(watch, watch->active);
+    printf("config: %s loaded in %llu us, applied in %llu us\n", watch->path, watch->load_us, sdk_ticks_to_us(sdk_now() - start));
+  }
+  sdk_manager_add_attach_hook(mgr, sdk_config_on_attach, watch);
+
+  strcpy(dir, watch->path);
+  slash = strrchr(dir, '\\');
+  if (slash) *slash = 0;
+  else       strcpy(dir, ".");
+  watch->dir = CreateFileA(dir, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+  if (watch->dir == INVALID_HANDLE_VALUE) { report_error("CreateFileA"); return false; }
+  watch->ol.hEvent   = CreateEvent(NULL, FALSE, FALSE, NULL);
+  watch->stop_event  = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (!watch->ol.hEvent || !watch->stop_event) { report_error("CreateEvent"); return false; }
+  watch->thread = CreateThread(NULL, 0, sdk_config_watch_proc, watch, 0, NULL);
+  if (!watch->thread) { report_error("CreateThread"); return false; }
+  return true;
+}
+
+static void
+sdk_config_watch_close(Sdk_Config_Watch *watch)
+{
+  if (watch->loader)
+  {
+    WaitForSingleObject(watch->loader, INFINITE);
+    handle_close(watch->loader);
+  }
+  sdk_config_close(watch->loaded);
+  if (watch->thread)
+  {
+    SetEvent(watch->stop_event);
+    WaitForSingleObject(watch->thread, INFINITE);
+    handle_close(watch->thread);
+  }
+  if (watch->stop_event) handle_close(watch->stop_event);
+  if (watch->ol.hEvent)  handle_close(watch->ol.hEvent);
+  if (watch->dir != INVALID_HANDLE_VALUE && watch->dir) handle_close(watch->dir);
+  if (watch->mgr) sdk_manager_remove_attach_hook(watch->mgr, sdk_config_on_attach, watch);
+  sdk_config_close(watch->active);
+  memset(watch, 0, sizeof(Sdk_Config_Watch));
+}
+
+#endif // SDK_CONFIG_C
@@ -0,0 +1,1764 @@
+#ifndef SDK_DECK_C
+#define SDK_DECK_C
+
+#pragma warning(push, 0)
+#include <stdatomic.h>
+#pragma warning(pop)
+
+/* NOTE: Taken from elgato's repo */
+#define VID_ELGATO              0x0fd9
+#define PID_SDECK_ORIGINAL      0x0060
+#define PID_SDECK_ORIGINAL_19   0x006d
+#define PID_SDECK_MK2_21        0x0080
+#define PID_SDECK_MK2_SCISSOR   0x0080 /* (2023) */
+#define PID_SDECK_MINI          0x0063
+#define PID_SDECK_MINI_22       0x0090
+#define PID_SDECK_NEO           0x009a
+#define PID_SDECK_XL            0x006c
+#define PID_SDECK_XL_22         0x008f
+#define PID_SDECK_PEDAL         0x0086
+#define PID_SDECK_PLUS          0x0084 /* (Wave deck) */
+
+global u16 g_elgato_pids[] = {
+  PID_SDECK_ORIGINAL, PID_SDECK_ORIGINAL_19, PID_SDECK_MINI,
+  PID_SDECK_NEO,      PID_SDECK_XL,          PID_SDECK_XL_22, PID_SDECK_MK2_21,
+  PID_SDECK_PEDAL,    PID_SDECK_MINI_22,     PID_SDECK_PLUS,
+};
+
+#pragma warning(disable : 4820)
+/*
+ * NOTE:
+ *      Only the decks speaking the second protocol revision (JPEG images,
+ *      8 bytes image report header, key states at offset 4) are listed here.
+ *      Original/Mini use BMP and a different header, Pedal has no screen.
+ */
+typedef struct SdkModel
+{
+  u16   pid;
+  u8    rows, cols;
+  u16   pxl;
+  u8    key_rotation;                          /* NOTE: Quarter turns clockwise of its key images */
+  char  *name;
+} SdkModel, Sdk_Model;
+
+global Sdk_Model g_sdk_models[] = {
+  { PID_SDECK_XL,          4, 8,  96, 0, "Stream Deck XL"       },
+  { PID_SDECK_XL_22,       4, 8,  96, 0, "Stream Deck XL (22)"  },
+  { PID_SDECK_ORIGINAL_19, 3, 5,  72, 0, "Stream Deck (19)"     },
+  { PID_SDECK_MK2_21,      3, 5,  72, 0, "Stream Deck MK.2"     },
+  { PID_SDECK_NEO,         2, 4,  96, 0, "Stream Deck Neo"      },
+  { PID_SDECK_PLUS,        2, 4, 120, 0, "Stream Deck +"        },
+};
+
+#define SDK_WRITE_QUEUE_LEN   128           /* NOTE: A BLANK frame of the XL alone is 64 jobs */
+#define SDK_FEATURE_QUEUE_LEN 16
+#define SDK_FEATURE_CACHE_LEN 32
+#define SDK_SERIAL_LEN        64
+#define SDK_BRIGHTNESS_UNKNOWN 0xFF
+
+/* NOTE: Pressed variant of a bound key image: size and brightness in percent, JPEG quality */
+#define SDK_PRESSED_SCALE      85
+#define SDK_PRESSED_BRIGHTNESS 60
+#define SDK_PRESSED_QUALITY    90
+/* NOTE: JPEG quality of images resized or rotated for the deck, see sdk_fit_key_image */
+#define SDK_FIT_QUALITY        90
+/* NOTE: Animated content, see Sdk_Link */
+#define SDK_LINK_TARGET_US     (40 * 1000)   /* NOTE: Frame latency, queued to on the device */
+#define SDK_LINK_SAMPLES       4             /* NOTE: Frames at a level before it can be left */
+#define SDK_LINK_RESTORE_MS    1000          /* NOTE: Queue idle that long: one level back up */
+#define SDK_LINK_SLACK_MS      50
+
+typedef struct SdkWriteJob
+{
+  u8         *image;
+  u32        size;
+  u8         key;
+  bool       mapped;   /* NOTE: `file` has to be closed once the upload is done */
+  File       file;
+  Sdk_Packed *packed;  /* NOTE: Pre-built reports, `image` is unused. Holds a reference */
+  u64        stamp;   /* NOTE: Page switch it belongs to, see Sdk_Page_Timing */
+  bool       animated; /* NOTE: Encoded at link level `level`, timed from `queued` */
+  u8         level;
+  u64        queued;
+  struct SdkFrame *frame; /* NOTE: Presented with others, see sdk_frame.c */
+  u64        sequence; /* NOTE: Of its frame, 0 = none */
+} SdkWriteJob, Sdk_Write_Job;
+
+/*
+ * NOTE:
+ *      Image uploads waiting for the deck. A job for a key that is still
+ *      queued is replaced in place, so a producer re-sending the same key
+ *      faster than the bus drains never grows the queue. Jobs of the same
+ *      frame (`sequence`) are the exception, they keep their order.
+ *      Pushing wakes the service owning the deck (see sdk_notify).
+ */
+typedef struct SdkWriteQueue
+{
+  SRWLOCK       lock;
+  u32           head, count;
+  Sdk_Write_Job jobs[SDK_WRITE_QUEUE_LEN];
+  /* NOTE: Only touched by the thread servicing the deck */
+  Sdk_Write_Job current;
+  bool          busy;
+  u32           page;
+  u32           sent;
+} SdkWriteQueue, Sdk_Write_Queue;
+
+/*
+ * NOTE:
+ *      Press feedback: keys bound with sdk_bind_key_image keep both their
+ *      normal and pressed images packed. The thread servicing the deck marks
+ *      a key `pending` the moment a report changes it, and the write pump
+ *      sends the variant matching the key state ahead of the write queue, so
+ *      a press is on screen after at most the upload already on the wire.
+ */
+typedef struct SdkKeyFeedback
+{
+  SRWLOCK       lock;
+  Sdk_Packed    *normal[SDK_KEYS_MAX];
+  Sdk_Packed    *pressed[SDK_KEYS_MAX];
+  atomic_ullong bound[SDK_KEY_WORDS];
+  /* NOTE: Only touched by the thread servicing the deck */
+  u64           pending[SDK_KEY_WORDS];
+} SdkKeyFeedback, Sdk_Key_Feedback;
+
+/*
+ * NOTE:
+ *      Page switch latency: the switch stamps its jobs with `start` and the
+ *      write pump counts them down, the last one completing closes the
+ *      measure. A job replaced, failed or dropped on disconnect counts down
+ *      too, so a switch that lost a key still closes. A newer switch simply
+ *      replaces the one in flight.
+ */
+typedef struct SdkPageTiming
+{
+  atomic_ullong start;
+  atomic_uint   left;
+  /* NOTE: Only written by whoever counts the last job down */
+  u64           switches;
+  u64           total_us, last_us, max_us;
+} SdkPageTiming, Sdk_Page_Timing;
+
+/*
+ * NOTE:
+ *      Link quality. Hubs and KVMs drain reports at very different rates,
+ *      so the write pump measures it: every report is timed from
+ *      hid_write_start to its completion, and every animated job (widgets,
+ *      live keys) from its push to its last report. When the average frame
+ *      latency goes over SDK_LINK_TARGET_US, animated content steps down a
+ *      level: a lower JPEG quality, then a lower resolution scaled back to
+ *      the key size (the device only takes its own size, a smoother image
+ *      is fewer bytes and fewer reports). Each SDK_LINK_RESTORE_MS the write
+ *      queue stays idle without a break, on the service's timer wheel, steps
+ *      back up one level. Static content (pages, bound images) always goes
+ *      at level 0.
+ */
+typedef struct SdkLinkLevel
+{
+  u8 quality;
+  u8 scale;                                  /* NOTE: Percent of the key size it is encoded at */
+} SdkLinkLevel, Sdk_Link_Level;
+
+global Sdk_Link_Level g_sdk_link_levels[] = {
+  { SDK_FIT_QUALITY, 100 }, { 75, 100 }, { 60, 100 }, { 50, 75 }, { 40, 50 },
+};
+
+typedef struct SdkLink
+{
+  atomic_uint level;                         /* NOTE: g_sdk_link_levels index, read by producers */
+  /* NOTE: Only touched by the thread servicing the deck */
+  u64         report_start;                  /* NOTE: sdk_now() of the report in flight */
+  u64         report_us, frame_us;           /* NOTE: Averages, 1/8 weight per sample */
+  u32         window;                        /* NOTE: Frames timed at the current level */
+  u64         busy_end;                      /* NOTE: sdk_now() the last job went through */
+  Sdk_Timer   restore;
+  /* NOTE: Stats */
+  u64         reports, bytes, busy_us, frames, late, downs, ups;
+} SdkLink, Sdk_Link;
+
+/*
+ * NOTE:
+ *      How long the first connection took to light the deck, sdk_now()
+ *      ticks (0 = not reached yet). `launch` is the manager's, `opened` is
+ *      written by the main thread, the rest by the thread servicing the deck.
+ */
+typedef struct SdkDeckStartup
+{
+  u64 launch;
+  u64 opened;
+  u64 first_report;
+  u64 full_page;
+} SdkDeckStartup, Sdk_Deck_Startup;
+
+/* NOTE: Feature report ids, second protocol revision */
+#define SDK_FEATURE_FIRMWARE  0x05
+#define SDK_FEATURE_SERIAL    0x06
+
+#define SDK_OP_SET_BRIGHTNESS 0x01
+#define SDK_OP_RESET          0x02
+#define SDK_OP_GET_REPORT     0x03
+#define SDK_OP_INPUT_DEPTH    0x04           /* NOTE: Not a report, sets the driver ring to `input.depth` */
+
+struct StreamDeck;
+/* NOTE: Runs on the service thread, `result` is the report length or -1 */
+typedef void (*Sdk_Feature_Done)(struct StreamDeck *sdk, u8 op, u8 value, i64 result, void *user);
+
+/* NOTE: Runs on the service thread once per input batch, must not block */
+typedef void (*Sdk_Key_Sink_Proc)(struct StreamDeck *sdk, Sdk_Key_Event *events, u32 count, void *user);
+
+typedef struct SdkKeySink
+{
+  Sdk_Key_Sink_Proc proc;
+  void              *user;
+} SdkKeySink, Sdk_Key_Sink;
+
+typedef struct SdkFeatureOp
+{
+  u8                op;
+  u8                value;       /* NOTE: brightness percent or report id */
+  Sdk_Feature_Done  done;
+  void              *user;
+} SdkFeatureOp, Sdk_Feature_Op;
+
+typedef struct SdkFeatureQueue
+{
+  SRWLOCK         lock;
+  u32             head, count;
+  Sdk_Feature_Op  ops[SDK_FEATURE_QUEUE_LEN];
+  /* NOTE: Only touched by the thread servicing the deck */
+  Sdk_Feature_Op  current;
+  bool            busy;
+} SdkFeatureQueue, Sdk_Feature_Queue;
+
+/*
+ * NOTE:
+ *      Static feature data (firmware version, serial) read once per
+ *      connection. `valid` holds one bit per slot and is published after the
+ *      bytes, so readers on any thread only need an acquire load.
+ */
+#define SDK_CACHE_FIRMWARE 0x00
+#define SDK_CACHE_SERIAL   0x01
+#define SDK_CACHE_SLOTS    0x02
+
+typedef struct SdkFeatureCache
+{
+  atomic_uint valid;
+  u32         len[SDK_CACHE_SLOTS];
+  u8          data[SDK_CACHE_SLOTS][SDK_FEATURE_CACHE_LEN + 1];
+} SdkFeatureCache, Sdk_Feature_Cache;
+
+/* NOTE: This is currently based off StreamDeckXL's values */
+typedef struct StreamDeck
+{
+  u8          rows, cols, total;                 /* r4 | c8 | r * c                 */
+  u16         pxl_w, pxl_h;                      /* w96 | h96                       */
+  u8          img_rpt_header_len;                /* 8                               */
+  u32         img_rpt_payload_len, img_rpt_len;  /* img_rpt - img_rpt_header | 1024 */
+  char*       img_format;                        /* "JPEG"                          */
+  u8          key_rotation;                      /* 0                               */
+  u8          *blank_key;                        /* see sdk_blank_key               */
+  u32         blank_key_size;
+  Sdk_Key_State keys;                            /* up to 256 keys, any thread      */
+  Hid_Device* hid;
+
+  u16             product_id;
+  char            serial[SDK_SERIAL_LEN];        /* stable identity across replugs  */
+  atomic_bool       connected;
+  Sdk_Model         *model;
+  _Atomic(HANDLE)   notify;                      /* wake event of the owning service */
+  _Atomic(Sdk_Timers*) timers;                   /* wheel of the owning service     */
+  Sdk_Write_Queue   queue;
+  Sdk_Feature_Queue features;
+  Sdk_Feature_Cache cache;
+  Sdk_Input         input;
+  _Atomic(Sdk_Gesture_Table*) gesture_table;     /* shared, NULL disables gestures */
+  Sdk_Gesture_State gestures;
+  Sdk_Key_Feedback  feedback;
+  _Atomic(Sdk_Actions*) actions;                 /* shared, NULL disables actions  */
+  _Atomic(Sdk_Key_Sink*) key_sink;               /* shared, NULL when nobody listens */
+  struct SdkDeckPages *pages;                    /* profile shown, see sdk_profile.c */
+  atomic_ullong     owned[SDK_KEY_WORDS];        /* keys the profile leaves alone   */
+  Sdk_Page_Timing   page_timing;
+  Sdk_Link          link;
+  atomic_uint       brightness;                  /* last asked for, or SDK_BRIGHTNESS_UNKNOWN */
+  atomic_uint       transition;                  /* of page switches, see sdk_frame.c */
+  atomic_ullong     transition_sequence;         /* transition on its way out, 0 = none */
+  Sdk_Deck_Startup  startup;
+} StreamDeck, Stream_Deck;
+#pragma warning(default : 4820)
+
+static Sdk_Model*
+sdk_model_get(u16 pid)
+{
+  u32 i;
+
+  for (i = 0; i < countof(g_sdk_models); i++)
+  {
+    if (g_sdk_models[i].pid == pid) return &g_sdk_models[i];
+  }
+  return NULL;
+}
+
+static void
+sdk_init_from_model(Stream_Deck *sdk, Sdk_Model *model)
+{
+  sdk->model               = model;
+  sdk->product_id          = model->pid;
+  sdk->rows                = model->rows;
+  sdk->cols                = model->cols;
+  sdk->total               = model->rows * model->cols;
+  sdk->pxl_w               = model->pxl;
+  sdk->pxl_h               = model->pxl;
+  sdk->img_rpt_header_len  = 8;
+  sdk->img_rpt_len         = 1024;
+  sdk->img_rpt_payload_len = 1024 - 8;
+  sdk->img_format          = "JPEG";
+  sdk->key_rotation        = model->key_rotation;
+  sdk->blank_key           = sdk_blank_key(model->pxl, &sdk->blank_key_size);
+}
+
+static inline void
+sdk_notify(Stream_Deck *sdk)
+{
+  HANDLE event;
+
+  event = atomic_load(&sdk->notify);
+  if (event) SetEvent(event);
+}
+
+/*
+ * NOTE:
+ *      Feature and output reports are built in place in the device's pooled
+ *      report buffers (hid->feature, hid->output), hid_send_report/hid_write
+ *      then send them without copying.
+ */
+static i64
+sdk_set_brightness(Stream_Deck* sdk, u8 percent)
+{
+  i64        written;
+  Hid_Report report;
+
+  report      = sdk->hid->feature;
+  report.size = 3;
+  percent     = (percent >= 100) ? 100 : percent;
+  report.buf[0] = 0x03;
+  report.buf[1] = 0x08;
+  report.buf[2] = percent;
+  written     = hid_send_report(sdk->hid, report, HID_SEND_FEATURE);
+  if (written == -1) printf("sdk_set_brightness failed\n");
+  return written;
+}
+
+/*
+ * NOTE:
+ *      Builds the `page`th image report for `key` into `buffer`
+ *      (img_rpt_len bytes) and returns how many image bytes it carries.
+ */
+#pragma warning(disable : 4333)
+static u32
+sdk_image_report_fill(Stream_Deck *sdk, u8 *buffer, u8 key, u8 *image, u32 image_size, u32 page)
+{
+  u32 to_copy, track_copy, left, header_len, payload_len;
+
+  header_len  = sdk->img_rpt_header_len;
+  payload_len = sdk->img_rpt_payload_len;
+  track_copy  = page * payload_len;
+  left        = image_size - track_copy;
+  to_copy     = (left >= payload_len) ? payload_len : left;
+  memset(buffer, 0, sdk->img_rpt_len);
+  buffer[0]  = 0x02; /* NOTE: Report ID */
+  buffer[1]  = 0x07; /* NOTE: Command ID */
+  buffer[2]  = key;
+  buffer[3]  = (to_copy == left);
+  buffer[4]  = (u8)(to_copy & 0xff);
+  buffer[5]  = (u8)(to_copy >> header_len);
+  buffer[6]  = (u8)(page & 0xFF);
+  buffer[7]  = (u8)(page >> header_len);
+  memcpy(buffer + header_len, image + track_copy, to_copy);
+  return to_copy;
+}
+#pragma warning(default : 4333)
+
+/* NOTE: It seems we need to rotate 90 degrees the image */
+#pragma warning(disable : 4701)
+static i64
+sdk_set_key_image(Stream_Deck* sdk, u8 key, u8 *image, u32 image_size)
+{
+  i64        written;
+  u32        left, loops;
+  Hid_Report report;
+
+  report = sdk->hid->output;
+  if (key >= sdk->total)
+  {
+    written = -2;
+    goto _failure;
+  }
+  left  = image_size;
+  loops = 0;
+  while (left > 0)
+  {
+    left   -= sdk_image_report_fill(sdk, report.buf, key, image, image_size, loops);
+    written = hid_write(sdk->hid, report);
+    loops++;
+    if (written == -1) goto _failure;
+  }
+_failure:
+  switch (written)
+  {
+    case -1: printf("sdk_set_key_image failed\n"); break;
+    case -2: printf("Invalid key\n"); break;
+    default: break;
+  }
+  return written;
+}
+#pragma warning(default : 4701)
+
+/*
+ * TODO:
+ *       [X]: Images are smaller whenever key is pressed (sdk_bind_key_image)
+ *       [X]: This should be done on a separate thread
+ *       [X]: Resize images to fit streamdeck's expected output (sdk_fit_key_image)
+ *       [X]: Rotate the images
+ *       [X]: PNG's, large JPEG's (sdk_decode.c)
+ *       [_]: GIF's
+ */
+static u8*
+sdk_encode_key_file(Stream_Deck *sdk, char *path, u32 *size, u32 level);
+static bool
+sdk_key_image_ready(Stream_Deck *sdk, u8 *image, u32 image_size);
+
+/* NOTE: A JPEG of the key size goes as it is, anything else is decoded and encoded again. */
+static i64
+sdk_set_key_image_path(Stream_Deck* sdk, u8 key, char* path)
+{
+  u8    *image;
+  i64   written;
+  u32   size;
+  File  file;
+
+  if ( file_exist_open_map_ro(path, &file) != CM_OK )
+  {
+    written = -1;
+    report_error_box("file_exist_open_map_ro"); goto _end;
+  }
+  image   = file.buffer.view;
+  size    = (u32) file.buffer.size;
+  if (sdk_key_image_ready(sdk, image, size))
+  {
+    written = sdk_set_key_image(sdk, key, image, size);
+    file_close(&file);
+    goto _end;
+  }
+  file_close(&file);
+  image = sdk_encode_key_file(sdk, path, &size, 0);
+  if (!image) { written = -1; printf("[%s] %s: not a key image\n", sdk->serial, path); goto _end; }
+  written = sdk_set_key_image(sdk, key, image, size);
+  heap_free_dz(image);
+_end:
+  return written;
+}
+
+static i64
+sdk_reset_key_stream(Stream_Deck* sdk)
+{
+  Hid_Report  report;
+
+  report = sdk->hid->output;
+  memset(report.buf, 0, report.size);
+  report.buf[0] = 0x02;
+  return hid_write(sdk->hid, report);
+}
+
+static i64
+sdk_reset(Stream_Deck *sdk)
+{
+  Hid_Report  report;
+
+  report        = sdk->hid->feature;
+  report.size   = 2;
+  report.buf[0] = 0x03;
+  report.buf[1] = 0x02;
+  return hid_send_report(sdk->hid, report, HID_SEND_FEATURE);
+}
+
+/* NOTE: Any thread, see Sdk_Key_State. */
+static inline void
+sdk_get_key_states(Stream_Deck *sdk, Sdk_Key_Snapshot *snapshot)
+{
+  sdk_key_state_read(&sdk->keys, snapshot);
+}
+
+static void
+print_pressed(Stream_Deck *sdk)
+{
+  u32              i;
+  Sdk_Key_Snapshot snapshot;
+
+  sdk_get_key_states(sdk, &snapshot);
+  for (i = 0; i < snapshot.key_count; i++)
+  {
+    if (sdk_key_snapshot_down(&snapshot, i)) printf("[%s] Key %u is pressed\n", sdk->serial, i);
+  }
+}
+
+#define SDK_KEY_HEADER      27
+#define SDK_KEY_DATA        512
+#define SDK_KEY_INPUT_SIZE  ((SDK_KEY_HEADER + SDK_KEY_DATA))
+
+/*
+ * NOTE:
+ *      Decodes an input report sitting in the deck's own input buffer
+ *      (hid->input, sized from the HID caps at open time) and appends the
+ *      key transitions to the current input batch.
+ */
+static void
+sdk_keys_update(Stream_Deck *sdk, Sdk_Gesture_Table *table, u64 *new_keystates, u64 time);
+
+static void
+sdk_parse_input(Stream_Deck* sdk, u8 *buf, u32 size, u64 time)
+{
+  u32               max, i, j;
+  u64               new_keystates[SDK_KEY_WORDS] = {0};
+  Sdk_Gesture_Table *table;
+
+  /* NOTE: Skip the header and get the key states. */
+  max = 4 + atomic_load_explicit(&sdk->keys.key_count, memory_order_relaxed);
+  if (max > size) max = size;
+  for (i = 4, j = 0; i < max ; i++, j++)
+  {
+    if (buf[i]) new_keystates[j / 64] |= 1ull << (j % 64);
+  }
+  table = atomic_load_explicit(&sdk->gesture_table, memory_order_acquire);
+  if (table)
+  {
+    sdk_gesture_debounce(table, &sdk->gestures, sdk->keys.current, new_keystates, time,
+                         atomic_load_explicit(&sdk->timers, memory_order_acquire));
+  }
+  sdk_keys_update(sdk, table, new_keystates, time);
+}
+
+/* NOTE: Thread servicing the deck. Appends the key transitions to `new_keystates` to the batch and publishes them. */
+static void
+sdk_keys_update(Stream_Deck *sdk, Sdk_Gesture_Table *table, u64 *new_keystates, u64 time)
+{
+  u32 i, first;
+
+  first = sdk->input.count;
+  for (i = 0; i < SDK_KEY_WORDS; i++)
+  {
+    sdk->feedback.pending[i] |= (sdk->keys.current[i] ^ new_keystates[i])
+                              & atomic_load_explicit(&sdk->feedback.bound[i], memory_order_relaxed);
+  }
+  if (sdk_input_diff(&sdk->input, sdk->keys.current, new_keystates, SDK_KEY_WORDS, time))
+  {
+    sdk_key_state_publish(&sdk->keys, new_keystates, time);
+    if (table)
+    {
+      sdk_gesture_feed(table, &sdk->gestures, &sdk->input.events[first], sdk->input.count - first, new_keystates,
+                       atomic_load_explicit(&sdk->timers, memory_order_acquire));
+    }
+  }
+}
+
+static void sdk_pages_key_down(Stream_Deck *sdk, Sdk_Actions *actions, u8 key, u64 time);
+
+/* NOTE: Thread servicing the deck, the gestures recognized since the last call. */
+static void
+sdk_gesture_dispatch(Stream_Deck *sdk, Sdk_Actions *actions)
+{
+  u32               i;
+  Sdk_Gesture_Event *gesture;
+
+  for (i = 0; i < sdk->gestures.count; i++)
+  {
+    gesture = &sdk->gestures.events[i];
+    printf("[%s] Gesture %u (key %u)\n", sdk->serial, gesture->id, gesture->key);
+    if (actions && gesture->id < SDK_ACTION_GESTURES)
+    {
+      sdk_action_trigger(actions, atomic_load_explicit(&actions->on_gesture[gesture->id], memory_order_acquire), gesture->key, gesture->time);
+    }
+  }
+  sdk->gestures.count = 0;
+}
+
+/* NOTE: Runs once per drained batch on the thread servicing the deck. */
+static void
+sdk_input_dispatch(Stream_Deck *sdk)
+{
+  u32               i;
+  Sdk_Key_Event     *event;
+  Sdk_Actions       *actions;
+  Sdk_Key_Sink      *sink;
+
+  actions = atomic_load_explicit(&sdk->actions, memory_order_acquire);
+  sink    = atomic_load_explicit(&sdk->key_sink, memory_order_acquire);
+  if (sink && sdk->input.count) sink->proc(sdk, sdk->input.events, sdk->input.count, sink->user);
+  for (i = 0; i < sdk->input.count; i++)
+  {
+    event = &sdk->input.events[i];
+    if (!event->down) printf("[%s] Key %u is released\n", sdk->serial, event->key);
+    else if (sdk->pages) sdk_pages_key_down(sdk, actions, event->key, event->time);
+    else if (actions)
+    {
+      sdk_action_trigger(actions, atomic_load_explicit(&actions->on_key[event->key], memory_order_acquire), event->key, event->time);
+    }
+  }
+  if (sdk->input.count) print_pressed(sdk);
+  sdk_gesture_dispatch(sdk, actions);
+}
+
+/*
+ * NOTE:
+ *      Service thread, a HOLD timer of `timer->user` fired: the key went
+ *      down hold_ms ago and did not come up since (that stops it). Runs
+ *      outside of any read batch, the gesture goes out on its own.
+ */
+static void
+sdk_hold_fired(Sdk_Timers *timers, Sdk_Timer *timer, u64 now)
+{
+  Stream_Deck       *sdk;
+  Sdk_Gesture_Table *table;
+
+  (void) timers;
+  (void) now;
+  sdk   = timer->user;
+  table = atomic_load_explicit(&sdk->gesture_table, memory_order_acquire);
+  if (!table || !atomic_load(&sdk->connected)) return;
+  sdk_gesture_held(table, &sdk->gestures, (u8) timer->id, sdk_now());
+  sdk_gesture_dispatch(sdk, atomic_load_explicit(&sdk->actions, memory_order_acquire));
+}
+
+/*
+ * NOTE:
+ *      Service thread, the settle timer of a key fired: an edge of it was
+ *      ignored by the debounce and its window is over. When the last report
+ *      still disagrees with the published state, the key catches up now as
+ *      a batch of its own.
+ */
+static void
+sdk_settle_fired(Sdk_Timers *timers, Sdk_Timer *timer, u64 now)
+{
+  u32               key;
+  u64               time, bits[SDK_KEY_WORDS];
+  Stream_Deck       *sdk;
+  Sdk_Key_Snapshot  snapshot;
+  Sdk_Gesture_Table *table;
+
+  (void) timers;
+  (void) now;
+  sdk   = timer->user;
+  key   = timer->id;
+  table = atomic_load_explicit(&sdk->gesture_table, memory_order_acquire);
+  if (!atomic_load(&sdk->connected)) return;
+  sdk_get_key_states(sdk, &snapshot);
+  if (key >= snapshot.key_count || !(((snapshot.bits[key / 64] ^ sdk->gestures.raw[key / 64]) >> (key % 64)) & 1)) return;
+  memcpy(bits, snapshot.bits, sizeof(bits));
+  bits[key / 64] ^= 1ull << (key % 64);
+  time = sdk_now();
+  sdk->gestures.last_edge[key] = time;
+  sdk_input_batch_begin(&sdk->input);
+  sdk_keys_update(sdk, table, bits, time);
+  sdk_input_dispatch(sdk);
+  /* NOTE: Press feedback of the key goes out with the write pump this wakes */
+  sdk_notify(sdk);
+}
+
+static bool sdk_features_push(Stream_Deck *sdk, Sdk_Feature_Op *op);
+
+/*
+ * NOTE:
+ *      Driver side input ring depth, kept across reconnects. Safe from any
+ *      thread: a connected deck gets it from its service thread, which is
+ *      the one that may close the device (sdk_feature_pump).
+ */
+static bool
+sdk_set_input_depth(Stream_Deck *sdk, u32 depth)
+{
+  Sdk_Feature_Op op;
+
+  sdk->input.depth = sdk_input_clamp_depth(depth);
+  if (!atomic_load(&sdk->connected)) return true;
+  memset(&op, 0, sizeof(Sdk_Feature_Op));
+  op.op = SDK_OP_INPUT_DEPTH;
+  return sdk_features_push(sdk, &op);
+}
+
+/*
+ * NOTE:
+ *      Blocking read for callers driving the deck themselves. Decks owned by
+ *      the manager are read from its event loop instead.
+ */
+static i64
+sdk_read_input(Stream_Deck* sdk)
+{
+  i64 read;
+
+  read = hid_read(sdk->hid, sdk->hid->input);
+  if (read == -1) console_debug("sdk_read_input failed")
+  else if (read != -2)
+  {
+    sdk_input_batch_begin(&sdk->input);
+    sdk_parse_input(sdk, sdk->hid->input.buf, (u32) read, sdk_now());
+    sdk_input_batch_end(&sdk->input);
+    sdk_input_dispatch(sdk);
+  }
+  return read;
+}
+
+/* -- Write queue ------------------------------------------------------------------- */
+
+static void
+sdk_queue_open(Sdk_Write_Queue *queue)
+{
+  memset(queue, 0, sizeof(Sdk_Write_Queue));
+  InitializeSRWLock(&queue->lock);
+}
+
+struct SdkFrame;
+static void
+sdk_frame_put(struct SdkFrame *frame, bool sent);
+
+/* NOTE: No lock held, a frame completed by its last job calls back. */
+static inline void
+sdk_job_release(Sdk_Write_Job *job)
+{
+  struct SdkFrame *frame;
+
+  frame = job->frame;
+  if (job->mapped) file_close(&job->file);
+  sdk_packed_release(job->packed);
+  memset(job, 0, sizeof(Sdk_Write_Job));
+  if (frame) sdk_frame_put(frame, false);
+}
+
+static void
+sdk_page_timing_done(Stream_Deck *sdk, u64 stamp);
+
+/* NOTE: No lock held. A job that will never go through (replaced, failed, dropped) still counts for its page switch. */
+static inline void
+sdk_job_drop(Stream_Deck *sdk, Sdk_Write_Job *job)
+{
+  if (job->stamp) sdk_page_timing_done(sdk, job->stamp);
+  sdk_job_release(job);
+}
+
+static void
+sdk_queue_close(Sdk_Write_Queue *queue)
+{
+  u32 i;
+
+  for (i = 0; i < queue->count; i++)
+  {
+    sdk_job_release(&queue->jobs[(queue->head + i) % SDK_WRITE_QUEUE_LEN]);
+  }
+  if (queue->busy) sdk_job_release(&queue->current);
+  memset(queue, 0, sizeof(Sdk_Write_Queue));
+}
+
+static bool
+sdk_queue_push(Stream_Deck *sdk, Sdk_Write_Job *job)
+{
+  u32             i;
+  bool            pushed;
+  Sdk_Write_Job   *slot, replaced;
+  Sdk_Write_Queue *queue;
+
+  queue  = &sdk->queue;
+  pushed = false;
+  memset(&replaced, 0, sizeof(Sdk_Write_Job));
+  AcquireSRWLockExclusive(&queue->lock);
+  for (i = 0; i < queue->count; i++)
+  {
+    slot = &queue->jobs[(queue->head + i) % SDK_WRITE_QUEUE_LEN];
+    if (slot->key == job->key && !(slot->sequence && slot->sequence == job->sequence))
+    {
+      replaced = *slot;
+      *slot    = *job;
+      pushed   = true;
+      break;
+    }
+  }
+  if (!pushed && queue->count < SDK_WRITE_QUEUE_LEN)
+  {
+    queue->jobs[(queue->head + queue->count) % SDK_WRITE_QUEUE_LEN] = *job;
+    queue->count++;
+    pushed = true;
+  }
+  ReleaseSRWLockExclusive(&queue->lock);
+  /* NOTE: Outside the lock, its frame may complete and queue the next one */
+  sdk_job_drop(sdk, &replaced);
+  if (pushed) sdk_notify(sdk);
+  return pushed;
+}
+
+static bool
+sdk_queue_pop(Sdk_Write_Queue *queue, Sdk_Write_Job *job)
+{
+  bool popped;
+
+  popped = false;
+  AcquireSRWLockExclusive(&queue->lock);
+  if (queue->count)
+  {
+    *job = queue->jobs[queue->head];
+    memset(&queue->jobs[queue->head], 0, sizeof(Sdk_Write_Job));
+    queue->head = (queue->head + 1) % SDK_WRITE_QUEUE_LEN;
+    queue->count--;
+    popped = true;
+  }
+  ReleaseSRWLockExclusive(&queue->lock);
+  return popped;
+}
+
+/*
+ * NOTE:
+ *      Thread-safe, never touches the device. `image` must stay valid until
+ *      the upload is done (static icons, arenas...).
+ */
+static bool
+sdk_queue_key_image(Stream_Deck *sdk, u8 key, u8 *image, u32 image_size)
+{
+  Sdk_Write_Job job;
+
+  if (key >= sdk->total) { printf("Invalid key\n"); return false; }
+  memset(&job, 0, sizeof(Sdk_Write_Job));
+  job.key   = key;
+  job.image = image;
+  job.size  = image_size;
+  if (!sdk_queue_push(sdk, &job)) { printf("[%s] write queue full\n", sdk->serial); return false; }
+  return true;
+}
+
+static Sdk_Packed*
+sdk_pack_key_file(Stream_Deck *sdk, char *path, u32 level);
+static bool
+sdk_queue_packed(Stream_Deck *sdk, u8 key, Sdk_Packed *packed);
+
+/* NOTE: Thread-safe. Like sdk_set_key_image_path, a ready JPEG is uploaded straight from the mapping. */
+static bool
+sdk_queue_key_image_path(Stream_Deck *sdk, u8 key, char *path)
+{
+  bool          queued;
+  Sdk_Write_Job job;
+  Sdk_Packed    *packed;
+
+  if (key >= sdk->total) { printf("Invalid key\n"); return false; }
+  memset(&job, 0, sizeof(Sdk_Write_Job));
+  if ( file_exist_open_map_ro(path, &job.file) != CM_OK )
+  {
+    report_error_box("file_exist_open_map_ro");
+    return false;
+  }
+  if (!sdk_key_image_ready(sdk, job.file.buffer.view, (u32) job.file.buffer.size))
+  {
+    file_close(&job.file);
+    packed = sdk_pack_key_file(sdk, path, 0);
+    if (!packed) { printf("[%s] %s: not a key image\n", sdk->serial, path); return false; }
+    queued = sdk_queue_packed(sdk, key, packed);
+    sdk_packed_release(packed);
+    return queued;
+  }
+  job.key    = key;
+  job.mapped = true;
+  job.image  = job.file.buffer.view;
+  job.size   = (u32) job.file.buffer.size;
+  if (!sdk_queue_push(sdk, &job))
+  {
+    printf("[%s] write queue full\n", sdk->serial);
+    file_close(&job.file);
+    return false;
+  }
+  return true;
+}
+
+/* -- Packed images ----------------------------------------------------------------- */
+
+/*
+ * NOTE:
+ *      Any thread. Cuts `image` into output reports, the same ones
+ *      sdk_write_pump would build, the key index left to the pump. `hash` is
+ *      sdk_image_hash of `image` (0 computes it): an image already packed
+ *      for any key or deck is shared, not cut again.
+ */
+static Sdk_Packed*
+sdk_pack_key_image(Stream_Deck *sdk, u8 *image, u32 image_size, u64 hash)
+{
+  u32        page, count;
+  Sdk_Packed *packed;
+
+  if (!hash) hash = sdk_image_hash(image, image_size);
+  packed = sdk_packed_find(hash, sdk->img_rpt_len);
+  if (packed) return packed;
+  count  = (image_size + sdk->img_rpt_payload_len - 1) / sdk->img_rpt_payload_len;
+  packed = sdk_packed_alloc(sdk->img_rpt_len, count ? count : 1);
+  if (!packed) return NULL;
+  packed->hash       = hash;
+  packed->image_size = image_size;
+  for (page = 0; page < count; page++)
+  {
+    sdk_image_report_fill(sdk, packed->reports + (u64) page * packed->report_len, 0, image, image_size, page);
+  }
+  return sdk_packed_share(packed);
+}
+
+/* NOTE: Reports already cut for this model (asset compiler, tile cache), shared like sdk_pack_key_image. */
+static Sdk_Packed*
+sdk_pack_key_reports(Stream_Deck *sdk, u8 *reports, u32 size, u32 image_size, u64 hash)
+{
+  Sdk_Packed *packed;
+
+  if (!size || size % sdk->img_rpt_len) { printf("[%s] compiled key image does not fit this model\n", sdk->serial); return NULL; }
+  if (!hash) hash = sdk_image_hash(reports, size);
+  packed = sdk_packed_find(hash, sdk->img_rpt_len);
+  if (packed) return packed;
+  packed = sdk_packed_alloc(sdk->img_rpt_len, size / sdk->img_rpt_len);
+  if (!packed) return NULL;
+  packed->hash       = hash;
+  packed->image_size = image_size;
+  memcpy(packed->reports, reports, size);
+  return sdk_packed_share(packed);
+}
+
+/* NOTE: Thread-safe, takes its own reference on `packed`. */
+static bool
+sdk_queue_packed(Stream_Deck *sdk, u8 key, Sdk_Packed *packed)
+{
+  Sdk_Write_Job job;
+
+  memset(&job, 0, sizeof(Sdk_Write_Job));
+  job.key    = key;
+  job.size   = packed->image_size;
+  job.packed = sdk_packed_retain(packed);
+  if (!sdk_queue_push(sdk, &job))
+  {
+    printf("[%s] write queue full\n", sdk->serial);
+    sdk_packed_release(packed);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Thread-safe, sdk_queue_packed for animated content: `packed` was
+ *      encoded at link `level` (sdk_link_level) and its upload is timed.
+ */
+static bool
+sdk_queue_animated(Stream_Deck *sdk, u8 key, Sdk_Packed *packed, u32 level)
+{
+  Sdk_Write_Job job;
+
+  memset(&job, 0, sizeof(Sdk_Write_Job));
+  job.key      = key;
+  job.size     = packed->image_size;
+  job.packed   = sdk_packed_retain(packed);
+  job.animated = true;
+  job.level    = (u8) level;
+  job.queued   = sdk_now();
+  if (!sdk_queue_push(sdk, &job))
+  {
+    printf("[%s] write queue full\n", sdk->serial);
+    sdk_packed_release(packed);
+    return false;
+  }
+  return true;
+}
+
+/* -- Press feedback ----------------------------------------------------------------- */
+
+static void
+sdk_feedback_open(Sdk_Key_Feedback *feedback)
+{
+  memset(feedback, 0, sizeof(Sdk_Key_Feedback));
+  InitializeSRWLock(&feedback->lock);
+}
+
+static void
+sdk_feedback_close(Sdk_Key_Feedback *feedback)
+{
+  u32 i;
+
+  for (i = 0; i < SDK_KEYS_MAX; i++)
+  {
+    sdk_packed_release(feedback->normal[i]);
+    sdk_packed_release(feedback->pressed[i]);
+  }
+  memset(feedback, 0, sizeof(Sdk_Key_Feedback));
+}
+
+/* NOTE: `image` decoded and resized to the deck's key size, release `pixels` with image_free. */
+static inline bool
+sdk_key_pixels(Stream_Deck *sdk, u8 *image, u32 image_size, Image *pixels)
+{
+  return sdk_decode_image(image, image_size, sdk->pxl_w, sdk->pxl_h, pixels);
+}
+
+/* NOTE: A JPEG the device takes as it is: the key size, and no rotation on this model. */
+static bool
+sdk_key_image_ready(Stream_Deck *sdk, u8 *image, u32 image_size)
+{
+  u32 w, h;
+
+  if (sdk->key_rotation || sdk_image_kind(image, image_size) != SDK_IMAGE_JPEG) return false;
+  return jpeg_dimensions(image, image_size, &w, &h) && w == sdk->pxl_w && h == sdk->pxl_h;
+}
+
+/* NOTE: Rotated for the model and encoded at link `level` (0 = full quality), takes `sized`. */
+static u8*
+sdk_encode_key_pixels(Stream_Deck *sdk, Image *sized, u32 *size, u32 level)
+{
+  u8             *encoded;
+  Image          turned, small;
+  Sdk_Link_Level *quality;
+
+  encoded = NULL;
+  quality = &g_sdk_link_levels[level];
+  if (quality->scale < 100)
+  {
+    /* NOTE: Down and back up in place, the device only takes its key size */
+    if (!image_resize(sized, &small, sized->w * quality->scale / 100, sized->h * quality->scale / 100)) goto _end;
+    image_scale_into(&small, sized->pixels, sized->w * 3, sized->w, sized->h);
+    image_free(&small);
+  }
+  if (sdk->key_rotation)
+  {
+    if (!image_rotate(sized, &turned, sdk->key_rotation)) goto _end;
+    image_free(sized);
+    *sized = turned;
+  }
+  encoded = jpeg_encode(sized, quality->quality, size);
+_end:
+  image_free(sized);
+  return encoded;
+}
+
+/* NOTE: Any thread. The image file at `path` as a key image of this model, NULL when it is not an image. */
+static u8*
+sdk_encode_key_file(Stream_Deck *sdk, char *path, u32 *size, u32 level)
+{
+  Image sized;
+
+  if (!sdk_decode_file(path, sdk->pxl_w, sdk->pxl_h, &sized)) return NULL;
+  return sdk_encode_key_pixels(sdk, &sized, size, level);
+}
+
+/*
+ * NOTE:
+ *      Any thread. sdk_encode_key_file packed for key 0, a ready JPEG is
+ *      packed as it is at level 0 and encoded again at any other.
+ */
+static Sdk_Packed*
+sdk_pack_key_file(Stream_Deck *sdk, char *path, u32 level)
+{
+  u8         *encoded;
+  u32        encoded_size;
+  File       file;
+  Sdk_Packed *packed;
+
+  if (file_exist_open_map_ro(path, &file) != CM_OK) return NULL;
+  packed = NULL;
+  if (!level && sdk_key_image_ready(sdk, file.buffer.view, (u32) file.buffer.size))
+  {
+    packed = sdk_pack_key_image(sdk, file.buffer.view, (u32) file.buffer.size, 0);
+  }
+  file_close(&file);
+  if (packed) return packed;
+  encoded = sdk_encode_key_file(sdk, path, &encoded_size, level);
+  if (!encoded) return NULL;
+  packed = sdk_pack_key_image(sdk, encoded, encoded_size, 0);
+  heap_free_dz(encoded);
+  return packed;
+}
+
+/*
+ * NOTE:
+ *      Any thread. `image` (JPEG or PNG, any size) turned into a key image
+ *      of this model, resized and rotated, then packed for key 0. NULL when
+ *      it can be sent as it is, or cannot be decoded. The result goes in
+ *      the tile cache so an unchanged image is only worked on once, ever.
+ */
+static Sdk_Packed*
+sdk_fit_key_image(Stream_Deck *sdk, u8 *image, u32 image_size)
+{
+  u8              *encoded;
+  u32             encoded_size;
+  u64             tile;
+  Image           sized;
+  Sdk_Packed      *packed;
+  Sdk_Tile_Params params;
+
+  if (sdk_key_image_ready(sdk, image, image_size)) return NULL;
+  memset(&params, 0, sizeof(Sdk_Tile_Params));
+  params.source   = sdk_image_hash(image, image_size);
+  params.pid      = sdk->product_id;
+  params.pxl      = sdk->pxl_w;
+  params.op       = SDK_TILE_FIT;
+  params.rotation = sdk->key_rotation;
+  params.quality  = SDK_FIT_QUALITY;
+  tile   = sdk_tile_key(&params);
+  packed = sdk_tiles_find(&g_tiles, tile, sdk->img_rpt_len);
+  if (packed) return packed;
+
+  if (!sdk_key_pixels(sdk, image, image_size, &sized)) { printf("[%s] cannot decode image, sent as it is\n", sdk->serial); return NULL; }
+  encoded = sdk_encode_key_pixels(sdk, &sized, &encoded_size, 0);
+  if (!encoded) return NULL;
+  packed = sdk_pack_key_image(sdk, encoded, encoded_size, 0);
+  sdk_tiles_store(&g_tiles, tile, packed);
+  heap_free_dz(encoded);
+  return packed;
+}
+
+/*
+ * NOTE:
+ *      Thread-safe. The pressed variant of `image` (shrunk and darkened, then
+ *      encoded again), from the tile cache when this image was seen before.
+ *      With `rotate` the image is a source image (any size, JPEG or PNG) and
+ *      is rotated for the model as well. NULL on failure.
+ */
+static Sdk_Packed*
+sdk_pressed_key_image(Stream_Deck *sdk, u8 *image, u32 image_size, bool rotate)
+{
+  u8              *encoded;
+  u32             encoded_size;
+  u64             tile;
+  Image           sized, pressed, turned;
+  Sdk_Packed      *packed;
+  Sdk_Tile_Params params;
+
+  memset(&params, 0, sizeof(Sdk_Tile_Params));
+  params.source     = sdk_image_hash(image, image_size);
+  params.pid        = sdk->product_id;
+  params.pxl        = sdk->pxl_w;
+  params.op         = SDK_TILE_PRESSED;
+  params.rotation   = rotate ? sdk->key_rotation : 0;
+  params.quality    = SDK_PRESSED_QUALITY;
+  params.scale      = SDK_PRESSED_SCALE;
+  params.brightness = SDK_PRESSED_BRIGHTNESS;
+  tile   = sdk_tile_key(&params);
+  packed = sdk_tiles_find(&g_tiles, tile, sdk->img_rpt_len);
+  if (packed) return packed;
+
+  encoded = NULL;
+  memset(&sized,   0, sizeof(Image));
+  memset(&pressed, 0, sizeof(Image));
+  if (!sdk_key_pixels(sdk, image, image_size, &sized)) { printf("[%s] cannot decode image\n", sdk->serial); goto _end; }
+  if (!image_inset(&sized, &pressed, SDK_PRESSED_SCALE)) goto _end;
+  image_darken(&pressed, SDK_PRESSED_BRIGHTNESS);
+  if (params.rotation)
+  {
+    if (!image_rotate(&pressed, &turned, params.rotation)) goto _end;
+    image_free(&pressed);
+    pressed = turned;
+  }
+  encoded = jpeg_encode(&pressed, SDK_PRESSED_QUALITY, &encoded_size);
+  if (!encoded) goto _end;
+  packed = sdk_pack_key_image(sdk, encoded, encoded_size, 0);
+  if (packed) sdk_tiles_store(&g_tiles, tile, packed);
+
+_end:
+  if (encoded) heap_free_dz(encoded);
+  image_free(&sized);
+  image_free(&pressed);
+  return packed;
+}
+
+/*
+ * NOTE:
+ *      Thread-safe. Press feedback of `key`: `normal` while it is up,
+ *      `pressed` while it is down, each retained. A NULL `pressed` unbinds
+ *      the key. Nothing is uploaded, the key shows what it showed until its
+ *      state changes.
+ */
+static void
+sdk_feedback_bind(Stream_Deck *sdk, u8 key, Sdk_Packed *normal, Sdk_Packed *pressed)
+{
+  Sdk_Packed *old_normal, *old_pressed;
+
+  if (!pressed) normal = NULL;
+  AcquireSRWLockExclusive(&sdk->feedback.lock);
+  old_normal  = sdk->feedback.normal[key];
+  old_pressed = sdk->feedback.pressed[key];
+  sdk->feedback.normal[key]  = sdk_packed_retain(normal);
+  sdk->feedback.pressed[key] = sdk_packed_retain(pressed);
+  if (pressed) atomic_fetch_or(&sdk->feedback.bound[key / 64], 1ull << (key % 64));
+  else         atomic_fetch_and(&sdk->feedback.bound[key / 64], ~(1ull << (key % 64)));
+  ReleaseSRWLockExclusive(&sdk->feedback.lock);
+  sdk_packed_release(old_normal);
+  sdk_packed_release(old_pressed);
+}
+
+/*
+ * NOTE:
+ *      Thread-safe. Binds `image` (JPEG, the deck's key size) to `key` and
+ *      uploads it. With `press_feedback` a pressed variant is made from it
+ *      right away (sdk_pressed_key_image) so nothing is decoded or encoded
+ *      once the key is actually pressed. `image` is copied, it does not need
+ *      to outlive the call. Profile keys get theirs from the page shown
+ *      instead, see sdk_pages_switch.
+ */
+static bool
+sdk_bind_key_image(Stream_Deck *sdk, u8 key, u8 *image, u32 image_size, bool press_feedback)
+{
+  bool       ok;
+  Sdk_Packed *normal_packed, *pressed_packed;
+
+  if (key >= sdk->total) { printf("Invalid key\n"); return false; }
+  pressed_packed = NULL;
+  normal_packed  = sdk_pack_key_image(sdk, image, image_size, 0);
+  if (!normal_packed) return false;
+  if (press_feedback)
+  {
+    pressed_packed = sdk_pressed_key_image(sdk, image, image_size, false);
+    if (!pressed_packed) { printf("[%s] key %u: no pressed variant\n", sdk->serial, key); sdk_packed_release(normal_packed); return false; }
+  }
+  sdk_feedback_bind(sdk, key, normal_packed, pressed_packed);
+  ok = sdk_queue_packed(sdk, key, normal_packed);
+  sdk_packed_release(normal_packed);
+  sdk_packed_release(pressed_packed);
+  return ok;
+}
+
+static inline bool
+sdk_feedback_pending(Stream_Deck *sdk)
+{
+  u32 w;
+  u64 any;
+
+  for (w = 0, any = 0; w < SDK_KEY_WORDS; w++) any |= sdk->feedback.pending[w];
+  return any != 0;
+}
+
+/*
+ * NOTE:
+ *      Service thread. Takes the lowest pending key and turns the variant
+ *      matching its current state into a job. False when nothing is pending.
+ */
+static bool
+sdk_feedback_next(Stream_Deck *sdk, Sdk_Write_Job *job)
+{
+  u32           w, key;
+  bool          down;
+  unsigned long low;
+  Sdk_Packed    *packed;
+
+  for (w = 0; w < SDK_KEY_WORDS; w++)
+  {
+    while (sdk->feedback.pending[w])
+    {
+      _BitScanForward64(&low, sdk->feedback.pending[w]);
+      sdk->feedback.pending[w] &= sdk->feedback.pending[w] - 1;
+      key  = w * 64 + low;
+      down = (sdk->keys.current[w] >> low) & 1;
+      AcquireSRWLockShared(&sdk->feedback.lock);
+      packed = sdk_packed_retain(down ? sdk->feedback.pressed[key] : sdk->feedback.normal[key]);
+      ReleaseSRWLockShared(&sdk->feedback.lock);
+      if (!packed) continue;
+      memset(job, 0, sizeof(Sdk_Write_Job));
+      job->key    = (u8) key;
+      job->size   = packed->image_size;
+      job->packed = packed;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* NOTE: Any thread, a job of a page switch went through or was dropped. */
+static void
+sdk_page_timing_done(Stream_Deck *sdk, u64 stamp)
+{
+  u64             us;
+  Sdk_Page_Timing *timing;
+
+  timing = &sdk->page_timing;
+  if (stamp != atomic_load(&timing->start)) return;
+  if (atomic_fetch_sub(&timing->left, 1) != 1) return;
+  us = sdk_ticks_to_us(sdk_now() - stamp);
+  if (!sdk->startup.full_page)
+  {
+    sdk->startup.full_page = sdk_now();
+    printf("[%s] first page drawn %llu ms after launch\n", sdk->serial, sdk_ticks_to_us(sdk->startup.full_page - sdk->startup.launch) / 1000);
+  }
+  timing->switches++;
+  timing->total_us += us;
+  timing->last_us   = us;
+  if (us > timing->max_us) timing->max_us = us;
+}
+
+/* -- Link quality ------------------------------------------------------------------- */
+
+/* NOTE: Any thread. Level animated content is encoded at right now, see Sdk_Link. */
+static inline u32
+sdk_link_level(Stream_Deck *sdk)
+{
+  return atomic_load_explicit(&sdk->link.level, memory_order_relaxed);
+}
+
+/* NOTE: Service thread. */
+static void
+sdk_link_step(Stream_Deck *sdk, u32 level)
+{
+  Sdk_Link_Level *quality;
+
+  quality = &g_sdk_link_levels[level];
+  if (level > sdk_link_level(sdk)) sdk->link.downs++;
+  else                             sdk->link.ups++;
+  atomic_store_explicit(&sdk->link.level, level, memory_order_relaxed);
+  sdk->link.window = 0;
+  printf("[%s] animated content at quality %u, %u%% size (frames %llu us, reports %llu us)\n", sdk->serial,
+         quality->quality, quality->scale, sdk->link.frame_us, sdk->link.report_us);
+}
+
+/*
+ * NOTE:
+ *      Service thread, Sdk_Timer_Proc of `restore`: the queue went idle a
+ *      while ago. Only steps up once it stayed idle the whole window, a job
+ *      since pushes the window to the end of that job.
+ */
+static void
+sdk_link_restore(Sdk_Timers *timers, Sdk_Timer *timer, u64 now)
+{
+  u32         level;
+  u64         idle_ms;
+  Stream_Deck *sdk;
+
+  (void) now;
+  sdk   = timer->user;
+  level = sdk_link_level(sdk);
+  if (!level || !atomic_load(&sdk->connected)) return;
+  if (sdk->queue.busy) { sdk_timer_start(timers, timer, SDK_LINK_RESTORE_MS, 0, SDK_LINK_SLACK_MS); return; }
+  idle_ms = sdk_ticks_to_us(sdk_now() - sdk->link.busy_end) / 1000;
+  if (idle_ms < SDK_LINK_RESTORE_MS)
+  {
+    sdk_timer_start(timers, timer, (u32)(SDK_LINK_RESTORE_MS - idle_ms), 0, SDK_LINK_SLACK_MS);
+    return;
+  }
+  sdk_link_step(sdk, level - 1);
+  if (level > 1) sdk_timer_start(timers, timer, SDK_LINK_RESTORE_MS, 0, SDK_LINK_SLACK_MS);
+}
+
+/* NOTE: Once per deck, before its service runs. */
+static inline void
+sdk_link_open(Stream_Deck *sdk)
+{
+  sdk_timer_init(&sdk->link.restore, sdk_link_restore, sdk, 0);
+}
+
+/* NOTE: Service thread. A new connection may be on another bus, measures start over. */
+static void
+sdk_link_reset(Stream_Deck *sdk)
+{
+  Sdk_Timers *timers;
+
+  timers = atomic_load(&sdk->timers);
+  if (timers) sdk_timer_stop(timers, &sdk->link.restore);
+  atomic_store(&sdk->link.level, 0);
+  sdk->link.report_us = 0;
+  sdk->link.frame_us  = 0;
+  sdk->link.window    = 0;
+}
+
+/* NOTE: Service thread, the report started at `report_start` went through. */
+static inline void
+sdk_link_sent(Stream_Deck *sdk)
+{
+  u64 us;
+
+  us = sdk_ticks_to_us(sdk_now() - sdk->link.report_start);
+  sdk->link.report_us = sdk->link.reports ? sdk->link.report_us - sdk->link.report_us / 8 + us / 8 : us;
+  sdk->link.reports++;
+  sdk->link.bytes   += sdk->img_rpt_len;
+  sdk->link.busy_us += us;
+}
+
+/* NOTE: Service thread, the last report of an animated job went through. */
+static void
+sdk_link_frame(Stream_Deck *sdk, Sdk_Write_Job *job)
+{
+  u32 level;
+  u64 us;
+
+  level = sdk_link_level(sdk);
+  us    = sdk_ticks_to_us(sdk_now() - job->queued);
+  sdk->link.frames++;
+  if (us > SDK_LINK_TARGET_US) sdk->link.late++;
+  /* NOTE: Encoded before the last step, it says nothing about this level */
+  if (job->level != level) return;
+  sdk->link.frame_us = sdk->link.window ? sdk->link.frame_us - sdk->link.frame_us / 8 + us / 8 : us;
+  sdk->link.window++;
+  if (sdk->link.frame_us <= SDK_LINK_TARGET_US || sdk->link.window < SDK_LINK_SAMPLES) return;
+  if (level + 1 < countof(g_sdk_link_levels)) sdk_link_step(sdk, level + 1);
+}
+
+/* NOTE: Service thread, nothing left to send. */
+static inline void
+sdk_link_idle(Stream_Deck *sdk)
+{
+  Sdk_Timers *timers;
+
+  timers = atomic_load(&sdk->timers);
+  if (!timers || !sdk_link_level(sdk) || sdk_timer_pending(&sdk->link.restore)) return;
+  sdk_timer_start(timers, &sdk->link.restore, SDK_LINK_RESTORE_MS, 0, SDK_LINK_SLACK_MS);
+}
+
+static void
+sdk_link_report(Stream_Deck *sdk)
+{
+  Sdk_Link *link;
+
+  link = &sdk->link;
+  printf("[%s] link: %llu reports, %llu KB/s while busy, report avg %llu us; %llu animated frames, %llu late, "
+         "level %u (%llu down, %llu up)\n", sdk->serial, link->reports,
+         link->busy_us ? link->bytes * 1000000 / link->busy_us >> 10 : 0, link->report_us,
+         link->frames, link->late, sdk_link_level(sdk), link->downs, link->ups);
+}
+
+/*
+ * NOTE:
+ *      Advances the upload in flight without ever blocking: reports are built
+ *      in the deck's output buffer (or copied there from a packed image and
+ *      given the key index) and written overlapped, the caller comes back
+ *      once write_ol.hEvent fires.
+ *      Pending press feedback always goes before the write queue.
+ *      Returns HID_IO_PENDING while the bus is busy, HID_IO_DONE when there
+ *      is nothing left to send.
+ */
+static i32
+sdk_write_pump(Stream_Deck *sdk, bool completed)
+{
+  u32             written;
+  i32             status;
+  bool            finished;
+  Sdk_Packed      *packed;
+  Sdk_Write_Queue *queue;
+  Hid_Report      report;
+  struct SdkFrame *frame;
+
+  queue = &sdk->queue;
+  cm_stack_mark(&report);
+  if (completed && queue->busy)
+  {
+    status = hid_write_finish(sdk->hid, &written);
+    if (status == HID_IO_PENDING) return status;
+    if (status != HID_IO_DONE) goto _failure;
+    if (!sdk->startup.first_report) sdk->startup.first_report = sdk_now();
+    sdk_link_sent(sdk);
+    queue->page++;
+  }
+  else if (queue->busy) return HID_IO_PENDING;
+
+  for (;;)
+  {
+    if (queue->busy)
+    {
+      packed   = queue->current.packed;
+      finished = packed ? queue->page >= packed->report_count : queue->sent >= queue->current.size;
+      if (finished)
+      {
+        if (queue->current.stamp)    sdk_page_timing_done(sdk, queue->current.stamp);
+        if (queue->current.animated) sdk_link_frame(sdk, &queue->current);
+        sdk->link.busy_end = sdk_now();
+        frame = queue->current.frame;
+        queue->current.frame = NULL;
+        sdk_job_release(&queue->current);
+        queue->busy = false;
+        if (frame) sdk_frame_put(frame, true);
+      }
+    }
+    if (!queue->busy)
+    {
+      if (!sdk_feedback_next(sdk, &queue->current) && !sdk_queue_pop(queue, &queue->current))
+      {
+        sdk_link_idle(sdk);
+        return HID_IO_DONE;
+      }
+      queue->busy = true;
+      queue->page = 0;
+      queue->sent = 0;
+    }
+    packed = queue->current.packed;
+    /* NOTE: Shared by every key showing it, the key index only goes into the copy on the wire */
+    if (packed)
+    {
+      report = sdk->hid->output;
+      if (packed->report_len < report.size) memset(report.buf + packed->report_len, 0, report.size - packed->report_len);
+      memcpy(report.buf, packed->reports + (u64) queue->page * packed->report_len,
+             packed->report_len < report.size ? packed->report_len : report.size);
+      report.buf[2] = queue->current.key;
+    }
+    else
+    {
+      report = sdk->hid->output;
+      queue->sent += sdk_image_report_fill(sdk, report.buf, queue->current.key,
+                                           queue->current.image, queue->current.size, queue->page);
+    }
+    sdk->link.report_start = sdk_now();
+    status = hid_write_start(sdk->hid, report, &written);
+    if (status == HID_IO_PENDING) return status;
+    if (status != HID_IO_DONE) goto _failure;
+    if (!sdk->startup.first_report) sdk->startup.first_report = sdk_now();
+    sdk_link_sent(sdk);
+    queue->page++;
+  }
+_failure:
+  printf("[%s] upload of key %u failed\n", sdk->serial, queue->current.key);
+  sdk_job_drop(sdk, &queue->current);
+  queue->busy = false;
+  return status;
+}
+
+/* -- Feature reports ---------------------------------------------------------------- */
+
+static inline i32
+sdk_cache_slot(u8 report_id)
+{
+  switch (report_id)
+  {
+    case SDK_FEATURE_FIRMWARE: return SDK_CACHE_FIRMWARE;
+    case SDK_FEATURE_SERIAL:   return SDK_CACHE_SERIAL;
+    default:                   return -1;
+  }
+}
+
+static void
+sdk_features_open(Sdk_Feature_Queue *features)
+{
+  memset(features, 0, sizeof(Sdk_Feature_Queue));
+  InitializeSRWLock(&features->lock);
+}
+
+/*
+ * NOTE:
+ *      A brightness change replaces the one still queued unless someone
+ *      waits on that one (a DIM frame, see sdk_frame.c), a get without
+ *      callback for a report id already queued is dropped: the first one
+ *      fills the cache anyway. So is an input depth change while one is
+ *      queued, it applies whatever depth is set by the time it runs.
+ */
+static bool
+sdk_features_push(Stream_Deck *sdk, Sdk_Feature_Op *op)
+{
+  u32               i;
+  bool              pushed;
+  Sdk_Feature_Op    *slot;
+  Sdk_Feature_Queue *features;
+
+  features = &sdk->features;
+  pushed   = false;
+  AcquireSRWLockExclusive(&features->lock);
+  for (i = 0; i < features->count; i++)
+  {
+    slot = &features->ops[(features->head + i) % SDK_FEATURE_QUEUE_LEN];
+    if (slot->op != op->op || op->op == SDK_OP_RESET) continue;
+    if (op->op == SDK_OP_GET_REPORT && slot->value != op->value) continue;
+    if (op->op == SDK_OP_SET_BRIGHTNESS)
+    {
+      if (slot->done) continue;
+      *slot = *op;
+    }
+    else if (op->done) continue;
+    pushed = true;
+    break;
+  }
+  if (!pushed && features->count < SDK_FEATURE_QUEUE_LEN)
+  {
+    features->ops[(features->head + features->count) % SDK_FEATURE_QUEUE_LEN] = *op;
+    features->count++;
+    pushed = true;
+  }
+  ReleaseSRWLockExclusive(&features->lock);
+  if (pushed) sdk_notify(sdk);
+  return pushed;
+}
+
+static bool
+sdk_features_pop(Sdk_Feature_Queue *features, Sdk_Feature_Op *op)
+{
+  bool popped;
+
+  popped = false;
+  AcquireSRWLockExclusive(&features->lock);
+  if (features->count)
+  {
+    *op = features->ops[features->head];
+    features->head = (features->head + 1) % SDK_FEATURE_QUEUE_LEN;
+    features->count--;
+    popped = true;
+  }
+  ReleaseSRWLockExclusive(&features->lock);
+  return popped;
+}
+
+/* NOTE: Non-blocking, `done` (optional) runs on the service thread. */
+static bool
+sdk_queue_brightness(Stream_Deck *sdk, u8 percent, Sdk_Feature_Done done, void *user)
+{
+  Sdk_Feature_Op op;
+
+  op.op    = SDK_OP_SET_BRIGHTNESS;
+  op.value = (percent >= 100) ? 100 : percent;
+  op.done  = done;
+  op.user  = user;
+  atomic_store(&sdk->brightness, op.value);
+  return sdk_features_push(sdk, &op);
+}
+
+static bool
+sdk_queue_reset(Stream_Deck *sdk, Sdk_Feature_Done done, void *user)
+{
+  Sdk_Feature_Op op;
+
+  op.op    = SDK_OP_RESET;
+  op.value = 0;
+  op.done  = done;
+  op.user  = user;
+  return sdk_features_push(sdk, &op);
+}
+
+static bool
+sdk_queue_get_report(Stream_Deck *sdk, u8 report_id, Sdk_Feature_Done done, void *user)
+{
+  Sdk_Feature_Op op;
+
+  op.op    = SDK_OP_GET_REPORT;
+  op.value = report_id;
+  op.done  = done;
+  op.user  = user;
+  return sdk_features_push(sdk, &op);
+}
+
+/*
+ * NOTE:
+ *      Returns the cached length of a static feature report and points `data`
+ *      at it. The device is only asked once per connection: while the report
+ *      is not cached yet this queues the read and returns -2, -1 for report
+ *      ids that are not cacheable.
+ */
+static i64
+sdk_get_report(Stream_Deck* sdk, u8 report_id, u8 **data)
+{
+  i32 slot;
+
+  slot = sdk_cache_slot(report_id);
+  if (slot < 0) return -1;
+  if (atomic_load_explicit(&sdk->cache.valid, memory_order_acquire) & (1u << slot))
+  {
+    *data = sdk->cache.data[slot];
+    return sdk->cache.len[slot];
+  }
+  sdk_queue_get_report(sdk, report_id, NULL, NULL);
+  return -2;
+}
+
+/* NOTE: ASCII, NULL until cached. Offsets from elgato's protocol. */
+static char*
+sdk_get_firmware_version(Stream_Deck *sdk)
+{
+  u8 *data;
+  return (sdk_get_report(sdk, SDK_FEATURE_FIRMWARE, &data) > 6) ? (char*) data + 6 : NULL;
+}
+
+static char*
+sdk_get_serial_number(Stream_Deck *sdk)
+{
+  u8 *data;
+  return (sdk_get_report(sdk, SDK_FEATURE_SERIAL, &data) > 2) ? (char*) data + 2 : NULL;
+}
+
+static inline void
+sdk_cache_clear(Stream_Deck *sdk)
+{
+  atomic_store(&sdk->cache.valid, 0);
+}
+
+static void
+sdk_feature_complete(Stream_Deck *sdk, i32 status, u32 total)
+{
+  i32               slot;
+  i64               result;
+  Sdk_Feature_Op    *op;
+  Sdk_Feature_Cache *cache;
+
+  op     = &sdk->features.current;
+  result = (status == HID_IO_DONE) ? (i64) total : -1;
+  if (status == HID_IO_DONE && op->op == SDK_OP_GET_REPORT)
+  {
+    slot  = sdk_cache_slot(op->value);
+    cache = &sdk->cache;
+    if (slot >= 0)
+    {
+      if (total > SDK_FEATURE_CACHE_LEN) total = SDK_FEATURE_CACHE_LEN;
+      memcpy(cache->data[slot], sdk->hid->feature.buf, total);
+      cache->data[slot][total] = 0;
+      cache->len[slot]         = total;
+      atomic_fetch_or_explicit(&cache->valid, 1u << slot, memory_order_release);
+    }
+  }
+  if (status != HID_IO_DONE) printf("[%s] feature op 0x%02x failed\n", sdk->serial, op->op);
+  if (op->done) op->done(sdk, op->op, op->value, result, op->user);
+  sdk->features.busy = false;
+}
+
+/*
+ * NOTE:
+ *      Same contract as sdk_write_pump, on the feature OVERLAPPED. A failing
+ *      request is reported to its callback, only a vanished device stops it.
+ */
+static i32
+sdk_feature_pump(Stream_Deck *sdk, bool completed)
+{
+  u32               total, ioctl;
+  i32               status;
+  Hid_Report        report;
+  Sdk_Feature_Queue *features;
+
+  features = &sdk->features;
+  if (completed && features->busy)
+  {
+    status = hid_feature_finish(sdk->hid, &total);
+    if (status == HID_IO_PENDING) return status;
+    sdk_feature_complete(sdk, status, total);
+    if (status == HID_IO_GONE) return status;
+  }
+  else if (features->busy) return HID_IO_PENDING;
+
+  report = sdk->hid->feature;
+  for (;;)
+  {
+    if (!sdk_features_pop(features, &features->current)) return HID_IO_DONE;
+    features->busy = true;
+    memset(report.buf, 0, report.size);
+    switch (features->current.op)
+    {
+      case SDK_OP_INPUT_DEPTH:
+        /* NOTE: Synchronous, the driver only resizes its ring */
+        status = HidD_SetNumInputBuffers(sdk->hid->h_dev, sdk->input.depth) ? HID_IO_DONE : HID_IO_ERROR;
+        if (status == HID_IO_ERROR) report_error("HidD_SetNumInputBuffers");
+        sdk_feature_complete(sdk, status, 0);
+        continue;
+      case SDK_OP_SET_BRIGHTNESS:
+        report.buf[0] = 0x03;
+        report.buf[1] = 0x08;
+        report.buf[2] = features->current.value;
+        ioctl         = IOCTL_HID_SET_FEATURE;
+        break;
+      case SDK_OP_RESET:
+        report.buf[0] = 0x03;
+        report.buf[1] = 0x02;
+        ioctl         = IOCTL_HID_SET_FEATURE;
+        break;
+      case SDK_OP_GET_REPORT:
+      default:
+        report.buf[0] = features->current.value;
+        ioctl         = IOCTL_HID_GET_FEATURE;
+        break;
+    }
+    status = hid_feature_start(sdk->hid, report, ioctl, &total);
+    if (status == HID_IO_PENDING) return status;
+    sdk_feature_complete(sdk, status, total);
+    if (status == HID_IO_GONE) return status;
+  }
+}
+
+#endif // SDK_DECK_C
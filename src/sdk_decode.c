@@ -0,0 +1,228 @@
+#ifndef SDK_DECODE_C
+#define SDK_DECODE_C
+
+/*
+ * NOTE:
+ *      Decoding layer between image files and the deck: the format is taken
+ *      from the signature (JPEG, PNG), never from the extension, and the
+ *      pixels come out at the size they are asked for. A JPEG larger than
+ *      that is decoded scaled down right in its DCT, a photo bound for a key
+ *      is never decoded at full size. Anything else is refused instead of
+ *      being sent to the device as it is.
+ *
+ *      Files decoded by path go through g_decoded, a small LRU keyed by
+ *      path, write time and size (and the size asked for): binding the same
+ *      icon on every page, profile and deck decodes it once. A file written
+ *      again is a miss and replaces its old entries.
+ */
+#define SDK_DECODE_ENTRIES  64
+#define SDK_DECODE_BUDGET   (32u << 20)      /* NOTE: Bytes of pixels kept */
+
+enum
+{
+  SDK_IMAGE_UNKNOWN = 0,
+  SDK_IMAGE_JPEG,
+  SDK_IMAGE_PNG,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkDecoded
+{
+  char  path[MAX_PATH];                      /* NOTE: Empty = free */
+  u64   write_time;
+  u32   size;
+  u64   used;                                /* NOTE: g_decoded.clock of the last hit */
+  Image image;
+} SdkDecoded, Sdk_Decoded;
+
+typedef struct SdkDecodeCache
+{
+  SRWLOCK     lock;
+  Sdk_Decoded entries[SDK_DECODE_ENTRIES];
+  u64         clock;
+  u64         bytes;
+  /* NOTE: Stats */
+  u64         hits, misses, evicted;
+} SdkDecodeCache, Sdk_Decode_Cache;
+#pragma warning(default : 4820)
+
+global Sdk_Decode_Cache g_decoded;           /* NOTE: Ready zeroed, SRWLOCK_INIT is 0 */
+
+/* NOTE: Last write time of `path`, 0 when it cannot be read. */
+static inline u64
+sdk_file_write_time(char *path, u32 *size)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data;
+
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) return 0;
+  *size = data.nFileSizeLow;
+  return ((u64) data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+}
+
+static inline u32
+sdk_image_kind(u8 *data, u32 size)
+{
+  if (size >= 4 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) return SDK_IMAGE_JPEG;
+  if (size >= 8 && !memcmp(data, "\x89PNG\r\n\x1a\n", 8))                 return SDK_IMAGE_PNG;
+  return SDK_IMAGE_UNKNOWN;
+}
+
+/*
+ * NOTE:
+ *      Any thread. `data` decoded to `w` x `h` RGB, release `image` with
+ *      image_free. With a `mask`, a PNG with transparency also gives its
+ *      alpha at the same size (see png_decode_alpha), `image` being
+ *      premultiplied by it; anything opaque leaves `mask` zeroed.
+ */
+static bool
+sdk_decode_image_alpha(u8 *data, u32 size, u32 w, u32 h, Image *image, Image *mask)
+{
+  Image decoded, alpha;
+
+  memset(image, 0, sizeof(Image));
+  memset(&alpha, 0, sizeof(Image));
+  if (mask) memset(mask, 0, sizeof(Image));
+  switch (sdk_image_kind(data, size))
+  {
+    case SDK_IMAGE_JPEG: if (!jpeg_decode_scaled(data, size, w, h, &decoded))                   return false; break;
+    case SDK_IMAGE_PNG:  if (!png_decode_alpha(data, size, &decoded, mask ? &alpha : NULL))     return false; break;
+    default: return false;
+  }
+  if (decoded.w == w && decoded.h == h) { *image = decoded; if (mask) *mask = alpha; return true; }
+  if (!image_resize(&decoded, image, w, h) || (alpha.pixels && !image_resize(&alpha, mask, w, h)))
+  {
+    image_free(image);
+    image_free(&decoded);
+    image_free(&alpha);
+    return false;
+  }
+  image_free(&decoded);
+  image_free(&alpha);
+  return true;
+}
+
+/* NOTE: Any thread. `data` decoded to `w` x `h` RGB, release `image` with image_free. */
+static bool
+sdk_decode_image(u8 *data, u32 size, u32 w, u32 h, Image *image)
+{
+  return sdk_decode_image_alpha(data, size, w, h, image, NULL);
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_decode_evict(Sdk_Decoded *entry)
+{
+  g_decoded.bytes -= (u64) entry->image.w * entry->image.h * 3;
+  g_decoded.evicted++;
+  image_free(&entry->image);
+  memset(entry, 0, sizeof(Sdk_Decoded));
+}
+
+/* NOTE: Lock held. Takes `image`, left alone when it does not fit at all. */
+static bool
+sdk_decode_insert(char *path, u64 write_time, u32 size, Image *image)
+{
+  u32         i;
+  u64         bytes;
+  Sdk_Decoded *entry, *oldest;
+
+  bytes = (u64) image->w * image->h * 3;
+  if (bytes > SDK_DECODE_BUDGET / 4 || strlen(path) >= MAX_PATH) return false;
+  for (i = 0; i < SDK_DECODE_ENTRIES; i++)
+  {
+    entry = &g_decoded.entries[i];
+    if (!entry->path[0] || strcmp(entry->path, path)) continue;
+    /* NOTE: Another thread got there first */
+    if (entry->write_time == write_time && entry->size == size && entry->image.w == image->w && entry->image.h == image->h) return false;
+    if (entry->write_time != write_time || entry->size != size) sdk_decode_evict(entry);
+  }
+  for (;;)
+  {
+    entry = oldest = NULL;
+    for (i = 0; i < SDK_DECODE_ENTRIES; i++)
+    {
+      if (!g_decoded.entries[i].path[0]) { if (!entry) entry = &g_decoded.entries[i]; continue; }
+      if (!oldest || g_decoded.entries[i].used < oldest->used) oldest = &g_decoded.entries[i];
+    }
+    if (entry && g_decoded.bytes + bytes <= SDK_DECODE_BUDGET) break;
+    sdk_decode_evict(oldest);
+  }
+  strcpy(entry->path, path);
+  entry->write_time = write_time;
+  entry->size       = size;
+  entry->used       = ++g_decoded.clock;
+  entry->image      = *image;
+  g_decoded.bytes  += bytes;
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Any thread. The image file at `path` decoded to `w` x `h`, from
+ *      g_decoded when it did not change since. `image` is the caller's copy,
+ *      release it with image_free.
+ */
+static bool
+sdk_decode_file(char *path, u32 w, u32 h, Image *image)
+{
+  u32         i, size;
+  u64         write_time;
+  bool        ok;
+  File        file;
+  Image       decoded;
+  Sdk_Decoded *entry;
+
+  memset(image, 0, sizeof(Image));
+  size       = 0;
+  write_time = sdk_file_write_time(path, &size);
+  if (write_time)
+  {
+    AcquireSRWLockExclusive(&g_decoded.lock);
+    for (i = 0; i < SDK_DECODE_ENTRIES; i++)
+    {
+      entry = &g_decoded.entries[i];
+      if (!entry->path[0] || entry->write_time != write_time || entry->size != size
+          || entry->image.w != w || entry->image.h != h || strcmp(entry->path, path)) continue;
+      entry->used = ++g_decoded.clock;
+      g_decoded.hits++;
+      ok = image_alloc(image, w, h);
+      if (ok) memcpy(image->pixels, entry->image.pixels, (u64) w * h * 3);
+      ReleaseSRWLockExclusive(&g_decoded.lock);
+      return ok;
+    }
+    g_decoded.misses++;
+    ReleaseSRWLockExclusive(&g_decoded.lock);
+  }
+
+  if (file_exist_open_map_ro(path, &file) != CM_OK) return false;
+  ok = sdk_decode_image(file.buffer.view, (u32) file.buffer.size, w, h, &decoded);
+  file_close(&file);
+  if (!ok) return false;
+  if (!write_time || !image_alloc(image, w, h)) { *image = decoded; return true; }
+  memcpy(image->pixels, decoded.pixels, (u64) w * h * 3);
+  AcquireSRWLockExclusive(&g_decoded.lock);
+  if (!sdk_decode_insert(path, write_time, size, &decoded)) image_free(&decoded);
+  ReleaseSRWLockExclusive(&g_decoded.lock);
+  return true;
+}
+
+static void
+sdk_decode_close(void)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&g_decoded.lock);
+  for (i = 0; i < SDK_DECODE_ENTRIES; i++) image_free(&g_decoded.entries[i].image);
+  memset(g_decoded.entries, 0, sizeof(g_decoded.entries));
+  g_decoded.bytes = 0;
+  ReleaseSRWLockExclusive(&g_decoded.lock);
+}
+
+static void
+sdk_decode_report(void)
+{
+  printf("decode: %llu hits, %llu misses, %llu evicted, %llu KB held\n",
+         g_decoded.hits, g_decoded.misses, g_decoded.evicted, g_decoded.bytes >> 10);
+}
+
+#endif // SDK_DECODE_C
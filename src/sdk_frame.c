@@ -0,0 +1,670 @@
+#ifndef SDK_FRAME_C
+#define SDK_FRAME_C
+
+/*
+ * NOTE:
+ *      Frames: a set of key images presented as one update. Each key changes
+ *      the moment its last report lands, so an update touching the whole XL
+ *      reads as a wipe across it. A frame collects its keys first
+ *      (sdk_frame_set), queues them together, smallest images first so most
+ *      keys change as early as the bus allows, and reports once, when the
+ *      last one is on the device (Sdk_Frame_Done). The device has a single
+ *      buffer per key, the reveal hides the transfer instead:
+ *
+ *        PLAIN  keys change as their upload ends
+ *        BLANK  every key of the frame goes black first (one report each),
+ *               the images then fill in on a dark deck
+ *        DIM    the deck is dimmed for the transfer and brought back once
+ *               the last image is there, the change appears at once. Needs
+ *               the brightness to be known (sdk_queue_brightness), BLANK
+ *               otherwise.
+ *
+ *      The jobs of a frame never replace each other in the write queue (a
+ *      BLANK frame queues two per key), anything else still replaces them.
+ *      A job that is replaced or dropped marks the frame failed.
+ *
+ *      Page switches can use a frame (sdk_pages_switch) or be animated:
+ *      SLIDE and FADE compute their steps on a deck sized canvas, both pages
+ *      decoded side by side from their packed reports, then encode every
+ *      key of every step in parallel on the system thread pool. The steps
+ *      go out one frame after the other, the last one is the page itself.
+ *      Navigating again before the end cancels the transition, the page
+ *      then goes out whole.
+ */
+#define SDK_FRAME_DIM_PERCENT    5
+#define SDK_TRANSITION_STEPS     3            /* NOTE: Frames of a SLIDE / FADE, the page itself included */
+#define SDK_TRANSITION_LEVEL     2            /* NOTE: Link level the steps are encoded at, at least */
+#define SDK_TRANSITION_WORKERS   4
+
+enum
+{
+  SDK_FRAME_PLAIN,
+  SDK_FRAME_BLANK,
+  SDK_FRAME_DIM,
+};
+
+enum
+{
+  SDK_TRANSITION_NONE,
+  SDK_TRANSITION_BLANK,
+  SDK_TRANSITION_DIM,
+  SDK_TRANSITION_SLIDE,
+  SDK_TRANSITION_FADE,
+};
+
+global char *g_sdk_transition_names[] = { "none", "blank", "dim", "slide", "fade" };
+
+/* NOTE: Wherever the last job of the frame let go (mostly the service thread), must not block. */
+typedef void (*Sdk_Frame_Done)(Stream_Deck *sdk, bool presented, u64 us, void *user);
+
+#pragma warning(disable : 4820)
+typedef struct SdkFrame
+{
+  Stream_Deck    *sdk;
+  u8             mode;
+  bool           animated;                   /* NOTE: Encoded at link `level`, see Sdk_Link */
+  u8             level;
+  u64            sequence;                   /* NOTE: Shared by its jobs, see sdk_queue_push */
+  u64            stamp;                      /* NOTE: Page switch, see Sdk_Page_Timing */
+  u64            start;
+  atomic_uint    left;                       /* NOTE: Jobs not through yet, +1 while queuing */
+  atomic_bool    failed;
+  Sdk_Frame_Done done;
+  void           *user;
+  u32            count;
+  u8             keys[SDK_KEYS_MAX];
+  Sdk_Packed     *packed[SDK_KEYS_MAX];      /* NOTE: One reference each, NULL is skipped */
+} SdkFrame, Sdk_Frame;
+
+typedef struct SdkTransition
+{
+  Stream_Deck            *sdk;
+  u8                     kind;
+  i8                     direction;          /* NOTE: SLIDE: 1 moves the page left (next), -1 right */
+  u32                    level;
+  u64                    sequence;
+  struct SdkTransitions  *owner;             /* NOTE: Until encoded */
+  atomic_uint            refs;               /* NOTE: Workers, plus the encoding or presenting stage */
+  PTP_WORK               work;
+  u32                    count;
+  u8                     keys[SDK_KEYS_MAX];
+  Sdk_Packed             *from[SDK_KEYS_MAX]; /* NOTE: On screen now, NULL = black */
+  Image                  canvas[2];          /* NOTE: Deck sized, the page left then the page shown */
+  Sdk_Frame              *frames[SDK_TRANSITION_STEPS];
+  u32                    shown;              /* NOTE: Frames presented */
+  /* NOTE: Decoding (phase 0) then encoding (phase 1), one task per key and page / key and step */
+  atomic_uint            phase;
+  u32                    tasks[2];
+  atomic_uint            next[2], left[2];
+  atomic_bool            cancelled;          /* NOTE: Set with the owner's lock held */
+} SdkTransition, Sdk_Transition;
+
+/* NOTE: Per deck, in Sdk_Deck_Pages. */
+typedef struct SdkTransitions
+{
+  SRWLOCK        *lock;                      /* NOTE: The owner's, guards `encoding` */
+  Sdk_Transition *encoding;                  /* NOTE: At most one, NULL when idle */
+} SdkTransitions, Sdk_Transitions;
+
+typedef struct SdkFrameStats
+{
+  atomic_ullong sequence;
+  atomic_ullong presented, failed, keys;
+  atomic_ullong transitions, finished, cancelled;
+} SdkFrameStats, Sdk_Frame_Stats;
+#pragma warning(default : 4820)
+
+global Sdk_Frame_Stats g_frames;
+
+/* -- Frames ------------------------------------------------------------------------- */
+
+/* NOTE: Any thread. An empty frame for `sdk`, NULL on failure. */
+static Sdk_Frame*
+sdk_frame_begin(Stream_Deck *sdk, u8 mode)
+{
+  Sdk_Frame *frame;
+
+  frame = NULL;
+  cm_heap_alloc(sizeof(Sdk_Frame), frame);
+  if (!frame) { report_error("sdk_frame_begin"); return NULL; }
+  frame->sdk      = sdk;
+  frame->mode     = mode;
+  frame->sequence = atomic_fetch_add(&g_frames.sequence, 1) + 1;
+  return frame;
+}
+
+/* NOTE: Takes its own reference on `packed`, a key set twice keeps the last image. */
+static bool
+sdk_frame_set(Sdk_Frame *frame, u8 key, Sdk_Packed *packed)
+{
+  u32 i;
+
+  if (key >= frame->sdk->total || !packed) { printf("Invalid key\n"); return false; }
+  for (i = 0; i < frame->count; i++) if (frame->keys[i] == key) break;
+  if (i == frame->count) frame->count++;
+  else                   sdk_packed_release(frame->packed[i]);
+  frame->keys[i]   = key;
+  frame->packed[i] = sdk_packed_retain(packed);
+  return true;
+}
+
+/* NOTE: A frame that was never presented. */
+static void
+sdk_frame_discard(Sdk_Frame *frame)
+{
+  u32 i;
+
+  for (i = 0; i < frame->count; i++) sdk_packed_release(frame->packed[i]);
+  heap_free_dz(frame);
+}
+
+static void
+sdk_frame_complete(Sdk_Frame *frame)
+{
+  u64  us;
+  bool presented;
+
+  presented = !atomic_load(&frame->failed);
+  us        = sdk_ticks_to_us(sdk_now() - frame->start);
+  atomic_fetch_add(presented ? &g_frames.presented : &g_frames.failed, 1);
+  if (frame->done) frame->done(frame->sdk, presented, us, frame->user);
+  sdk_frame_discard(frame);
+}
+
+/* NOTE: Sdk_Feature_Done, the deck is back to its brightness. */
+static void
+sdk_frame_restored(Stream_Deck *sdk, u8 op, u8 value, i64 result, void *user)
+{
+  (void) sdk; (void) op; (void) value; (void) result;
+  sdk_frame_complete(user);
+}
+
+/*
+ * NOTE:
+ *      Any thread, no lock held. A job of `frame` left the write queue,
+ *      `sent` when it reached the device. The last one completes the frame,
+ *      once the brightness is back for DIM.
+ */
+static void
+sdk_frame_put(Sdk_Frame *frame, bool sent)
+{
+  Stream_Deck    *sdk;
+  Sdk_Feature_Op op;
+
+  if (!sent) atomic_store(&frame->failed, true);
+  if (atomic_fetch_sub(&frame->left, 1) != 1) return;
+  sdk = frame->sdk;
+  if (frame->mode == SDK_FRAME_DIM && atomic_load(&sdk->connected))
+  {
+    /* NOTE: The brightness asked for meanwhile, if any */
+    op.op    = SDK_OP_SET_BRIGHTNESS;
+    op.value = (u8) atomic_load(&sdk->brightness);
+    op.done  = sdk_frame_restored;
+    op.user  = frame;
+    if (sdk_features_push(sdk, &op)) return;
+  }
+  sdk_frame_complete(frame);
+}
+
+static void
+sdk_frame_push(Sdk_Frame *frame, u8 key, Sdk_Packed *packed, u64 stamp)
+{
+  Sdk_Write_Job job;
+
+  memset(&job, 0, sizeof(Sdk_Write_Job));
+  job.key      = key;
+  job.size     = packed->image_size;
+  job.packed   = sdk_packed_retain(packed);
+  job.stamp    = stamp;
+  job.animated = frame->animated;
+  job.level    = frame->level;
+  job.queued   = sdk_now();
+  job.frame    = frame;
+  job.sequence = frame->sequence;
+  atomic_fetch_add(&frame->left, 1);
+  if (sdk_queue_push(frame->sdk, &job)) return;
+  printf("[%s] write queue full\n", frame->sdk->serial);
+  sdk_packed_release(job.packed);
+  sdk_frame_put(frame, false);
+}
+
+/* NOTE: Queues the jobs of `frame`, fewest reports first, then lets go of the queuing reference. */
+static void
+sdk_frame_queue(Sdk_Frame *frame)
+{
+  u32         i, j, count;
+  u8          order[SDK_KEYS_MAX];
+  Sdk_Packed  *blank;
+  Stream_Deck *sdk;
+
+  sdk = frame->sdk;
+  for (i = 0, count = 0; i < frame->count; i++)
+  {
+    if (!frame->packed[i]) continue;
+    for (j = count; j && frame->packed[order[j - 1]]->report_count > frame->packed[i]->report_count; j--) order[j] = order[j - 1];
+    order[j] = (u8) i;
+    count++;
+  }
+  if (frame->mode == SDK_FRAME_BLANK)
+  {
+    blank = sdk_pack_key_image(sdk, sdk->blank_key, sdk->blank_key_size, 0);
+    for (i = 0; blank && i < count; i++) sdk_frame_push(frame, frame->keys[order[i]], blank, 0);
+    sdk_packed_release(blank);
+  }
+  for (i = 0; i < count; i++) sdk_frame_push(frame, frame->keys[order[i]], frame->packed[order[i]], frame->stamp);
+  atomic_fetch_add(&g_frames.keys, count);
+  sdk_frame_put(frame, true);
+}
+
+/* NOTE: Sdk_Feature_Done, the deck is dimmed (or could not be), the images go. */
+static void
+sdk_frame_dimmed(Stream_Deck *sdk, u8 op, u8 value, i64 result, void *user)
+{
+  (void) sdk; (void) op; (void) value; (void) result;
+  sdk_frame_queue(user);
+}
+
+/*
+ * NOTE:
+ *      Any thread, never blocks. Takes `frame`, which may be gone by the
+ *      time this returns. `done` (optional) runs once every key is on the
+ *      device, `presented` false when one of them was replaced or failed.
+ */
+static void
+sdk_frame_present(Sdk_Frame *frame, Sdk_Frame_Done done, void *user)
+{
+  Stream_Deck    *sdk;
+  Sdk_Feature_Op op;
+
+  sdk          = frame->sdk;
+  frame->done  = done;
+  frame->user  = user;
+  frame->start = sdk_now();
+  atomic_store(&frame->left, 1);
+  if (frame->mode == SDK_FRAME_DIM && !frame->count) frame->mode = SDK_FRAME_PLAIN;
+  if (frame->mode == SDK_FRAME_DIM)
+  {
+    if (atomic_load(&sdk->brightness) == SDK_BRIGHTNESS_UNKNOWN) frame->mode = SDK_FRAME_BLANK;
+    else
+    {
+      op.op    = SDK_OP_SET_BRIGHTNESS;
+      op.value = SDK_FRAME_DIM_PERCENT;
+      op.done  = sdk_frame_dimmed;
+      op.user  = frame;
+      if (sdk_features_push(sdk, &op)) return;
+      frame->mode = SDK_FRAME_PLAIN;
+    }
+  }
+  sdk_frame_queue(frame);
+}
+
+/* -- Transitions -------------------------------------------------------------------- */
+
+/* NOTE: Any thread. The image `packed` carries, in one piece again. Release with heap_free_dz. */
+static u8*
+sdk_packed_unpack(Stream_Deck *sdk, Sdk_Packed *packed)
+{
+  u32 page, len, at;
+  u8  *image, *report;
+
+  image = NULL;
+  cm_heap_alloc(packed->image_size, image);
+  if (!image) return NULL;
+  for (page = 0, at = 0; page < packed->report_count && at < packed->image_size; page++)
+  {
+    report = packed->reports + (u64) page * packed->report_len;
+    len    = report[4] | ((u32) report[5] << 8);
+    if (len > packed->image_size - at) len = packed->image_size - at;
+    memcpy(image + at, report + sdk->img_rpt_header_len, len);
+    at += len;
+  }
+  return image;
+}
+
+static void
+sdk_transition_put(Sdk_Transition *t)
+{
+  u32 i;
+
+  if (atomic_fetch_sub(&t->refs, 1) != 1) return;
+  for (i = 0; i < t->count; i++) sdk_packed_release(t->from[i]);
+  for (i = 0; i < SDK_TRANSITION_STEPS; i++) if (t->frames[i]) sdk_frame_discard(t->frames[i]);
+  image_free(&t->canvas[0]);
+  image_free(&t->canvas[1]);
+  /* NOTE: Released once its last callback returned, this may be one */
+  if (t->work) CloseThreadpoolWork(t->work);
+  heap_free_dz(t);
+}
+
+static void
+sdk_transition_stepped(Stream_Deck *sdk, bool presented, u64 us, void *user);
+
+static void
+sdk_transition_next(Sdk_Transition *t)
+{
+  Sdk_Frame *frame;
+
+  frame = t->frames[t->shown];
+  t->frames[t->shown++] = NULL;
+  sdk_frame_present(frame, sdk_transition_stepped, t);
+}
+
+/* NOTE: Sdk_Frame_Done, a step is on screen: the next one, unless cancelled. */
+static void
+sdk_transition_stepped(Stream_Deck *sdk, bool presented, u64 us, void *user)
+{
+  u64            sequence;
+  Sdk_Transition *t;
+
+  (void) us;
+  t        = user;
+  sequence = t->sequence;
+  if (presented && t->shown < SDK_TRANSITION_STEPS && atomic_load(&sdk->transition_sequence) == sequence)
+  {
+    sdk_transition_next(t);
+    return;
+  }
+  atomic_fetch_add(presented && t->shown == SDK_TRANSITION_STEPS ? &g_frames.finished : &g_frames.cancelled, 1);
+  atomic_compare_exchange_strong(&sdk->transition_sequence, &sequence, 0);
+  sdk_transition_put(t);
+}
+
+/* NOTE: Worker. One key of one page, decoded upright into its place on the canvas. */
+static void
+sdk_transition_decode(Sdk_Transition *t, u32 task)
+{
+  u32         j, which, x0, y0, row;
+  u8          *image;
+  bool        ok;
+  Image       pixels, upright, *canvas;
+  Sdk_Packed  *packed;
+  Stream_Deck *sdk;
+
+  sdk    = t->sdk;
+  j      = task / 2;
+  which  = task % 2;
+  packed = which ? t->frames[SDK_TRANSITION_STEPS - 1]->packed[j] : t->from[j];
+  if (!packed) return;
+  image = sdk_packed_unpack(sdk, packed);
+  if (!image) return;
+  ok = sdk_decode_image(image, packed->image_size, sdk->pxl_w, sdk->pxl_h, &pixels);
+  heap_free_dz(image);
+  if (!ok) return;
+  /* NOTE: Packed turned for the model */
+  if (sdk->key_rotation && image_rotate(&pixels, &upright, (4 - sdk->key_rotation) % 4))
+  {
+    image_free(&pixels);
+    pixels = upright;
+  }
+  canvas = &t->canvas[which];
+  x0     = (t->keys[j] % sdk->cols) * sdk->pxl_w;
+  y0     = (t->keys[j] / sdk->cols) * sdk->pxl_h;
+  for (row = 0; row < pixels.h && row < sdk->pxl_h; row++)
+  {
+    memcpy(canvas->pixels + ((u64) (y0 + row) * canvas->w + x0) * 3, pixels.pixels + (u64) row * pixels.w * 3,
+           (u64) (pixels.w < sdk->pxl_w ? pixels.w : sdk->pxl_w) * 3);
+  }
+  image_free(&pixels);
+}
+
+/* NOTE: Worker. One key of one step, cut from the canvases, encoded and packed into its frame. */
+static void
+sdk_transition_encode(Sdk_Transition *t, u32 task)
+{
+  u32         j, step, x, y, x0, y0, w, offset, a, c, size;
+  i32         src;
+  u8          *out, *in, *from, *to, *encoded;
+  Image       key;
+  Stream_Deck *sdk;
+
+  sdk  = t->sdk;
+  j    = task % t->count;
+  step = task / t->count + 1;
+  if (!image_alloc(&key, sdk->pxl_w, sdk->pxl_h)) return;
+  w      = t->canvas[0].w;
+  x0     = (t->keys[j] % sdk->cols) * sdk->pxl_w;
+  y0     = (t->keys[j] / sdk->cols) * sdk->pxl_h;
+  offset = w * step / SDK_TRANSITION_STEPS;
+  a      = 256 * step / SDK_TRANSITION_STEPS;
+  for (y = 0; y < key.h; y++)
+  {
+    out  = key.pixels + (u64) y * key.w * 3;
+    from = t->canvas[0].pixels + (u64) (y0 + y) * w * 3;
+    to   = t->canvas[1].pixels + (u64) (y0 + y) * w * 3;
+    for (x = 0; x < key.w; x++, out += 3)
+    {
+      if (t->kind == SDK_TRANSITION_FADE)
+      {
+        for (c = 0; c < 3; c++) out[c] = (u8) ((from[(x0 + x) * 3 + c] * (256 - a) + to[(x0 + x) * 3 + c] * a) >> 8);
+        continue;
+      }
+      /* NOTE: Both pages side by side, the new one coming in from the side it moves away from */
+      src = (t->direction > 0) ? (i32) (x0 + x + offset) : (i32) (x0 + x) - (i32) offset;
+      if      (src >= (i32) w) in = to + (u64) (src - (i32) w) * 3;
+      else if (src < 0)        in = to + (u64) (src + (i32) w) * 3;
+      else                     in = from + (u64) src * 3;
+      out[0] = in[0]; out[1] = in[1]; out[2] = in[2];
+    }
+  }
+  encoded = sdk_encode_key_pixels(sdk, &key, &size, t->level);
+  if (!encoded) return;
+  t->frames[step - 1]->packed[j] = sdk_pack_key_image(sdk, encoded, size, 0);
+  heap_free_dz(encoded);
+}
+
+/* NOTE: Worker, every step is encoded or the transition was cancelled. Presents the first step. */
+static void
+sdk_transition_ready(Sdk_Transition *t)
+{
+  bool            ok;
+  Sdk_Transitions *ts;
+
+  image_free(&t->canvas[0]);
+  image_free(&t->canvas[1]);
+  ts = t->owner;
+  /* NOTE: Ordered with the page switches, which take the same lock */
+  AcquireSRWLockExclusive(ts->lock);
+  ts->encoding = NULL;
+  t->owner     = NULL;
+  ok           = !atomic_load(&t->cancelled);
+  if (ok)
+  {
+    atomic_store(&t->sdk->transition_sequence, t->sequence);
+    sdk_transition_next(t);
+  }
+  ReleaseSRWLockExclusive(ts->lock);
+  if (!ok)
+  {
+    atomic_fetch_add(&g_frames.cancelled, 1);
+    sdk_transition_put(t);
+  }
+}
+
+static void
+sdk_transition_submit(Sdk_Transition *t, u32 tasks)
+{
+  u32 i;
+
+  for (i = 0; i < tasks && i < SDK_TRANSITION_WORKERS; i++)
+  {
+    atomic_fetch_add(&t->refs, 1);
+    SubmitThreadpoolWork(t->work);
+  }
+}
+
+static void CALLBACK
+sdk_transition_proc(PTP_CALLBACK_INSTANCE instance, void *context, PTP_WORK work)
+{
+  u32            phase, task;
+  Sdk_Transition *t;
+
+  (void) instance; (void) work;
+  t = context;
+  for (;;)
+  {
+    phase = atomic_load(&t->phase);
+    task  = atomic_fetch_add(&t->next[phase], 1);
+    if (task >= t->tasks[phase]) break;
+    if (!atomic_load(&t->cancelled))
+    {
+      if (phase == 0) sdk_transition_decode(t, task);
+      else            sdk_transition_encode(t, task);
+    }
+    if (atomic_fetch_sub(&t->left[phase], 1) != 1) continue;
+    /* NOTE: Last task of the phase, every canvas is complete */
+    if (phase == 0 && !atomic_load(&t->cancelled))
+    {
+      atomic_store(&t->phase, 1);
+      sdk_transition_submit(t, t->tasks[1]);
+      continue;
+    }
+    sdk_transition_ready(t);
+  }
+  sdk_transition_put(t);
+}
+
+/* NOTE: Any thread. An empty SLIDE / FADE for `sdk`, NULL on failure. */
+static Sdk_Transition*
+sdk_transition_begin(Stream_Deck *sdk, u8 kind, i32 direction)
+{
+  u32            i, level;
+  Sdk_Transition *t;
+
+  t = NULL;
+  cm_heap_alloc(sizeof(Sdk_Transition), t);
+  if (!t) { report_error("sdk_transition_begin"); return NULL; }
+  level        = sdk_link_level(sdk);
+  t->sdk       = sdk;
+  t->kind      = kind;
+  t->direction = (direction < 0) ? -1 : 1;
+  t->level     = (level > SDK_TRANSITION_LEVEL) ? level : SDK_TRANSITION_LEVEL;
+  atomic_store(&t->refs, 1);
+  for (i = 0; i < SDK_TRANSITION_STEPS; i++)
+  {
+    t->frames[i] = sdk_frame_begin(sdk, SDK_FRAME_PLAIN);
+    if (!t->frames[i]) { sdk_transition_put(t); return NULL; }
+    /* NOTE: The steps are only on screen for a moment, the page itself is not */
+    if (i < SDK_TRANSITION_STEPS - 1)
+    {
+      t->frames[i]->animated = true;
+      t->frames[i]->level    = (u8) t->level;
+    }
+  }
+  t->work = CreateThreadpoolWork(sdk_transition_proc, t, NULL);
+  if (!t->work) { report_error("CreateThreadpoolWork"); sdk_transition_put(t); return NULL; }
+  return t;
+}
+
+/* NOTE: `key` goes from `from` (NULL = black) to `to`, takes its own references. */
+static void
+sdk_transition_key(Sdk_Transition *t, u8 key, Sdk_Packed *from, Sdk_Packed *to)
+{
+  u32       i;
+  Sdk_Frame *step;
+
+  t->keys[t->count] = key;
+  t->from[t->count] = from ? sdk_packed_retain(from) : NULL;
+  for (i = 0; i < SDK_TRANSITION_STEPS - 1; i++)
+  {
+    step = t->frames[i];
+    step->keys[step->count++] = key;
+  }
+  sdk_frame_set(t->frames[SDK_TRANSITION_STEPS - 1], key, to);
+  t->count++;
+}
+
+static void
+sdk_transitions_open(Sdk_Transitions *ts, SRWLOCK *lock)
+{
+  ts->lock     = lock;
+  ts->encoding = NULL;
+}
+
+/* NOTE: Lock held. Stops the transition being encoded or presented, true when there was one. */
+static bool
+sdk_transitions_cancel(Sdk_Transitions *ts, Stream_Deck *sdk)
+{
+  bool cancelled;
+
+  cancelled = false;
+  if (ts->encoding)
+  {
+    atomic_store(&ts->encoding->cancelled, true);
+    cancelled = true;
+  }
+  if (atomic_exchange(&sdk->transition_sequence, 0)) cancelled = true;
+  return cancelled;
+}
+
+/* NOTE: Lock held. False when `t` cannot start (one is still being encoded, no memory), nothing happened then. */
+static bool
+sdk_transitions_prepare(Sdk_Transitions *ts, Sdk_Transition *t)
+{
+  u32         w, h;
+  Stream_Deck *sdk;
+
+  sdk = t->sdk;
+  if (ts->encoding || !t->count) return false;
+  w = sdk->cols * sdk->pxl_w;
+  h = sdk->rows * sdk->pxl_h;
+  if (!image_alloc(&t->canvas[0], w, h) || !image_alloc(&t->canvas[1], w, h)) return false;
+  /* NOTE: What nothing is known of shows black */
+  memset(t->canvas[0].pixels, 0, (u64) w * h * 3);
+  memset(t->canvas[1].pixels, 0, (u64) w * h * 3);
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Lock held, after sdk_transitions_prepare. Takes `t` and returns right
+ *      away, the thread pool decodes and encodes and the write pump presents.
+ *      The jobs of the last step carry `stamp`.
+ */
+static void
+sdk_transitions_run(Sdk_Transitions *ts, Sdk_Transition *t, u64 stamp)
+{
+  t->frames[SDK_TRANSITION_STEPS - 1]->stamp = stamp;
+  t->sequence  = atomic_fetch_add(&g_frames.sequence, 1) + 1;
+  t->owner     = ts;
+  t->tasks[0]  = t->count * 2;
+  t->tasks[1]  = t->count * (SDK_TRANSITION_STEPS - 1);
+  atomic_store(&t->left[0], t->tasks[0]);
+  atomic_store(&t->left[1], t->tasks[1]);
+  ts->encoding = t;
+  atomic_fetch_add(&g_frames.transitions, 1);
+  sdk_transition_submit(t, t->tasks[0]);
+}
+
+/* NOTE: No lock held. Cancels what is being encoded and waits for it, the presenting stage needs none of `ts`. */
+static void
+sdk_transitions_close(Sdk_Transitions *ts, Stream_Deck *sdk)
+{
+  bool busy;
+
+  for (;;)
+  {
+    AcquireSRWLockExclusive(ts->lock);
+    sdk_transitions_cancel(ts, sdk);
+    busy = ts->encoding != NULL;
+    ReleaseSRWLockExclusive(ts->lock);
+    if (!busy) break;
+    Sleep(1);
+  }
+}
+
+/* NOTE: Any thread. How `sdk` switches pages from now on, SDK_TRANSITION_*. */
+static void
+sdk_set_transition(Stream_Deck *sdk, u8 kind)
+{
+  atomic_store(&sdk->transition, kind < countof(g_sdk_transition_names) ? kind : SDK_TRANSITION_NONE);
+}
+
+static void
+sdk_frames_report(void)
+{
+  printf("frames: %llu presented, %llu failed, %llu keys; transitions %llu started, %llu finished, %llu cancelled\n",
+         atomic_load(&g_frames.presented), atomic_load(&g_frames.failed), atomic_load(&g_frames.keys),
+         atomic_load(&g_frames.transitions), atomic_load(&g_frames.finished), atomic_load(&g_frames.cancelled));
+}
+
+#endif // SDK_FRAME_C
@@ -0,0 +1,367 @@
+#ifndef SDK_GESTURE_C
+#define SDK_GESTURE_C
+
+/*
+ * NOTE:
+ *      Gesture recognition on the thread servicing the deck, fed from
+ *      sdk_parse_input with the key bitset of every report.
+ *
+ *      Definitions are compiled once into a Sdk_Gesture_Table that can be
+ *      shared by any number of decks:
+ *        - CHORD:  every key in `keys` down, fires on whichever goes down last,
+ *                  once when the last ones go down in the same report
+ *        - COMBO:  `keys` held, then `key` pressed (order matters)
+ *        - DOUBLE: `key` pressed twice within the double tap window
+ *        - HOLD:   `key` kept down for the hold window (long press)
+ *      Chords and combos become (trigger key, exact down set) entries in an
+ *      open addressed hash table, doubles a per key slot. A key press is one
+ *      hash probe whatever the number of gestures, so a report costs
+ *      O(changed keys). Exact match means an extra key held cancels a chord.
+ *      A HOLD key arms a timer of its own on the service's wheel when it
+ *      goes down (sdk_timer.c) and stops it when it comes back up, no key
+ *      is ever polled.
+ *
+ *      Debounce is per key: an edge within `debounce` ticks of the last
+ *      accepted edge of the same key is ignored and arms a settle timer of
+ *      the key for the end of the window. When it fires, the last state the
+ *      device reported is compared with the published one (the seqlock
+ *      snapshot) and a key that settled in the other state catches up then,
+ *      a release inside the window never leaves the key stuck down.
+ */
+#define SDK_GESTURE_BATCH_LEN   64
+#define SDK_GESTURE_KEYS_MAX    8
+#define SDK_GESTURE_NONE        0xFFFF
+
+enum
+{
+  SDK_GESTURE_CHORD,
+  SDK_GESTURE_COMBO,
+  SDK_GESTURE_DOUBLE,
+  SDK_GESTURE_HOLD,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkGestureDef
+{
+  u16 id;
+  u8  kind;
+  u8  key;                                   /* NOTE: COMBO / DOUBLE / HOLD trigger */
+  u8  count;
+  u8  keys[SDK_GESTURE_KEYS_MAX];            /* NOTE: CHORD set / COMBO held keys */
+} SdkGestureDef, Sdk_Gesture_Def;
+
+typedef struct SdkGestureSlot
+{
+  u64 down[SDK_KEY_WORDS];
+  u16 gesture;                               /* NOTE: SDK_GESTURE_NONE when free */
+  u8  key;
+} SdkGestureSlot, Sdk_Gesture_Slot;
+
+typedef struct SdkGestureTable
+{
+  u64              debounce;                 /* NOTE: sdk_now() ticks */
+  u64              double_tap;
+  u32              hold_ms;
+  u32              mask;                     /* NOTE: slot count - 1 */
+  u16              doubles[SDK_KEYS_MAX];
+  u16              holds[SDK_KEYS_MAX];
+  Sdk_Gesture_Def  *defs;
+  u32              def_count;
+  Sdk_Gesture_Slot *slots;
+} SdkGestureTable, Sdk_Gesture_Table;
+
+typedef struct SdkGestureEvent
+{
+  u64 time;
+  u16 id;
+  u8  kind;
+  u8  key;
+} SdkGestureEvent, Sdk_Gesture_Event;
+
+/* NOTE: Per deck, only touched by the thread servicing it. */
+typedef struct SdkGestureState
+{
+  u64               last_edge[SDK_KEYS_MAX];
+  u64               last_tap[SDK_KEYS_MAX];
+  u64               raw[SDK_KEY_WORDS];      /* NOTE: Key bits of the last report, before debounce */
+  u64               bounces;
+  u64               dropped;
+  u32               count;
+  Sdk_Gesture_Event events[SDK_GESTURE_BATCH_LEN];
+  Sdk_Timer         holds[SDK_KEYS_MAX];     /* NOTE: HOLD, armed while the key is down */
+  Sdk_Timer         settles[SDK_KEYS_MAX];   /* NOTE: Armed by an ignored edge, see sdk_gesture_debounce */
+} SdkGestureState, Sdk_Gesture_State;
+#pragma warning(default : 4820)
+
+static inline u32
+sdk_gesture_hash(u64 *down, u32 key)
+{
+  u32 w;
+  u64 h;
+
+  h = key * 0x9E3779B97F4A7C15ull;
+  for (w = 0; w < SDK_KEY_WORDS; w++) h = (h ^ down[w]) * 0xBF58476D1CE4E5B9ull;
+  return (u32)(h ^ (h >> 31));
+}
+
+static bool
+sdk_gesture_insert(Sdk_Gesture_Table *table, u64 *down, u8 key, u16 gesture)
+{
+  u32              i, n;
+  Sdk_Gesture_Slot *slot;
+
+  i = sdk_gesture_hash(down, key) & table->mask;
+  for (n = 0; n <= table->mask; n++, i = (i + 1) & table->mask)
+  {
+    slot = &table->slots[i];
+    if (slot->gesture == SDK_GESTURE_NONE)
+    {
+      memcpy(slot->down, down, sizeof(slot->down));
+      slot->key     = key;
+      slot->gesture = gesture;
+      return true;
+    }
+    if (slot->key == key && !memcmp(slot->down, down, sizeof(slot->down)))
+    {
+      printf("gesture %u shadows gesture %u\n", table->defs[gesture].id, table->defs[slot->gesture].id);
+      return true;
+    }
+  }
+  return false;
+}
+
+static u16
+sdk_gesture_lookup(Sdk_Gesture_Table *table, u64 *down, u8 key)
+{
+  u32              i, n;
+  Sdk_Gesture_Slot *slot;
+
+  i = sdk_gesture_hash(down, key) & table->mask;
+  for (n = 0; n <= table->mask; n++, i = (i + 1) & table->mask)
+  {
+    slot = &table->slots[i];
+    if (slot->gesture == SDK_GESTURE_NONE) break;
+    if (slot->key == key && !memcmp(slot->down, down, sizeof(slot->down))) return slot->gesture;
+  }
+  return SDK_GESTURE_NONE;
+}
+
+static void
+sdk_gestures_close(Sdk_Gesture_Table *table)
+{
+  if (!table) return;
+  if (table->slots) heap_free_dz(table->slots);
+  if (table->defs)  heap_free_dz(table->defs);
+  heap_free_dz(table);
+}
+
+/*
+ * NOTE:
+ *      Builds the lookup structures for `defs` (copied). Windows are in
+ *      milliseconds, 0 disables debounce / double taps, `hold_ms` is the long
+ *      press of HOLD gestures. NULL on failure.
+ */
+static Sdk_Gesture_Table*
+sdk_gestures_compile(Sdk_Gesture_Def *defs, u32 count, u32 debounce_ms, u32 double_tap_ms, u32 hold_ms)
+{
+  u32               i, j, slots, entries;
+  u64               down[SDK_KEY_WORDS];
+  Sdk_Gesture_Def   *def;
+  Sdk_Gesture_Table *table = NULL;
+
+  if (count >= SDK_GESTURE_NONE) { printf("sdk_gestures_compile: too many gestures\n"); return NULL; }
+  entries = 0;
+  for (i = 0; i < count; i++)
+  {
+    def = &defs[i];
+    if (def->count > SDK_GESTURE_KEYS_MAX) goto _invalid;
+    if (def->kind == SDK_GESTURE_CHORD) entries += def->count;
+    else if (def->kind == SDK_GESTURE_COMBO) entries++;
+    else if (def->kind != SDK_GESTURE_DOUBLE && def->kind != SDK_GESTURE_HOLD) goto _invalid;
+  }
+  for (slots = 16; slots < entries * 2; slots <<= 1);
+
+  cm_heap_alloc(sizeof(Sdk_Gesture_Table), table);
+  if (!table) return NULL;
+  cm_heap_alloc(sizeof(Sdk_Gesture_Slot) * slots, table->slots);
+  if (count) cm_heap_alloc(sizeof(Sdk_Gesture_Def) * count, table->defs);
+  if (!table->slots || (count && !table->defs)) goto _failure;
+  if (count) memcpy(table->defs, defs, sizeof(Sdk_Gesture_Def) * count);
+  table->def_count  = count;
+  table->mask       = slots - 1;
+  table->debounce   = sdk_ms_to_ticks(debounce_ms);
+  table->double_tap = sdk_ms_to_ticks(double_tap_ms);
+  table->hold_ms    = hold_ms;
+  for (i = 0; i < slots; i++)        table->slots[i].gesture = SDK_GESTURE_NONE;
+  for (i = 0; i < SDK_KEYS_MAX; i++) table->doubles[i]       = SDK_GESTURE_NONE;
+  for (i = 0; i < SDK_KEYS_MAX; i++) table->holds[i]         = SDK_GESTURE_NONE;
+
+  for (i = 0; i < count; i++)
+  {
+    def = &table->defs[i];
+    memset(down, 0, sizeof(down));
+    for (j = 0; j < def->count; j++) down[def->keys[j] / 64] |= 1ull << (def->keys[j] % 64);
+    switch (def->kind)
+    {
+      case SDK_GESTURE_CHORD:
+        for (j = 0; j < def->count; j++)
+        {
+          if (!sdk_gesture_insert(table, down, def->keys[j], (u16) i)) goto _failure;
+        }
+        break;
+      case SDK_GESTURE_COMBO:
+        down[def->key / 64] |= 1ull << (def->key % 64);
+        if (!sdk_gesture_insert(table, down, def->key, (u16) i)) goto _failure;
+        break;
+      case SDK_GESTURE_DOUBLE:
+        table->doubles[def->key] = (u16) i;
+        break;
+      case SDK_GESTURE_HOLD:
+        table->holds[def->key] = (u16) i;
+        break;
+    }
+  }
+  return table;
+
+_invalid:
+  printf("sdk_gestures_compile: invalid gesture %u\n", defs[i].id);
+  return NULL;
+_failure:
+  console_debug("sdk_gestures_compile failed");
+  sdk_gestures_close(table);
+  return NULL;
+}
+
+/*
+ * NOTE:
+ *      Filters the raw key bits of a report against the last published
+ *      `stable` bits, in place. Only keys that changed are looked at. An
+ *      ignored edge arms the key's settle timer on `timers` (NULL ignores
+ *      them) for when its window closes.
+ */
+static void
+sdk_gesture_debounce(Sdk_Gesture_Table *table, Sdk_Gesture_State *state, u64 *stable, u64 *raw, u64 time,
+                     Sdk_Timers *timers)
+{
+  u32           w, key;
+  u64           changed, left;
+  unsigned long low;
+
+  memcpy(state->raw, raw, sizeof(state->raw));
+  for (w = 0; w < SDK_KEY_WORDS; w++)
+  {
+    changed = stable[w] ^ raw[w];
+    while (changed)
+    {
+      _BitScanForward64(&low, changed);
+      changed &= changed - 1;
+      key = w * 64 + low;
+      if (time - state->last_edge[key] < table->debounce)
+      {
+        raw[w] ^= 1ull << low;
+        state->bounces++;
+        left = table->debounce - (time - state->last_edge[key]);
+        if (timers) sdk_timer_start(timers, &state->settles[key], (u32)(sdk_ticks_to_us(left) / 1000) + 1, 0, 0);
+        continue;
+      }
+      state->last_edge[key] = time;
+    }
+  }
+}
+
+static inline void
+sdk_gesture_emit(Sdk_Gesture_State *state, Sdk_Gesture_Def *def, u8 key, u64 time)
+{
+  Sdk_Gesture_Event *event;
+
+  if (state->count >= SDK_GESTURE_BATCH_LEN) { state->dropped++; return; }
+  event       = &state->events[state->count++];
+  event->time = time;
+  event->id   = def->id;
+  event->kind = def->kind;
+  event->key  = key;
+}
+
+/*
+ * NOTE:
+ *      Once per deck, `hold` gets the HOLD timers when they fire, `settle`
+ *      the settle timers. The `id` of both is the key.
+ */
+static void
+sdk_gesture_state_open(Sdk_Gesture_State *state, Sdk_Timer_Proc hold, Sdk_Timer_Proc settle, void *user)
+{
+  u32 key;
+
+  for (key = 0; key < SDK_KEYS_MAX; key++)
+  {
+    sdk_timer_init(&state->holds[key], hold, user, key);
+    sdk_timer_init(&state->settles[key], settle, user, key);
+  }
+}
+
+/* NOTE: Every key came up (disconnect). */
+static void
+sdk_gesture_stop_holds(Sdk_Gesture_State *state, Sdk_Timers *timers)
+{
+  u32 key;
+
+  memset(state->raw, 0, sizeof(state->raw));
+  if (!timers) return;
+  for (key = 0; key < SDK_KEYS_MAX; key++)
+  {
+    if (sdk_timer_pending(&state->holds[key]))   sdk_timer_stop(timers, &state->holds[key]);
+    if (sdk_timer_pending(&state->settles[key])) sdk_timer_stop(timers, &state->settles[key]);
+  }
+}
+
+/* NOTE: The HOLD timer of `key` fired, the key is still down. */
+static void
+sdk_gesture_held(Sdk_Gesture_Table *table, Sdk_Gesture_State *state, u8 key, u64 time)
+{
+  if (table->holds[key] != SDK_GESTURE_NONE) sdk_gesture_emit(state, &table->defs[table->holds[key]], key, time);
+}
+
+/*
+ * NOTE:
+ *      Matches the presses in `events` against `down`, the bits they
+ *      produced. HOLD timers go on `timers`, NULL ignores them.
+ */
+static void
+sdk_gesture_feed(Sdk_Gesture_Table *table, Sdk_Gesture_State *state, Sdk_Key_Event *events, u32 count, u64 *down,
+                 Sdk_Timers *timers)
+{
+  u16           g, fired[SDK_GESTURE_KEYS_MAX];
+  u32           i, j, fired_count;
+  Sdk_Key_Event *event;
+
+  fired_count = 0;
+  for (i = 0; i < count; i++)
+  {
+    event = &events[i];
+    if (timers && table->holds[event->key] != SDK_GESTURE_NONE)
+    {
+      if (event->down) sdk_timer_start(timers, &state->holds[event->key], table->hold_ms, 0, 0);
+      else             sdk_timer_stop(timers, &state->holds[event->key]);
+    }
+    if (!event->down) continue;
+    g = table->doubles[event->key];
+    if (g != SDK_GESTURE_NONE)
+    {
+      if (state->last_tap[event->key] && event->time - state->last_tap[event->key] <= table->double_tap)
+      {
+        sdk_gesture_emit(state, &table->defs[g], event->key, event->time);
+        state->last_tap[event->key] = 0;
+      }
+      else state->last_tap[event->key] = event->time;
+    }
+    g = sdk_gesture_lookup(table, down, event->key);
+    if (g == SDK_GESTURE_NONE) continue;
+    /* NOTE: Every chord key pressed in this report finds the chord, `down` is the same for all of them */
+    for (j = 0; j < fired_count && fired[j] != g; j++);
+    if (j < fired_count) continue;
+    if (fired_count < SDK_GESTURE_KEYS_MAX) fired[fired_count++] = g;
+    sdk_gesture_emit(state, &table->defs[g], event->key, event->time);
+  }
+}
+
+#endif // SDK_GESTURE_C
@@ -0,0 +1,264 @@
+#ifndef SDK_INPUT_C
+#define SDK_INPUT_C
+
+#pragma warning(push, 0)
+#include <intrin.h>
+#include <stdatomic.h>
+#pragma warning(pop)
+
+/*
+ * NOTE:
+ *      Every input report queued by the HID driver is drained in one go per
+ *      wakeup (see sdk_read_pump), diffed against the previous key states and
+ *      turned into ordered key events. The batch is dispatched once at the end.
+ *
+ *      `depth` is the driver's input ring (HidD_SetNumInputBuffers, 2..512).
+ *      When one drain pulls `depth` reports the ring was full and the driver
+ *      may have dropped the oldest ones: that is what `overflows` counts.
+ */
+#define SDK_INPUT_DEPTH_DEFAULT 64
+#define SDK_INPUT_DEPTH_MIN     2
+#define SDK_INPUT_DEPTH_MAX     512
+#define SDK_INPUT_BATCH_LEN     256
+#define SDK_KEYS_MAX            256
+#define SDK_KEY_WORDS           ((SDK_KEYS_MAX + 63) / 64)
+
+#pragma warning(disable : 4820)
+typedef struct SdkKeyEvent
+{
+  u64 time;       /* NOTE: sdk_now() ticks when the report was drained */
+  u32 seq;
+  u8  key;
+  u8  down;
+} SdkKeyEvent, Sdk_Key_Event;
+
+typedef struct SdkInput
+{
+  u32           depth;
+  u32           seq;
+  /* NOTE: Stats, only written by the thread servicing the deck, the atomic ones read by anyone */
+  u64           reports;
+  u64           batches;
+  atomic_ullong overflows;
+  atomic_ullong events_dropped;
+  u32           last_batch, max_batch;
+  /* NOTE: Current batch */
+  u32           batch_reports;
+  u32           count;
+  Sdk_Key_Event events[SDK_INPUT_BATCH_LEN];
+} SdkInput, Sdk_Input;
+
+/*
+ * NOTE:
+ *      Published key states, one writer (the thread servicing the deck) and
+ *      any number of readers. Seqlock: `seq` is odd while an update is being
+ *      written, readers copy and retry if it moved. The writer never waits on
+ *      readers and a reader only ever retries over a few words, so polling it
+ *      from a UI thread costs nothing to the I/O thread.
+ */
+typedef struct SdkKeyState
+{
+  atomic_ullong seq;
+  atomic_ullong time;                        /* NOTE: sdk_now() of the report   */
+  atomic_uint   key_count;
+  atomic_ullong bits[SDK_KEY_WORDS];
+  /* NOTE: Writer side copy, never read by other threads */
+  u64           current[SDK_KEY_WORDS];
+} SdkKeyState, Sdk_Key_State;
+
+typedef struct SdkKeySnapshot
+{
+  u64 seq;                                   /* NOTE: Number of published updates */
+  u64 time;
+  u32 key_count;
+  u64 bits[SDK_KEY_WORDS];
+} SdkKeySnapshot, Sdk_Key_Snapshot;
+#pragma warning(default : 4820)
+
+global i64 g_sdk_qpc_freq;
+
+static inline u64
+sdk_now(void)
+{
+  LARGE_INTEGER now;
+
+  QueryPerformanceCounter(&now);
+  return (u64) now.QuadPart;
+}
+
+static inline u64
+sdk_qpc_freq(void)
+{
+  LARGE_INTEGER freq;
+
+  if (!g_sdk_qpc_freq)
+  {
+    QueryPerformanceFrequency(&freq);
+    g_sdk_qpc_freq = freq.QuadPart;
+  }
+  return (u64) g_sdk_qpc_freq;
+}
+
+static inline u64
+sdk_ms_to_ticks(u64 ms)
+{
+  return (ms * sdk_qpc_freq()) / 1'000;
+}
+
+static inline u64
+sdk_ticks_to_us(u64 ticks)
+{
+  sdk_qpc_freq();
+  return (ticks / (u64) g_sdk_qpc_freq) * 1'000'000 + ((ticks % (u64) g_sdk_qpc_freq) * 1'000'000) / (u64) g_sdk_qpc_freq;
+}
+
+static inline void
+sdk_input_init(Sdk_Input *input)
+{
+  memset(input, 0, sizeof(Sdk_Input));
+  input->depth = SDK_INPUT_DEPTH_DEFAULT;
+}
+
+static inline u32
+sdk_input_clamp_depth(u32 depth)
+{
+  if (depth < SDK_INPUT_DEPTH_MIN) return SDK_INPUT_DEPTH_MIN;
+  if (depth > SDK_INPUT_DEPTH_MAX) return SDK_INPUT_DEPTH_MAX;
+  return depth;
+}
+
+static inline void
+sdk_input_batch_begin(Sdk_Input *input)
+{
+  input->batch_reports = 0;
+  input->count         = 0;
+}
+
+/*
+ * NOTE:
+ *      Appends one event per key whose state differs, lowest key first.
+ *      Returns false when nothing changed.
+ */
+static bool
+sdk_input_diff(Sdk_Input *input, u64 *previous, u64 *current, u32 words, u64 time)
+{
+  u32           w, bit;
+  u64           changed;
+  unsigned long low;
+  bool          any;
+  Sdk_Key_Event *event;
+
+  input->reports++;
+  input->batch_reports++;
+  any = false;
+  for (w = 0; w < words; w++)
+  {
+    changed = previous[w] ^ current[w];
+    any    |= changed != 0;
+    while (changed)
+    {
+      _BitScanForward64(&low, changed);
+      changed &= changed - 1;
+      bit = w * 64 + low;
+      if (input->count >= SDK_INPUT_BATCH_LEN) { atomic_fetch_add_explicit(&input->events_dropped, 1, memory_order_relaxed); continue; }
+      event       = &input->events[input->count++];
+      event->time = time;
+      event->seq  = input->seq++;
+      event->key  = (u8) bit;
+      event->down = (u8)((current[w] >> low) & 1);
+    }
+  }
+  return any;
+}
+
+static inline u32
+sdk_key_words(u32 key_count)
+{
+  return (key_count + 63) / 64;
+}
+
+/* NOTE: Writer side, publishes `bits` (key_count wide) as the new state. */
+static void
+sdk_key_state_publish(Sdk_Key_State *state, u64 *bits, u64 time)
+{
+  u32 w, words;
+  u64 seq;
+
+  words = sdk_key_words(atomic_load_explicit(&state->key_count, memory_order_relaxed));
+  seq   = atomic_load_explicit(&state->seq, memory_order_relaxed);
+  atomic_store_explicit(&state->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (w = 0; w < words; w++)
+  {
+    state->current[w] = bits[w];
+    atomic_store_explicit(&state->bits[w], bits[w], memory_order_relaxed);
+  }
+  atomic_store_explicit(&state->time, time, memory_order_relaxed);
+  atomic_store_explicit(&state->seq, seq + 2, memory_order_release);
+}
+
+/* NOTE: Writer side, all keys up. Called on attach (new key count) and disconnect. */
+static void
+sdk_key_state_reset(Sdk_Key_State *state, u32 key_count, u64 time)
+{
+  u64 zero[SDK_KEY_WORDS] = {0};
+  u64 seq;
+
+  if (key_count > SDK_KEYS_MAX) key_count = SDK_KEYS_MAX;
+  seq = atomic_load_explicit(&state->seq, memory_order_relaxed);
+  atomic_store_explicit(&state->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&state->key_count, key_count, memory_order_relaxed);
+  atomic_store_explicit(&state->seq, seq + 2, memory_order_release);
+  sdk_key_state_publish(state, zero, time);
+}
+
+/* NOTE: Any thread. Copies a consistent state, never blocks the writer. */
+static void
+sdk_key_state_read(Sdk_Key_State *state, Sdk_Key_Snapshot *snapshot)
+{
+  u32 w, words;
+  u64 begin, end;
+
+  for (;;)
+  {
+    begin = atomic_load_explicit(&state->seq, memory_order_acquire);
+    if (begin & 1) { YieldProcessor(); continue; }
+    snapshot->key_count = atomic_load_explicit(&state->key_count, memory_order_relaxed);
+    words = sdk_key_words(snapshot->key_count);
+    for (w = 0; w < words; w++) snapshot->bits[w] = atomic_load_explicit(&state->bits[w], memory_order_relaxed);
+    for (; w < SDK_KEY_WORDS; w++) snapshot->bits[w] = 0;
+    snapshot->time = atomic_load_explicit(&state->time, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    end = atomic_load_explicit(&state->seq, memory_order_relaxed);
+    if (begin == end) break;
+  }
+  snapshot->seq = begin / 2;
+}
+
+static inline bool
+sdk_key_snapshot_down(Sdk_Key_Snapshot *snapshot, u32 key)
+{
+  if (key >= snapshot->key_count) return false;
+  return (snapshot->bits[key / 64] >> (key % 64)) & 1;
+}
+
+static inline void
+sdk_input_batch_end(Sdk_Input *input)
+{
+  if (!input->batch_reports) return;
+  input->batches++;
+  input->last_batch = input->batch_reports;
+  if (input->batch_reports > input->max_batch) input->max_batch = input->batch_reports;
+  if (input->batch_reports >= input->depth)    atomic_fetch_add_explicit(&input->overflows, 1, memory_order_relaxed);
+}
+
+static void
+sdk_input_report(Sdk_Input *input, char *serial)
+{
+  printf("[%s] input: %llu reports in %llu batches, max batch %u, depth %u, %llu overflows, %llu events dropped\n",
+         serial, input->reports, input->batches, input->max_batch, input->depth,
+         atomic_load(&input->overflows), atomic_load(&input->events_dropped));
+}
+
+#endif // SDK_INPUT_C
@@ -0,0 +1,655 @@
+#ifndef SDK_IPC_C
+#define SDK_IPC_C
+
+/*
+ * NOTE:
+ *      Local control server on a named pipe, so other processes can drive
+ *      keys and hear about presses. One thread serves every client with
+ *      overlapped I/O: a slow client only fills its own output buffers (the
+ *      events it misses are counted), it never holds up the other clients
+ *      or the decks.
+ *
+ *      A message is a Sdk_Ipc_Header followed by `size` payload bytes. A
+ *      client sends one message per pipe write; the server may put several
+ *      messages in one pipe message, they are read back to back.
+ *
+ *        HELLO                            -> WELCOME (Sdk_Ipc_Welcome, Sdk_Ipc_Deck...)
+ *        CLAIM     deck key               -> OK / ERROR
+ *        RELEASE   deck key               -> OK / ERROR
+ *        IMAGE     deck key, JPEG payload -> OK / ERROR
+ *        IMAGE_SHM deck key offset length -> OK / ERROR
+ *        SUBSCRIBE flags (1 = on)         -> OK
+ *        KEY       deck key flags (1 = down), u64 time in us     server -> client
+ *        DECK      deck flags (1 = connected)                    server -> client
+ *
+ *      Each connection gets its own shared memory section (named in the
+ *      WELCOME): the client writes its images there and only sends where
+ *      they are, the server packs them straight out of the view so the bytes
+ *      never go through the pipe. Once the OK is back the client may reuse
+ *      the space.
+ *
+ *      Keys are owned: a client CLAIMs a key (taken from the profile, see
+ *      sdk_claim_key) before sending it images and its keys are released
+ *      when it goes away. The events of an owned key only go to its owner,
+ *      the others go to every subscriber. A replugged deck gets the last
+ *      image of every owned key again.
+ */
+#define SDK_IPC_PIPE        "\\\\.\\pipe\\betterdeck"
+#define SDK_IPC_CLIENTS     8
+#define SDK_IPC_MSG_MAX     (64 * 1024)
+#define SDK_IPC_OUT_LEN     (16 * 1024)
+#define SDK_IPC_SHM_SIZE    (4u << 20)
+#define SDK_IPC_EVENTS_LEN  1024
+#define SDK_IPC_NAME_LEN    64
+
+enum
+{
+  SDK_IPC_HELLO = 1,
+  SDK_IPC_WELCOME,
+  SDK_IPC_CLAIM,
+  SDK_IPC_RELEASE,
+  SDK_IPC_IMAGE,
+  SDK_IPC_IMAGE_SHM,
+  SDK_IPC_SUBSCRIBE,
+  SDK_IPC_OK,
+  SDK_IPC_ERROR,
+  SDK_IPC_KEY,
+  SDK_IPC_DECK,
+};
+
+/* NOTE: ERROR replies carry one of these in `flags` */
+enum
+{
+  SDK_IPC_ERR_MESSAGE = 1,
+  SDK_IPC_ERR_DECK,
+  SDK_IPC_ERR_KEY,
+  SDK_IPC_ERR_CLAIMED,
+  SDK_IPC_ERR_NOT_OWNER,
+  SDK_IPC_ERR_IMAGE,
+  SDK_IPC_ERR_FULL,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkIpcHeader
+{
+  u16 type;
+  u16 deck;                                  /* NOTE: Slot in the manager, stable across replugs */
+  u16 key;
+  u16 flags;
+  u32 size;                                  /* NOTE: Payload bytes after the header */
+  u32 offset;                                /* NOTE: IMAGE_SHM: image start in the section */
+  u32 length;                                /* NOTE: IMAGE_SHM: image bytes */
+} SdkIpcHeader, Sdk_Ipc_Header;
+
+typedef struct SdkIpcWelcome
+{
+  char shm[SDK_IPC_NAME_LEN];
+  u32  shm_size;
+  u32  deck_count;
+} SdkIpcWelcome, Sdk_Ipc_Welcome;
+
+typedef struct SdkIpcDeck
+{
+  char serial[SDK_SERIAL_LEN];
+  u16  pid;
+  u8   keys;
+  u8   connected;
+} SdkIpcDeck, Sdk_Ipc_Deck;
+
+typedef struct SdkIpcEvent
+{
+  u64 time;
+  u16 deck;
+  u8  key;
+  u8  down;
+} SdkIpcEvent, Sdk_Ipc_Event;
+
+typedef struct SdkIpcClient
+{
+  HANDLE     pipe;
+  OVERLAPPED read_ol;                        /* NOTE: Connect, then reads */
+  OVERLAPPED write_ol;
+  bool       listening, connected, reading, writing, subscribed;
+  HANDLE     shm;
+  char       shm_name[SDK_IPC_NAME_LEN];     /* NOTE: Of this connection, sent back in the WELCOME */
+  u8         *view;
+  u32        fill;                           /* NOTE: Output buffer being appended to */
+  u32        out_len[2];
+  u8         out[2][SDK_IPC_OUT_LEN];
+  u8         in[SDK_IPC_MSG_MAX];
+  /* NOTE: Stats */
+  u64        messages, dropped;
+} SdkIpcClient, Sdk_Ipc_Client;
+
+typedef struct SdkIpc
+{
+  Sdk_Manager    *mgr;
+  HANDLE         thread;
+  HANDLE         stop_event;
+  HANDLE         wake_event;
+  Sdk_Key_Sink   sink;
+  /* NOTE: Written by the service threads (sink) and the main thread (attach) */
+  SRWLOCK        lock;
+  u32            head, count;
+  Sdk_Ipc_Event  events[SDK_IPC_EVENTS_LEN];
+  u64            events_dropped;
+  atomic_uint    attached;                   /* NOTE: Bit per deck slot that (re)attached */
+  /* NOTE: Server thread only */
+  u32            connections;
+  u8             owner[SDK_MAX_DECKS][SDK_KEYS_MAX];   /* NOTE: Client index + 1, 0 = free */
+  Sdk_Packed     *last[SDK_MAX_DECKS][SDK_KEYS_MAX];   /* NOTE: Last image of an owned key */
+  Sdk_Ipc_Client clients[SDK_IPC_CLIENTS];
+} SdkIpc, Sdk_Ipc;
+#pragma warning(default : 4820)
+
+/* -- Deck side ---------------------------------------------------------------------- */
+
+/* NOTE: Sdk_Key_Sink_Proc, service thread: queue and wake, never waits on a client. */
+static void
+sdk_ipc_sink(Stream_Deck *sdk, Sdk_Key_Event *events, u32 count, void *user)
+{
+  u32           i;
+  Sdk_Ipc       *ipc;
+  Sdk_Ipc_Event *event;
+
+  ipc = user;
+  AcquireSRWLockExclusive(&ipc->lock);
+  for (i = 0; i < count; i++)
+  {
+    if (ipc->count >= SDK_IPC_EVENTS_LEN) { ipc->events_dropped += count - i; break; }
+    event = &ipc->events[(ipc->head + ipc->count++) % SDK_IPC_EVENTS_LEN];
+    event->time = events[i].time;
+    event->deck = (u16)(sdk - ipc->mgr->decks);
+    event->key  = events[i].key;
+    event->down = events[i].down;
+  }
+  ReleaseSRWLockExclusive(&ipc->lock);
+  SetEvent(ipc->wake_event);
+}
+
+/* NOTE: Sdk_Attach_Hook. New slots start listening, owned keys are sent again. */
+static void
+sdk_ipc_on_attach(Sdk_Manager *mgr, Stream_Deck *sdk, void *user)
+{
+  Sdk_Ipc *ipc;
+
+  ipc = user;
+  atomic_store(&sdk->key_sink, &ipc->sink);
+  atomic_fetch_or(&ipc->attached, 1u << (sdk - mgr->decks));
+  SetEvent(ipc->wake_event);
+}
+
+/* -- Clients ------------------------------------------------------------------------ */
+
+/* NOTE: Appends one message to the client's output, false (and counted) when it is full. */
+static bool
+sdk_ipc_send(Sdk_Ipc_Client *client, Sdk_Ipc_Header *header, void *payload)
+{
+  u32 len;
+  u8  *out;
+
+  if (!client->connected) return false;
+  header->size = payload ? header->size : 0;
+  len = (u32) sizeof(Sdk_Ipc_Header) + header->size;
+  if (client->out_len[client->fill] + len > SDK_IPC_OUT_LEN) { client->dropped++; return false; }
+  out = client->out[client->fill] + client->out_len[client->fill];
+  memcpy(out, header, sizeof(Sdk_Ipc_Header));
+  if (header->size) memcpy(out + sizeof(Sdk_Ipc_Header), payload, header->size);
+  client->out_len[client->fill] += len;
+  return true;
+}
+
+static void
+sdk_ipc_reply(Sdk_Ipc_Client *client, Sdk_Ipc_Header *request, u16 error)
+{
+  Sdk_Ipc_Header reply;
+
+  memset(&reply, 0, sizeof(Sdk_Ipc_Header));
+  reply.type  = error ? SDK_IPC_ERROR : SDK_IPC_OK;
+  reply.deck  = request->deck;
+  reply.key   = request->key;
+  reply.flags = error;
+  sdk_ipc_send(client, &reply, NULL);
+}
+
+static void
+sdk_ipc_disconnect(Sdk_Ipc *ipc, Sdk_Ipc_Client *client);
+
+/* NOTE: Starts writing whatever was appended, unless a write is already in flight. */
+static void
+sdk_ipc_flush(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  u32 buffer;
+
+  if (!client->connected || client->writing || !client->out_len[client->fill]) return;
+  buffer = client->fill;
+  if (WriteFile(client->pipe, client->out[buffer], client->out_len[buffer], NULL, &client->write_ol))
+  {
+    client->out_len[buffer] = 0;
+    return;
+  }
+  if (GetLastError() != ERROR_IO_PENDING) { sdk_ipc_disconnect(ipc, client); return; }
+  client->writing = true;
+  client->fill    = buffer ^ 1;
+}
+
+static void
+sdk_ipc_write_done(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  DWORD written;
+
+  client->writing = false;
+  if (!GetOverlappedResult(client->pipe, &client->write_ol, &written, FALSE)) { sdk_ipc_disconnect(ipc, client); return; }
+  client->out_len[client->fill ^ 1] = 0;
+  sdk_ipc_flush(ipc, client);
+}
+
+/* NOTE: Packs `image` for an owned key and queues it, keeping it for replugs. */
+static u16
+sdk_ipc_image(Sdk_Ipc *ipc, Stream_Deck *sdk, u16 deck, u8 key, u8 *image, u32 size)
+{
+  Sdk_Packed *packed;
+
+  if (!size) return SDK_IPC_ERR_IMAGE;
+  packed = sdk_pack_key_image(sdk, image, size, 0);
+  if (!packed) return SDK_IPC_ERR_IMAGE;
+  sdk_packed_release(ipc->last[deck][key]);
+  ipc->last[deck][key] = packed;
+  return sdk_queue_packed(sdk, key, packed) ? 0 : SDK_IPC_ERR_FULL;
+}
+
+static void
+sdk_ipc_welcome(Sdk_Ipc *ipc, Sdk_Ipc_Client *client, Sdk_Ipc_Header *request)
+{
+  u32             i, count;
+  u8              payload[sizeof(Sdk_Ipc_Welcome) + SDK_MAX_DECKS * sizeof(Sdk_Ipc_Deck)];
+  Sdk_Ipc_Header  reply;
+  Sdk_Ipc_Welcome *welcome;
+  Sdk_Ipc_Deck    *deck;
+  Stream_Deck     *sdk;
+
+  memset(payload, 0, sizeof(payload));
+  welcome = (Sdk_Ipc_Welcome*) payload;
+  memcpy(welcome->shm, client->shm_name, SDK_IPC_NAME_LEN);
+  welcome->shm_size = client->view ? SDK_IPC_SHM_SIZE : 0;
+  count = atomic_load(&ipc->mgr->count);
+  welcome->deck_count = count;
+  for (i = 0; i < count; i++)
+  {
+    sdk  = &ipc->mgr->decks[i];
+    deck = (Sdk_Ipc_Deck*)(payload + sizeof(Sdk_Ipc_Welcome)) + i;
+    memcpy(deck->serial, sdk->serial, SDK_SERIAL_LEN);
+    deck->pid       = sdk->product_id;
+    deck->keys      = sdk->total;
+    deck->connected = atomic_load(&sdk->connected);
+  }
+  memset(&reply, 0, sizeof(Sdk_Ipc_Header));
+  reply.type = SDK_IPC_WELCOME;
+  reply.deck = request->deck;
+  reply.size = (u32)(sizeof(Sdk_Ipc_Welcome) + count * sizeof(Sdk_Ipc_Deck));
+  sdk_ipc_send(client, &reply, payload);
+}
+
+static void
+sdk_ipc_message(Sdk_Ipc *ipc, Sdk_Ipc_Client *client, u32 bytes)
+{
+  u8             owner;
+  u16            error;
+  u32            index;
+  Sdk_Ipc_Header *header, bad;
+  Stream_Deck    *sdk;
+
+  index  = (u32)(client - ipc->clients);
+  header = (Sdk_Ipc_Header*) client->in;
+  client->messages++;
+  if (bytes < sizeof(Sdk_Ipc_Header) || header->size != bytes - sizeof(Sdk_Ipc_Header))
+  {
+    memset(&bad, 0, sizeof(Sdk_Ipc_Header));
+    sdk_ipc_reply(client, &bad, SDK_IPC_ERR_MESSAGE);
+    return;
+  }
+  if (header->type == SDK_IPC_HELLO)     { sdk_ipc_welcome(ipc, client, header); return; }
+  if (header->type == SDK_IPC_SUBSCRIBE) { client->subscribed = header->flags & 1; sdk_ipc_reply(client, header, 0); return; }
+
+  if (header->deck >= atomic_load(&ipc->mgr->count)) { sdk_ipc_reply(client, header, SDK_IPC_ERR_DECK); return; }
+  sdk = &ipc->mgr->decks[header->deck];
+  if (header->key >= sdk->total) { sdk_ipc_reply(client, header, SDK_IPC_ERR_KEY); return; }
+  owner = ipc->owner[header->deck][header->key];
+  error = 0;
+  switch (header->type)
+  {
+    case SDK_IPC_CLAIM:
+      if (owner == index + 1) break;
+      if (owner || !sdk_claim_key(sdk, (u8) header->key)) { error = SDK_IPC_ERR_CLAIMED; break; }
+      ipc->owner[header->deck][header->key] = (u8)(index + 1);
+      break;
+    case SDK_IPC_RELEASE:
+      if (owner != index + 1) { error = SDK_IPC_ERR_NOT_OWNER; break; }
+      ipc->owner[header->deck][header->key] = 0;
+      sdk_packed_release(ipc->last[header->deck][header->key]);
+      ipc->last[header->deck][header->key] = NULL;
+      sdk_release_key(sdk, (u8) header->key);
+      break;
+    case SDK_IPC_IMAGE:
+      if (owner != index + 1) { error = SDK_IPC_ERR_NOT_OWNER; break; }
+      error = sdk_ipc_image(ipc, sdk, header->deck, (u8) header->key, client->in + sizeof(Sdk_Ipc_Header), header->size);
+      break;
+    case SDK_IPC_IMAGE_SHM:
+      if (owner != index + 1) { error = SDK_IPC_ERR_NOT_OWNER; break; }
+      if (!client->view || header->offset > SDK_IPC_SHM_SIZE || header->length > SDK_IPC_SHM_SIZE - header->offset)
+      {
+        error = SDK_IPC_ERR_IMAGE;
+        break;
+      }
+      error = sdk_ipc_image(ipc, sdk, header->deck, (u8) header->key, client->view + header->offset, header->length);
+      break;
+    default:
+      error = SDK_IPC_ERR_MESSAGE;
+      break;
+  }
+  sdk_ipc_reply(client, header, error);
+}
+
+/* NOTE: Reads until a read is left pending, handling every message that was already there. */
+static void
+sdk_ipc_read(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  DWORD bytes;
+
+  while (client->connected)
+  {
+    if (!ReadFile(client->pipe, client->in, SDK_IPC_MSG_MAX, &bytes, &client->read_ol))
+    {
+      /* NOTE: ERROR_MORE_DATA: larger than any valid message, the client is broken */
+      if (GetLastError() == ERROR_IO_PENDING) { client->reading = true; break; }
+      sdk_ipc_disconnect(ipc, client);
+      break;
+    }
+    sdk_ipc_message(ipc, client, bytes);
+  }
+  sdk_ipc_flush(ipc, client);
+}
+
+static void
+sdk_ipc_read_done(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  DWORD bytes;
+
+  client->reading = false;
+  if (!GetOverlappedResult(client->pipe, &client->read_ol, &bytes, FALSE)) { sdk_ipc_disconnect(ipc, client); return; }
+  sdk_ipc_message(ipc, client, bytes);
+  sdk_ipc_read(ipc, client);
+}
+
+static void
+sdk_ipc_connected(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  u32 index;
+
+  index = (u32)(client - ipc->clients);
+  client->listening = false;
+  client->connected = true;
+  client->fill      = 0;
+  ipc->connections++;
+  /* NOTE: Named after the connection, the WELCOME tells the client */
+  snprintf(client->shm_name, SDK_IPC_NAME_LEN, "Local\\betterdeck-%u-%u-%u", (u32) GetCurrentProcessId(), index, ipc->connections);
+  client->shm = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, SDK_IPC_SHM_SIZE, client->shm_name);
+  if (client->shm) client->view = MapViewOfFile(client->shm, FILE_MAP_READ, 0, 0, 0);
+  if (!client->view) report_error("CreateFileMappingA");
+  sdk_ipc_read(ipc, client);
+}
+
+/* NOTE: Waits for a client on this pipe instance. */
+static void
+sdk_ipc_listen(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  u32 tries;
+
+  for (tries = 0; tries < 2; tries++)
+  {
+    if (ConnectNamedPipe(client->pipe, &client->read_ol)) { sdk_ipc_connected(ipc, client); return; }
+    switch (GetLastError())
+    {
+      case ERROR_IO_PENDING:     client->listening = true;       return;
+      case ERROR_PIPE_CONNECTED: sdk_ipc_connected(ipc, client); return;
+      /* NOTE: A client came and went before we listened */
+      case ERROR_NO_DATA:        DisconnectNamedPipe(client->pipe); break;
+      default:                   tries = 2; break;
+    }
+  }
+  report_error("ConnectNamedPipe");
+}
+
+/* NOTE: Drops the client, gives its keys back to the profiles and listens again. */
+static void
+sdk_ipc_disconnect(Sdk_Ipc *ipc, Sdk_Ipc_Client *client)
+{
+  u32   deck, key, index, count;
+  DWORD bytes;
+
+  if (!client->connected) return;
+  index = (u32)(client - ipc->clients);
+  count = atomic_load(&ipc->mgr->count);
+  for (deck = 0; deck < count; deck++)
+  {
+    for (key = 0; key < SDK_KEYS_MAX; key++)
+    {
+      if (ipc->owner[deck][key] != index + 1) continue;
+      ipc->owner[deck][key] = 0;
+      sdk_packed_release(ipc->last[deck][key]);
+      ipc->last[deck][key] = NULL;
+      sdk_release_key(&ipc->mgr->decks[deck], (u8) key);
+    }
+  }
+  CancelIoEx(client->pipe, NULL);
+  if (client->reading) GetOverlappedResult(client->pipe, &client->read_ol, &bytes, TRUE);
+  if (client->writing) GetOverlappedResult(client->pipe, &client->write_ol, &bytes, TRUE);
+  DisconnectNamedPipe(client->pipe);
+  if (client->view) UnmapViewOfFile(client->view);
+  if (client->shm)  handle_close(client->shm);
+  client->view       = NULL;
+  client->shm        = NULL;
+  client->connected  = false;
+  client->reading    = false;
+  client->writing    = false;
+  client->subscribed = false;
+  client->out_len[0] = client->out_len[1] = 0;
+  client->shm_name[0] = 0;
+  if (WaitForSingleObject(ipc->stop_event, 0) != WAIT_OBJECT_0) sdk_ipc_listen(ipc, client);
+}
+
+/* -- Server ------------------------------------------------------------------------- */
+
+static void
+sdk_ipc_broadcast(Sdk_Ipc *ipc, Sdk_Ipc_Header *header, void *payload, u8 owner)
+{
+  u32 i;
+
+  if (owner) { if (ipc->clients[owner - 1].subscribed) sdk_ipc_send(&ipc->clients[owner - 1], header, payload); return; }
+  for (i = 0; i < SDK_IPC_CLIENTS; i++)
+  {
+    if (ipc->clients[i].subscribed) sdk_ipc_send(&ipc->clients[i], header, payload);
+  }
+}
+
+/* NOTE: Forwards the key events queued by the services and the decks that came back. */
+static void
+sdk_ipc_pump(Sdk_Ipc *ipc)
+{
+  u32            i, n, attached, deck, key;
+  u64            time_us;
+  Sdk_Ipc_Event  events[64];
+  Sdk_Ipc_Header header;
+  Stream_Deck    *sdk;
+
+  attached = atomic_exchange(&ipc->attached, 0);
+  for (deck = 0; attached; deck++, attached >>= 1)
+  {
+    if (!(attached & 1)) continue;
+    sdk = &ipc->mgr->decks[deck];
+    for (key = 0; key < SDK_KEYS_MAX; key++)
+    {
+      if (ipc->last[deck][key]) sdk_queue_packed(sdk, (u8) key, ipc->last[deck][key]);
+    }
+    memset(&header, 0, sizeof(Sdk_Ipc_Header));
+    header.type  = SDK_IPC_DECK;
+    header.deck  = (u16) deck;
+    header.flags = 1;
+    sdk_ipc_broadcast(ipc, &header, NULL, 0);
+  }
+  for (;;)
+  {
+    AcquireSRWLockExclusive(&ipc->lock);
+    for (n = 0; n < sizeof(events) / sizeof(events[0]) && ipc->count; n++, ipc->count--)
+    {
+      events[n] = ipc->events[ipc->head];
+      ipc->head = (ipc->head + 1) % SDK_IPC_EVENTS_LEN;
+    }
+    ReleaseSRWLockExclusive(&ipc->lock);
+    if (!n) break;
+    for (i = 0; i < n; i++)
+    {
+      memset(&header, 0, sizeof(Sdk_Ipc_Header));
+      header.type  = SDK_IPC_KEY;
+      header.deck  = events[i].deck;
+      header.key   = events[i].key;
+      header.flags = events[i].down;
+      header.size  = sizeof(u64);
+      time_us      = sdk_ticks_to_us(events[i].time);
+      sdk_ipc_broadcast(ipc, &header, &time_us, ipc->owner[events[i].deck][events[i].key]);
+    }
+  }
+  for (i = 0; i < SDK_IPC_CLIENTS; i++) sdk_ipc_flush(ipc, &ipc->clients[i]);
+}
+
+static DWORD WINAPI
+sdk_ipc_proc(void *args)
+{
+  u8             kinds[MAXIMUM_WAIT_OBJECTS];
+  u32            i, n, ret;
+  HANDLE         handles[MAXIMUM_WAIT_OBJECTS];
+  Sdk_Ipc_Client *owners[MAXIMUM_WAIT_OBJECTS];
+  Sdk_Ipc_Client *client;
+  Sdk_Ipc        *ipc;
+
+  ipc = args;
+  for (i = 0; i < SDK_IPC_CLIENTS; i++) sdk_ipc_listen(ipc, &ipc->clients[i]);
+  for (;;)
+  {
+    n = 0;
+    handles[n++] = ipc->stop_event;
+    handles[n++] = ipc->wake_event;
+    for (i = 0; i < SDK_IPC_CLIENTS; i++)
+    {
+      client = &ipc->clients[i];
+      if (client->listening || client->reading) { owners[n] = client; kinds[n] = 0; handles[n++] = client->read_ol.hEvent; }
+      if (client->writing)                      { owners[n] = client; kinds[n] = 1; handles[n++] = client->write_ol.hEvent; }
+    }
+    ret = WaitForMultipleObjects(n, handles, FALSE, INFINITE);
+    if (ret == WAIT_OBJECT_0) break;
+    if (ret == WAIT_OBJECT_0 + 1) { sdk_ipc_pump(ipc); continue; }
+    if (ret >= WAIT_OBJECT_0 + n) { report_error("WaitForMultipleObjects"); break; }
+    client = owners[ret - WAIT_OBJECT_0];
+    if (kinds[ret - WAIT_OBJECT_0]) sdk_ipc_write_done(ipc, client);
+    else if (client->listening)     sdk_ipc_connected(ipc, client);
+    else                            sdk_ipc_read_done(ipc, client);
+  }
+  for (i = 0; i < SDK_IPC_CLIENTS; i++) sdk_ipc_disconnect(ipc, &ipc->clients[i]);
+  return EXIT_SUCCESS;
+}
+
+/* NOTE: Main thread, before the manager: the decks stop talking to it first. */
+static void
+sdk_ipc_close(Sdk_Ipc *ipc)
+{
+  u32 i, deck, key, count;
+
+  if (ipc->mgr)
+  {
+    sdk_manager_remove_attach_hook(ipc->mgr, sdk_ipc_on_attach, ipc);
+    count = atomic_load(&ipc->mgr->count);
+    for (i = 0; i < count; i++) atomic_store(&ipc->mgr->decks[i].key_sink, NULL);
+    sdk_manager_synchronize(ipc->mgr);
+  }
+  if (ipc->thread)
+  {
+    SetEvent(ipc->stop_event);
+    WaitForSingleObject(ipc->thread, INFINITE);
+    handle_close(ipc->thread);
+  }
+  for (i = 0; i < SDK_IPC_CLIENTS; i++)
+  {
+    if (ipc->clients[i].pipe && ipc->clients[i].pipe != INVALID_HANDLE_VALUE)
+    {
+      CancelIoEx(ipc->clients[i].pipe, NULL);
+      handle_close(ipc->clients[i].pipe);
+    }
+    if (ipc->clients[i].read_ol.hEvent)  handle_close(ipc->clients[i].read_ol.hEvent);
+    if (ipc->clients[i].write_ol.hEvent) handle_close(ipc->clients[i].write_ol.hEvent);
+  }
+  for (deck = 0; deck < SDK_MAX_DECKS; deck++)
+  {
+    for (key = 0; key < SDK_KEYS_MAX; key++) sdk_packed_release(ipc->last[deck][key]);
+  }
+  if (ipc->stop_event) handle_close(ipc->stop_event);
+  if (ipc->wake_event) handle_close(ipc->wake_event);
+  memset(ipc, 0, sizeof(Sdk_Ipc));
+}
+
+/* NOTE: Heap allocate it, the client buffers make it large. */
+static bool
+sdk_ipc_open(Sdk_Ipc *ipc, Sdk_Manager *mgr)
+{
+  u32            i, count;
+  DWORD          flags;
+  Sdk_Ipc_Client *client;
+
+  memset(ipc, 0, sizeof(Sdk_Ipc));
+  InitializeSRWLock(&ipc->lock);
+  ipc->sink.proc  = sdk_ipc_sink;
+  ipc->sink.user  = ipc;
+  ipc->stop_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+  ipc->wake_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  if (!ipc->stop_event || !ipc->wake_event) { report_error("CreateEvent"); goto _failure; }
+  for (i = 0; i < SDK_IPC_CLIENTS; i++)
+  {
+    client = &ipc->clients[i];
+    flags  = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (i ? 0 : FILE_FLAG_FIRST_PIPE_INSTANCE);
+    client->pipe = CreateNamedPipeA(SDK_IPC_PIPE, flags, PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                    SDK_IPC_CLIENTS, SDK_IPC_OUT_LEN, SDK_IPC_MSG_MAX, 0, NULL);
+    if (client->pipe == INVALID_HANDLE_VALUE) { client->pipe = NULL; report_error("CreateNamedPipeA"); goto _failure; }
+    client->read_ol.hEvent  = CreateEvent(NULL, TRUE, FALSE, NULL);
+    client->write_ol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!client->read_ol.hEvent || !client->write_ol.hEvent) { report_error("CreateEvent"); goto _failure; }
+  }
+  ipc->mgr = mgr;
+  if (!sdk_manager_add_attach_hook(mgr, sdk_ipc_on_attach, ipc)) goto _failure;
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++) atomic_store(&mgr->decks[i].key_sink, &ipc->sink);
+  ipc->thread = CreateThread(NULL, 0, sdk_ipc_proc, ipc, 0, NULL);
+  if (!ipc->thread) { report_error("CreateThread"); goto _failure; }
+  return true;
+
+_failure:
+  sdk_ipc_close(ipc);
+  return false;
+}
+
+static void
+sdk_ipc_report(Sdk_Ipc *ipc)
+{
+  u32            i;
+  Sdk_Ipc_Client *client;
+
+  printf("ipc: %u connections, %llu key events dropped\n", ipc->connections, ipc->events_dropped);
+  for (i = 0; i < SDK_IPC_CLIENTS; i++)
+  {
+    client = &ipc->clients[i];
+    if (client->messages || client->dropped)
+    {
+      printf("ipc: client %u: %llu messages, %llu replies/events dropped\n", i, client->messages, client->dropped);
+    }
+  }
+}
+
+#endif // SDK_IPC_C
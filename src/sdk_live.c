@@ -0,0 +1,475 @@
+#ifndef SDK_LIVE_C
+#define SDK_LIVE_C
+
+/*
+ * NOTE:
+ *      Live keys: a key bound to an image file that other tools regenerate
+ *      (status images, graphs). One thread watches the directories of every
+ *      bound file with ReadDirectoryChangesW and sleeps until something
+ *      changes, nothing is polled.
+ *
+ *      A change marks the key dirty. It is sent once the file stayed quiet
+ *      for `debounce_ms` (writers rarely produce a file in one write) and
+ *      no sooner than `interval_ms` after the previous upload of that key:
+ *      a file rewritten faster than that only shows its latest version.
+ *      The file is mapped (file_exist_open_map_ro), packed and unmapped
+ *      right away, so the writer is never kept from replacing it.
+ *
+ *      The key is claimed from the profile (sdk_claim_key) for as long as
+ *      it is bound, and sent again when its deck comes back.
+ */
+#define SDK_LIVE_MAX          64
+#define SDK_LIVE_DIRS         (MAXIMUM_WAIT_OBJECTS - 2)
+#define SDK_LIVE_DEBOUNCE_MS  50
+#define SDK_LIVE_INTERVAL_MS  100
+#define SDK_LIVE_PATH_LEN     260
+
+#pragma warning(disable : 4820)
+typedef struct SdkLiveKey
+{
+  Stream_Deck *sdk;                          /* NOTE: NULL when the slot is free */
+  u8          key;
+  char        path[SDK_LIVE_PATH_LEN];
+  wchar_t     name[SDK_LIVE_PATH_LEN];       /* NOTE: File name, as the notifications report it */
+  u32         name_len;
+  u32         dir;
+  u64         debounce, interval;            /* NOTE: sdk_now() ticks */
+  u64         changed;                       /* NOTE: Last change seen */
+  u64         sent;                          /* NOTE: Last upload queued */
+  bool        dirty;
+  u32         generation;
+  /* NOTE: Stats */
+  u64         uploads, coalesced, failures;
+} SdkLiveKey, Sdk_Live_Key;
+
+typedef struct SdkLiveDir
+{
+  char       path[SDK_LIVE_PATH_LEN];
+  HANDLE     handle;
+  OVERLAPPED ol;
+  u32        users;
+  DWORD      buffer[1024];                   /* NOTE: FILE_NOTIFY_INFORMATION, DWORD aligned */
+} SdkLiveDir, Sdk_Live_Dir;
+
+typedef struct SdkLive
+{
+  SRWLOCK      lock;                         /* NOTE: keys and dirs */
+  Sdk_Manager  *mgr;
+  HANDLE       thread;
+  HANDLE       stop_event;
+  HANDLE       wake_event;
+  Sdk_Live_Key keys[SDK_LIVE_MAX];
+  Sdk_Live_Dir dirs[SDK_LIVE_DIRS];
+} SdkLive, Sdk_Live;
+#pragma warning(default : 4820)
+
+/* NOTE: Lock held. Only the watcher thread opens and closes directory handles. */
+static u32
+sdk_live_dir(Sdk_Live *live, char *path)
+{
+  u32 i, free;
+
+  free = SDK_LIVE_DIRS;
+  for (i = 0; i < SDK_LIVE_DIRS; i++)
+  {
+    if (live->dirs[i].users && !_stricmp(live->dirs[i].path, path)) return i;
+    if (!live->dirs[i].users && !live->dirs[i].handle && free == SDK_LIVE_DIRS) free = i;
+  }
+  if (free != SDK_LIVE_DIRS) strncpy(live->dirs[free].path, path, SDK_LIVE_PATH_LEN - 1);
+  return free;
+}
+
+static bool
+sdk_live_arm(Sdk_Live_Dir *dir)
+{
+  DWORD filter;
+
+  filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+  if (!ReadDirectoryChangesW(dir->handle, dir->buffer, sizeof(dir->buffer), FALSE, filter, NULL, &dir->ol, NULL))
+  {
+    report_error("ReadDirectoryChangesW");
+    return false;
+  }
+  return true;
+}
+
+/* NOTE: Watcher thread. Opens the directories that gained a key, closes the ones that lost all. */
+static void
+sdk_live_sync_dirs(Sdk_Live *live)
+{
+  u32          i;
+  Sdk_Live_Dir *dir;
+
+  AcquireSRWLockExclusive(&live->lock);
+  for (i = 0; i < SDK_LIVE_DIRS; i++)
+  {
+    dir = &live->dirs[i];
+    if (!dir->users && dir->handle)
+    {
+      CancelIoEx(dir->handle, &dir->ol);
+      WaitForSingleObject(dir->ol.hEvent, INFINITE);
+      handle_close(dir->handle);
+      handle_close(dir->ol.hEvent);
+      memset(dir, 0, sizeof(Sdk_Live_Dir));
+    }
+    if (!dir->users || dir->handle) continue;
+    dir->handle = CreateFileA(dir->path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (dir->handle == INVALID_HANDLE_VALUE) { report_error("CreateFileA"); dir->handle = NULL; continue; }
+    dir->ol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!dir->ol.hEvent || !sdk_live_arm(dir))
+    {
+      if (dir->ol.hEvent) handle_close(dir->ol.hEvent);
+      handle_close(dir->handle);
+      dir->handle    = NULL;
+      dir->ol.hEvent = NULL;
+    }
+  }
+  ReleaseSRWLockExclusive(&live->lock);
+}
+
+/* NOTE: Lock held. Marks the keys whose file shows up in the notifications of `dir`. */
+static void
+sdk_live_changed(Sdk_Live *live, u32 dir, DWORD bytes, u64 now)
+{
+  u32                     i, offset, len;
+  Sdk_Live_Key            *key;
+  FILE_NOTIFY_INFORMATION *info;
+
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    key = &live->keys[i];
+    if (!key->sdk || key->dir != dir) continue;
+    /* NOTE: 0 bytes is an overflowed buffer, any file may have changed */
+    for (offset = 0, info = NULL; bytes; offset += info->NextEntryOffset)
+    {
+      info = (FILE_NOTIFY_INFORMATION*)((u8*) live->dirs[dir].buffer + offset);
+      len  = info->FileNameLength / sizeof(wchar_t);
+      if (CompareStringOrdinal(info->FileName, (int) len, key->name, (int) key->name_len, TRUE) == CSTR_EQUAL) break;
+      if (!info->NextEntryOffset) { info = NULL; break; }
+    }
+    if (bytes && !info) continue;
+    if (key->dirty) key->coalesced++;
+    key->dirty   = true;
+    key->changed = now;
+  }
+}
+
+/* NOTE: Watcher thread, lock not held. Quiet failures: the writer may still hold the file. */
+static bool
+sdk_live_send(Stream_Deck *sdk, u8 key, char *path)
+{
+  u32        level;
+  bool       queued;
+  Sdk_Packed *packed;
+
+  if (!atomic_load(&sdk->connected)) return true;
+  /* NOTE: Animated content, see Sdk_Link */
+  level  = sdk_link_level(sdk);
+  packed = sdk_pack_key_file(sdk, path, level);
+  if (!packed) return false;
+  queued = sdk_queue_animated(sdk, key, packed, level);
+  sdk_packed_release(packed);
+  return queued;
+}
+
+/* NOTE: Sends the keys that are due, returns how long until the next one is. */
+static u32
+sdk_live_flush(Sdk_Live *live)
+{
+  u8           key;
+  u32          i, timeout;
+  u64          now, due, wait_ms;
+  bool         sent;
+  char         path[SDK_LIVE_PATH_LEN];
+  Stream_Deck  *sdk;
+  Sdk_Live_Key *live_key;
+
+  timeout = INFINITE;
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    AcquireSRWLockExclusive(&live->lock);
+    live_key = &live->keys[i];
+    if (!live_key->sdk || !live_key->dirty) { ReleaseSRWLockExclusive(&live->lock); continue; }
+    now = sdk_now();
+    due = live_key->changed + live_key->debounce;
+    if (live_key->sent && live_key->sent + live_key->interval > due) due = live_key->sent + live_key->interval;
+    if (due > now)
+    {
+      wait_ms = sdk_ticks_to_us(due - now) / 1000 + 1;
+      if (wait_ms < timeout) timeout = (u32) wait_ms;
+      ReleaseSRWLockExclusive(&live->lock);
+      continue;
+    }
+    sdk = live_key->sdk;
+    key = live_key->key;
+    memcpy(path, live_key->path, SDK_LIVE_PATH_LEN);
+    live_key->dirty = false;
+    live_key->sent  = now;
+    ReleaseSRWLockExclusive(&live->lock);
+
+    sent = sdk_live_send(sdk, key, path);
+    AcquireSRWLockExclusive(&live->lock);
+    if (live_key->sdk == sdk && live_key->key == key)
+    {
+      if (sent) live_key->uploads++;
+      else
+      {
+        /* NOTE: Try again after another debounce period */
+        live_key->failures++;
+        live_key->dirty   = true;
+        live_key->changed = sdk_now();
+        wait_ms = sdk_ticks_to_us(live_key->debounce) / 1000 + 1;
+        if (wait_ms < timeout) timeout = (u32) wait_ms;
+      }
+    }
+    ReleaseSRWLockExclusive(&live->lock);
+  }
+  return timeout;
+}
+
+static DWORD WINAPI
+sdk_live_proc(void *args)
+{
+  u32          i, n, ret, timeout;
+  u32          dirs[SDK_LIVE_DIRS];
+  DWORD        bytes;
+  HANDLE       handles[MAXIMUM_WAIT_OBJECTS];
+  Sdk_Live     *live;
+  Sdk_Live_Dir *dir;
+
+  live    = args;
+  timeout = 0;
+  sdk_live_sync_dirs(live);
+  for (;;)
+  {
+    n = 0;
+    handles[n++] = live->stop_event;
+    handles[n++] = live->wake_event;
+    for (i = 0; i < SDK_LIVE_DIRS; i++)
+    {
+      if (!live->dirs[i].handle) continue;
+      dirs[n - 2]  = i;
+      handles[n++] = live->dirs[i].ol.hEvent;
+    }
+    ret = WaitForMultipleObjects(n, handles, FALSE, timeout);
+    if (ret == WAIT_OBJECT_0) break;
+    if (ret == WAIT_OBJECT_0 + 1) sdk_live_sync_dirs(live);
+    else if (ret >= WAIT_OBJECT_0 + 2 && ret < WAIT_OBJECT_0 + n)
+    {
+      dir = &live->dirs[dirs[ret - WAIT_OBJECT_0 - 2]];
+      AcquireSRWLockExclusive(&live->lock);
+      if (GetOverlappedResult(dir->handle, &dir->ol, &bytes, FALSE))
+      {
+        sdk_live_changed(live, dirs[ret - WAIT_OBJECT_0 - 2], bytes, sdk_now());
+      }
+      else report_error("GetOverlappedResult");
+      ResetEvent(dir->ol.hEvent);
+      sdk_live_arm(dir);
+      ReleaseSRWLockExclusive(&live->lock);
+    }
+    else if (ret != WAIT_TIMEOUT) { report_error("WaitForMultipleObjects"); break; }
+    timeout = sdk_live_flush(live);
+  }
+  return EXIT_SUCCESS;
+}
+
+/*
+ * NOTE:
+ *      Any thread. Binds `key` of `sdk` to the image file at `path` and
+ *      sends it right away. Rebinding a key to the same file only updates
+ *      its timings (0 ms picks the defaults) and `generation`, see
+ *      sdk_live_prune. False when the key is claimed by another source.
+ */
+static bool
+sdk_live_bind(Sdk_Live *live, Stream_Deck *sdk, u8 key, char *path, u32 debounce_ms, u32 interval_ms, u32 generation)
+{
+  u32          i, dir, name_len;
+  char         *name, *slash, dir_path[SDK_LIVE_PATH_LEN];
+  Sdk_Live_Key *live_key, *slot;
+
+  if (strlen(path) >= SDK_LIVE_PATH_LEN) { printf("sdk_live_bind: path too long\n"); return false; }
+  strcpy(dir_path, path);
+  slash = strrchr(dir_path, '\\');
+  if (!slash) slash = strrchr(dir_path, '/');
+  if (slash) { *slash = 0; name = path + (slash - dir_path) + 1; }
+  else       { strcpy(dir_path, "."); name = path; }
+
+  AcquireSRWLockExclusive(&live->lock);
+  slot = NULL;
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    live_key = &live->keys[i];
+    if (live_key->sdk == sdk && live_key->key == key) { slot = live_key; break; }
+    if (!live_key->sdk && !slot) slot = live_key;
+  }
+  if (!slot) { ReleaseSRWLockExclusive(&live->lock); printf("sdk_live_bind: too many live keys\n"); return false; }
+  if (slot->sdk && !_stricmp(slot->path, path))
+  {
+    slot->debounce   = sdk_ms_to_ticks(debounce_ms ? debounce_ms : SDK_LIVE_DEBOUNCE_MS);
+    slot->interval   = sdk_ms_to_ticks(interval_ms ? interval_ms : SDK_LIVE_INTERVAL_MS);
+    slot->generation = generation;
+    ReleaseSRWLockExclusive(&live->lock);
+    return true;
+  }
+  dir = sdk_live_dir(live, dir_path);
+  if (dir == SDK_LIVE_DIRS) { ReleaseSRWLockExclusive(&live->lock); printf("sdk_live_bind: too many directories\n"); return false; }
+  /* NOTE: Same key, other file: the key is already ours */
+  if (slot->sdk) live->dirs[slot->dir].users--;
+  else if (!sdk_claim_key(sdk, key))
+  {
+    ReleaseSRWLockExclusive(&live->lock);
+    printf("[%s] key %u is already claimed\n", sdk->serial, key);
+    return false;
+  }
+  memset(slot, 0, sizeof(Sdk_Live_Key));
+  strcpy(slot->path, path);
+  name_len = (u32) MultiByteToWideChar(CP_ACP, 0, name, -1, slot->name, SDK_LIVE_PATH_LEN);
+  slot->name_len   = name_len ? name_len - 1 : 0;
+  slot->sdk        = sdk;
+  slot->key        = key;
+  slot->dir        = dir;
+  slot->debounce   = sdk_ms_to_ticks(debounce_ms ? debounce_ms : SDK_LIVE_DEBOUNCE_MS);
+  slot->interval   = sdk_ms_to_ticks(interval_ms ? interval_ms : SDK_LIVE_INTERVAL_MS);
+  slot->generation = generation;
+  slot->dirty      = true;
+  live->dirs[dir].users++;
+  ReleaseSRWLockExclusive(&live->lock);
+  SetEvent(live->wake_event);
+  return true;
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_live_remove(Sdk_Live *live, Sdk_Live_Key *live_key)
+{
+  sdk_release_key(live_key->sdk, live_key->key);
+  live->dirs[live_key->dir].users--;
+  memset(live_key, 0, sizeof(Sdk_Live_Key));
+}
+
+/* NOTE: Any thread. The key goes back to the profile. */
+static void
+sdk_live_unbind(Sdk_Live *live, Stream_Deck *sdk, u8 key)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&live->lock);
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    if (live->keys[i].sdk == sdk && live->keys[i].key == key) sdk_live_remove(live, &live->keys[i]);
+  }
+  ReleaseSRWLockExclusive(&live->lock);
+  SetEvent(live->wake_event);
+}
+
+/*
+ * NOTE:
+ *      Any thread. Unbinds every key of a `generation` other than the given
+ *      one: a caller rebinding a whole set (configuration reload) bumps its
+ *      generation, rebinds, then prunes what it did not bind again.
+ *      Generation 0 is left alone.
+ */
+static void
+sdk_live_prune(Sdk_Live *live, u32 generation)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&live->lock);
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    if (live->keys[i].sdk && live->keys[i].generation && live->keys[i].generation != generation)
+    {
+      sdk_live_remove(live, &live->keys[i]);
+    }
+  }
+  ReleaseSRWLockExclusive(&live->lock);
+  SetEvent(live->wake_event);
+}
+
+/* NOTE: Sdk_Attach_Hook, the deck came back blank: its live keys are sent again. */
+static void
+sdk_live_on_attach(Sdk_Manager *mgr, Stream_Deck *sdk, void *user)
+{
+  u32      i;
+  Sdk_Live *live;
+
+  (void) mgr;
+  live = user;
+  AcquireSRWLockExclusive(&live->lock);
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    if (live->keys[i].sdk != sdk) continue;
+    live->keys[i].dirty   = true;
+    live->keys[i].changed = 0;
+    live->keys[i].sent    = 0;
+  }
+  ReleaseSRWLockExclusive(&live->lock);
+  SetEvent(live->wake_event);
+}
+
+static void
+sdk_live_close(Sdk_Live *live)
+{
+  u32 i;
+
+  if (live->thread)
+  {
+    SetEvent(live->stop_event);
+    WaitForSingleObject(live->thread, INFINITE);
+    handle_close(live->thread);
+  }
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    if (live->keys[i].sdk) sdk_live_remove(live, &live->keys[i]);
+  }
+  for (i = 0; i < SDK_LIVE_DIRS; i++)
+  {
+    if (!live->dirs[i].handle) continue;
+    CancelIoEx(live->dirs[i].handle, &live->dirs[i].ol);
+    WaitForSingleObject(live->dirs[i].ol.hEvent, INFINITE);
+    handle_close(live->dirs[i].handle);
+    handle_close(live->dirs[i].ol.hEvent);
+  }
+  if (live->stop_event) handle_close(live->stop_event);
+  if (live->wake_event) handle_close(live->wake_event);
+  if (live->mgr) sdk_manager_remove_attach_hook(live->mgr, sdk_live_on_attach, live);
+  memset(live, 0, sizeof(Sdk_Live));
+}
+
+/* NOTE: Close it before the manager, its keys point into the manager's decks. */
+static bool
+sdk_live_open(Sdk_Live *live, Sdk_Manager *mgr)
+{
+  memset(live, 0, sizeof(Sdk_Live));
+  InitializeSRWLock(&live->lock);
+  live->mgr        = mgr;
+  live->stop_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+  live->wake_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  if (!live->stop_event || !live->wake_event) { report_error("CreateEvent"); goto _failure; }
+  if (!sdk_manager_add_attach_hook(mgr, sdk_live_on_attach, live)) goto _failure;
+  live->thread = CreateThread(NULL, 0, sdk_live_proc, live, 0, NULL);
+  if (!live->thread) { report_error("CreateThread"); goto _failure; }
+  return true;
+
+_failure:
+  sdk_live_close(live);
+  return false;
+}
+
+static void
+sdk_live_report(Sdk_Live *live)
+{
+  u32          i;
+  Sdk_Live_Key *live_key;
+
+  for (i = 0; i < SDK_LIVE_MAX; i++)
+  {
+    live_key = &live->keys[i];
+    if (!live_key->sdk) continue;
+    printf("[%s] live key %u (%s): %llu uploads, %llu coalesced, %llu failed\n", live_key->sdk->serial, live_key->key,
+           live_key->path, live_key->uploads, live_key->coalesced, live_key->failures);
+  }
+}
+
+#endif // SDK_LIVE_C
@@ -0,0 +1,690 @@
+#ifndef SDK_MANAGER_C
+#define SDK_MANAGER_C
+
+#define SDK_MAX_DECKS   16
+#define SDK_ATTACH_HOOKS 4
+
+/*
+ * NOTE:
+ *      SINGLE_LOOP: one thread waits on every deck's read/write/feature events.
+ *      PER_DECK:    one thread per deck, each running the same loop on its deck.
+ *      Either way reads and writes are overlapped, so an upload in flight on
+ *      one deck never delays input from another.
+ */
+#define SDK_SERVICE_SINGLE_LOOP 0x00
+#define SDK_SERVICE_PER_DECK    0x01
+
+#pragma warning(disable : 4820)
+typedef struct ThreadArgs
+{
+  void    *args;
+  /* NOTE: Event for the thread to exit */
+  HANDLE  wait_event;
+} ThreadArgs, Thread_Args;
+
+typedef struct cmThread
+{
+  HANDLE      handle;
+  u32         id;
+  u32         padding;
+  Thread_Args args;
+} cmThread, Thread;
+
+typedef struct SdkService
+{
+  struct SdkManager *mgr;
+  Stream_Deck       *deck;        /* NOTE: NULL services every deck of the manager */
+  HANDLE            wake_event;   /* NOTE: Deck list or connection state changed   */
+  Sdk_Timers        timers;       /* NOTE: Deck timers (holds), waited on with I/O */
+  u32               first;        /* NOTE: Rotates which deck is waited on first   */
+  u64               wakeups;
+  u64               allocs;       /* NOTE: Heap allocations seen after warm-up     */
+  /* NOTE: Quiescent states, see sdk_manager_synchronize */
+  atomic_ullong     epoch;
+  atomic_bool       idle;
+} SdkService, Sdk_Service;
+
+/* NOTE: sdk_now() ticks, 0 = not reached. Per deck steps are in Stream_Deck::startup */
+typedef struct SdkStartup
+{
+  u64 launch;                     /* NOTE: sdk_manager_open                        */
+  u64 scanned;                    /* NOTE: First scan done, decks enumerated, open */
+  u64 started;                    /* NOTE: Services running, writes go out         */
+} SdkStartup, Sdk_Startup;
+
+struct SdkManager;
+/* NOTE: Main thread, a deck (re)attached. A new slot is not yet visible to the services */
+typedef void (*Sdk_Attach_Hook)(struct SdkManager *mgr, Stream_Deck *sdk, void *user);
+
+typedef struct SdkManager
+{
+  Stream_Deck  decks[SDK_MAX_DECKS];
+  atomic_uint  count;
+  u32          mode;
+  bool         running;
+  HANDLE       stop_event;
+  Sdk_Service  services[SDK_MAX_DECKS];
+  Thread       threads[SDK_MAX_DECKS];
+  u32          service_count;
+  /* NOTE: Enumeration results and property scratch, cleared on every scan */
+  Arena        scan;
+  Arena        scan_scratch;
+  Sdk_Gesture_Table *gestures;               /* owned, handed to every deck */
+  Sdk_Actions       *actions;                /* owned, handed to every deck */
+  Sdk_Attach_Hook   on_attach[SDK_ATTACH_HOOKS];
+  void              *on_attach_user[SDK_ATTACH_HOOKS];
+  HCMNOTIFICATION   device_notify;           /* NOTE: See sdk_manager_notify_devices */
+  Sdk_Startup       startup;
+} SdkManager, Sdk_Manager;
+#pragma warning(default : 4820)
+
+#define SDK_WAIT_READ    0x00
+#define SDK_WAIT_WRITE   0x01
+#define SDK_WAIT_FEATURE 0x02
+#define SDK_WAIT_TIMER   0x03
+
+static Stream_Deck*
+sdk_manager_find(Sdk_Manager *mgr, char *serial)
+{
+  u32 i, count;
+
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++)
+  {
+    if (!strcmp(mgr->decks[i].serial, serial)) return &mgr->decks[i];
+  }
+  return NULL;
+}
+
+/* NOTE: Only called from the thread servicing `sdk`. */
+static void
+sdk_disconnect(Stream_Deck *sdk)
+{
+  Sdk_Feature_Op *op;
+
+  printf("[%s] disconnected\n", sdk->serial);
+  if (sdk->queue.busy) sdk_job_drop(sdk, &sdk->queue.current);
+  sdk->queue.busy = false;
+  /* NOTE: Whoever waits on the request in flight hears it failed (a DIM frame does) */
+  op = &sdk->features.current;
+  if (sdk->features.busy && op->done) op->done(sdk, op->op, op->value, -1, op->user);
+  sdk->features.busy = false;
+  memset(sdk->feedback.pending, 0, sizeof(sdk->feedback.pending));
+  sdk_gesture_stop_holds(&sdk->gestures, atomic_load(&sdk->timers));
+  sdk_link_reset(sdk);
+  sdk_key_state_reset(&sdk->keys, sdk->total, sdk_now());
+  hid_close_device(sdk->hid);
+  sdk->hid = NULL;
+  atomic_store(&sdk->connected, false);
+}
+
+/*
+ * NOTE:
+ *      Drains every report the driver has queued: after the completed read,
+ *      ReadFile keeps completing synchronously until the driver ring is empty
+ *      (bounded by its depth, so a flooding device cannot starve the loop).
+ *      The resulting key events are dispatched once for the whole batch.
+ */
+static i32
+sdk_read_pump(Stream_Deck *sdk, bool completed)
+{
+  u32        read, drained;
+  u64        now;
+  i32        status, write_status;
+  Hid_Device *hid;
+
+  hid = sdk->hid;
+  cm_stack_mark(&read);
+  now = sdk_now();
+  sdk_input_batch_begin(&sdk->input);
+  status = HID_IO_PENDING;
+  if (completed)
+  {
+    status = hid_read_finish(hid, &read);
+    if (status == HID_IO_DONE) sdk_parse_input(sdk, hid->input.buf, read, now);
+  }
+  if (!completed || status == HID_IO_DONE)
+  {
+    for (drained = 0; drained <= sdk->input.depth; drained++)
+    {
+      status = hid_read_start(hid, hid->input, &read);
+      if (status != HID_IO_DONE) break;
+      sdk_parse_input(sdk, hid->input.buf, read, now);
+    }
+  }
+  sdk_input_batch_end(&sdk->input);
+  sdk_input_dispatch(sdk);
+  /* NOTE: Press feedback leaves right away, or right after the upload in flight */
+  if (!sdk->queue.busy && sdk_feedback_pending(sdk))
+  {
+    write_status = sdk_write_pump(sdk, false);
+    if (write_status == HID_IO_GONE || write_status == HID_IO_ERROR) return write_status;
+  }
+  return status;
+}
+
+/*
+ * NOTE:
+ *      DEBUG builds check that a warmed up service thread never touches the
+ *      heap again and stays within its stack budget, whatever mix of uploads,
+ *      reads and feature reports it is handling. An allocation stops the
+ *      process there and then: whatever led to it (a page build, a frame)
+ *      belongs on another thread.
+ */
+#define SDK_AUDIT_WARMUP    64
+#define SDK_AUDIT_STACK_MAX (16 * 1024)
+
+static void
+sdk_service_audit(Sdk_Service *svc)
+{
+  u64 allocs;
+
+  svc->wakeups++;
+  allocs = cm_alloc_thread_count();
+  if (svc->wakeups <= SDK_AUDIT_WARMUP) { svc->allocs = allocs; return; }
+  if (allocs != svc->allocs)
+  {
+    printf("sdk_service: %llu heap allocation(s) after warm-up\n", (unsigned long long)(allocs - svc->allocs));
+    EXIT_FAIL();
+  }
+  if (cm_stack_used() > SDK_AUDIT_STACK_MAX)
+  {
+    printf("sdk_service: stack use %llu over budget\n", (unsigned long long) cm_stack_used());
+  }
+}
+
+static u32
+sdk_service_proc(void *args)
+{
+  u8          kinds[MAXIMUM_WAIT_OBJECTS];
+  u32         i, k, n, count, ret, timeout;
+  i32         status;
+  HANDLE      handles[MAXIMUM_WAIT_OBJECTS];
+  Stream_Deck *owners[MAXIMUM_WAIT_OBJECTS];
+  Stream_Deck *sdk;
+  Sdk_Service *svc;
+  Thread_Args *th_args;
+
+  th_args = args;
+  svc     = th_args->args;
+  cm_stack_base(&kinds[MAXIMUM_WAIT_OBJECTS - 1]);
+  for (;;)
+  {
+    sdk_service_audit(svc);
+    n       = 0;
+    timeout = INFINITE;
+    handles[n++] = th_args->wait_event;
+    handles[n++] = svc->wake_event;
+    owners[n] = NULL; kinds[n] = SDK_WAIT_TIMER; handles[n++] = svc->timers.event;
+    count = svc->deck ? 1 : atomic_load(&svc->mgr->count);
+    for (k = 0; k < count; k++)
+    {
+      i   = (svc->first + k) % count;
+      sdk = svc->deck ? svc->deck : &svc->mgr->decks[i];
+      if (!atomic_load(&sdk->connected)) continue;
+      if (!sdk->hid->read_pending)
+      {
+        status = sdk_read_pump(sdk, false);
+        if (status == HID_IO_GONE || status == HID_IO_ERROR) { sdk_disconnect(sdk); continue; }
+      }
+      /* NOTE: The drain stopped at the driver depth, come back right away */
+      if (!sdk->hid->read_pending) timeout = 0;
+      else { owners[n] = sdk; kinds[n] = SDK_WAIT_READ; handles[n++] = sdk->hid->read_ol.hEvent; }
+      if (sdk->queue.busy)
+      {
+        owners[n] = sdk; kinds[n] = SDK_WAIT_WRITE; handles[n++] = sdk->hid->write_ol.hEvent;
+      }
+      if (sdk->features.busy)
+      {
+        owners[n] = sdk; kinds[n] = SDK_WAIT_FEATURE; handles[n++] = sdk->hid->feature_ol.hEvent;
+      }
+    }
+    svc->first++;
+
+    atomic_store(&svc->idle, true);
+    ret = WaitForMultipleObjects(n, handles, FALSE, timeout);
+    atomic_store(&svc->idle, false);
+    atomic_fetch_add(&svc->epoch, 1);
+    if (ret == WAIT_TIMEOUT) continue;
+    if (ret == WAIT_OBJECT_0) break;
+    if (ret == WAIT_OBJECT_0 + 1)
+    {
+      /* NOTE: Something was queued (or a deck came back), start idle decks */
+      for (k = 0; k < count; k++)
+      {
+        sdk = svc->deck ? svc->deck : &svc->mgr->decks[k];
+        if (!atomic_load(&sdk->connected)) continue;
+        status = sdk_write_pump(sdk, false);
+        if (status == HID_IO_GONE || status == HID_IO_ERROR) { sdk_disconnect(sdk); continue; }
+        status = sdk_feature_pump(sdk, false);
+        if (status == HID_IO_GONE) sdk_disconnect(sdk);
+      }
+      continue;
+    }
+    if (ret >= WAIT_OBJECT_0 + n) { report_error("WaitForMultipleObjects"); break; }
+
+    i   = ret - WAIT_OBJECT_0;
+    sdk = owners[i];
+    if (kinds[i] == SDK_WAIT_TIMER) { sdk_timers_run(&svc->timers); continue; }
+    switch (kinds[i])
+    {
+      case SDK_WAIT_READ:    status = sdk_read_pump(sdk, true);    break;
+      case SDK_WAIT_WRITE:   status = sdk_write_pump(sdk, true);   break;
+      case SDK_WAIT_FEATURE: status = sdk_feature_pump(sdk, true); break;
+      default:               status = HID_IO_PENDING;              break;
+    }
+    if (status == HID_IO_GONE || status == HID_IO_ERROR) sdk_disconnect(sdk);
+  }
+  return EXIT_SUCCESS;
+}
+
+static bool
+sdk_service_start(Sdk_Manager *mgr, Stream_Deck *deck)
+{
+  Thread      *th;
+  Sdk_Service *svc;
+
+  if (mgr->service_count >= SDK_MAX_DECKS) return false;
+  svc = &mgr->services[mgr->service_count];
+  th  = &mgr->threads[mgr->service_count];
+  memset(svc, 0, sizeof(Sdk_Service));
+  memset(th,  0, sizeof(Thread));
+  svc->mgr        = mgr;
+  svc->deck       = deck;
+  svc->wake_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  if (!svc->wake_event) { report_error_box("CreateEvent"); return false; }
+  if (!sdk_timers_open(&svc->timers)) { handle_close(svc->wake_event); return false; }
+
+  th->args.args       = svc;
+  th->args.wait_event = mgr->stop_event;
+  th->handle = CreateThread(NULL, 1'000'000, sdk_service_proc, &th->args, CREATE_SUSPENDED, &th->id);
+  if (!th->handle)
+  {
+    report_error_box("CreateThread");
+    handle_close(svc->wake_event);
+    sdk_timers_close(&svc->timers);
+    return false;
+  }
+  if (deck)
+  {
+    atomic_store(&deck->timers, &svc->timers);
+    atomic_store(&deck->notify, svc->wake_event);
+  }
+  else
+  {
+    for (u32 i = 0; i < atomic_load(&mgr->count); i++)
+    {
+      atomic_store(&mgr->decks[i].timers, &svc->timers);
+      atomic_store(&mgr->decks[i].notify, svc->wake_event);
+    }
+  }
+  /* NOTE: Pick up whatever was queued before the service existed */
+  SetEvent(svc->wake_event);
+  if (ResumeThread(th->handle) == (u32) -1) report_error_box("ResumeThread");
+  mgr->service_count++;
+  return true;
+}
+
+static void
+sdk_manager_wake(Sdk_Manager *mgr)
+{
+  u32 i;
+
+  for (i = 0; i < mgr->service_count; i++) SetEvent(mgr->services[i].wake_event);
+}
+
+/*
+ * NOTE:
+ *      Returns once every service went through a quiescent state (waiting,
+ *      or woken up at least once) since the call: whatever they read before
+ *      a pointer was swapped is no longer in use and can be freed.
+ *      Not from a service thread.
+ */
+static void
+sdk_manager_synchronize(Sdk_Manager *mgr)
+{
+  u32 i;
+  u64 epoch;
+
+  for (i = 0; i < mgr->service_count; i++)
+  {
+    epoch = atomic_load(&mgr->services[i].epoch);
+    while (!atomic_load(&mgr->services[i].idle) && atomic_load(&mgr->services[i].epoch) == epoch) Sleep(0);
+  }
+}
+
+static bool
+sdk_attach(Stream_Deck *sdk, Hid_Device_Info *info, Sdk_Model *model)
+{
+  u32        i;
+  Hid_Device *hid;
+
+  hid = hid_get_device(info, 20, 20);
+  if (!hid) return false;
+  sdk_init_from_model(sdk, model);
+  if (!HidD_SetNumInputBuffers(hid->h_dev, sdk->input.depth)) report_error("HidD_SetNumInputBuffers");
+  if (hid->output.size < sdk->img_rpt_len)
+  {
+    printf("[%s] unexpected output report length %u\n", sdk->serial, hid->output.size);
+    hid_close_device(hid);
+    return false;
+  }
+  sdk->hid = hid;
+  if (!sdk->startup.opened) sdk->startup.opened = sdk_now();
+  sdk_key_state_reset(&sdk->keys, sdk->total, sdk_now());
+  /* NOTE: Bound images come back on their own after a replug */
+  for (i = 0; i < SDK_KEY_WORDS; i++) sdk->feedback.pending[i] = atomic_load(&sdk->feedback.bound[i]);
+  sdk_pages_show(sdk, SDK_PAGE_NONE, true);
+  sdk_cache_clear(sdk);
+  atomic_store(&sdk->connected, true);
+  printf("[%s] %s connected\n", sdk->serial, model->name);
+  return true;
+}
+
+/* NOTE: Main thread. Hooks run in the order they were added. */
+static bool
+sdk_manager_add_attach_hook(Sdk_Manager *mgr, Sdk_Attach_Hook hook, void *user)
+{
+  u32 i;
+
+  for (i = 0; i < SDK_ATTACH_HOOKS; i++)
+  {
+    if (mgr->on_attach[i]) continue;
+    mgr->on_attach[i]      = hook;
+    mgr->on_attach_user[i] = user;
+    return true;
+  }
+  printf("sdk_manager_add_attach_hook: too many hooks\n");
+  return false;
+}
+
+static void
+sdk_manager_remove_attach_hook(Sdk_Manager *mgr, Sdk_Attach_Hook hook, void *user)
+{
+  u32 i;
+
+  for (i = 0; i < SDK_ATTACH_HOOKS; i++)
+  {
+    if (mgr->on_attach[i] != hook || mgr->on_attach_user[i] != user) continue;
+    mgr->on_attach[i]      = NULL;
+    mgr->on_attach_user[i] = NULL;
+  }
+}
+
+static void
+sdk_manager_attached(Sdk_Manager *mgr, Stream_Deck *sdk)
+{
+  u32 i;
+
+  for (i = 0; i < SDK_ATTACH_HOOKS; i++)
+  {
+    if (mgr->on_attach[i]) mgr->on_attach[i](mgr, sdk, mgr->on_attach_user[i]);
+  }
+}
+
+/*
+ * NOTE:
+ *      Opens every supported deck that is not already open. A deck that went
+ *      away and comes back lands in its old slot (matched by serial number),
+ *      so pointers handed out by sdk_manager_find stay valid across replugs.
+ *      Returns the number of decks attached by this scan.
+ */
+static u32
+sdk_manager_scan(Sdk_Manager *mgr)
+{
+  u32             count, attached;
+  char            *serial;
+  Sdk_Model       *model;
+  Stream_Deck     *sdk;
+  Hid_Device_Info *info;
+
+  attached = 0;
+  arena_clear(&mgr->scan);
+  arena_clear(&mgr->scan_scratch);
+  info = hid_enumerate(&mgr->scan, &mgr->scan_scratch, VID_ELGATO, 0);
+  for (; info; info = info->next)
+  {
+    model  = sdk_model_get(info->product_id);
+    serial = info->serial_number[0] ? info->serial_number : info->path;
+    if (!model)
+    {
+      printf("[%s] unsupported streamdeck (pid 0x%04x)\n", serial, info->product_id);
+      continue;
+    }
+    sdk = sdk_manager_find(mgr, serial);
+    if (sdk && atomic_load(&sdk->connected)) continue;
+    if (!sdk)
+    {
+      count = atomic_load(&mgr->count);
+      if (count >= SDK_MAX_DECKS) continue;
+      sdk = &mgr->decks[count];
+      memset(sdk, 0, sizeof(Stream_Deck));
+      strncpy(sdk->serial, serial, SDK_SERIAL_LEN - 1);
+      sdk->startup.launch = mgr->startup.launch;
+      sdk_queue_open(&sdk->queue);
+      sdk_features_open(&sdk->features);
+      sdk_input_init(&sdk->input);
+      sdk_gesture_state_open(&sdk->gestures, sdk_hold_fired, sdk_settle_fired, sdk);
+      sdk_link_open(sdk);
+      atomic_store(&sdk->brightness, SDK_BRIGHTNESS_UNKNOWN);
+      atomic_store(&sdk->gesture_table, mgr->gestures);
+      atomic_store(&sdk->actions, mgr->actions);
+      sdk_feedback_open(&sdk->feedback);
+      if (!sdk_attach(sdk, info, model)) { sdk_queue_close(&sdk->queue); continue; }
+      sdk_manager_attached(mgr, sdk);
+      if (mgr->running && mgr->mode == SDK_SERVICE_SINGLE_LOOP)
+      {
+        atomic_store(&sdk->timers, &mgr->services[0].timers);
+        atomic_store(&sdk->notify, mgr->services[0].wake_event);
+      }
+      atomic_store(&mgr->count, count + 1);
+      if (mgr->running && mgr->mode == SDK_SERVICE_PER_DECK) sdk_service_start(mgr, sdk);
+    }
+    else
+    {
+      if (!sdk_attach(sdk, info, model)) continue;
+      sdk_manager_attached(mgr, sdk);
+    }
+    /* NOTE: Its first page goes out now, not once every deck is open */
+    if (mgr->running) sdk_manager_wake(mgr);
+    attached++;
+  }
+  return attached;
+}
+
+/*
+ * NOTE:
+ *      Takes ownership of `table` (may be NULL) and frees the previous one
+ *      once no service can be reading it. Main thread.
+ */
+static void
+sdk_manager_set_gestures(Sdk_Manager *mgr, Sdk_Gesture_Table *table)
+{
+  u32               i, count;
+  Sdk_Gesture_Table *old;
+
+  old   = mgr->gestures;
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++) atomic_store(&mgr->decks[i].gesture_table, table);
+  mgr->gestures = table;
+  if (old == table) return;
+  sdk_manager_synchronize(mgr);
+  sdk_gestures_close(old);
+}
+
+/*
+ * NOTE:
+ *      Takes ownership of `actions` (opened, heap allocated, may be NULL).
+ *      Only while the services are stopped: closing joins the workers.
+ */
+static void
+sdk_manager_set_actions(Sdk_Manager *mgr, Sdk_Actions *actions)
+{
+  u32 i, count;
+
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++) atomic_store(&mgr->decks[i].actions, actions);
+  if (mgr->actions)
+  {
+    sdk_actions_close(mgr->actions);
+    heap_free_dz(mgr->actions);
+  }
+  mgr->actions = actions;
+}
+
+static bool
+sdk_manager_open(Sdk_Manager *mgr, u32 mode)
+{
+  memset(mgr, 0, sizeof(Sdk_Manager));
+  mgr->startup.launch = sdk_now();
+  mgr->mode       = mode;
+  mgr->stop_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (!mgr->stop_event) { report_error_box("CreateEvent"); return false; }
+  if (!arena_open(&mgr->scan, 1ull << 20) || !arena_open(&mgr->scan_scratch, 1ull << 20)) return false;
+  sdk_manager_scan(mgr);
+  mgr->startup.scanned = sdk_now();
+  /* NOTE: Not an error, decks attach on the next scan once plugged */
+  if (!atomic_load(&mgr->count)) printf("No streamdeck found, waiting for one.\n");
+  else printf("Found %u streamdeck(s) !\n", atomic_load(&mgr->count));
+  return true;
+}
+
+/* NOTE: System thread, a HID interface came or went. */
+static DWORD CALLBACK
+sdk_manager_device_notify(HCMNOTIFICATION notify, void *context, CM_NOTIFY_ACTION action, CM_NOTIFY_EVENT_DATA *data, DWORD size)
+{
+  (void) notify; (void) data; (void) size;
+  if (action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL || action == CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL)
+  {
+    SetEvent(context);
+  }
+  return ERROR_SUCCESS;
+}
+
+/*
+ * NOTE:
+ *      Signals `event` whenever a HID interface arrives or goes, the caller
+ *      then rescans. Needs no window, unlike WM_DEVICECHANGE. `event` must
+ *      outlive the manager.
+ */
+static bool
+sdk_manager_notify_devices(Sdk_Manager *mgr, HANDLE event)
+{
+  CM_NOTIFY_FILTER filter;
+
+  memset(&filter, 0, sizeof(CM_NOTIFY_FILTER));
+  filter.cbSize     = sizeof(CM_NOTIFY_FILTER);
+  filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+  HidD_GetHidGuid(&filter.u.DeviceInterface.ClassGuid);
+  if (CM_Register_Notification(&filter, event, sdk_manager_device_notify, &mgr->device_notify) != CR_SUCCESS)
+  {
+    mgr->device_notify = NULL;
+    report_error("CM_Register_Notification");
+    return false;
+  }
+  return true;
+}
+
+static bool
+sdk_manager_start(Sdk_Manager *mgr)
+{
+  u32 i, count;
+
+  mgr->running = true;
+  mgr->startup.started = sdk_now();
+  if (mgr->mode == SDK_SERVICE_SINGLE_LOOP) return sdk_service_start(mgr, NULL);
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++)
+  {
+    if (!sdk_service_start(mgr, &mgr->decks[i])) return false;
+  }
+  return true;
+}
+
+/* NOTE: Milliseconds from launch to `stamp`, 0.1 ms precision, "-" when never reached */
+static char*
+sdk_startup_ms(Sdk_Startup *startup, u64 stamp, char *buffer, u32 size)
+{
+  u64 us;
+
+  if (!stamp) { snprintf(buffer, size, "-"); return buffer; }
+  us = sdk_ticks_to_us(stamp - startup->launch);
+  snprintf(buffer, size, "%llu.%llu ms", us / 1000, us % 1000 / 100);
+  return buffer;
+}
+
+static void
+sdk_manager_startup_report(Sdk_Manager *mgr)
+{
+  u32         i, count;
+  char        a[32], b[32], c[32];
+  Stream_Deck *sdk;
+
+  printf("startup: scanned %s, services %s\n", sdk_startup_ms(&mgr->startup, mgr->startup.scanned, a, sizeof(a)),
+         sdk_startup_ms(&mgr->startup, mgr->startup.started, b, sizeof(b)));
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++)
+  {
+    sdk = &mgr->decks[i];
+    printf("[%s] startup: opened %s, first report %s, full page %s\n", sdk->serial,
+           sdk_startup_ms(&mgr->startup, sdk->startup.opened, a, sizeof(a)),
+           sdk_startup_ms(&mgr->startup, sdk->startup.first_report, b, sizeof(b)),
+           sdk_startup_ms(&mgr->startup, sdk->startup.full_page, c, sizeof(c)));
+    sdk_input_report(&sdk->input, sdk->serial);
+    sdk_link_report(sdk);
+  }
+  for (i = 0; i < mgr->service_count; i++) sdk_timers_report(&mgr->services[i].timers, "service");
+}
+
+static void
+sdk_manager_stop(Sdk_Manager *mgr)
+{
+  u32 i, ret, count;
+
+  if (!mgr->running) return;
+  if (!SetEvent(mgr->stop_event)) report_error_box("SetEvent");
+  for (i = 0; i < mgr->service_count; i++)
+  {
+    /* NOTE: Until it is really gone, its wake event, wheel and devices are freed right after */
+    ret = WaitForSingleObject(mgr->threads[i].handle, INFINITE);
+    if (ret != WAIT_OBJECT_0) report_error_box("WaitForSingleObject");
+    handle_close(mgr->threads[i].handle);
+    handle_close(mgr->services[i].wake_event);
+    sdk_timers_close(&mgr->services[i].timers);
+  }
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++) atomic_store(&mgr->decks[i].timers, NULL);
+  mgr->service_count = 0;
+  mgr->running       = false;
+}
+
+static void
+sdk_manager_close(Sdk_Manager *mgr)
+{
+  u32         i, count;
+  Stream_Deck *sdk;
+
+  if (!mgr) return;
+  /* NOTE: Waits for a callback in flight */
+  if (mgr->device_notify) CM_Unregister_Notification(mgr->device_notify);
+  sdk_manager_stop(mgr);
+  count = atomic_load(&mgr->count);
+  for (i = 0; i < count; i++)
+  {
+    sdk = &mgr->decks[i];
+    if (atomic_load(&sdk->connected)) hid_close_device(sdk->hid);
+    /* NOTE: Frames still queued complete without going to the device */
+    atomic_store(&sdk->connected, false);
+    sdk_set_profile(sdk, NULL);
+    sdk_queue_close(&sdk->queue);
+    sdk_feedback_close(&sdk->feedback);
+  }
+  if (mgr->stop_event) handle_close(mgr->stop_event);
+  sdk_gestures_close(mgr->gestures);
+  sdk_manager_set_actions(mgr, NULL);
+  arena_close(&mgr->scan);
+  arena_close(&mgr->scan_scratch);
+  memset(mgr, 0, sizeof(Sdk_Manager));
+}
+
+#endif // SDK_MANAGER_C
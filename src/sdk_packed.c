@@ -0,0 +1,171 @@
+#ifndef SDK_PACKED_C
+#define SDK_PACKED_C
+
+/*
+ * NOTE:
+ *      An image already cut into the deck's output reports, headers and all,
+ *      so uploading it is only WriteFile calls out of `reports`. The key
+ *      index is left at 0 and filled in by the write pump as each report
+ *      goes out, so one packed image serves every key showing it.
+ *      Refcounted: the write queue holds a reference while it is being sent,
+ *      whoever built it can drop theirs at any time.
+ *
+ *      Packed images with a hash are shared (sdk_packed_share): packing an
+ *      image some key, page or deck already holds gives that one back with
+ *      a new reference, and the last release takes it out of the store.
+ *      Nothing is ever copied twice for the same content.
+ */
+#define SDK_PACKED_ALIGN   64
+#define SDK_PACKED_BUCKETS 4096
+
+#pragma warning(disable : 4820)
+typedef struct SdkPacked
+{
+  atomic_uint      refs;
+  bool             shared;                   /* NOTE: In g_packed, unlinked by the last release */
+  u32              image_size;
+  u64              hash;                     /* NOTE: Identity of the content, 0 = unknown, never shared */
+  u32              report_len;
+  u32              report_count;
+  u8               *reports;                 /* NOTE: report_count * report_len, key index 0 */
+  struct SdkPacked *next;                    /* NOTE: Bucket chain of g_packed */
+} SdkPacked, Sdk_Packed;
+
+/* NOTE: Chained on hash and report length. Entries at 0 references are on their way out, never handed out again. */
+typedef struct SdkPackedStore
+{
+  SRWLOCK       lock;
+  Sdk_Packed    *buckets[SDK_PACKED_BUCKETS];
+  atomic_ullong shares, uniques;
+} SdkPackedStore, Sdk_Packed_Store;
+#pragma warning(default : 4820)
+
+global Sdk_Packed_Store g_packed;          /* NOTE: Ready zeroed, SRWLOCK_INIT is 0 */
+
+/* NOTE: FNV-1a, never 0 so 0 can mean "no image". */
+static inline u64
+sdk_image_hash(u8 *data, u32 size)
+{
+  u32 i;
+  u64 hash;
+
+  hash = 0xCBF29CE484222325ull;
+  for (i = 0; i < size; i++) hash = (hash ^ data[i]) * 0x100000001B3ull;
+  return hash ? hash : 1;
+}
+
+/* NOTE: One block, the reports follow the header. Starts with one reference. */
+static Sdk_Packed*
+sdk_packed_alloc(u32 report_len, u32 report_count)
+{
+  u64        header;
+  Sdk_Packed *packed;
+
+  packed = NULL;
+  header = (sizeof(Sdk_Packed) + SDK_PACKED_ALIGN - 1) & ~(u64)(SDK_PACKED_ALIGN - 1);
+  cm_heap_alloc(header + (u64) report_len * report_count, packed);
+  if (!packed) { report_error("sdk_packed_alloc"); return NULL; }
+  atomic_init(&packed->refs, 1);
+  packed->report_len   = report_len;
+  packed->report_count = report_count;
+  packed->reports      = (u8*) packed + header;
+  return packed;
+}
+
+static inline Sdk_Packed*
+sdk_packed_retain(Sdk_Packed *packed)
+{
+  if (packed) atomic_fetch_add_explicit(&packed->refs, 1, memory_order_relaxed);
+  return packed;
+}
+
+/* NOTE: Store lock held. A new reference unless the last one is already gone. */
+static inline bool
+sdk_packed_revive(Sdk_Packed *packed)
+{
+  u32 refs;
+
+  refs = atomic_load_explicit(&packed->refs, memory_order_relaxed);
+  while (refs && !atomic_compare_exchange_weak_explicit(&packed->refs, &refs, refs + 1, memory_order_relaxed, memory_order_relaxed)) {}
+  return refs != 0;
+}
+
+static inline Sdk_Packed**
+sdk_packed_bucket(u64 hash)
+{
+  return &g_packed.buckets[(hash ^ (hash >> 32)) & (SDK_PACKED_BUCKETS - 1)];
+}
+
+static void
+sdk_packed_release(Sdk_Packed *packed)
+{
+  Sdk_Packed **link;
+
+  if (!packed || atomic_fetch_sub_explicit(&packed->refs, 1, memory_order_acq_rel) != 1) return;
+  if (packed->shared)
+  {
+    AcquireSRWLockExclusive(&g_packed.lock);
+    for (link = sdk_packed_bucket(packed->hash); *link; link = &(*link)->next)
+    {
+      if (*link == packed) { *link = packed->next; break; }
+    }
+    ReleaseSRWLockExclusive(&g_packed.lock);
+  }
+  heap_free_dz(packed);
+}
+
+/* NOTE: Any thread. A reference on the shared image of `hash` cut in `report_len` reports, NULL when nobody holds one. */
+static Sdk_Packed*
+sdk_packed_find(u64 hash, u32 report_len)
+{
+  Sdk_Packed *packed;
+
+  if (!hash) return NULL;
+  AcquireSRWLockShared(&g_packed.lock);
+  for (packed = *sdk_packed_bucket(hash); packed; packed = packed->next)
+  {
+    if (packed->hash == hash && packed->report_len == report_len && sdk_packed_revive(packed)) break;
+  }
+  ReleaseSRWLockShared(&g_packed.lock);
+  if (packed) atomic_fetch_add_explicit(&g_packed.shares, 1, memory_order_relaxed);
+  return packed;
+}
+
+/*
+ * NOTE:
+ *      Any thread. Publishes `packed` (its hash set), or trades it for the
+ *      image published meanwhile under the same hash. Takes the caller's
+ *      reference and returns one on whichever is kept.
+ */
+static Sdk_Packed*
+sdk_packed_share(Sdk_Packed *packed)
+{
+  Sdk_Packed *other, **bucket;
+
+  if (!packed || !packed->hash) return packed;
+  bucket = sdk_packed_bucket(packed->hash);
+  AcquireSRWLockExclusive(&g_packed.lock);
+  for (other = *bucket; other; other = other->next)
+  {
+    if (other->hash == packed->hash && other->report_len == packed->report_len && sdk_packed_revive(other)) break;
+  }
+  if (!other)
+  {
+    packed->shared = true;
+    packed->next   = *bucket;
+    *bucket        = packed;
+  }
+  ReleaseSRWLockExclusive(&g_packed.lock);
+  if (!other) { atomic_fetch_add_explicit(&g_packed.uniques, 1, memory_order_relaxed); return packed; }
+  atomic_fetch_add_explicit(&g_packed.shares, 1, memory_order_relaxed);
+  sdk_packed_release(packed);
+  return other;
+}
+
+static void
+sdk_packed_report(void)
+{
+  printf("packed: %llu images packed, %llu reused\n", atomic_load(&g_packed.uniques), atomic_load(&g_packed.shares));
+}
+
+#endif // SDK_PACKED_C
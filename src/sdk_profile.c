@@ -0,0 +1,805 @@
+#ifndef SDK_PROFILE_C
+#define SDK_PROFILE_C
+
+/*
+ * NOTE:
+ *      Profiles: more keys than the deck has, split in pages. Top level pages
+ *      are siblings (NEXT / PREV cycle through them), a FOLDER key opens a
+ *      child page whose BACK key returns to the page holding the folder.
+ *      A profile is built once (sdk_profile_*), everything lives in its arena
+ *      and it is read only once handed to a deck.
+ *
+ *      Each deck keeps its pages packed (see sdk_packed.c) in a small LRU.
+ *      Packed images are shared, so an icon on many keys, pages or decks is
+ *      cut and held once, whatever the size of the profile. Showing a page
+ *      queues the cached reports of the keys whose image differs from what
+ *      is on screen, nothing else. Once a page is shown its neighbours
+ *      (siblings, folders, parent) are packed in the background on the
+ *      system thread pool, so walking the profile only costs the USB time.
+ *      The write pump measures it (Sdk_Page_Timing).
+ *      Navigation keys switch on the thread pool too, so the service thread
+ *      that read them never packs a page or sets up a frame. They switch
+ *      with the deck's transition (sdk_frame.c): the keys go out as one
+ *      frame revealed on a blank or dimmed deck, or the page slides / fades
+ *      in. Other switches (attach, release, swap) are plain.
+ *
+ *      A running deck can be handed a new profile (sdk_swap_profile): the
+ *      cached reports stay alive as donors, keys whose image did not change
+ *      find them in the shared store, and `shown` is kept, so only the keys
+ *      that really differ are re-packed and re-sent.
+ */
+#define SDK_PAGE_CACHE_LEN  8
+#define SDK_PAGE_NONE       0xFFFF
+#define SDK_PAGE_PRELOAD    8
+#define SDK_PAGE_NAVS       8                /* NOTE: Navigation presses waiting for the thread pool */
+#define SDK_PROFILE_PAGES   1024
+#define SDK_HASH_BLANK      (~0ull)
+
+enum
+{
+  SDK_NAV_NONE,
+  SDK_NAV_NEXT,
+  SDK_NAV_PREV,
+  SDK_NAV_FOLDER,
+  SDK_NAV_BACK,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkProfileKey
+{
+  u8  *image;                                /* NOTE: JPEG, NULL shows the blank key */
+  u32 image_size;
+  u8  *reports;                              /* NOTE: Compiled for the model, over `image`, not owned */
+  u32 reports_size;
+  u64 hash;                                  /* NOTE: Identity of the image, 0 = blank */
+  u16 action;                                /* NOTE: Sdk_Actions id or SDK_ACTION_UNBOUND */
+  u8  nav;
+  u16 target;                                /* NOTE: FOLDER: page it opens */
+  u8  *pressed;                              /* NOTE: Reports of the press feedback variant, NULL = none */
+  u32 pressed_size;
+  u32 pressed_image_size;
+  u64 pressed_hash;
+} SdkProfileKey, Sdk_Profile_Key;
+
+typedef struct SdkPage
+{
+  u16             parent;                    /* NOTE: SDK_PAGE_NONE for top level pages */
+  Sdk_Profile_Key *keys;                     /* NOTE: key_count entries */
+} SdkPage, Sdk_Page;
+
+typedef struct SdkProfile
+{
+  Arena    arena;
+  u32      key_count;
+  u32      page_count;
+  Sdk_Page pages[SDK_PROFILE_PAGES];
+} SdkProfile, Sdk_Profile;
+
+typedef struct SdkPageEntry
+{
+  u16        page;                           /* NOTE: SDK_PAGE_NONE when free */
+  u64        last_use;
+  Sdk_Packed **keys;                         /* NOTE: key_count, then key_count pressed variants (NULL = none), one reference each */
+} SdkPageEntry, Sdk_Page_Entry;
+
+/* NOTE: Per deck, `lock` guards everything but the preload work object. */
+typedef struct SdkDeckPages
+{
+  SRWLOCK        lock;
+  Stream_Deck    *sdk;
+  Sdk_Profile    *profile;
+  u32            key_count;
+  u16            current;
+  u64            shown[SDK_KEYS_MAX];        /* NOTE: Hash on screen, 0 = unknown */
+  u64            clock;
+  Sdk_Page_Entry entries[SDK_PAGE_CACHE_LEN];
+  u16            preload[SDK_PAGE_PRELOAD];
+  u32            preload_count;
+  PTP_WORK       work;
+  u8             navs[SDK_PAGE_NAVS];        /* NOTE: Keys pressed, oldest first, see sdk_pages_key_down */
+  u32            nav_count;
+  PTP_WORK       nav_work;
+  u32            builds;                     /* NOTE: sdk_page_build running unlocked, each reading `profile` */
+  CONDITION_VARIABLE built;
+  Sdk_Transitions transitions;
+  /* NOTE: Stats */
+  u64            hits, misses, preloads, evictions;
+} SdkDeckPages, Sdk_Deck_Pages;
+#pragma warning(default : 4820)
+
+/* -- Profile ------------------------------------------------------------------------ */
+
+static bool
+sdk_profile_open(Sdk_Profile *profile, u32 key_count)
+{
+  memset(profile, 0, sizeof(Sdk_Profile));
+  if (!key_count || key_count > SDK_KEYS_MAX) { printf("sdk_profile_open: bad key count %u\n", key_count); return false; }
+  profile->key_count = key_count;
+  return arena_open(&profile->arena, 0);
+}
+
+static void
+sdk_profile_close(Sdk_Profile *profile)
+{
+  arena_close(&profile->arena);
+  memset(profile, 0, sizeof(Sdk_Profile));
+}
+
+/* NOTE: Returns the page index, SDK_PAGE_NONE on failure. */
+static u16
+sdk_profile_add_page(Sdk_Profile *profile, u16 parent)
+{
+  u32      i;
+  Sdk_Page *page;
+
+  if (profile->page_count >= SDK_PROFILE_PAGES) { printf("sdk_profile_add_page: too many pages\n"); return SDK_PAGE_NONE; }
+  page         = &profile->pages[profile->page_count];
+  page->parent = parent;
+  page->keys   = arena_push_array(&profile->arena, Sdk_Profile_Key, profile->key_count);
+  if (!page->keys) return SDK_PAGE_NONE;
+  for (i = 0; i < profile->key_count; i++) page->keys[i].action = SDK_ACTION_UNBOUND;
+  return (u16) profile->page_count++;
+}
+
+/* NOTE: `image` is copied into the profile, NULL leaves the key blank. */
+static bool
+sdk_profile_set_key(Sdk_Profile *profile, u16 page, u8 key, u8 *image, u32 image_size, u16 action)
+{
+  Sdk_Profile_Key *def;
+
+  if (page >= profile->page_count || key >= profile->key_count) { printf("sdk_profile_set_key: bad page/key\n"); return false; }
+  def = &profile->pages[page].keys[key];
+  def->action  = action;
+  def->image   = NULL;
+  def->reports = NULL;
+  def->hash    = 0;
+  def->pressed = NULL;
+  if (!image) return true;
+  def->image = arena_push(&profile->arena, image_size);
+  if (!def->image) return false;
+  memcpy(def->image, image, image_size);
+  def->image_size = image_size;
+  def->hash       = sdk_image_hash(image, image_size);
+  return true;
+}
+
+/*
+ * NOTE:
+ *      `reports` were cut for the profile's model, by the asset compiler
+ *      (see sdk_asset_key) or sdk_fit_key_image, `image_size` bytes of JPEG.
+ *      They are not copied: the asset pack and the configuration's arena
+ *      both outlive the profile. `hash` is the Sdk_Packed hash they came
+ *      with, 0 hashes the reports.
+ */
+static bool
+sdk_profile_set_key_reports(Sdk_Profile *profile, u16 page, u8 key, u8 *reports, u32 size, u32 image_size, u64 hash, u16 action)
+{
+  Sdk_Profile_Key *def;
+
+  if (!sdk_profile_set_key(profile, page, key, NULL, 0, action)) return false;
+  def = &profile->pages[page].keys[key];
+  def->reports      = reports;
+  def->reports_size = size;
+  def->image_size   = image_size;
+  def->hash         = hash ? hash : sdk_image_hash(reports, size);
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Press feedback of a key set before: `reports` (cut for the profile's
+ *      model, not copied) show while it is down, its own image once it is
+ *      released. Only on the page it belongs to.
+ */
+static bool
+sdk_profile_set_key_pressed(Sdk_Profile *profile, u16 page, u8 key, u8 *reports, u32 size, u32 image_size, u64 hash)
+{
+  Sdk_Profile_Key *def;
+
+  if (page >= profile->page_count || key >= profile->key_count) { printf("sdk_profile_set_key_pressed: bad page/key\n"); return false; }
+  def = &profile->pages[page].keys[key];
+  def->pressed            = reports;
+  def->pressed_size       = size;
+  def->pressed_image_size = image_size;
+  def->pressed_hash       = hash ? hash : sdk_image_hash(reports, size);
+  return true;
+}
+
+/* NOTE: FOLDER needs `target`, a page whose parent is `page`. */
+static bool
+sdk_profile_set_nav(Sdk_Profile *profile, u16 page, u8 key, u8 nav, u16 target)
+{
+  if (page >= profile->page_count || key >= profile->key_count) { printf("sdk_profile_set_nav: bad page/key\n"); return false; }
+  if (nav == SDK_NAV_FOLDER && (target >= profile->page_count || profile->pages[target].parent != page))
+  {
+    printf("sdk_profile_set_nav: page %u is not a folder of page %u\n", target, page);
+    return false;
+  }
+  profile->pages[page].keys[key].nav    = nav;
+  profile->pages[page].keys[key].target = target;
+  return true;
+}
+
+/* NOTE: Next (or previous) page sharing the parent of `page`, wrapping around. */
+static u16
+sdk_profile_sibling(Sdk_Profile *profile, u16 page, i32 step)
+{
+  u32 i, n, candidate;
+
+  n = profile->page_count;
+  for (i = 1; i < n; i++)
+  {
+    candidate = (u32)((i32) page + step * (i32) i + (i32) n * (i32) n) % n;
+    if (profile->pages[candidate].parent == profile->pages[page].parent) return (u16) candidate;
+  }
+  return page;
+}
+
+/* -- Page cache --------------------------------------------------------------------- */
+
+static inline u64
+sdk_page_key_hash(Sdk_Profile *profile, u16 page, u32 key)
+{
+  u64 hash;
+
+  hash = profile->pages[page].keys[key].hash;
+  return hash ? hash : SDK_HASH_BLANK;
+}
+
+/* NOTE: Lets go of what sdk_page_build returned. */
+static void
+sdk_page_keys_free(Sdk_Deck_Pages *pages, Sdk_Packed **keys)
+{
+  u32 i;
+
+  if (!keys) return;
+  for (i = 0; i < pages->key_count * 2; i++) sdk_packed_release(keys[i]);
+  heap_free_dz(keys);
+}
+
+static void
+sdk_page_entry_release(Sdk_Deck_Pages *pages, Sdk_Page_Entry *entry)
+{
+  sdk_page_keys_free(pages, entry->keys);
+  entry->keys = NULL;
+  entry->page = SDK_PAGE_NONE;
+}
+
+/*
+ * NOTE:
+ *      Packs every key of `page`, no lock held. Images some key of any page
+ *      or deck already holds are shared (sdk_packed_find), only the others
+ *      are cut. NULL on failure.
+ */
+static Sdk_Packed**
+sdk_page_build(Sdk_Deck_Pages *pages, Sdk_Profile *profile, u16 page)
+{
+  u32             i;
+  Sdk_Packed      **keys;
+  Sdk_Profile_Key *def;
+  Stream_Deck     *sdk;
+
+  sdk  = pages->sdk;
+  keys = NULL;
+  cm_heap_alloc(sizeof(Sdk_Packed*) * pages->key_count * 2, keys);
+  if (!keys) return NULL;
+  for (i = 0; i < pages->key_count; i++)
+  {
+    def = &profile->pages[page].keys[i];
+    if (def->reports)    keys[i] = sdk_pack_key_reports(sdk, def->reports, def->reports_size, def->image_size, def->hash);
+    else if (def->image) keys[i] = sdk_pack_key_image(sdk, def->image, def->image_size, def->hash);
+    else                 keys[i] = sdk_pack_key_image(sdk, sdk->blank_key, sdk->blank_key_size, 0);
+    if (def->pressed)
+    {
+      keys[pages->key_count + i] = sdk_pack_key_reports(sdk, def->pressed, def->pressed_size, def->pressed_image_size,
+                                                        def->pressed_hash);
+    }
+    if (!keys[i] || (def->pressed && !keys[pages->key_count + i]))
+    {
+      sdk_page_keys_free(pages, keys);
+      return NULL;
+    }
+  }
+  return keys;
+}
+
+/*
+ * NOTE:
+ *      Lock held on entry and on return. sdk_page_build of `profile`, the
+ *      current one, with the lock dropped meanwhile; sdk_swap_profile waits
+ *      for these before it hands the old profile back to be closed.
+ */
+static Sdk_Packed**
+sdk_page_build_unlocked(Sdk_Deck_Pages *pages, Sdk_Profile *profile, u16 page)
+{
+  Sdk_Packed **keys;
+
+  pages->builds++;
+  ReleaseSRWLockExclusive(&pages->lock);
+  keys = sdk_page_build(pages, profile, page);
+  AcquireSRWLockExclusive(&pages->lock);
+  if (!--pages->builds) WakeAllConditionVariable(&pages->built);
+  return keys;
+}
+
+static Sdk_Page_Entry*
+sdk_page_find(Sdk_Deck_Pages *pages, u16 page)
+{
+  u32 i;
+
+  for (i = 0; i < SDK_PAGE_CACHE_LEN; i++)
+  {
+    if (pages->entries[i].page == page) return &pages->entries[i];
+  }
+  return NULL;
+}
+
+/* NOTE: Lock held. Takes `keys`, evicting the least recently used page but the current one. */
+static Sdk_Page_Entry*
+sdk_page_insert(Sdk_Deck_Pages *pages, u16 page, Sdk_Packed **keys)
+{
+  u32            i;
+  Sdk_Page_Entry *entry, *victim;
+
+  victim = NULL;
+  for (i = 0; i < SDK_PAGE_CACHE_LEN; i++)
+  {
+    entry = &pages->entries[i];
+    if (entry->page == SDK_PAGE_NONE) { victim = entry; break; }
+    if (entry->page == pages->current) continue;
+    if (!victim || entry->last_use < victim->last_use) victim = entry;
+  }
+  if (victim->page != SDK_PAGE_NONE) pages->evictions++;
+  sdk_page_entry_release(pages, victim);
+  victim->page     = page;
+  victim->keys     = keys;
+  victim->last_use = ++pages->clock;
+  return victim;
+}
+
+static void CALLBACK
+sdk_page_preload_proc(PTP_CALLBACK_INSTANCE instance, void *context, PTP_WORK work)
+{
+  u16            page;
+  Sdk_Packed     **keys;
+  Sdk_Profile    *profile;
+  Sdk_Deck_Pages *pages;
+
+  (void) instance; (void) work;
+  pages = context;
+  for (;;)
+  {
+    AcquireSRWLockExclusive(&pages->lock);
+    if (!pages->preload_count) { ReleaseSRWLockExclusive(&pages->lock); break; }
+    page    = pages->preload[--pages->preload_count];
+    profile = pages->profile;
+    keys    = sdk_page_build_unlocked(pages, profile, page);
+    if (keys && pages->profile == profile && !sdk_page_find(pages, page))
+    {
+      sdk_page_insert(pages, page, keys);
+      pages->preloads++;
+      keys = NULL;
+    }
+    ReleaseSRWLockExclusive(&pages->lock);
+    sdk_page_keys_free(pages, keys);
+  }
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_page_want(Sdk_Deck_Pages *pages, u16 page)
+{
+  u32 i;
+
+  if (page == SDK_PAGE_NONE || page == pages->current || sdk_page_find(pages, page)) return;
+  for (i = 0; i < pages->preload_count; i++) if (pages->preload[i] == page) return;
+  if (pages->preload_count < SDK_PAGE_PRELOAD) pages->preload[pages->preload_count++] = page;
+}
+
+/* NOTE: Lock held. Siblings, folders and the parent of the current page. */
+static void
+sdk_page_preload_neighbours(Sdk_Deck_Pages *pages)
+{
+  u32             i;
+  Sdk_Page        *page;
+  Sdk_Profile_Key *def;
+
+  page = &pages->profile->pages[pages->current];
+  sdk_page_want(pages, sdk_profile_sibling(pages->profile, pages->current, 1));
+  sdk_page_want(pages, sdk_profile_sibling(pages->profile, pages->current, -1));
+  sdk_page_want(pages, page->parent);
+  for (i = 0; i < pages->key_count; i++)
+  {
+    def = &page->keys[i];
+    if (def->nav == SDK_NAV_FOLDER) sdk_page_want(pages, def->target);
+  }
+  if (pages->preload_count) SubmitThreadpoolWork(pages->work);
+}
+
+/* -- Deck side ---------------------------------------------------------------------- */
+
+static inline bool
+sdk_key_owned(Stream_Deck *sdk, u32 key)
+{
+  return (atomic_load(&sdk->owned[key / 64]) >> (key % 64)) & 1;
+}
+
+/*
+ * NOTE:
+ *      Lock held. Hands the keys of `page` to `transition`, each from what
+ *      is on screen: the key itself when it already shows the new image,
+ *      `before` (the page being left) where it still shows, black when
+ *      nothing is known. A fade leaves the keys that do not change alone, a
+ *      slide moves them too. False when it cannot start, `transition` is
+ *      gone either way.
+ */
+static bool
+sdk_pages_transition(Sdk_Deck_Pages *pages, Sdk_Transition *transition, Sdk_Page_Entry *before, u16 previous,
+                     Sdk_Page_Entry *entry, u16 page)
+{
+  u32         i;
+  u64         stamp;
+  Sdk_Packed  *from;
+  Stream_Deck *sdk;
+
+  sdk = pages->sdk;
+  for (i = 0; i < pages->key_count; i++)
+  {
+    if (sdk_key_owned(sdk, i)) continue;
+    from = NULL;
+    if (pages->shown[i] == sdk_page_key_hash(pages->profile, page, i)) from = entry->keys[i];
+    else if (before && pages->shown[i] == sdk_page_key_hash(pages->profile, previous, i)) from = before->keys[i];
+    if (transition->kind == SDK_TRANSITION_FADE && from == entry->keys[i]) continue;
+    sdk_transition_key(transition, (u8) i, from, entry->keys[i]);
+  }
+  if (!sdk_transitions_prepare(&pages->transitions, transition)) { sdk_transition_put(transition); return false; }
+  for (i = 0; i < pages->key_count; i++)
+  {
+    if (sdk_key_owned(sdk, i)) pages->shown[i] = 0;
+  }
+  for (i = 0; i < transition->count; i++)
+  {
+    pages->shown[transition->keys[i]] = sdk_page_key_hash(pages->profile, page, transition->keys[i]);
+  }
+  stamp = sdk_now();
+  atomic_store(&sdk->page_timing.left, transition->count);
+  atomic_store(&sdk->page_timing.start, stamp);
+  sdk_transitions_run(&pages->transitions, transition, stamp);
+  return true;
+}
+
+/*
+ * NOTE:
+ *      Any thread, never blocks on the device. Queues the keys of `page`
+ *      that differ from the screen (all of them with `force`) and stamps
+ *      them so the write pump can time the switch. `nav` is the navigation
+ *      that led there, SDK_NAV_NONE switches plainly, the others with the
+ *      deck's transition.
+ */
+static bool
+sdk_pages_switch(Stream_Deck *sdk, u16 page, bool force, u8 nav)
+{
+  u32            i, differ, kind;
+  u16            previous;
+  u64            stamp, hash;
+  bool           hit;
+  Sdk_Packed     **keys;
+  Sdk_Profile    *profile;
+  Sdk_Page_Entry *entry, *before;
+  Sdk_Deck_Pages *pages;
+  Sdk_Frame      *frame;
+  Sdk_Transition *transition;
+  Sdk_Write_Job  job;
+
+  pages = sdk->pages;
+  if (!pages) return false;
+  AcquireSRWLockExclusive(&pages->lock);
+  if (page == SDK_PAGE_NONE) page = pages->current;
+  profile = pages->profile;
+  if (page >= profile->page_count) { ReleaseSRWLockExclusive(&pages->lock); return false; }
+  /* NOTE: The one still running left the screen somewhere between two pages, all of it goes out */
+  if (sdk_transitions_cancel(&pages->transitions, sdk) || force) memset(pages->shown, 0, sizeof(pages->shown));
+  entry = sdk_page_find(pages, page);
+  hit   = entry != NULL;
+  if (!entry)
+  {
+    keys = sdk_page_build_unlocked(pages, profile, page);
+    if (!keys) { ReleaseSRWLockExclusive(&pages->lock); return false; }
+    /* NOTE: Swapped meanwhile, whoever swapped shows the new profile */
+    if (pages->profile != profile)
+    {
+      ReleaseSRWLockExclusive(&pages->lock);
+      sdk_page_keys_free(pages, keys);
+      return false;
+    }
+    entry = sdk_page_find(pages, page);
+    if (!entry) entry = sdk_page_insert(pages, page, keys);
+    else sdk_page_keys_free(pages, keys);
+  }
+  if (hit) pages->hits++;
+  else     pages->misses++;
+  entry->last_use = ++pages->clock;
+  previous        = pages->current;
+  before          = (previous != page) ? sdk_page_find(pages, previous) : NULL;
+  pages->current  = page;
+
+  kind = (nav != SDK_NAV_NONE && !force) ? atomic_load(&sdk->transition) : SDK_TRANSITION_NONE;
+  if (kind == SDK_TRANSITION_SLIDE || kind == SDK_TRANSITION_FADE)
+  {
+    transition = sdk_transition_begin(sdk, (u8) kind, (nav == SDK_NAV_PREV || nav == SDK_NAV_BACK) ? -1 : 1);
+    if (transition && sdk_pages_transition(pages, transition, before, previous, entry, page)) goto _shown;
+  }
+  frame = NULL;
+  if (kind == SDK_TRANSITION_BLANK || kind == SDK_TRANSITION_DIM)
+  {
+    frame = sdk_frame_begin(sdk, (kind == SDK_TRANSITION_BLANK) ? SDK_FRAME_BLANK : SDK_FRAME_DIM);
+  }
+
+  for (i = 0, differ = 0; i < pages->key_count; i++)
+  {
+    if (pages->shown[i] != sdk_page_key_hash(pages->profile, page, i) && !sdk_key_owned(sdk, i)) differ++;
+  }
+  stamp = sdk_now();
+  atomic_store(&sdk->page_timing.left, differ);
+  atomic_store(&sdk->page_timing.start, differ ? stamp : 0);
+  for (i = 0; i < pages->key_count; i++)
+  {
+    hash = sdk_page_key_hash(pages->profile, page, i);
+    if (pages->shown[i] == hash) continue;
+    /* NOTE: Claimed by someone else, redrawn once released */
+    if (sdk_key_owned(sdk, i)) { pages->shown[i] = 0; continue; }
+    if (frame)
+    {
+      sdk_frame_set(frame, (u8) i, entry->keys[i]);
+      pages->shown[i] = hash;
+      continue;
+    }
+    memset(&job, 0, sizeof(Sdk_Write_Job));
+    job.key    = (u8) i;
+    job.size   = entry->keys[i]->image_size;
+    job.packed = sdk_packed_retain(entry->keys[i]);
+    job.stamp  = stamp;
+    if (!sdk_queue_push(sdk, &job)) { sdk_packed_release(job.packed); pages->shown[i] = 0; continue; }
+    pages->shown[i] = hash;
+  }
+  if (frame)
+  {
+    frame->stamp = stamp;
+    sdk_frame_present(frame, NULL, NULL);
+  }
+_shown:
+  /* NOTE: Press feedback follows the page, claimed keys keep whatever their owner bound */
+  for (i = 0; i < pages->key_count; i++)
+  {
+    if (!sdk_key_owned(sdk, i)) sdk_feedback_bind(sdk, (u8) i, entry->keys[i], entry->keys[pages->key_count + i]);
+  }
+  sdk_page_preload_neighbours(pages);
+  ReleaseSRWLockExclusive(&pages->lock);
+  return true;
+}
+
+/* NOTE: Any thread. sdk_pages_switch without a transition. */
+static inline bool
+sdk_pages_show(Stream_Deck *sdk, u16 page, bool force)
+{
+  return sdk_pages_switch(sdk, page, force, SDK_NAV_NONE);
+}
+
+/* NOTE: The page `key` of the current page leads to, SDK_PAGE_NONE when it is not a navigation key. */
+static u16
+sdk_pages_target(Sdk_Profile *profile, u16 current, u8 key, u8 *nav)
+{
+  Sdk_Profile_Key *def;
+
+  def  = &profile->pages[current].keys[key];
+  *nav = def->nav;
+  switch (def->nav)
+  {
+    case SDK_NAV_NEXT:   return sdk_profile_sibling(profile, current, 1);
+    case SDK_NAV_PREV:   return sdk_profile_sibling(profile, current, -1);
+    case SDK_NAV_FOLDER: return def->target;
+    case SDK_NAV_BACK:   return profile->pages[current].parent;
+    default:             return SDK_PAGE_NONE;
+  }
+}
+
+/*
+ * NOTE:
+ *      Thread pool. Switches for the navigation keys pressed, in order, each
+ *      from the page the previous one led to.
+ */
+static void CALLBACK
+sdk_pages_nav_proc(PTP_CALLBACK_INSTANCE instance, void *context, PTP_WORK work)
+{
+  u8             key, nav;
+  u16            target, current;
+  Sdk_Deck_Pages *pages;
+
+  (void) instance; (void) work;
+  pages = context;
+  for (;;)
+  {
+    AcquireSRWLockExclusive(&pages->lock);
+    if (!pages->nav_count) { ReleaseSRWLockExclusive(&pages->lock); break; }
+    key = pages->navs[0];
+    memmove(pages->navs, pages->navs + 1, --pages->nav_count);
+    current = pages->current;
+    target  = sdk_pages_target(pages->profile, current, key, &nav);
+    ReleaseSRWLockExclusive(&pages->lock);
+    if (target != SDK_PAGE_NONE && target != current) sdk_pages_switch(pages->sdk, target, false, nav);
+  }
+}
+
+/*
+ * NOTE:
+ *      Service thread. Navigation keys are handed to the thread pool, the
+ *      others trigger their action.
+ */
+static void
+sdk_pages_key_down(Stream_Deck *sdk, Sdk_Actions *actions, u8 key, u64 time)
+{
+  u8             nav;
+  u16            action;
+  bool           queued;
+  Sdk_Deck_Pages *pages;
+
+  pages = sdk->pages;
+  if (key >= pages->key_count) return;
+  /* NOTE: The profile may be swapped by another thread, only read it locked */
+  AcquireSRWLockExclusive(&pages->lock);
+  sdk_pages_target(pages->profile, pages->current, key, &nav);
+  action = pages->profile->pages[pages->current].keys[key].action;
+  queued = false;
+  if (nav != SDK_NAV_NONE && pages->nav_count < SDK_PAGE_NAVS)
+  {
+    pages->navs[pages->nav_count++] = key;
+    queued = true;
+  }
+  ReleaseSRWLockExclusive(&pages->lock);
+  if (nav != SDK_NAV_NONE) { if (queued) SubmitThreadpoolWork(pages->nav_work); return; }
+  if (actions) sdk_action_trigger(actions, action, key, time);
+}
+
+/*
+ * NOTE:
+ *      Attaches `profile` (NULL detaches) to the deck and shows its first
+ *      page. The profile has to outlive the deck or the next call.
+ *      Only while the services are stopped, or for a deck they cannot see
+ *      yet; a running deck goes through sdk_swap_profile.
+ */
+static bool
+sdk_set_profile(Stream_Deck *sdk, Sdk_Profile *profile)
+{
+  u32            i;
+  Sdk_Deck_Pages *pages;
+
+  pages = sdk->pages;
+  if (pages)
+  {
+    WaitForThreadpoolWorkCallbacks(pages->nav_work, TRUE);
+    CloseThreadpoolWork(pages->nav_work);
+    sdk_transitions_close(&pages->transitions, sdk);
+    WaitForThreadpoolWorkCallbacks(pages->work, TRUE);
+    CloseThreadpoolWork(pages->work);
+    for (i = 0; i < SDK_PAGE_CACHE_LEN; i++) sdk_page_entry_release(pages, &pages->entries[i]);
+    heap_free_dz(pages);
+    sdk->pages = NULL;
+  }
+  if (!profile) return true;
+  if (profile->key_count != sdk->total || !profile->page_count)
+  {
+    printf("[%s] profile made for %u keys, deck has %u\n", sdk->serial, profile->key_count, sdk->total);
+    return false;
+  }
+  pages = NULL;
+  cm_heap_alloc(sizeof(Sdk_Deck_Pages), pages);
+  if (!pages) return false;
+  InitializeSRWLock(&pages->lock);
+  InitializeConditionVariable(&pages->built);
+  pages->sdk       = sdk;
+  pages->profile   = profile;
+  pages->key_count = profile->key_count;
+  for (i = 0; i < SDK_PAGE_CACHE_LEN; i++) pages->entries[i].page = SDK_PAGE_NONE;
+  sdk_transitions_open(&pages->transitions, &pages->lock);
+  pages->work     = CreateThreadpoolWork(sdk_page_preload_proc, pages, NULL);
+  pages->nav_work = CreateThreadpoolWork(sdk_pages_nav_proc, pages, NULL);
+  if (!pages->work || !pages->nav_work)
+  {
+    report_error("CreateThreadpoolWork");
+    if (pages->work) CloseThreadpoolWork(pages->work);
+    if (pages->nav_work) CloseThreadpoolWork(pages->nav_work);
+    heap_free_dz(pages);
+    return false;
+  }
+  sdk->pages = pages;
+  return sdk_pages_show(sdk, 0, true);
+}
+
+/*
+ * NOTE:
+ *      Replaces the profile of a deck that already has one, services running.
+ *      Stays on the same page when the new profile still has it. Cached
+ *      pages are dropped but their reports are kept as donors, and only the
+ *      keys whose image changed are queued.
+ *      Returns the previous profile once no page of it is being built
+ *      anymore; the service threads may still read it, free it only after
+ *      sdk_manager_synchronize.
+ */
+static Sdk_Profile*
+sdk_swap_profile(Stream_Deck *sdk, Sdk_Profile *profile)
+{
+  u32            i;
+  Sdk_Profile    *old;
+  Sdk_Deck_Pages *pages;
+
+  pages = sdk->pages;
+  if (!pages) { sdk_set_profile(sdk, profile); return NULL; }
+  if (profile->key_count != pages->key_count || !profile->page_count)
+  {
+    printf("[%s] profile made for %u keys, deck has %u\n", sdk->serial, profile->key_count, pages->key_count);
+    return NULL;
+  }
+  /* NOTE: Preloads and navigation presses in flight read the old profile, let them finish */
+  AcquireSRWLockExclusive(&pages->lock);
+  pages->preload_count = 0;
+  ReleaseSRWLockExclusive(&pages->lock);
+  WaitForThreadpoolWorkCallbacks(pages->work, TRUE);
+  WaitForThreadpoolWorkCallbacks(pages->nav_work, TRUE);
+
+  AcquireSRWLockExclusive(&pages->lock);
+  old            = pages->profile;
+  pages->profile = profile;
+  if (pages->current >= profile->page_count) pages->current = 0;
+  for (i = 0; i < SDK_PAGE_CACHE_LEN; i++) pages->entries[i].page = SDK_PAGE_NONE;
+  /* NOTE: Any other switch (key release, live source) may still be packing from it */
+  while (pages->builds) SleepConditionVariableSRW(&pages->built, &pages->lock, INFINITE, 0);
+  ReleaseSRWLockExclusive(&pages->lock);
+  sdk_pages_show(sdk, SDK_PAGE_NONE, false);
+  return old;
+}
+
+/*
+ * NOTE:
+ *      Any thread. Takes `key` away from the profile for a source of its own
+ *      (live file, IPC client): page switches leave it alone until it is
+ *      released. False when the key is already claimed.
+ */
+static bool
+sdk_claim_key(Stream_Deck *sdk, u8 key)
+{
+  u64 bit;
+
+  if (key >= sdk->total) return false;
+  bit = 1ull << (key % 64);
+  if (atomic_fetch_or(&sdk->owned[key / 64], bit) & bit) return false;
+  /* NOTE: The page's press feedback would draw over the new owner */
+  sdk_feedback_bind(sdk, key, NULL, NULL);
+  return true;
+}
+
+/* NOTE: Any thread. Gives `key` back, the current page draws it again. */
+static void
+sdk_release_key(Stream_Deck *sdk, u8 key)
+{
+  if (key >= sdk->total) return;
+  atomic_fetch_and(&sdk->owned[key / 64], ~(1ull << (key % 64)));
+  sdk_pages_show(sdk, SDK_PAGE_NONE, false);
+}
+
+static void
+sdk_pages_report(Stream_Deck *sdk)
+{
+  u64             switches;
+  Sdk_Deck_Pages  *pages;
+  Sdk_Page_Timing *timing;
+
+  pages  = sdk->pages;
+  timing = &sdk->page_timing;
+  if (!pages) return;
+  switches = timing->switches;
+  printf("[%s] pages: %llu hits, %llu misses, %llu preloaded, %llu evicted; switch avg %llu us last %llu us max %llu us\n",
+         sdk->serial, pages->hits, pages->misses, pages->preloads, pages->evictions,
+         switches ? timing->total_us / switches : 0, timing->last_us, timing->max_us);
+}
+
+#endif // SDK_PROFILE_C
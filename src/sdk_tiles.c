@@ -0,0 +1,259 @@
+#ifndef SDK_TILES_C
+#define SDK_TILES_C
+
+/*
+ * NOTE:
+ *      Tile cache: key images derived at run time (fitted to a model,
+ *      pressed variants, composed layers) kept on disk already cut into output reports, so
+ *      the next start maps yesterday's work back instead of decoding and
+ *      encoding every key again. One file of fixed size, mapped read/write:
+ *
+ *        Sdk_Tile_Header
+ *        Sdk_Tile_Slot[SDK_TILE_SLOTS]      open addressing on the tile key,
+ *                                            linear probing, key 0 = empty
+ *        ring                               SDK_TILE_RING bytes of records
+ *
+ *      A tile key hashes the source bytes, the model and every parameter of
+ *      the transform (sdk_tile_key): a changed source or setting is simply a
+ *      miss. Records are appended to the ring and the oldest are overwritten
+ *      once it wraps, so the file never grows and a slot whose record was
+ *      overwritten is a miss (and free to reuse). A record carries its key
+ *      and the hash of its reports, checked on every hit: a write torn by a
+ *      crash only loses that tile. Hits come back as shared packed images
+ *      (see sdk_packed.c), a tile some key already shows is not copied.
+ */
+#define SDK_TILE_MAGIC    0x43544442         /* NOTE: "BDTC" */
+#define SDK_TILE_VERSION  2                  /* NOTE: Bump when the encoder output changes */
+#define SDK_TILE_SLOTS    32768
+#define SDK_TILE_RING     (32ull << 20)
+#define SDK_TILE_ALIGN    64
+#define SDK_TILE_FILE     "betterdeck.tiles"
+#define SDK_TILE_ENV      "BETTERDECK_TILES"
+
+/* NOTE: Transforms, part of the tile key */
+enum
+{
+  SDK_TILE_FIT = 1,                          /* NOTE: Resized to the key size, rotated for the model */
+  SDK_TILE_PRESSED,                          /* NOTE: Press feedback variant, see sdk_bind_key_image */
+  SDK_TILE_COMPOSE,                          /* NOTE: Layers, see sdk_compose_key */
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkTileHeader
+{
+  u32 magic;
+  u32 version;
+  u32 slot_count;
+  u32 reserved;
+  u64 ring_size;
+  u64 written;                               /* NOTE: Bytes ever appended, ring offset = written % ring_size */
+} SdkTileHeader, Sdk_Tile_Header;
+
+typedef struct SdkTileSlot
+{
+  u64 key;
+  u64 position;                              /* NOTE: Value of `written` when the record went in */
+} SdkTileSlot, Sdk_Tile_Slot;
+
+typedef struct SdkTileRecord
+{
+  u64 key;
+  u64 hash;                                  /* NOTE: Sdk_Packed hash, identity of the content */
+  u64 check;                                 /* NOTE: sdk_image_hash of the reports */
+  u32 size;                                  /* NOTE: Bytes of reports following the record */
+  u32 image_size;
+  u32 report_len;
+  u32 reserved;
+} SdkTileRecord, Sdk_Tile_Record;
+
+/* NOTE: Hashed whole into the tile key, zero what is unused */
+typedef struct SdkTileParams
+{
+  u64 source;                                /* NOTE: sdk_image_hash of the source image */
+  u32 version;
+  u16 pid, pxl;
+  u8  op, rotation, quality, scale, brightness;
+  u8  pad[7];
+} SdkTileParams, Sdk_Tile_Params;
+
+typedef struct SdkTiles
+{
+  SRWLOCK         lock;
+  HANDLE          file, map;
+  u8              *view;                     /* NOTE: NULL without a cache */
+  Sdk_Tile_Header *header;
+  Sdk_Tile_Slot   *slots;
+  u8              *ring;
+  /* NOTE: Stats */
+  u64             hits, misses, stored;
+} SdkTiles, Sdk_Tiles;
+#pragma warning(default : 4820)
+
+global Sdk_Tiles g_tiles;
+
+static inline u64
+sdk_tile_key(Sdk_Tile_Params *params)
+{
+  params->version = SDK_TILE_VERSION;
+  return sdk_image_hash((u8*) params, sizeof(Sdk_Tile_Params));
+}
+
+/*
+ * NOTE:
+ *      `path` NULL uses %BETTERDECK_TILES% or betterdeck.tiles next to the
+ *      executable. Created the first time, started over when it does not
+ *      match this build. Without it every tile is simply derived again.
+ */
+static bool
+sdk_tiles_open(Sdk_Tiles *tiles, char *path)
+{
+  u64  size;
+  char buffer[MAX_PATH];
+
+  memset(tiles, 0, sizeof(Sdk_Tiles));
+  InitializeSRWLock(&tiles->lock);
+  if (!path)
+  {
+    path = buffer;
+    if (!sdk_app_file(buffer, SDK_TILE_ENV, SDK_TILE_FILE)) return false;
+  }
+  size = sizeof(Sdk_Tile_Header) + SDK_TILE_SLOTS * sizeof(Sdk_Tile_Slot) + SDK_TILE_RING;
+  tiles->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (tiles->file == INVALID_HANDLE_VALUE) { tiles->file = NULL; printf("tiles: cannot open %s\n", path); return false; }
+  /* NOTE: Grows a new or smaller file to `size` */
+  tiles->map = CreateFileMappingA(tiles->file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD) size, NULL);
+  if (tiles->map) tiles->view = MapViewOfFile(tiles->map, FILE_MAP_WRITE, 0, 0, (size_t) size);
+  if (!tiles->view)
+  {
+    report_error("CreateFileMappingA");
+    if (tiles->map) handle_close(tiles->map);
+    handle_close(tiles->file);
+    memset(tiles, 0, sizeof(Sdk_Tiles));
+    return false;
+  }
+  tiles->header = (Sdk_Tile_Header*) tiles->view;
+  tiles->slots  = (Sdk_Tile_Slot*)(tiles->header + 1);
+  tiles->ring   = (u8*)(tiles->slots + SDK_TILE_SLOTS);
+  if (tiles->header->magic != SDK_TILE_MAGIC || tiles->header->version != SDK_TILE_VERSION
+      || tiles->header->slot_count != SDK_TILE_SLOTS || tiles->header->ring_size != SDK_TILE_RING)
+  {
+    memset(tiles->slots, 0, SDK_TILE_SLOTS * sizeof(Sdk_Tile_Slot));
+    tiles->header->written    = 0;
+    tiles->header->slot_count = SDK_TILE_SLOTS;
+    tiles->header->ring_size  = SDK_TILE_RING;
+    tiles->header->version    = SDK_TILE_VERSION;
+    tiles->header->magic      = SDK_TILE_MAGIC;
+    printf("tiles: new cache at %s\n", path);
+  }
+  return true;
+}
+
+static void
+sdk_tiles_close(Sdk_Tiles *tiles)
+{
+  if (tiles->view)
+  {
+    UnmapViewOfFile(tiles->view);
+    handle_close(tiles->map);
+    handle_close(tiles->file);
+  }
+  memset(tiles, 0, sizeof(Sdk_Tiles));
+}
+
+/* NOTE: Lock held. The record of `slot` when the ring still holds it whole. */
+static Sdk_Tile_Record*
+sdk_tiles_record(Sdk_Tiles *tiles, Sdk_Tile_Slot *slot)
+{
+  Sdk_Tile_Record *record;
+
+  if (tiles->header->written - slot->position > SDK_TILE_RING) return NULL;
+  record = (Sdk_Tile_Record*)(tiles->ring + slot->position % SDK_TILE_RING);
+  if (record->key != slot->key || record->size > SDK_TILE_RING - slot->position % SDK_TILE_RING - sizeof(Sdk_Tile_Record)) return NULL;
+  return record;
+}
+
+/* NOTE: Any thread. The packed image of `tile`, NULL on a miss or when its reports are not `report_len` long. */
+static Sdk_Packed*
+sdk_tiles_find(Sdk_Tiles *tiles, u64 tile, u32 report_len)
+{
+  u32             i, slot;
+  Sdk_Packed      *packed;
+  Sdk_Tile_Record *record;
+
+  if (!tiles->view) return NULL;
+  packed = NULL;
+  AcquireSRWLockExclusive(&tiles->lock);
+  for (i = 0, slot = (u32) tile & (SDK_TILE_SLOTS - 1); i < SDK_TILE_SLOTS; i++, slot = (slot + 1) & (SDK_TILE_SLOTS - 1))
+  {
+    if (!tiles->slots[slot].key) break;
+    if (tiles->slots[slot].key != tile) continue;
+    record = sdk_tiles_record(tiles, &tiles->slots[slot]);
+    if (!record || record->report_len != report_len || !record->size || record->size % report_len) break;
+    packed = sdk_packed_find(record->hash, report_len);
+    if (packed) break;
+    if (sdk_image_hash((u8*)(record + 1), record->size) != record->check) break;
+    packed = sdk_packed_alloc(report_len, record->size / report_len);
+    if (!packed) break;
+    packed->hash       = record->hash;
+    packed->image_size = record->image_size;
+    memcpy(packed->reports, record + 1, record->size);
+    break;
+  }
+  if (packed) tiles->hits++;
+  else        tiles->misses++;
+  ReleaseSRWLockExclusive(&tiles->lock);
+  /* NOTE: Copied out of the ring, publish it */
+  return (packed && !packed->shared) ? sdk_packed_share(packed) : packed;
+}
+
+/* NOTE: Any thread. Appends the reports of `packed` as `tile`, overwriting the oldest records. */
+static void
+sdk_tiles_store(Sdk_Tiles *tiles, u64 tile, Sdk_Packed *packed)
+{
+  u32             i, slot, size;
+  u64             record_size, offset;
+  Sdk_Tile_Slot   *target, *stale;
+  Sdk_Tile_Record *record;
+
+  if (!tiles->view || !packed) return;
+  size        = packed->report_len * packed->report_count;
+  record_size = (sizeof(Sdk_Tile_Record) + size + SDK_TILE_ALIGN - 1) & ~(u64)(SDK_TILE_ALIGN - 1);
+  if (record_size > SDK_TILE_RING / 4) return;
+  AcquireSRWLockExclusive(&tiles->lock);
+  target = stale = NULL;
+  for (i = 0, slot = (u32) tile & (SDK_TILE_SLOTS - 1); i < SDK_TILE_SLOTS; i++, slot = (slot + 1) & (SDK_TILE_SLOTS - 1))
+  {
+    if (!tiles->slots[slot].key || tiles->slots[slot].key == tile) { target = &tiles->slots[slot]; break; }
+    if (!stale && !sdk_tiles_record(tiles, &tiles->slots[slot])) stale = &tiles->slots[slot];
+  }
+  /* NOTE: Reuse the first overwritten one on the way rather than lengthen the chain */
+  if (stale && (!target || !target->key)) target = stale;
+  if (!target) { ReleaseSRWLockExclusive(&tiles->lock); return; }
+
+  /* NOTE: Records never wrap, skip to the start of the ring */
+  offset = tiles->header->written % SDK_TILE_RING;
+  if (offset + record_size > SDK_TILE_RING) tiles->header->written += SDK_TILE_RING - offset;
+  record             = (Sdk_Tile_Record*)(tiles->ring + tiles->header->written % SDK_TILE_RING);
+  record->key        = tile;
+  record->size       = size;
+  record->image_size = packed->image_size;
+  record->report_len = packed->report_len;
+  record->hash       = packed->hash;
+  memcpy(record + 1, packed->reports, size);
+  record->check      = sdk_image_hash((u8*)(record + 1), size);
+  target->position   = tiles->header->written;
+  target->key        = tile;
+  tiles->header->written += record_size;
+  tiles->stored++;
+  ReleaseSRWLockExclusive(&tiles->lock);
+}
+
+static void
+sdk_tiles_report(Sdk_Tiles *tiles)
+{
+  if (!tiles->view) return;
+  printf("tiles: %llu hits, %llu misses, %llu stored, %llu MB written\n",
+         tiles->hits, tiles->misses, tiles->stored, tiles->header->written >> 20);
+}
+
+#endif // SDK_TILES_C
@@ -0,0 +1,432 @@
+#ifndef SDK_TIMER_C
+#define SDK_TIMER_C
+
+/*
+ * NOTE:
+ *      Hierarchical timer wheel, one per event loop (service threads,
+ *      widgets). SDK_TIMER_LEVELS levels of 64 slots, 1 ms apart on level 0,
+ *      64 ms on level 1 and so on. A timer sits on the level of the highest
+ *      6 bits where its deadline differs from the wheel's `now`, in the slot
+ *      those bits name. Every timer of a level is due before any timer of
+ *      the level above, and within a level the slots are in deadline order:
+ *      the nearest deadline is the first occupied slot of the lowest
+ *      occupied level (a bit scan).
+ *      Deadlines differing from `now` above the top level (a multiple of
+ *      2^30 ms crossed, ~12 days of uptime) go on the top level too: it is
+ *      cyclic, the slots behind `now`'s are the next round, and they are
+ *      collected once `now` wraps around to them.
+ *
+ *      Timers are intrusive (Sdk_Timer lives in its owner), in doubly linked
+ *      slot lists: starting and stopping are O(1) and never allocate, which
+ *      the service threads rely on. Advancing the wheel only moves the slots
+ *      it went past, each timer moves down at most once per level.
+ *
+ *      The loop owning the wheel waits on `event`, a high resolution
+ *      waitable timer armed for the nearest wakeup, then calls
+ *      sdk_timers_run. A timer with `slack` may fire that much late: the
+ *      wakeup is pushed to the earliest deadline + slack of the first slot,
+ *      never past the start of the next occupied one, so timers close
+ *      together share it. Nothing scheduled, nothing armed: the loop sleeps.
+ *
+ *      Any thread may start and stop timers, callbacks run on the loop's
+ *      thread without the wheel's lock.
+ */
+#define SDK_TIMER_LEVELS    5
+#define SDK_TIMER_BITS      6
+#define SDK_TIMER_SLOTS     (1 << SDK_TIMER_BITS)
+#define SDK_TIMER_MAX_MS    (1ull << (SDK_TIMER_LEVELS * SDK_TIMER_BITS - 1))  /* NOTE: ~6 days, longer delays are cut */
+#define SDK_TIMER_EXPIRED   0xFFFF           /* NOTE: Sdk_Timer::slot on the expired list */
+
+struct SdkTimers;
+struct SdkTimer;
+/* NOTE: Loop thread, wheel lock not held. `now` in wheel ms. */
+typedef void (*Sdk_Timer_Proc)(struct SdkTimers *timers, struct SdkTimer *timer, u64 now);
+
+#pragma warning(disable : 4820)
+typedef struct SdkTimer
+{
+  struct SdkTimer *prev, *next;
+  u64             deadline;                  /* NOTE: Wheel ms, 0 = not armed */
+  u32             period;                    /* NOTE: ms, 0 = one shot */
+  u32             slack;                     /* NOTE: ms it may fire late */
+  u16             slot;                      /* NOTE: level * SDK_TIMER_SLOTS + index */
+  u32             id;                        /* NOTE: For the owner */
+  void            *user;
+  Sdk_Timer_Proc  proc;
+} SdkTimer, Sdk_Timer;
+
+typedef struct SdkTimers
+{
+  SRWLOCK   lock;
+  HANDLE    event;                           /* NOTE: Waitable timer, signaled at the next wakeup */
+  u64       now;                             /* NOTE: Wheel ms the slots are laid out from */
+  u64       armed;                           /* NOTE: Wheel ms `event` is set for, 0 = none */
+  u64       occupied[SDK_TIMER_LEVELS];      /* NOTE: Bit per non empty slot */
+  Sdk_Timer *slots[SDK_TIMER_LEVELS][SDK_TIMER_SLOTS];
+  Sdk_Timer *expired;                        /* NOTE: Due, waiting for their callback */
+  u32       count;
+  /* NOTE: Stats */
+  u64       fired, wakeups, empty_wakeups, cascaded;
+} SdkTimers, Sdk_Timers;
+#pragma warning(default : 4820)
+
+/* NOTE: Milliseconds on the sdk_now() clock. */
+static inline u64
+sdk_timers_ms(void)
+{
+  return sdk_ticks_to_us(sdk_now()) / 1000;
+}
+
+static inline void
+sdk_timer_init(Sdk_Timer *timer, Sdk_Timer_Proc proc, void *user, u32 id)
+{
+  memset(timer, 0, sizeof(Sdk_Timer));
+  timer->proc = proc;
+  timer->user = user;
+  timer->id   = id;
+}
+
+static inline bool
+sdk_timer_pending(Sdk_Timer *timer)
+{
+  return timer->deadline != 0;
+}
+
+/* NOTE: Lock held. */
+static inline Sdk_Timer**
+sdk_timers_head(Sdk_Timers *timers, u16 slot)
+{
+  if (slot == SDK_TIMER_EXPIRED) return &timers->expired;
+  return &timers->slots[slot / SDK_TIMER_SLOTS][slot % SDK_TIMER_SLOTS];
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_timers_unlink(Sdk_Timers *timers, Sdk_Timer *timer)
+{
+  Sdk_Timer **head;
+
+  head = sdk_timers_head(timers, timer->slot);
+  if (timer->prev) timer->prev->next = timer->next;
+  else             *head             = timer->next;
+  if (timer->next) timer->next->prev = timer->prev;
+  if (!*head && timer->slot != SDK_TIMER_EXPIRED)
+  {
+    timers->occupied[timer->slot / SDK_TIMER_SLOTS] &= ~(1ull << (timer->slot % SDK_TIMER_SLOTS));
+  }
+  timer->prev = timer->next = NULL;
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_timers_link(Sdk_Timers *timers, Sdk_Timer *timer, u16 slot)
+{
+  Sdk_Timer **head;
+
+  head        = sdk_timers_head(timers, slot);
+  timer->slot = slot;
+  timer->prev = NULL;
+  timer->next = *head;
+  if (*head) (*head)->prev = timer;
+  *head = timer;
+  if (slot != SDK_TIMER_EXPIRED) timers->occupied[slot / SDK_TIMER_SLOTS] |= 1ull << (slot % SDK_TIMER_SLOTS);
+}
+
+/* NOTE: Lock held. Into the slot of its deadline from `now`, a deadline already reached is expired. */
+static void
+sdk_timers_place(Sdk_Timers *timers, Sdk_Timer *timer)
+{
+  u32           level;
+  u64           diff;
+  unsigned long high;
+
+  if (timer->deadline <= timers->now) { sdk_timers_link(timers, timer, SDK_TIMER_EXPIRED); return; }
+  diff = timer->deadline ^ timers->now;
+  _BitScanReverse64(&high, diff);
+  level = high / SDK_TIMER_BITS;
+  /* NOTE: Within SDK_TIMER_MAX_MS, the next round of the top level */
+  if (level >= SDK_TIMER_LEVELS) level = SDK_TIMER_LEVELS - 1;
+  sdk_timers_link(timers, timer, (u16)(level * SDK_TIMER_SLOTS + ((timer->deadline >> (level * SDK_TIMER_BITS)) & (SDK_TIMER_SLOTS - 1))));
+}
+
+/* NOTE: First bit of `bits` after `digit`, wrapping around (only the top level has any behind). */
+static inline void
+sdk_timers_first(u64 bits, u32 digit, unsigned long *index)
+{
+  u64 ahead;
+
+  ahead = bits & ~((2ull << digit) - 1);
+  _BitScanForward64(index, ahead ? ahead : bits);
+}
+
+/* NOTE: Lock held. Wheel ms slot `index` of `level` starts at, a slot behind `now`'s is the next round. */
+static inline u64
+sdk_timers_slot_start(Sdk_Timers *timers, u32 level, u32 index)
+{
+  u32 shift, digit;
+  u64 base;
+
+  shift = level * SDK_TIMER_BITS;
+  digit = (u32)(timers->now >> shift) & (SDK_TIMER_SLOTS - 1);
+  base  = timers->now >> (shift + SDK_TIMER_BITS) << (shift + SDK_TIMER_BITS);
+  if (index <= digit) base += 1ull << (shift + SDK_TIMER_BITS);
+  return base | ((u64) index << shift);
+}
+
+/*
+ * NOTE:
+ *      Lock held. Wheel ms of the next wakeup, 0 when nothing is scheduled:
+ *      the earliest deadline, pushed up to the slack of its slot's timers
+ *      but not past the start of the next occupied slot.
+ */
+static u64
+sdk_timers_next(Sdk_Timers *timers)
+{
+  u32           level, upper;
+  u64           wake, earliest, bits, limit;
+  unsigned long index, next;
+  Sdk_Timer     *timer;
+
+  if (timers->expired) return timers->now;
+  for (level = 0; level < SDK_TIMER_LEVELS && !timers->occupied[level]; level++) {}
+  if (level == SDK_TIMER_LEVELS) return 0;
+  sdk_timers_first(timers->occupied[level], (u32)(timers->now >> (level * SDK_TIMER_BITS)) & (SDK_TIMER_SLOTS - 1), &index);
+  earliest = wake = 0;
+  for (timer = timers->slots[level][index]; timer; timer = timer->next)
+  {
+    if (!earliest || timer->deadline < earliest)          earliest = timer->deadline;
+    if (!wake || timer->deadline + timer->slack < wake)   wake     = timer->deadline + timer->slack;
+  }
+  /* NOTE: Start of the next occupied slot, this level then the ones above */
+  limit = 0;
+  for (upper = level; upper < SDK_TIMER_LEVELS; upper++)
+  {
+    bits = upper == level ? timers->occupied[level] & ~(1ull << index) : timers->occupied[upper];
+    if (!bits) continue;
+    sdk_timers_first(bits, (u32)(timers->now >> (upper * SDK_TIMER_BITS)) & (SDK_TIMER_SLOTS - 1), &next);
+    limit = sdk_timers_slot_start(timers, upper, next);
+    break;
+  }
+  if (limit && wake > limit) wake = limit > earliest ? limit : earliest;
+  return wake;
+}
+
+/* NOTE: Lock held. Sets `event` for the next wakeup when it moved. */
+static void
+sdk_timers_arm(Sdk_Timers *timers)
+{
+  u64           wake, now_us;
+  LARGE_INTEGER due;
+
+  wake = sdk_timers_next(timers);
+  if (wake == timers->armed) return;
+  timers->armed = wake;
+  if (!wake) { CancelWaitableTimer(timers->event); return; }
+  /* NOTE: Relative, in 100 ns */
+  now_us       = sdk_ticks_to_us(sdk_now());
+  due.QuadPart = wake * 1000 > now_us ? -(i64)((wake * 1000 - now_us) * 10) : -1;
+  if (!SetWaitableTimer(timers->event, &due, 0, NULL, NULL, FALSE)) report_error("SetWaitableTimer");
+}
+
+static void sdk_timers_advance(Sdk_Timers *timers, u64 to);
+
+/*
+ * NOTE:
+ *      Any thread. (Re)starts `timer` to fire at `deadline` (wheel ms, see
+ *      sdk_timers_ms), then every `period_ms` when not 0. It may fire up to
+ *      `slack_ms` late to share a wakeup.
+ */
+static void
+sdk_timer_start_at(Sdk_Timers *timers, Sdk_Timer *timer, u64 deadline, u32 period_ms, u32 slack_ms)
+{
+  u64 now;
+
+  AcquireSRWLockExclusive(&timers->lock);
+  if (timer->deadline) sdk_timers_unlink(timers, timer);
+  else                 timers->count++;
+  /* NOTE: The wheel only moves when the loop wakes up, an idle one is behind: the clamp and the slot go from the clock */
+  now = sdk_timers_ms();
+  if (now > timers->now) sdk_timers_advance(timers, now);
+  if (!deadline) deadline = 1;
+  if (deadline > timers->now + SDK_TIMER_MAX_MS) deadline = timers->now + SDK_TIMER_MAX_MS;
+  timer->deadline = deadline;
+  timer->period   = period_ms;
+  timer->slack    = slack_ms;
+  sdk_timers_place(timers, timer);
+  /* NOTE: Advancing may have made others due */
+  if (!timers->armed || deadline < timers->armed || timers->expired) sdk_timers_arm(timers);
+  ReleaseSRWLockExclusive(&timers->lock);
+}
+
+/* NOTE: Any thread. `delay_ms` from now. */
+static inline void
+sdk_timer_start(Sdk_Timers *timers, Sdk_Timer *timer, u32 delay_ms, u32 period_ms, u32 slack_ms)
+{
+  sdk_timer_start_at(timers, timer, sdk_timers_ms() + delay_ms, period_ms, slack_ms);
+}
+
+/* NOTE: Any thread. A callback already running is not waited for. */
+static void
+sdk_timer_stop(Sdk_Timers *timers, Sdk_Timer *timer)
+{
+  u64 deadline;
+
+  AcquireSRWLockExclusive(&timers->lock);
+  deadline = timer->deadline;
+  if (deadline)
+  {
+    sdk_timers_unlink(timers, timer);
+    timer->deadline = 0;
+    timers->count--;
+    /* NOTE: It may have been what the wakeup was set for */
+    if (deadline <= timers->armed) sdk_timers_arm(timers);
+  }
+  ReleaseSRWLockExclusive(&timers->lock);
+}
+
+/* NOTE: Lock held. Moves `now` to `to`, the timers due land on the expired list. */
+static void
+sdk_timers_advance(Sdk_Timers *timers, u64 to)
+{
+  u32           level, shift, old_digit, new_digit;
+  u64           bits;
+  unsigned long index;
+  Sdk_Timer     *moved, *timer, *next;
+
+  moved = NULL;
+  for (level = SDK_TIMER_LEVELS; level-- > 0;)
+  {
+    shift     = level * SDK_TIMER_BITS;
+    old_digit = (u32)(timers->now >> shift) & (SDK_TIMER_SLOTS - 1);
+    new_digit = (u32)(to >> shift) & (SDK_TIMER_SLOTS - 1);
+    /* NOTE: Slots past the old digit, up to the new one when the levels above did not move */
+    bits = timers->occupied[level] & ~((2ull << old_digit) - 1);
+    if ((timers->now >> (shift + SDK_TIMER_BITS)) == (to >> (shift + SDK_TIMER_BITS))) bits &= (2ull << new_digit) - 1;
+    else if (level == SDK_TIMER_LEVELS - 1)
+    {
+      /* NOTE: Wrapped around, the next round's slots up to the new digit (all of them after a longer jump) */
+      if ((to >> (shift + SDK_TIMER_BITS)) - (timers->now >> (shift + SDK_TIMER_BITS)) > 1) bits = timers->occupied[level];
+      else bits |= timers->occupied[level] & ((2ull << new_digit) - 1);
+    }
+    while (bits)
+    {
+      _BitScanForward64(&index, bits);
+      bits &= bits - 1;
+      for (timer = timers->slots[level][index]; timer; timer = next)
+      {
+        next        = timer->next;
+        timer->next = moved;
+        moved       = timer;
+        if (level) timers->cascaded++;
+      }
+      timers->slots[level][index] = NULL;
+      timers->occupied[level]    &= ~(1ull << index);
+    }
+  }
+  timers->now = to;
+  for (timer = moved; timer; timer = next)
+  {
+    next = timer->next;
+    sdk_timers_place(timers, timer);
+  }
+}
+
+/*
+ * NOTE:
+ *      Loop thread, once `event` is signaled (calling it anyway is harmless).
+ *      Runs the callbacks of every timer due, re-arms the periodic ones and
+ *      sets the next wakeup. Returns the number of callbacks run.
+ */
+static u32
+sdk_timers_run(Sdk_Timers *timers)
+{
+  u32            fired;
+  u64            now;
+  Sdk_Timer      *timer;
+  Sdk_Timer_Proc proc;
+
+  fired = 0;
+  AcquireSRWLockExclusive(&timers->lock);
+  timers->wakeups++;
+  timers->armed = 0;
+  now = sdk_timers_ms();
+  if (now > timers->now) sdk_timers_advance(timers, now);
+  while (timers->expired)
+  {
+    timer = timers->expired;
+    sdk_timers_unlink(timers, timer);
+    proc = timer->proc;
+    if (timer->period)
+    {
+      /* NOTE: On its period, missed ones are skipped */
+      timer->deadline += timer->period;
+      if (timer->deadline <= now) timer->deadline = now + timer->period - (now - timer->deadline) % timer->period;
+      sdk_timers_place(timers, timer);
+    }
+    else
+    {
+      timer->deadline = 0;
+      timers->count--;
+    }
+    timers->fired++;
+    fired++;
+    /* NOTE: The callback may start or stop any timer, this one included */
+    ReleaseSRWLockExclusive(&timers->lock);
+    if (proc) proc(timers, timer, now);
+    AcquireSRWLockExclusive(&timers->lock);
+  }
+  if (!fired) timers->empty_wakeups++;
+  sdk_timers_arm(timers);
+  ReleaseSRWLockExclusive(&timers->lock);
+  return fired;
+}
+
+static bool
+sdk_timers_open(Sdk_Timers *timers)
+{
+  memset(timers, 0, sizeof(Sdk_Timers));
+  InitializeSRWLock(&timers->lock);
+  timers->now   = sdk_timers_ms();
+  timers->event = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  /* NOTE: Before Windows 10 1803, the plain one rounds to the system tick */
+  if (!timers->event) timers->event = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+  if (!timers->event) { report_error("CreateWaitableTimerExW"); return false; }
+  return true;
+}
+
+static void
+sdk_timers_drop(Sdk_Timer *timer)
+{
+  Sdk_Timer *next;
+
+  for (; timer; timer = next)
+  {
+    next            = timer->next;
+    timer->prev     = timer->next = NULL;
+    timer->deadline = 0;
+  }
+}
+
+/* NOTE: Once the loop stopped. The timers still on the wheel are left unarmed. */
+static void
+sdk_timers_close(Sdk_Timers *timers)
+{
+  u32 level, index;
+
+  for (level = 0; level < SDK_TIMER_LEVELS; level++)
+  {
+    for (index = 0; index < SDK_TIMER_SLOTS; index++) sdk_timers_drop(timers->slots[level][index]);
+  }
+  sdk_timers_drop(timers->expired);
+  if (timers->event) handle_close(timers->event);
+  memset(timers, 0, sizeof(Sdk_Timers));
+}
+
+static void
+sdk_timers_report(Sdk_Timers *timers, char *name)
+{
+  printf("%s timers: %u scheduled, %llu fired, %llu wakeups (%llu with nothing due), %llu cascaded\n",
+         name, timers->count, timers->fired, timers->wakeups, timers->empty_wakeups, timers->cascaded);
+}
+
+#endif // SDK_TIMER_C
@@ -0,0 +1,483 @@
+#ifndef SDK_WIDGET_C
+#define SDK_WIDGET_C
+
+/*
+ * NOTE:
+ *      Built-in widgets: keys drawn from a value rather than a file.
+ *
+ *        CLOCK    local time, HH:MM or HH:MM:SS
+ *        COUNTER  a number other code sets (sdk_widget_set, sdk_widget_add)
+ *        CPU      processor load (GetSystemTimes), digits and a bar
+ *        MEMORY   physical memory load (GlobalMemoryStatusEx), same
+ *
+ *      A widget only goes out when what it shows changes. A clock is looked
+ *      at right after the second (or the minute) turns, never in between. A
+ *      meter samples every `interval_ms` but is quantized to `levels` steps,
+ *      and a sample that stays on the same level is not drawn. The key is
+ *      composed (sdk_compose.c) from a fill, the label, seven segment digits
+ *      and the bar, each a cached layer raster, and the composition goes
+ *      through the tile cache: a minute or a level seen before costs a
+ *      lookup, not an encode, on every key and deck showing it.
+ *
+ *      One thread drives every widget off its own timer wheel (sdk_timer.c),
+ *      it sleeps on the wheel's waitable timer until the nearest deadline.
+ *      Meter deadlines are aligned on their period and get a little slack,
+ *      so meters with the same interval, or close enough, share one wakeup.
+ *
+ *      Like a live key, a widget claims its key (sdk_claim_key) while it is
+ *      bound and is drawn again when its deck comes back.
+ */
+#define SDK_WIDGET_MAX          64
+#define SDK_WIDGET_INTERVAL_MS  1000
+#define SDK_WIDGET_SLACK_MS     20           /* NOTE: CPU, MEMORY: how late a sample may be taken */
+#define SDK_WIDGET_PRIME_MS     250          /* NOTE: CPU: first sampling window */
+#define SDK_WIDGET_RETRY_MS     500
+#define SDK_WIDGET_LEVELS       20
+#define SDK_WIDGET_LABEL_LEN    16
+#define SDK_WIDGET_TRACK        0x303030     /* NOTE: Empty part of a meter's bar */
+#define SDK_WIDGET_LABEL_COLOR  0xA0A0A0
+
+enum
+{
+  SDK_WIDGET_CLOCK = 1,
+  SDK_WIDGET_COUNTER,
+  SDK_WIDGET_CPU,
+  SDK_WIDGET_MEMORY,
+};
+
+#pragma warning(disable : 4820)
+typedef struct SdkWidgetDef
+{
+  u8   kind;
+  bool seconds;                              /* NOTE: CLOCK */
+  u8   levels;                               /* NOTE: CPU, MEMORY: steps, 0 = SDK_WIDGET_LEVELS */
+  u32  interval_ms;                          /* NOTE: CPU, MEMORY: sampling, 0 = SDK_WIDGET_INTERVAL_MS */
+  u32  color, background;                    /* NOTE: 0xRRGGBB */
+  char label[SDK_WIDGET_LABEL_LEN];          /* NOTE: Top line in SDK_COMPOSE_FONT, empty = none */
+} SdkWidgetDef, Sdk_Widget_Def;
+
+typedef struct SdkWidget
+{
+  Stream_Deck    *sdk;                       /* NOTE: NULL when the slot is free */
+  u8             key;
+  Sdk_Widget_Def def;
+  u32            generation;
+  i64            value;                      /* NOTE: COUNTER */
+  i64            shown;                      /* NOTE: What the key shows, when `drawn` */
+  bool           drawn;
+  u64            idle, busy;                 /* NOTE: CPU: previous sample, 100 ns */
+  Sdk_Timer      timer;                      /* NOTE: Next sample, `id` is the index */
+  /* NOTE: Stats */
+  u64            samples, uploads, failures;
+} SdkWidget, Sdk_Widget;
+
+typedef struct SdkWidgets
+{
+  SRWLOCK     lock;                          /* NOTE: Taken before the wheel's */
+  Sdk_Manager *mgr;
+  HANDLE      thread;
+  HANDLE      stop_event;
+  Sdk_Timers  timers;
+  Sdk_Widget  widgets[SDK_WIDGET_MAX];
+} SdkWidgets, Sdk_Widgets;
+#pragma warning(default : 4820)
+
+static inline u64
+sdk_filetime(FILETIME *time)
+{
+  return ((u64) time->dwHighDateTime << 32) | time->dwLowDateTime;
+}
+
+/*
+ * NOTE:
+ *      Lock held. The value `widget` shows at `now` (wheel ms, a quantized
+ *      level for the meters) and when to look again, 0 = only when it is
+ *      set. False when there is nothing to show yet.
+ */
+static bool
+sdk_widget_sample(Sdk_Widget *widget, u64 now, i64 *value, u64 *due)
+{
+  u32            period, ms, levels, percent;
+  u64            idle, busy;
+  FILETIME       idle_time, kernel_time, user_time;
+  SYSTEMTIME     time;
+  MEMORYSTATUSEX memory;
+
+  *due   = 0;
+  levels = widget->def.levels ? widget->def.levels : SDK_WIDGET_LEVELS;
+  period = widget->def.interval_ms ? widget->def.interval_ms : SDK_WIDGET_INTERVAL_MS;
+  switch (widget->def.kind)
+  {
+    case SDK_WIDGET_CLOCK:
+      GetLocalTime(&time);
+      /* NOTE: Just past the next second or minute, the only moments the text changes */
+      ms   = widget->def.seconds ? 1000u - time.wMilliseconds : (60u - time.wSecond) * 1000u - time.wMilliseconds;
+      *due = now + ms + 1;
+      *value = widget->def.seconds ? time.wHour * 3600 + time.wMinute * 60 + time.wSecond : time.wHour * 60 + time.wMinute;
+      return true;
+    case SDK_WIDGET_CPU:
+      *due = (now / period + 1) * period;
+      if (!GetSystemTimes(&idle_time, &kernel_time, &user_time)) { report_error("GetSystemTimes"); return false; }
+      /* NOTE: Kernel time counts the idle time too */
+      idle = sdk_filetime(&idle_time);
+      busy = sdk_filetime(&kernel_time) + sdk_filetime(&user_time) - idle;
+      if (!widget->idle && !widget->busy)
+      {
+        widget->idle = idle;
+        widget->busy = busy;
+        *due = now + SDK_WIDGET_PRIME_MS;
+        return false;
+      }
+      percent = busy - widget->busy + idle - widget->idle
+              ? (u32)((busy - widget->busy) * 100 / (busy - widget->busy + idle - widget->idle)) : 0;
+      widget->idle = idle;
+      widget->busy = busy;
+      break;
+    case SDK_WIDGET_MEMORY:
+      *due = (now / period + 1) * period;
+      memory.dwLength = sizeof(MEMORYSTATUSEX);
+      if (!GlobalMemoryStatusEx(&memory)) { report_error("GlobalMemoryStatusEx"); return false; }
+      percent = memory.dwMemoryLoad;
+      break;
+    default:
+      *value = widget->value;
+      return true;
+  }
+  if (percent > 100) percent = 100;
+  *value = (percent * levels + 50) / 100;
+  return true;
+}
+
+/* NOTE: Widget thread, lock not held. Composed and queued, see sdk_queue_layers. */
+static bool
+sdk_widget_draw(Stream_Deck *sdk, u8 key, Sdk_Widget_Def *def, i64 value)
+{
+  u32       count, levels, percent;
+  char      text[32];
+  Sdk_Layer layers[4];
+
+  if (!atomic_load(&sdk->connected)) return true;
+  memset(layers, 0, sizeof(layers));
+  count = 0;
+  layers[count].kind    = SDK_LAYER_FILL;
+  layers[count++].color = def->background;
+  if (def->label[0])
+  {
+    layers[count].kind    = SDK_LAYER_TEXT;
+    layers[count].align   = SDK_ALIGN_TOP;
+    layers[count].color   = SDK_WIDGET_LABEL_COLOR;
+    layers[count++].text  = def->label;
+  }
+  switch (def->kind)
+  {
+    case SDK_WIDGET_CLOCK:
+      if (def->seconds) snprintf(text, sizeof(text), "%02u:%02u:%02u", (u32)(value / 3600), (u32)(value / 60 % 60), (u32)(value % 60));
+      else              snprintf(text, sizeof(text), "%02u:%02u", (u32)(value / 60), (u32)(value % 60));
+      break;
+    case SDK_WIDGET_CPU:
+    case SDK_WIDGET_MEMORY:
+      levels  = def->levels ? def->levels : SDK_WIDGET_LEVELS;
+      percent = (u32)(value * 100 / levels);
+      snprintf(text, sizeof(text), "%u", percent);
+      layers[count].kind     = SDK_LAYER_BAR;
+      layers[count].percent  = (u8) percent;
+      layers[count].color    = def->color;
+      layers[count++].color2 = SDK_WIDGET_TRACK;
+      break;
+    default:
+      snprintf(text, sizeof(text), "%lld", value);
+      break;
+  }
+  layers[count].kind    = SDK_LAYER_DIGITS;
+  layers[count].align   = SDK_ALIGN_CENTER;
+  layers[count].color   = def->color;
+  layers[count++].text  = text;
+  return sdk_queue_layers(sdk, key, layers, count, true);
+}
+
+/* NOTE: Widget thread. Samples the widget that expired, draws it when what it shows changed. */
+static void
+sdk_widget_update(Sdk_Widgets *widgets, u32 index, u64 now)
+{
+  u8             key;
+  i64            value;
+  u64            due;
+  bool           has_value, sent;
+  Stream_Deck    *sdk;
+  Sdk_Widget     *widget;
+  Sdk_Widget_Def def;
+
+  AcquireSRWLockExclusive(&widgets->lock);
+  widget = &widgets->widgets[index];
+  if (!widget->sdk) { ReleaseSRWLockExclusive(&widgets->lock); return; }
+  widget->samples++;
+  has_value = sdk_widget_sample(widget, now, &value, &due);
+  if (due)
+  {
+    sdk_timer_start_at(&widgets->timers, &widget->timer, due, 0,
+                       widget->def.kind == SDK_WIDGET_CLOCK ? 0 : SDK_WIDGET_SLACK_MS);
+  }
+  /* NOTE: Same second, same level: nothing to send */
+  if (!has_value || (widget->drawn && widget->shown == value)) { ReleaseSRWLockExclusive(&widgets->lock); return; }
+  widget->shown = value;
+  widget->drawn = true;
+  sdk = widget->sdk;
+  key = widget->key;
+  def = widget->def;
+  ReleaseSRWLockExclusive(&widgets->lock);
+
+  sent = sdk_widget_draw(sdk, key, &def, value);
+  AcquireSRWLockExclusive(&widgets->lock);
+  if (widget->sdk == sdk && widget->key == key)
+  {
+    if (sent) widget->uploads++;
+    else
+    {
+      /* NOTE: Drawn again on its next tick, a counter gets one of its own */
+      widget->failures++;
+      widget->drawn = false;
+      if (!sdk_timer_pending(&widget->timer)) sdk_timer_start(&widgets->timers, &widget->timer, SDK_WIDGET_RETRY_MS, 0, 0);
+    }
+  }
+  ReleaseSRWLockExclusive(&widgets->lock);
+}
+
+/* NOTE: Sdk_Timer_Proc of every widget. */
+static void
+sdk_widget_fired(Sdk_Timers *timers, Sdk_Timer *timer, u64 now)
+{
+  (void) timers;
+  sdk_widget_update(timer->user, timer->id, now);
+}
+
+static DWORD WINAPI
+sdk_widget_proc(void *args)
+{
+  u32         ret;
+  HANDLE      handles[2];
+  Sdk_Widgets *widgets;
+
+  widgets    = args;
+  handles[0] = widgets->stop_event;
+  handles[1] = widgets->timers.event;
+  for (;;)
+  {
+    ret = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+    if (ret == WAIT_OBJECT_0) break;
+    if (ret != WAIT_OBJECT_0 + 1) { report_error("WaitForMultipleObjects"); break; }
+    sdk_timers_run(&widgets->timers);
+  }
+  return EXIT_SUCCESS;
+}
+
+/* NOTE: Lock held. Frees the slot, its timer stopped and ready for the next widget. */
+static void
+sdk_widget_reset(Sdk_Widgets *widgets, Sdk_Widget *widget)
+{
+  u32 index;
+
+  index = (u32)(widget - widgets->widgets);
+  sdk_timer_stop(&widgets->timers, &widget->timer);
+  memset(widget, 0, sizeof(Sdk_Widget));
+  sdk_timer_init(&widget->timer, sdk_widget_fired, widgets, index);
+}
+
+/*
+ * NOTE:
+ *      Any thread. Shows the widget `def` on `key` of `sdk`, drawn right
+ *      away. Rebinding a key to the same definition only updates its
+ *      `generation`, see sdk_widget_prune. False when the key is claimed by
+ *      another source.
+ */
+static bool
+sdk_widget_bind(Sdk_Widgets *widgets, Stream_Deck *sdk, u8 key, Sdk_Widget_Def *def, u32 generation)
+{
+  u32        i;
+  Sdk_Widget *widget, *slot;
+
+  AcquireSRWLockExclusive(&widgets->lock);
+  slot = NULL;
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    widget = &widgets->widgets[i];
+    if (widget->sdk == sdk && widget->key == key) { slot = widget; break; }
+    if (!widget->sdk && !slot) slot = widget;
+  }
+  if (!slot) { ReleaseSRWLockExclusive(&widgets->lock); printf("sdk_widget_bind: too many widgets\n"); return false; }
+  if (slot->sdk && !memcmp(&slot->def, def, sizeof(Sdk_Widget_Def)))
+  {
+    slot->generation = generation;
+    ReleaseSRWLockExclusive(&widgets->lock);
+    return true;
+  }
+  /* NOTE: Same key, another widget: the key is already ours */
+  if (!slot->sdk && !sdk_claim_key(sdk, key))
+  {
+    ReleaseSRWLockExclusive(&widgets->lock);
+    printf("[%s] key %u is already claimed\n", sdk->serial, key);
+    return false;
+  }
+  sdk_widget_reset(widgets, slot);
+  slot->sdk        = sdk;
+  slot->key        = key;
+  slot->def        = *def;
+  slot->generation = generation;
+  sdk_timer_start(&widgets->timers, &slot->timer, 0, 0, 0);
+  ReleaseSRWLockExclusive(&widgets->lock);
+  return true;
+}
+
+/* NOTE: Lock held. */
+static void
+sdk_widget_remove(Sdk_Widgets *widgets, Sdk_Widget *widget)
+{
+  sdk_release_key(widget->sdk, widget->key);
+  sdk_widget_reset(widgets, widget);
+}
+
+/* NOTE: Any thread. The key goes back to the profile. */
+static void
+sdk_widget_unbind(Sdk_Widgets *widgets, Stream_Deck *sdk, u8 key)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&widgets->lock);
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    if (widgets->widgets[i].sdk == sdk && widgets->widgets[i].key == key) sdk_widget_remove(widgets, &widgets->widgets[i]);
+  }
+  ReleaseSRWLockExclusive(&widgets->lock);
+}
+
+/* NOTE: Any thread. Same as sdk_live_prune. */
+static void
+sdk_widget_prune(Sdk_Widgets *widgets, u32 generation)
+{
+  u32 i;
+
+  AcquireSRWLockExclusive(&widgets->lock);
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    if (widgets->widgets[i].sdk && widgets->widgets[i].generation && widgets->widgets[i].generation != generation)
+    {
+      sdk_widget_remove(widgets, &widgets->widgets[i]);
+    }
+  }
+  ReleaseSRWLockExclusive(&widgets->lock);
+}
+
+/* NOTE: Any thread. Sets (`relative` false) or moves the value of the COUNTER on `key`. False without one. */
+static bool
+sdk_widget_count(Sdk_Widgets *widgets, Stream_Deck *sdk, u8 key, i64 value, bool relative)
+{
+  u32        i;
+  bool       found;
+  Sdk_Widget *widget;
+
+  found = false;
+  AcquireSRWLockExclusive(&widgets->lock);
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    widget = &widgets->widgets[i];
+    if (widget->sdk != sdk || widget->key != key || widget->def.kind != SDK_WIDGET_COUNTER) continue;
+    widget->value = relative ? widget->value + value : value;
+    /* NOTE: Changes made before it expires are drawn once */
+    if (!sdk_timer_pending(&widget->timer)) sdk_timer_start(&widgets->timers, &widget->timer, 0, 0, 0);
+    found = true;
+  }
+  ReleaseSRWLockExclusive(&widgets->lock);
+  return found;
+}
+
+static inline bool
+sdk_widget_set(Sdk_Widgets *widgets, Stream_Deck *sdk, u8 key, i64 value)
+{
+  return sdk_widget_count(widgets, sdk, key, value, false);
+}
+
+static inline bool
+sdk_widget_add(Sdk_Widgets *widgets, Stream_Deck *sdk, u8 key, i64 delta)
+{
+  return sdk_widget_count(widgets, sdk, key, delta, true);
+}
+
+/* NOTE: Sdk_Attach_Hook, the deck came back blank: its widgets are drawn again. */
+static void
+sdk_widget_on_attach(Sdk_Manager *mgr, Stream_Deck *sdk, void *user)
+{
+  u32         i;
+  Sdk_Widgets *widgets;
+
+  (void) mgr;
+  widgets = user;
+  AcquireSRWLockExclusive(&widgets->lock);
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    if (widgets->widgets[i].sdk != sdk) continue;
+    widgets->widgets[i].drawn = false;
+    sdk_timer_start(&widgets->timers, &widgets->widgets[i].timer, 0, 0, 0);
+  }
+  ReleaseSRWLockExclusive(&widgets->lock);
+}
+
+static void
+sdk_widget_close(Sdk_Widgets *widgets)
+{
+  u32 i;
+
+  if (widgets->thread)
+  {
+    SetEvent(widgets->stop_event);
+    WaitForSingleObject(widgets->thread, INFINITE);
+    handle_close(widgets->thread);
+  }
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    if (widgets->widgets[i].sdk) sdk_widget_remove(widgets, &widgets->widgets[i]);
+  }
+  if (widgets->stop_event) handle_close(widgets->stop_event);
+  sdk_timers_close(&widgets->timers);
+  if (widgets->mgr) sdk_manager_remove_attach_hook(widgets->mgr, sdk_widget_on_attach, widgets);
+  memset(widgets, 0, sizeof(Sdk_Widgets));
+}
+
+/* NOTE: Close it before the manager, its widgets point into the manager's decks. */
+static bool
+sdk_widget_open(Sdk_Widgets *widgets, Sdk_Manager *mgr)
+{
+  u32 i;
+
+  memset(widgets, 0, sizeof(Sdk_Widgets));
+  InitializeSRWLock(&widgets->lock);
+  widgets->mgr = mgr;
+  if (!sdk_timers_open(&widgets->timers)) goto _failure;
+  for (i = 0; i < SDK_WIDGET_MAX; i++) sdk_timer_init(&widgets->widgets[i].timer, sdk_widget_fired, widgets, i);
+  widgets->stop_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (!widgets->stop_event) { report_error("CreateEvent"); goto _failure; }
+  if (!sdk_manager_add_attach_hook(mgr, sdk_widget_on_attach, widgets)) goto _failure;
+  widgets->thread = CreateThread(NULL, 0, sdk_widget_proc, widgets, 0, NULL);
+  if (!widgets->thread) { report_error("CreateThread"); goto _failure; }
+  return true;
+
+_failure:
+  sdk_widget_close(widgets);
+  return false;
+}
+
+static void
+sdk_widget_report(Sdk_Widgets *widgets)
+{
+  u32        i;
+  Sdk_Widget *widget;
+
+  sdk_timers_report(&widgets->timers, "widgets");
+  for (i = 0; i < SDK_WIDGET_MAX; i++)
+  {
+    widget = &widgets->widgets[i];
+    if (!widget->sdk) continue;
+    printf("[%s] widget key %u: %llu samples, %llu uploads, %llu failed\n", widget->sdk->serial, widget->key,
+           widget->samples, widget->uploads, widget->failures);
+  }
+}
+
+#endif // SDK_WIDGET_C